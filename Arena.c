@@ -0,0 +1,103 @@
+/**********************************************************************************************
+*
+*   RockyRoad * Arena * Linear allocators for level and frame lifetimes
+*
+**********************************************************************************************/
+
+#include "Arena.h"
+#include "raylib.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGNMENT 16
+
+#if defined(_DEBUG)
+static volatile int heapAllocCount = 0;
+#endif
+
+void *GameHeapAlloc(size_t size)
+{
+#if defined(_DEBUG)
+    __atomic_add_fetch(&heapAllocCount, 1, __ATOMIC_RELAXED);
+#endif
+    return calloc(1, size);
+}
+
+void GameHeapFree(void *ptr)
+{
+    free(ptr);
+}
+
+int GetGameHeapAllocCount(void)
+{
+#if defined(_DEBUG)
+    return __atomic_load_n(&heapAllocCount, __ATOMIC_RELAXED);
+#else
+    return 0;
+#endif
+}
+
+Arena LoadArena(const char* name, size_t capacity)
+{
+    Arena arena = { 0 };
+    arena.name = name;
+    arena.base = (unsigned char*)GameHeapAlloc(capacity);
+
+    if (arena.base == NULL)
+        TraceLog(LOG_WARNING, "ARENA: [%s] Failed to reserve %i bytes", name, (int)capacity);
+    else
+        arena.capacity = capacity;
+
+    return arena;
+}
+
+void UnloadArena(Arena* arena)
+{
+    if (arena == NULL)
+        return;
+
+    if (arena->base != NULL)
+        TraceLog(LOG_INFO, "ARENA: [%s] Unloaded, peak use %i of %i bytes", arena->name, (int)arena->peak, (int)arena->capacity);
+
+    GameHeapFree(arena->base);
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+}
+
+void *ArenaAlloc(Arena* arena, size_t size)
+{
+    if (arena == NULL || arena->base == NULL)
+        return NULL;
+
+    size_t start = (arena->used + (ARENA_ALIGNMENT - 1)) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (start + size > arena->capacity)
+    {
+        TraceLog(LOG_WARNING, "ARENA: [%s] Out of space, %i bytes requested with %i of %i in use", arena->name, (int)size, (int)arena->used, (int)arena->capacity);
+        return NULL;
+    }
+
+    arena->used = start + size;
+    if (arena->used > arena->peak)
+        arena->peak = arena->used;
+
+    return arena->base + start;
+}
+
+void *ArenaCalloc(Arena* arena, size_t count, size_t size)
+{
+    void *ptr = ArenaAlloc(arena, count*size);
+    if (ptr != NULL)
+        memset(ptr, 0, count*size);
+
+    return ptr;
+}
+
+void ResetArena(Arena* arena)
+{
+    if (arena == NULL)
+        return;
+
+    arena->used = 0;
+}
@@ -0,0 +1,54 @@
+/**********************************************************************************************
+*
+*   RockyRoad * Arena * Linear allocators for level and frame lifetimes
+*
+*   An arena takes one block from the heap when it is loaded and hands out aligned slices of
+*   it. Nothing is freed individually: a level arena is reset when the level changes and the
+*   frame arena is reset once the frame has been presented.
+*
+*   Debug builds (_DEBUG) count the calls to GameHeapAlloc so a gameplay frame that goes
+*   through it can be caught. Allocations made by raylib or straight from the C library are
+*   not seen, unless raylib is built with RL_MALLOC pointing at GameHeapAlloc.
+*
+**********************************************************************************************/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct
+{
+    const char* name;
+    unsigned char* base;
+    size_t capacity;
+    size_t used;
+
+    // high water mark, useful for sizing the arena
+    size_t peak;
+}Arena;
+
+// reserve an arena of the given size, this is the only heap allocation it ever makes
+Arena LoadArena(const char* name, size_t capacity);
+
+// give the arena's block back to the heap
+void UnloadArena(Arena* arena);
+
+// take size bytes from the arena, 16 byte aligned. returns NULL when the arena is full
+void *ArenaAlloc(Arena* arena, size_t size);
+
+// same as ArenaAlloc but zeroed
+void *ArenaCalloc(Arena* arena, size_t count, size_t size);
+
+// forget every allocation made from the arena
+void ResetArena(Arena* arena);
+
+// heap allocation entry point for game code outside of arenas, counted in debug builds
+void *GameHeapAlloc(size_t size);
+void GameHeapFree(void *ptr);
+
+// number of GameHeapAlloc calls so far, always 0 outside of debug builds
+int GetGameHeapAllocCount(void);
+
+#endif //ARENA_H
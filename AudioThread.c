@@ -0,0 +1,228 @@
+/**********************************************************************************************
+*
+*   RockyRoad * AudioThread * Music streaming and sound triggering off the main thread
+*
+**********************************************************************************************/
+
+#include "AudioThread.h"
+
+#include <pthread.h>
+#include <time.h>
+
+#define AUDIO_QUEUE_SIZE 64                 // must be a power of two
+#define AUDIO_QUEUE_MASK (AUDIO_QUEUE_SIZE - 1)
+#define AUDIO_UPDATE_INTERVAL_MS 5          // how often the music stream is refilled
+
+typedef enum
+{
+    AUDIO_CMD_PLAY_EVENT = 0,
+    AUDIO_CMD_SET_EVENT_SOUND,
+    AUDIO_CMD_PLAY_MUSIC,
+    AUDIO_CMD_STOP_MUSIC,
+    AUDIO_CMD_MUSIC_VOLUME
+}AudioCommandType;
+
+typedef struct
+{
+    AudioCommandType type;
+    int event;
+    float value;
+    Sound sound;
+}AudioCommand;
+
+// ring written only by the game thread (tail) and read only by the audio thread (head)
+static AudioCommand queue[AUDIO_QUEUE_SIZE];
+static volatile unsigned int queueHead = 0;
+static volatile unsigned int queueTail = 0;
+
+static pthread_t audioThread;
+static pthread_mutex_t wakeLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wakeCond = PTHREAD_COND_INITIALIZER;
+static volatile int running = 0;
+
+// owned by the audio thread while it runs
+static Music music = { 0 };
+static bool musicPlaying = false;
+static Sound eventSounds[AUDIO_EVENT_COUNT] = { 0 };
+static bool eventBound[AUDIO_EVENT_COUNT] = { 0 };
+
+static bool PushAudioCommand(const AudioCommand* command)
+{
+    unsigned int tail = __atomic_load_n(&queueTail, __ATOMIC_RELAXED);
+    unsigned int head = __atomic_load_n(&queueHead, __ATOMIC_ACQUIRE);
+
+    if (tail - head >= AUDIO_QUEUE_SIZE)
+        return false;
+
+    queue[tail & AUDIO_QUEUE_MASK] = *command;
+    __atomic_store_n(&queueTail, tail + 1, __ATOMIC_RELEASE);
+
+    // wake the audio thread early if nobody holds the lock, otherwise it picks the command up
+    // on its next refill tick. the game thread never waits here
+    if (pthread_mutex_trylock(&wakeLock) == 0)
+    {
+        pthread_cond_signal(&wakeCond);
+        pthread_mutex_unlock(&wakeLock);
+    }
+
+    return true;
+}
+
+static bool PopAudioCommand(AudioCommand* command)
+{
+    unsigned int head = __atomic_load_n(&queueHead, __ATOMIC_RELAXED);
+    unsigned int tail = __atomic_load_n(&queueTail, __ATOMIC_ACQUIRE);
+
+    if (head == tail)
+        return false;
+
+    *command = queue[head & AUDIO_QUEUE_MASK];
+    __atomic_store_n(&queueHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static void ExecuteAudioCommand(const AudioCommand* command)
+{
+    switch (command->type)
+    {
+    case AUDIO_CMD_PLAY_EVENT:
+        if (eventBound[command->event])
+            PlaySound(eventSounds[command->event]);
+        break;
+    case AUDIO_CMD_SET_EVENT_SOUND:
+        eventSounds[command->event] = command->sound;
+        eventBound[command->event] = true;
+        break;
+    case AUDIO_CMD_PLAY_MUSIC:
+        if (!musicPlaying)
+            PlayMusicStream(music);
+        musicPlaying = true;
+        break;
+    case AUDIO_CMD_STOP_MUSIC:
+        if (musicPlaying)
+            StopMusicStream(music);
+        musicPlaying = false;
+        break;
+    case AUDIO_CMD_MUSIC_VOLUME:
+        SetMusicVolume(music, command->value);
+        break;
+    }
+}
+
+static void WaitForAudioWork(void)
+{
+    struct timespec wakeTime;
+    clock_gettime(CLOCK_REALTIME, &wakeTime);
+    wakeTime.tv_nsec += AUDIO_UPDATE_INTERVAL_MS*1000000L;
+    if (wakeTime.tv_nsec >= 1000000000L)
+    {
+        wakeTime.tv_sec += 1;
+        wakeTime.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&wakeLock);
+    if (__atomic_load_n(&running, __ATOMIC_ACQUIRE) && __atomic_load_n(&queueHead, __ATOMIC_RELAXED) == __atomic_load_n(&queueTail, __ATOMIC_ACQUIRE))
+        pthread_cond_timedwait(&wakeCond, &wakeLock, &wakeTime);
+    pthread_mutex_unlock(&wakeLock);
+}
+
+static void *AudioThreadMain(void *arg)
+{
+    (void)arg;
+
+    while (__atomic_load_n(&running, __ATOMIC_ACQUIRE))
+    {
+        AudioCommand command;
+        while (PopAudioCommand(&command))
+            ExecuteAudioCommand(&command);
+
+        if (musicPlaying)
+            UpdateMusicStream(music);
+
+        WaitForAudioWork();
+    }
+
+    // anything posted right before shutdown still gets applied, then the music is stopped
+    AudioCommand command;
+    while (PopAudioCommand(&command))
+        ExecuteAudioCommand(&command);
+
+    if (musicPlaying)
+        StopMusicStream(music);
+    musicPlaying = false;
+
+    return NULL;
+}
+
+void InitAudioThread(Music stream)
+{
+    if (running)
+        return;
+
+    music = stream;
+    musicPlaying = false;
+    running = 1;
+
+    if (pthread_create(&audioThread, NULL, AudioThreadMain, NULL) != 0)
+    {
+        running = 0;
+        TraceLog(LOG_WARNING, "AUDIO: Failed to start audio thread");
+        return;
+    }
+
+    TraceLog(LOG_INFO, "AUDIO: Audio thread started");
+}
+
+void CloseAudioThread(void)
+{
+    if (!running)
+        return;
+
+    __atomic_store_n(&running, 0, __ATOMIC_RELEASE);
+
+    pthread_mutex_lock(&wakeLock);
+    pthread_cond_signal(&wakeCond);
+    pthread_mutex_unlock(&wakeLock);
+
+    pthread_join(audioThread, NULL);
+}
+
+void SetAudioEventSound(AudioEvent event, Sound sound)
+{
+    AudioCommand command = { AUDIO_CMD_SET_EVENT_SOUND, event, 0.0f, sound };
+
+    if (!running)
+    {
+        ExecuteAudioCommand(&command);
+        return;
+    }
+
+    PushAudioCommand(&command);
+}
+
+bool PostAudioEvent(AudioEvent event)
+{
+    AudioCommand command = { AUDIO_CMD_PLAY_EVENT, event, 0.0f, { 0 } };
+    return running && PushAudioCommand(&command);
+}
+
+void PlayMusicAsync(void)
+{
+    AudioCommand command = { AUDIO_CMD_PLAY_MUSIC, 0, 0.0f, { 0 } };
+    if (running)
+        PushAudioCommand(&command);
+}
+
+void StopMusicAsync(void)
+{
+    AudioCommand command = { AUDIO_CMD_STOP_MUSIC, 0, 0.0f, { 0 } };
+    if (running)
+        PushAudioCommand(&command);
+}
+
+void SetMusicVolumeAsync(float volume)
+{
+    AudioCommand command = { AUDIO_CMD_MUSIC_VOLUME, 0, volume, { 0 } };
+    if (running)
+        PushAudioCommand(&command);
+}
@@ -0,0 +1,41 @@
+/**********************************************************************************************
+*
+*   RockyRoad * AudioThread * Music streaming and sound triggering off the main thread
+*
+*   The game thread posts commands into a single producer / single consumer ring, the audio
+*   thread drains it and keeps the music stream fed on its own schedule. Once the thread is
+*   running it is the only one allowed to touch raylib audio.
+*
+**********************************************************************************************/
+
+#ifndef AUDIO_THREAD_H
+#define AUDIO_THREAD_H
+
+#include "raylib.h"
+
+// gameplay events that have a sound attached
+typedef enum
+{
+    AUDIO_EVENT_JUMP = 0,
+    AUDIO_EVENT_GRAPPLE,
+    AUDIO_EVENT_COUNT
+}AudioEvent;
+
+// start the audio thread, it takes over updating the given music stream
+void InitAudioThread(Music music);
+
+// stop and join the audio thread, audio can be unloaded from the main thread afterwards
+void CloseAudioThread(void);
+
+// bind the sound played for an event
+void SetAudioEventSound(AudioEvent event, Sound sound);
+
+// queue a gameplay event, never blocks. returns false if the queue was full and the event dropped
+bool PostAudioEvent(AudioEvent event);
+
+// start, stop or change the volume of the music stream
+void PlayMusicAsync(void);
+void StopMusicAsync(void);
+void SetMusicVolumeAsync(float volume);
+
+#endif //AUDIO_THREAD_H
@@ -0,0 +1,433 @@
+/**********************************************************************************************
+*
+*   RockyRoad * CourseStream * Long courses streamed in chunks along the x axis
+*
+**********************************************************************************************/
+
+#include "CourseStream.h"
+#include "raymath.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COURSE_MAGIC 0x4f435252u            // "RRCO"
+#define COURSE_VERSION 1
+
+typedef struct
+{
+    unsigned int magic;
+    unsigned int version;
+    int chunkCount;
+    int elementCount;
+}CourseHeader;
+
+static int CompareElementX(const void* a, const void* b)
+{
+    float ax = ((const CourseElement*)a)->position.x;
+    float bx = ((const CourseElement*)b)->position.x;
+    return (ax > bx) - (ax < bx);
+}
+
+int CutCourseChunks(CourseElement* elements, int count, CourseChunk* chunks)
+{
+    qsort(elements, count, sizeof(CourseElement), CompareElementX);
+
+    // a chunk ends at its length or as soon as one of its per-chunk limits would be passed
+    int chunkCount = 0;
+    int platforms = 0;
+    int signs = 0;
+    for (int i = 0; i < count; i++)
+    {
+        int type = elements[i].type;
+        bool split = chunkCount == 0;
+        if (!split)
+        {
+            const CourseChunk *open = &chunks[chunkCount - 1];
+            split = (elements[i].position.x >= open->minX + COURSE_CHUNK_LENGTH) ||
+                    (type == COURSE_PLATFORM && platforms == MAX_CHUNK_PLATFORMS) ||
+                    (type == COURSE_SIGN && signs == MAX_CHUNK_SIGNS) ||
+                    (open->elementCount == MAX_CHUNK_ELEMENTS);
+        }
+        if (split)
+        {
+            chunks[chunkCount].minX = elements[i].position.x;
+            chunks[chunkCount].firstElement = i;
+            chunks[chunkCount].elementCount = 0;
+            chunkCount++;
+            platforms = 0;
+            signs = 0;
+        }
+
+        CourseChunk *chunk = &chunks[chunkCount - 1];
+        chunk->maxX = elements[i].position.x;
+        chunk->elementCount++;
+        if (type == COURSE_PLATFORM) platforms++;
+        if (type == COURSE_SIGN) signs++;
+    }
+
+    return chunkCount;
+}
+
+bool SaveCourse(const char* fileName, const CourseElement* elements, int count)
+{
+    if (count <= 0)
+        return false;
+
+    CourseElement *sorted = (CourseElement*)GameHeapAlloc(count*sizeof(CourseElement));
+    CourseChunk *chunks = (CourseChunk*)GameHeapAlloc(count*sizeof(CourseChunk));
+    if (sorted == NULL || chunks == NULL)
+    {
+        GameHeapFree(sorted);
+        GameHeapFree(chunks);
+        return false;
+    }
+    memcpy(sorted, elements, count*sizeof(CourseElement));
+    int chunkCount = CutCourseChunks(sorted, count, chunks);
+
+    CourseHeader header = { COURSE_MAGIC, COURSE_VERSION, chunkCount, count };
+    FILE *file = fopen(fileName, "wb");
+    bool written = file != NULL &&
+                   fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(chunks, sizeof(CourseChunk), chunkCount, file) == (size_t)chunkCount &&
+                   fwrite(sorted, sizeof(CourseElement), count, file) == (size_t)count;
+    if (file != NULL && fclose(file) != 0)
+        written = false;
+    if (!written)
+        TraceLog(LOG_WARNING, "COURSE: Could not write %s", fileName);
+    else
+        TraceLog(LOG_INFO, "COURSE: Wrote %s, %i elements in %i chunks", fileName, count, chunkCount);
+
+    GameHeapFree(sorted);
+    GameHeapFree(chunks);
+    return written;
+}
+
+bool LoadCourseStream(CourseStream* stream, const char* fileName, Model platform)
+{
+    memset(stream, 0, sizeof(*stream));
+    if (strlen(fileName) >= COURSE_PATH_LENGTH)
+        return false;
+
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL)
+    {
+        TraceLog(LOG_WARNING, "COURSE: Could not open %s", fileName);
+        return false;
+    }
+
+    CourseHeader header = { 0 };
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != COURSE_MAGIC || header.version != COURSE_VERSION ||
+        header.chunkCount <= 0 || header.elementCount <= 0)
+    {
+        TraceLog(LOG_WARNING, "COURSE: %s is not a course file", fileName);
+        fclose(file);
+        return false;
+    }
+
+    // the table is the only part that grows with the course, everything else is the window
+    size_t capacity = header.chunkCount*sizeof(CourseChunk) +
+                      COURSE_STREAM_SLOTS*MAX_CHUNK_ELEMENTS*sizeof(CourseElement) +
+                      COURSE_RESIDENT_CHUNKS*MAX_CHUNK_PLATFORMS*sizeof(Model) +
+                      COURSE_RESIDENT_CHUNKS*MAX_CHUNK_SIGNS*sizeof(CourseSign) +
+                      (COURSE_STREAM_SLOTS + 3)*16;
+    stream->arena = LoadArena("course", capacity);
+    stream->chunks = (CourseChunk*)ArenaAlloc(&stream->arena, header.chunkCount*sizeof(CourseChunk));
+    bool valid = stream->chunks != NULL &&
+                 fread(stream->chunks, sizeof(CourseChunk), header.chunkCount, file) == (size_t)header.chunkCount;
+    fclose(file);
+
+    for (int i = 0; valid && i < header.chunkCount; i++)
+    {
+        const CourseChunk *chunk = &stream->chunks[i];
+        valid = chunk->firstElement >= 0 && chunk->elementCount >= 0 && chunk->elementCount <= MAX_CHUNK_ELEMENTS &&
+                chunk->firstElement + chunk->elementCount <= header.elementCount &&
+                (i == 0 || chunk->minX >= stream->chunks[i - 1].minX);
+    }
+    if (!valid)
+    {
+        TraceLog(LOG_WARNING, "COURSE: Chunk table of %s is damaged", fileName);
+        UnloadArena(&stream->arena);
+        memset(stream, 0, sizeof(*stream));
+        return false;
+    }
+
+    strcpy(stream->fileName, fileName);
+    stream->elementsOffset = (long)(sizeof(header) + header.chunkCount*sizeof(CourseChunk));
+    stream->chunkCount = header.chunkCount;
+    stream->platform = platform;
+    stream->activeFirst = 0;
+    stream->activeLast = -1;
+    for (int i = 0; i < COURSE_STREAM_SLOTS; i++)
+    {
+        stream->slots[i].chunk = -1;
+        stream->slots[i].stream = stream;
+        stream->slots[i].elements = (CourseElement*)ArenaAlloc(&stream->arena, MAX_CHUNK_ELEMENTS*sizeof(CourseElement));
+    }
+    stream->groundArr = (Model*)ArenaAlloc(&stream->arena, COURSE_RESIDENT_CHUNKS*MAX_CHUNK_PLATFORMS*sizeof(Model));
+    stream->signs = (CourseSign*)ArenaAlloc(&stream->arena, COURSE_RESIDENT_CHUNKS*MAX_CHUNK_SIGNS*sizeof(CourseSign));
+
+    TraceLog(LOG_INFO, "COURSE: Streaming %s, %i elements in %i chunks", fileName, header.elementCount, header.chunkCount);
+    return true;
+}
+
+void UnloadCourseStream(CourseStream* stream)
+{
+    for (int i = 0; i < COURSE_STREAM_SLOTS; i++)
+        WaitForJobs(&stream->slots[i].counter);
+
+    UnloadArena(&stream->arena);
+    memset(stream, 0, sizeof(*stream));
+}
+
+// job: read one chunk's elements, opening the file on the worker so reads never share a handle
+static void LoadChunkJob(void* data)
+{
+    CourseSlot *slot = (CourseSlot*)data;
+    const CourseStream *stream = slot->stream;
+    const CourseChunk *chunk = &stream->chunks[slot->chunk];
+
+    slot->elementCount = 0;
+    slot->failed = true;
+
+    FILE *file = fopen(stream->fileName, "rb");
+    if (file == NULL)
+        return;
+
+    long offset = stream->elementsOffset + chunk->firstElement*(long)sizeof(CourseElement);
+    if (fseek(file, offset, SEEK_SET) == 0 &&
+        fread(slot->elements, sizeof(CourseElement), chunk->elementCount, file) == (size_t)chunk->elementCount)
+    {
+        slot->elementCount = chunk->elementCount;
+        slot->failed = false;
+    }
+    fclose(file);
+}
+
+static bool IsSlotLoading(const CourseSlot* slot)
+{
+    return __atomic_load_n(&slot->counter.pending, __ATOMIC_ACQUIRE) > 0;
+}
+
+static CourseSlot* FindSlot(CourseStream* stream, int chunk)
+{
+    for (int i = 0; i < COURSE_STREAM_SLOTS; i++)
+    {
+        if (stream->slots[i].chunk == chunk)
+            return &stream->slots[i];
+    }
+    return NULL;
+}
+
+// start reading a chunk into a slot not needed by the window [first, last]. a prefetch never
+// waits for a slot, a chunk the window needs now may have to wait for a stale read to finish
+static CourseSlot* RequestChunk(CourseStream* stream, int chunk, int first, int last, bool mayWait)
+{
+    CourseSlot *slot = FindSlot(stream, chunk);
+    if (slot != NULL)
+        return slot;
+
+    CourseSlot *loading = NULL;
+    for (int i = 0; i < COURSE_STREAM_SLOTS && slot == NULL; i++)
+    {
+        CourseSlot *candidate = &stream->slots[i];
+        if (candidate->active || (candidate->chunk >= first && candidate->chunk <= last))
+            continue;
+
+        if (!IsSlotLoading(candidate))
+            slot = candidate;
+        else if (loading == NULL)
+            loading = candidate;
+    }
+
+    if (slot == NULL)
+    {
+        if (!mayWait || loading == NULL)
+            return NULL;
+        WaitForJobs(&loading->counter);
+        slot = loading;
+    }
+
+    slot->chunk = chunk;
+    slot->elementCount = 0;
+    RunJob(LoadChunkJob, slot, &slot->counter);
+    return slot;
+}
+
+// slot holding a chunk of the window, finished reading
+static CourseSlot* GetLoadedChunk(CourseStream* stream, int chunk, int first, int last)
+{
+    CourseSlot *slot = RequestChunk(stream, chunk, first, last, true);
+    if (IsSlotLoading(slot))
+    {
+        stream->stalls++;
+        WaitForJobs(&slot->counter);
+    }
+    if (slot->failed)
+        TraceLog(LOG_WARNING, "COURSE: Could not read chunk %i of %s", chunk, stream->fileName);
+
+    return slot;
+}
+
+static int CountPlatforms(const CourseSlot* slot)
+{
+    int count = 0;
+    for (int i = 0; i < slot->elementCount && count < MAX_CHUNK_PLATFORMS; i++)
+    {
+        if (slot->elements[i].type == COURSE_PLATFORM)
+            count++;
+    }
+    return count;
+}
+
+static void BuildPlatforms(const CourseStream* stream, const CourseSlot* slot, Model* out)
+{
+    int count = 0;
+    for (int i = 0; i < slot->elementCount && count < slot->platformCount; i++)
+    {
+        const CourseElement *element = &slot->elements[i];
+        if (element->type != COURSE_PLATFORM)
+            continue;
+
+        out[count] = stream->platform;
+        out[count].transform = MatrixMultiply(stream->platform.transform, MatrixTranslate(element->position.x, element->position.y, element->position.z));
+        count++;
+    }
+}
+
+static void ActivateChunk(CourseStream* stream, int chunk, int first, int last, bool atFront)
+{
+    CourseSlot *slot = GetLoadedChunk(stream, chunk, first, last);
+    slot->platformCount = CountPlatforms(slot);
+    slot->active = true;
+
+    if (atFront)
+    {
+        memmove(stream->groundArr + slot->platformCount, stream->groundArr, stream->platformCount*sizeof(Model));
+        BuildPlatforms(stream, slot, stream->groundArr);
+        stream->activeFirst = chunk;
+    }
+    else
+    {
+        BuildPlatforms(stream, slot, stream->groundArr + stream->platformCount);
+        stream->activeLast = chunk;
+    }
+    stream->platformCount += slot->platformCount;
+}
+
+static void DeactivateChunk(CourseStream* stream, bool atFront)
+{
+    int chunk = atFront? stream->activeFirst : stream->activeLast;
+    CourseSlot *slot = FindSlot(stream, chunk);
+
+    // platforms that stay keep their state, a wobbling platform keeps wobbling
+    stream->platformCount -= slot->platformCount;
+    if (atFront)
+    {
+        memmove(stream->groundArr, stream->groundArr + slot->platformCount, stream->platformCount*sizeof(Model));
+        stream->activeFirst++;
+    }
+    else
+    {
+        stream->activeLast--;
+    }
+    slot->active = false;
+}
+
+static void CollectMarkers(CourseStream* stream)
+{
+    stream->signCount = 0;
+    stream->hasGoal = false;
+
+    for (int c = stream->activeFirst; c <= stream->activeLast; c++)
+    {
+        const CourseSlot *slot = FindSlot(stream, c);
+        int signs = 0;
+        for (int i = 0; i < slot->elementCount; i++)
+        {
+            const CourseElement *element = &slot->elements[i];
+            if (element->type == COURSE_SIGN && signs < MAX_CHUNK_SIGNS)
+            {
+                stream->signs[stream->signCount++] = (CourseSign){ element->position, element->variant };
+                signs++;
+            }
+            else if (element->type == COURSE_GOAL)
+            {
+                stream->hasGoal = true;
+                stream->goal = element->position;
+            }
+        }
+    }
+}
+
+int FindCourseChunk(const CourseChunk* chunks, int chunkCount, float x)
+{
+    // last chunk starting at or before x
+    int low = 0;
+    int high = chunkCount - 1;
+    while (low < high)
+    {
+        int mid = (low + high + 1)/2;
+        if (chunks[mid].minX <= x)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+    return low;
+}
+
+int UpdateCourseStream(CourseStream* stream, float x)
+{
+    if (stream->chunkCount == 0)
+        return 0;
+
+    int chunk = FindCourseChunk(stream->chunks, stream->chunkCount, x);
+    int first = (chunk - COURSE_CHUNKS_BEHIND < 0)? 0 : chunk - COURSE_CHUNKS_BEHIND;
+    int last = (chunk + COURSE_CHUNKS_AHEAD >= stream->chunkCount)? stream->chunkCount - 1 : chunk + COURSE_CHUNKS_AHEAD;
+    int shift = 0;
+
+    if (first != stream->activeFirst || last != stream->activeLast)
+    {
+        bool overlaps = stream->activeLast >= stream->activeFirst && first <= stream->activeLast && last >= stream->activeFirst;
+        if (!overlaps)
+        {
+            // a respawn or the first update, nothing carries over
+            for (int i = 0; i < COURSE_STREAM_SLOTS; i++)
+                stream->slots[i].active = false;
+            stream->platformCount = 0;
+            stream->activeFirst = first;
+            stream->activeLast = first - 1;
+            for (int c = first; c <= last; c++)
+                ActivateChunk(stream, c, first, last, false);
+        }
+        else
+        {
+            while (stream->activeFirst < first)
+            {
+                shift -= FindSlot(stream, stream->activeFirst)->platformCount;
+                DeactivateChunk(stream, true);
+            }
+            while (stream->activeLast > last)
+                DeactivateChunk(stream, false);
+            while (stream->activeFirst > first)
+            {
+                ActivateChunk(stream, stream->activeFirst - 1, first, last, true);
+                shift += FindSlot(stream, stream->activeFirst)->platformCount;
+            }
+            while (stream->activeLast < last)
+                ActivateChunk(stream, stream->activeLast + 1, first, last, false);
+        }
+        CollectMarkers(stream);
+    }
+
+    // read ahead in the direction of travel, there is one spare slot for it
+    if (x != stream->lastX)
+        stream->headingBack = x < stream->lastX;
+    stream->lastX = x;
+    if (stream->headingBack && first > 0)
+        RequestChunk(stream, first - 1, first, last, false);
+    else if (!stream->headingBack && last + 1 < stream->chunkCount)
+        RequestChunk(stream, last + 1, first, last, false);
+
+    return shift;
+}
@@ -0,0 +1,130 @@
+/**********************************************************************************************
+*
+*   RockyRoad * CourseStream * Long courses streamed in chunks along the x axis
+*
+*   A course file holds every platform, sign and the goal of a course sorted along x and cut
+*   into chunks of at most COURSE_CHUNK_LENGTH units. Only the chunk table is read up front.
+*
+*   While playing, the chunk under the player plus COURSE_CHUNKS_BEHIND and COURSE_CHUNKS_AHEAD
+*   chunks around it are resident, and the next chunk in the direction the player is moving
+*   is read on a job in the background. By the time the player crosses into the next chunk its
+*   data is already in memory and becoming resident is a copy into groundArr, never a file read.
+*
+*   All memory comes from one arena sized for the resident window when the course is loaded,
+*   so it stays the same for a course of any length apart from the chunk table itself.
+*
+**********************************************************************************************/
+
+#ifndef COURSE_STREAM_H
+#define COURSE_STREAM_H
+
+#include "raylib.h"
+#include "Arena.h"
+#include "JobSystem.h"
+
+#define COURSE_CHUNK_LENGTH 150.0f
+#define COURSE_CHUNKS_BEHIND 1
+#define COURSE_CHUNKS_AHEAD 2
+#define COURSE_RESIDENT_CHUNKS (COURSE_CHUNKS_BEHIND + 1 + COURSE_CHUNKS_AHEAD)
+#define COURSE_STREAM_SLOTS (COURSE_RESIDENT_CHUNKS + 1)     // one more for the prefetch
+#define MAX_CHUNK_PLATFORMS 256
+#define MAX_CHUNK_SIGNS 4
+#define MAX_CHUNK_ELEMENTS (MAX_CHUNK_PLATFORMS + MAX_CHUNK_SIGNS + 1)
+#define COURSE_PATH_LENGTH 256
+
+typedef enum
+{
+    COURSE_PLATFORM = 0,
+    COURSE_GOAL,
+    COURSE_SIGN                 // instruction billboard, variant picks the texture
+}CourseElementType;
+
+typedef struct
+{
+    int type;
+    int variant;
+    Vector3 position;
+}CourseElement;
+
+typedef struct
+{
+    float minX;
+    float maxX;
+    int firstElement;
+    int elementCount;
+}CourseChunk;
+
+typedef struct
+{
+    Vector3 position;
+    int variant;
+}CourseSign;
+
+typedef struct
+{
+    int chunk;                  // -1 when the slot is free
+    bool active;                // its platforms are in groundArr
+    int platformCount;
+
+    // written by the load job, read once counter drops to zero
+    CourseElement* elements;
+    int elementCount;
+    bool failed;
+    JobCounter counter;
+
+    const struct CourseStream* stream;
+}CourseSlot;
+
+typedef struct CourseStream
+{
+    char fileName[COURSE_PATH_LENGTH];
+    long elementsOffset;
+    int chunkCount;
+    CourseChunk* chunks;
+
+    CourseSlot slots[COURSE_STREAM_SLOTS];
+    int activeFirst;            // resident chunk range, activeLast < activeFirst when empty
+    int activeLast;
+
+    // resident platforms in course order, built from this model like LoadLevel does
+    Model platform;
+    Model* groundArr;
+    int platformCount;
+
+    CourseSign* signs;
+    int signCount;
+    bool hasGoal;
+    Vector3 goal;
+
+    // last player x and the way they were last moving, reads go ahead of them
+    float lastX;
+    bool headingBack;
+
+    // chunks that were needed before their background read finished
+    int stalls;
+
+    Arena arena;
+}CourseStream;
+
+// sort the elements along x in place and cut them into chunks the way a course file stores
+// them. chunks needs room for count entries, returns how many were used
+int CutCourseChunks(CourseElement* elements, int count, CourseChunk* chunks);
+
+// the last chunk starting at or before x, the first one for anything before the course
+int FindCourseChunk(const CourseChunk* chunks, int chunkCount, float x);
+
+// sort the elements along x, cut them into chunks and write the course file
+bool SaveCourse(const char* fileName, const CourseElement* elements, int count);
+
+// read the chunk table of a course file, nothing is resident until the first update. the
+// load jobs point back at the stream, so it must stay where it is until it is unloaded
+bool LoadCourseStream(CourseStream* stream, const char* fileName, Model platform);
+
+// wait for outstanding reads and release the arena
+void UnloadCourseStream(CourseStream* stream);
+
+// move the resident window to the player's x. returns how far the index of a platform that
+// stayed resident moved in groundArr, 0 when the window did not move or was rebuilt whole
+int UpdateCourseStream(CourseStream* stream, float x);
+
+#endif //COURSE_STREAM_H
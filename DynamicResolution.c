@@ -0,0 +1,179 @@
+/**********************************************************************************************
+*
+*   RockyRoad * DynamicResolution * Scale the 3D scene to hold a target frame rate
+*
+**********************************************************************************************/
+
+#include "DynamicResolution.h"
+#include "MemTrack.h"
+#include "rlgl.h"
+
+#include <math.h>
+
+#define DYNRES_MIN_SCALE 0.5f
+#define DYNRES_STEP 0.05f
+#define DYNRES_SMOOTHING 0.1f               // weight of the newest frame time
+#define DYNRES_MISS_FACTOR 1.08f            // smoothed time over budget*this counts as a miss
+#define DYNRES_HITCH_TIME 0.25f             // longer frames are loads or window drags, ignored
+#define DYNRES_PROBE_MIN 1.0f               // seconds on budget before trying a step up
+#define DYNRES_PROBE_MAX 8.0f
+#define DYNRES_PROBE_WINDOW 0.5f            // a miss this soon after a step up undoes it
+
+static void ReloadTarget(DynamicResolution* res, int width, int height)
+{
+    if (res->target.id != 0)
+    {
+        UntrackRenderTexture(res->target);
+        UnloadRenderTexture(res->target);
+    }
+
+    res->target = LoadRenderTexture(width, height);
+    SetTextureFilter(res->target.texture, TEXTURE_FILTER_BILINEAR);
+    TrackRenderTexture(res->target, "dynamic resolution");
+
+    res->width = width;
+    res->height = height;
+}
+
+static float QuantizeScale(const DynamicResolution* res, float scale)
+{
+    scale = floorf(scale/DYNRES_STEP + 0.001f)*DYNRES_STEP;
+    if (scale < res->minScale)
+        scale = res->minScale;
+    if (scale > 1.0f)
+        scale = 1.0f;
+
+    return scale;
+}
+
+DynamicResolution LoadDynamicResolution(int targetFps)
+{
+    DynamicResolution res = { 0 };
+
+    if (targetFps <= 0)
+        targetFps = 60;
+
+    res.sharpen = LoadShaderTracked(0, "sharpen.fs");
+    res.texelSizeLoc = GetShaderLocation(res.sharpen, "texelSize");
+    res.sharpnessLoc = GetShaderLocation(res.sharpen, "sharpness");
+
+    res.scale = 1.0f;
+    res.minScale = DYNRES_MIN_SCALE;
+    res.targetFrameTime = 1.0f/(float)targetFps;
+    res.smoothedFrameTime = res.targetFrameTime;
+    res.probeInterval = DYNRES_PROBE_MIN;
+    res.sinceProbe = -1.0f;
+
+    ReloadTarget(&res, GetScreenWidth(), GetScreenHeight());
+
+    return res;
+}
+
+void UnloadDynamicResolution(DynamicResolution* res)
+{
+    if (res == NULL)
+        return;
+
+    if (res->target.id != 0)
+    {
+        UntrackRenderTexture(res->target);
+        UnloadRenderTexture(res->target);
+    }
+
+    UnloadShaderTracked(res->sharpen);
+    res->target.id = 0;
+}
+
+void UpdateDynamicResolution(DynamicResolution* res, float frameTime)
+{
+    if (res == NULL)
+        return;
+
+    if (GetScreenWidth() != res->width || GetScreenHeight() != res->height)
+        ReloadTarget(res, GetScreenWidth(), GetScreenHeight());
+
+    if (frameTime <= 0.0f || frameTime > DYNRES_HITCH_TIME)
+        return;
+
+    res->smoothedFrameTime += (frameTime - res->smoothedFrameTime)*DYNRES_SMOOTHING;
+
+    if (res->smoothedFrameTime > res->targetFrameTime*DYNRES_MISS_FACTOR)
+    {
+        if (res->sinceProbe >= 0.0f)
+        {
+            // the last step up was too much, go back and wait longer before the next try
+            res->scale = QuantizeScale(res, res->scale - DYNRES_STEP);
+            res->probeInterval = fminf(res->probeInterval*2.0f, DYNRES_PROBE_MAX);
+        }
+        else
+        {
+            // pixel count goes with the square of the scale
+            res->scale = QuantizeScale(res, res->scale*sqrtf(res->targetFrameTime/res->smoothedFrameTime));
+        }
+
+        // start measuring the new scale from the budget instead of the old average
+        res->smoothedFrameTime = res->targetFrameTime;
+        res->stableTime = 0.0f;
+        res->sinceProbe = -1.0f;
+        return;
+    }
+
+    res->stableTime += frameTime;
+
+    if (res->sinceProbe >= 0.0f)
+    {
+        res->sinceProbe += frameTime;
+        if (res->sinceProbe > DYNRES_PROBE_WINDOW)
+        {
+            res->sinceProbe = -1.0f;
+            res->probeInterval = DYNRES_PROBE_MIN;
+        }
+    }
+    else if (res->stableTime >= res->probeInterval && res->scale < 1.0f)
+    {
+        res->scale = QuantizeScale(res, res->scale + DYNRES_STEP);
+        res->stableTime = 0.0f;
+        res->sinceProbe = 0.0f;
+    }
+}
+
+void BeginDynamicResolutionFP3D(DynamicResolution* res, FPCamera* camera, Color background)
+{
+    res->offscreen = res->scale < 1.0f && res->target.id != 0;
+
+    if (!res->offscreen)
+    {
+        BeginModeFP3D(camera);
+        return;
+    }
+
+    BeginTextureMode(res->target);
+    ClearBackground(background);
+
+    // only the bottom left part of the texture is used, the aspect ratio stays the window's
+    rlViewport(0, 0, (int)(res->width*res->scale), (int)(res->height*res->scale));
+    BeginModeFP3DTexture(camera, &res->target);
+}
+
+void EndDynamicResolutionFP3D(DynamicResolution* res)
+{
+    EndModeFP3D();
+
+    if (!res->offscreen)
+        return;
+
+    EndTextureMode();
+
+    float texelSize[2] = {1.0f/(float)res->width, 1.0f/(float)res->height};
+    float sharpness = fminf(fmaxf((1.0f - res->scale)*2.0f, 0.2f), 1.0f);
+    SetShaderValue(res->sharpen, res->texelSizeLoc, texelSize, SHADER_UNIFORM_VEC2);
+    SetShaderValue(res->sharpen, res->sharpnessLoc, &sharpness, SHADER_UNIFORM_FLOAT);
+
+    // render textures are stored bottom up, a negative height flips the region back
+    Rectangle source = {0, 0, res->width*res->scale, -res->height*res->scale};
+    Rectangle dest = {0, 0, (float)GetScreenWidth(), (float)GetScreenHeight()};
+
+    BeginShaderMode(res->sharpen);
+    DrawTexturePro(res->target.texture, source, dest, Vector2Zero(), 0.0f, WHITE);
+    EndShaderMode();
+}
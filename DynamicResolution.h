@@ -0,0 +1,56 @@
+/**********************************************************************************************
+*
+*   RockyRoad * DynamicResolution * Scale the 3D scene to hold a target frame rate
+*
+*   The scene is drawn into a render texture sized for the window, using only a scaled
+*   viewport of it, and then stretched back over the screen through a sharpening shader.
+*   At full scale the offscreen pass is skipped so the backbuffer keeps its MSAA.
+*
+*   The controller drops the scale as soon as the smoothed frame time misses the budget and
+*   probes one step back up after a stable period, backing off when a probe misses.
+*
+**********************************************************************************************/
+
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include "raylib.h"
+#include "FPCamera.h"
+
+typedef struct
+{
+    RenderTexture2D target;
+    Shader sharpen;
+    int texelSizeLoc;
+    int sharpnessLoc;
+
+    // size of the render texture, follows the window
+    int width;
+    int height;
+
+    float scale;
+    float minScale;
+    float targetFrameTime;
+
+    // controller state
+    float smoothedFrameTime;
+    float stableTime;
+    float probeInterval;
+    float sinceProbe;
+
+    // true while the current frame renders offscreen
+    bool offscreen;
+}DynamicResolution;
+
+// create the scaler for a target frame rate, loads sharpen.fs
+DynamicResolution LoadDynamicResolution(int targetFps);
+void UnloadDynamicResolution(DynamicResolution* res);
+
+// feed the last frame time, call once per frame before drawing
+void UpdateDynamicResolution(DynamicResolution* res, float frameTime);
+
+// replace BeginModeFP3D/EndModeFP3D for the scaled scene, call inside BeginDrawing
+void BeginDynamicResolutionFP3D(DynamicResolution* res, FPCamera* camera, Color background);
+void EndDynamicResolutionFP3D(DynamicResolution* res);
+
+#endif //DYNAMIC_RESOLUTION_H
@@ -30,10 +30,13 @@
 
 
 #include "FPCamera.h"
+#include "RawMouse.h"
 #include "rlgl.h"
 #include <stdlib.h>
 #include <math.h>
 
+#define VIEW_BOBBLE_DAMPEN 8.0f
+
 void InitFPCamera(FPCamera* camera, float fovY, Vector3 position)
 {
     if (camera == NULL)
@@ -96,6 +99,7 @@ void UseFPCameraMouse(FPCamera* camera, bool useMouse)
         return;
 
     camera->UseMouse = useMouse;
+    TakeRawMouseDelta();    // motion while the cursor was free does not turn the view
 
     if (useMouse && IsWindowFocused())
         DisableCursor();
@@ -149,6 +153,31 @@ static float GetSpeedForAxis(FPCamera* camera, CameraControls axis, float speed)
     return 0.0f;
 }
 
+// with RawMouse every event since the last look counts, otherwise only where the cursor is now
+static Vector2 GetMouseLookDelta(FPCamera* camera)
+{
+    Vector2 mousePosition = GetMousePosition();
+    Vector2 delta = { mousePosition.x - camera->PreviousMousePosition.x, mousePosition.y - camera->PreviousMousePosition.y };
+    camera->PreviousMousePosition = mousePosition;
+
+    if (IsRawMouseActive())
+        delta = TakeRawMouseDelta();
+    return delta;
+}
+
+static void ClampViewAngles(FPCamera* camera)
+{
+    if (camera->ViewAngles.y < camera->MinimumViewY * DEG2RAD)
+        camera->ViewAngles.y = camera->MinimumViewY * DEG2RAD;
+    else if (camera->ViewAngles.y > camera->MaximumViewY * DEG2RAD)
+        camera->ViewAngles.y = camera->MaximumViewY * DEG2RAD;
+}
+
+static Vector3 GetLookDirection(FPCamera* camera)
+{
+    return Vector3Transform((Vector3) { 0, 0, 1 }, MatrixRotateXYZ((Vector3) { camera->ViewAngles.y, -camera->ViewAngles.x, 0 }));
+}
+
 void UpdateFPCamera(FPCamera* camera, bool sliding)
 {
     if (camera == NULL)
@@ -161,6 +190,7 @@ void UpdateFPCamera(FPCamera* camera, bool sliding)
         {
             DisableCursor();
             camera->PreviousMousePosition = GetMousePosition(); // so there is no jump on focus
+            TakeRawMouseDelta();
         }
         else
         {
@@ -169,8 +199,7 @@ void UpdateFPCamera(FPCamera* camera, bool sliding)
     }
 
     // Mouse movement detection
-    Vector2 mousePositionDelta = (Vector2){ 0.0f, 0.0f };
-    Vector2 mousePosition = GetMousePosition();
+    Vector2 mousePositionDelta = GetMouseLookDelta(camera);
 
     // Keys input detection
     float direction[MOVE_DOWN + 1] = { GetSpeedForAxis(camera,MOVE_FRONT,camera->MoveSpeed.z),
@@ -180,11 +209,6 @@ void UpdateFPCamera(FPCamera* camera, bool sliding)
                                       GetSpeedForAxis(camera,MOVE_UP,camera->MoveSpeed.y),
                                       GetSpeedForAxis(camera,MOVE_DOWN,camera->MoveSpeed.y) };
 
-    mousePositionDelta.x = mousePosition.x - camera->PreviousMousePosition.x;
-    mousePositionDelta.y = mousePosition.y - camera->PreviousMousePosition.y;
-
-    camera->PreviousMousePosition = mousePosition;
-
 
     // let someone modify the projected position
     // Camera orientation calculation
@@ -201,14 +225,10 @@ void UpdateFPCamera(FPCamera* camera, bool sliding)
     else if (camera->UseMouse && camera->Focused)
         camera->ViewAngles.y += (mousePositionDelta.y / -camera->MouseSensitivity);
 
-    // Angle clamp
-    if (camera->ViewAngles.y < camera->MinimumViewY * DEG2RAD)
-        camera->ViewAngles.y = camera->MinimumViewY * DEG2RAD;
-    else if (camera->ViewAngles.y > camera->MaximumViewY * DEG2RAD)
-        camera->ViewAngles.y = camera->MaximumViewY * DEG2RAD;
+    ClampViewAngles(camera);
 
     // Recalculate camera target considering translation and rotation
-    Vector3 target = Vector3Transform((Vector3) { 0, 0, 1 }, MatrixRotateXYZ((Vector3) { camera->ViewAngles.y, -camera->ViewAngles.x, 0 }));
+    Vector3 target = GetLookDirection(camera);
 
     camera->Forward = Vector3Transform((Vector3) { 0, 0, 1 }, MatrixRotateXYZ((Vector3) { 0, -camera->ViewAngles.x, 0 }));
 
@@ -229,12 +249,10 @@ void UpdateFPCamera(FPCamera* camera, bool sliding)
 
         camera->CurrentBobble += swingDelta * camera->ViewBobbleFreq;
 
-        static float viewBobbleDampen = 8.0f;
-
-        eyeOfset -= sinf(camera->CurrentBobble / viewBobbleDampen) * camera->ViewBobbleMagnatude;
+        eyeOfset -= sinf(camera->CurrentBobble / VIEW_BOBBLE_DAMPEN) * camera->ViewBobbleMagnatude;
 
-        camera->ViewCamera.up.x = sinf(camera->CurrentBobble / (viewBobbleDampen * 2)) * camera->ViewBobbleWaverMagnitude;
-        camera->ViewCamera.up.z = -sinf(camera->CurrentBobble / (viewBobbleDampen * 2)) * camera->ViewBobbleWaverMagnitude;
+        camera->ViewCamera.up.x = sinf(camera->CurrentBobble / (VIEW_BOBBLE_DAMPEN * 2)) * camera->ViewBobbleWaverMagnitude;
+        camera->ViewCamera.up.z = -sinf(camera->CurrentBobble / (VIEW_BOBBLE_DAMPEN * 2)) * camera->ViewBobbleWaverMagnitude;
     }
     else
     {
@@ -250,6 +268,23 @@ void UpdateFPCamera(FPCamera* camera, bool sliding)
     camera->ViewCamera.target.z = camera->ViewCamera.position.z + target.z;
 }
 
+void LatchFPCameraLook(FPCamera* camera)
+{
+    if (camera == NULL || !camera->UseMouse || !camera->Focused)
+        return;
+
+    Vector2 mousePositionDelta = GetMouseLookDelta(camera);
+    camera->ViewAngles.x += (mousePositionDelta.x / -camera->MouseSensitivity);
+    camera->ViewAngles.y += (mousePositionDelta.y / -camera->MouseSensitivity);
+    ClampViewAngles(camera);
+
+    // only the view turns, the position stays where the update put it
+    Vector3 target = GetLookDirection(camera);
+    camera->Forward = Vector3Transform((Vector3) { 0, 0, 1 }, MatrixRotateXYZ((Vector3) { 0, -camera->ViewAngles.x, 0 }));
+    camera->Right = (Vector3){ camera->Forward.z * -1.0f, 0, camera->Forward.x };
+    camera->ViewCamera.target = Vector3Add(camera->ViewCamera.position, target);
+}
+
 void SetupCamera(FPCamera* camera, float aspect)
 {
     rlDrawRenderBatchActive();			// Draw Buffers (Only OpenGL 3+ and ES2)
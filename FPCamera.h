@@ -146,9 +146,16 @@ RLAPI void SetFPCameraPosition(FPCamera* camera, Vector3 pos);
 // update the camera for the current frame
 RLAPI void UpdateFPCamera(FPCamera* camera, bool sliding);
 
+// turn the view by the mouse movement since the update, call right before drawing with input
+// polled again, the late latched look then shows with less delay
+RLAPI void LatchFPCameraLook(FPCamera* camera);
+
 // start drawing using the camera, with near/far plane support
 RLAPI void BeginModeFP3D(FPCamera* camera);
 
+// same as BeginModeFP3D but with the aspect ratio of a render texture, call after BeginTextureMode
+RLAPI void BeginModeFP3DTexture(FPCamera* camera, RenderTexture* targetTexture);
+
 // end drawing with the camera
 RLAPI void EndModeFP3D();
 
@@ -0,0 +1,162 @@
+/**********************************************************************************************
+*
+*   RockyRoad * FramePacer * When frames start, when input is read and how late it shows
+*
+**********************************************************************************************/
+
+#include "FramePacer.h"
+
+#if defined(_WIN32)
+// keep the parts of windows.h out that clash with raylib's names
+#define NOGDI
+#define NOUSER
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "raylib.h"
+
+#if defined(PLATFORM_DESKTOP)
+// raylib links GLFW in on desktop but keeps it to itself, these are all the pacer needs
+void glfwPollEvents(void);
+void glfwSwapInterval(int interval);
+#endif
+
+#define PACER_SMOOTHING 0.1f                // weight of the newest latency sample
+#define PACER_DELAY_GROW 0.002              // of a refresh, per frame that made its vblank
+#define PACER_DELAY_SHRINK 0.1              // of a refresh, per missed vblank
+#define PACER_MAX_DELAY 0.8                 // of a refresh
+#define PACER_SPIN_TIME 0.001               // the end of a sleep is spun, sleeping overshoots
+#define PACER_FAST_FRAMES 30                // frames under half a refresh before the limiter takes over
+#define PACER_HITCH_TIME 0.25               // longer frames are loads or window drags, ignored
+
+static const char *modeNames[FRAME_PACING_COUNT] = { "vsync", "uncapped", "low latency" };
+
+static void SleepUntil(double time)
+{
+    double remaining = time - GetTime() - PACER_SPIN_TIME;
+    if (remaining > 0.0)
+    {
+#if defined(_WIN32)
+        Sleep((DWORD)(remaining*1000.0));
+#else
+        struct timespec wait = { (time_t)remaining, (long)((remaining - (double)(time_t)remaining)*1e9) };
+        nanosleep(&wait, NULL);
+#endif
+    }
+    while (GetTime() < time) { }
+}
+
+static void ApplyPacingMode(FramePacer* pacer)
+{
+    bool capped = pacer->mode != FRAME_PACING_UNCAPPED;
+#if defined(PLATFORM_DESKTOP)
+    glfwSwapInterval(capped? 1 : 0);
+#endif
+    SetTargetFPS((capped && pacer->limiterFallback)? (int)(1.0/pacer->refreshPeriod + 0.5) : 0);
+    pacer->delay = 0.0;
+    pacer->fastFrames = 0;
+}
+
+void InitFramePacer(FramePacer* pacer, int refreshRate, FramePacingMode mode)
+{
+    if (refreshRate <= 0)
+        refreshRate = 60;
+
+    *pacer = (FramePacer){ 0 };
+    pacer->mode = mode;
+    pacer->refreshPeriod = 1.0/(double)refreshRate;
+    pacer->frameStart = GetTime();
+    ApplyPacingMode(pacer);
+}
+
+void SetFramePacingMode(FramePacer* pacer, FramePacingMode mode)
+{
+    pacer->mode = mode;
+    ApplyPacingMode(pacer);
+    TraceLog(LOG_INFO, "PACING: %s", GetFramePacingModeName(mode));
+}
+
+const char* GetFramePacingModeName(FramePacingMode mode)
+{
+    return (mode >= 0 && mode < FRAME_PACING_COUNT)? modeNames[mode] : "unknown";
+}
+
+void SetFramePacerIdleRate(FramePacer* pacer, int fps)
+{
+    pacer->idleRate = (fps > 0)? fps : 0;
+    pacer->wakeUntil = 0.0;
+}
+
+void WakeFramePacer(FramePacer* pacer, double seconds)
+{
+    double until = GetTime() + seconds;
+    if (until > pacer->wakeUntil)
+        pacer->wakeUntil = until;
+}
+
+bool IsFramePacerIdle(const FramePacer* pacer)
+{
+    return pacer->idleRate > 0 && GetTime() >= pacer->wakeUntil;
+}
+
+void BeginFramePacing(FramePacer* pacer)
+{
+    // the frame in flight has just been swapped in
+    double now = GetTime();
+    bool idle = IsFramePacerIdle(pacer);
+    if (idle)
+    {
+        // whatever arrived while sleeping is read before the frame starts
+        SleepUntil(pacer->frameStart + 1.0/(double)pacer->idleRate);
+#if defined(PLATFORM_DESKTOP)
+        glfwPollEvents();
+#endif
+        now = GetTime();
+    }
+    double interval = now - pacer->frameStart;
+    pacer->frameStart = now;
+    if (pacer->lastSampleTime > 0.0 && interval < PACER_HITCH_TIME)
+    {
+        double latency = (pacer->sampleTime - pacer->lastSampleTime)/2.0 + (now - pacer->sampleTime) + pacer->refreshPeriod/2.0;
+        pacer->inputToPhotonMs += ((float)(latency*1000.0) - pacer->inputToPhotonMs)*PACER_SMOOTHING;
+    }
+
+    if (pacer->mode != FRAME_PACING_UNCAPPED && !pacer->limiterFallback && interval < pacer->refreshPeriod/2.0)
+    {
+        if (++pacer->fastFrames >= PACER_FAST_FRAMES)
+        {
+            pacer->limiterFallback = true;
+            ApplyPacingMode(pacer);
+            TraceLog(LOG_WARNING, "PACING: The swap does not wait for the display, limiting to %i fps", (int)(1.0/pacer->refreshPeriod + 0.5));
+        }
+    }
+    else pacer->fastFrames = 0;
+
+    pacer->lastSampleTime = pacer->sampleTime;
+    pacer->sampleTime = now;
+    // idle frames miss vblanks on purpose, they would only shrink the delay
+    if (pacer->mode != FRAME_PACING_LOW_LATENCY || idle)
+        return;
+
+    // a frame that took a refresh and a half missed its vblank
+    if (interval > pacer->refreshPeriod*1.5)
+        pacer->delay -= pacer->refreshPeriod*PACER_DELAY_SHRINK;
+    else
+        pacer->delay += pacer->refreshPeriod*PACER_DELAY_GROW;
+    if (pacer->delay < 0.0) pacer->delay = 0.0;
+    if (pacer->delay > pacer->refreshPeriod*PACER_MAX_DELAY) pacer->delay = pacer->refreshPeriod*PACER_MAX_DELAY;
+
+    SleepUntil(now + pacer->delay);
+    PollLateInput(pacer);
+}
+
+void PollLateInput(FramePacer* pacer)
+{
+#if defined(PLATFORM_DESKTOP)
+    glfwPollEvents();
+#endif
+    pacer->sampleTime = GetTime();
+}
@@ -0,0 +1,77 @@
+/**********************************************************************************************
+*
+*   RockyRoad * FramePacer * When frames start, when input is read and how late it shows
+*
+*   raylib reads input at the end of EndDrawing, so everything a frame reacts to is as old as
+*   the whole frame by the time its picture is swapped in. The pacer picks how frames are
+*   paced: waiting for the display in the swap, not waiting at all, or the low latency mode.
+*   That one still waits for the display, but sleeps after the swap for as long as the frame
+*   can afford and reads input again right before updating. The sleep grows slowly while the
+*   frames make their vblank and backs off quickly when one is missed.
+*
+*   Drivers that do not block in the swap fall back to raylib's frame limiter. The latency
+*   estimate is half the time between input reads, for events arriving at random, plus the
+*   time from the read to the swap returning, plus half a refresh for the scanout to reach the
+*   middle of the screen. Drivers that queue frames add to that unseen.
+*
+*   Screens that hardly change can set an idle rate. Frames then start no more often than
+*   that, sleeping out the rest of their slot and reading input again once they wake, until
+*   the game reports input and wakes the pacer to the full rate for a while.
+*
+**********************************************************************************************/
+
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <stdbool.h>
+
+typedef enum
+{
+    FRAME_PACING_VSYNC = 0,
+    FRAME_PACING_UNCAPPED,
+    FRAME_PACING_LOW_LATENCY,
+    FRAME_PACING_COUNT
+}FramePacingMode;
+
+typedef struct
+{
+    FramePacingMode mode;
+    bool lateLatch;                 // read the mouse again right before the 3D pass
+    double refreshPeriod;           // seconds
+
+    double frameStart;              // when the last swap returned
+    double sampleTime;              // when the input of the frame in flight was read
+    double lastSampleTime;
+    double delay;                   // low latency sleep after the swap
+    int fastFrames;                 // frames in a row shorter than the display allows
+    bool limiterFallback;
+
+    int idleRate;                   // frames per second while idle, 0 for no limit
+    double wakeUntil;               // full rate until then
+
+    float inputToPhotonMs;          // smoothed estimate
+}FramePacer;
+
+// a refresh rate of 0 or less means 60
+void InitFramePacer(FramePacer* pacer, int refreshRate, FramePacingMode mode);
+void SetFramePacingMode(FramePacer* pacer, FramePacingMode mode);
+const char* GetFramePacingModeName(FramePacingMode mode);
+
+// call first thing every frame, before any input is read. sleeps in the low latency mode
+void BeginFramePacing(FramePacer* pacer);
+
+// limit frames to fps while the pacer is not woken, 0 turns the limit off
+void SetFramePacerIdleRate(FramePacer* pacer, int fps);
+
+// run at the full rate for the next seconds, when input may change the picture
+void WakeFramePacer(FramePacer* pacer, double seconds);
+
+// true while frames are limited to the idle rate
+bool IsFramePacerIdle(const FramePacer* pacer);
+
+// fetch the input events that arrived since the last read, for late latching. the estimate
+// follows the latest read of a frame. a key pressed in this poll is already held when the next
+// frame reads input, so IsKeyPressed never sees it: callers compare IsKeyDown around the call
+void PollLateInput(FramePacer* pacer);
+
+#endif //FRAME_PACER_H
@@ -0,0 +1,403 @@
+/**********************************************************************************************
+*
+*   RockyRoad * Ghost * Compact per-tick recording of runs to race against
+*
+**********************************************************************************************/
+
+#include "Ghost.h"
+#include "Arena.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GHOST_MAGIC 0x48475252u             // "RRGH"
+#define GHOST_VERSION 1
+
+#define POSITION_SCALE 256.0f               // fixed point steps per unit
+#define ANGLE_SCALE 4096.0f                 // fixed point steps per radian
+#define POSITION_TOLERANCE 16               // 1/16 of a unit
+#define ANGLE_TOLERANCE 32                  // about half a degree
+#define FIRST_ANGLE_CHANNEL 3
+
+#define CONTROL_GRAPPLING 0x20
+#define CONTROL_GRAPPLE_HIT 0x40
+#define CONTROL_RUN 0x80
+#define CONTROL_LEVEL 0xc0
+#define MAX_RUN 64
+
+#define INITIAL_CAPACITY 16384
+#define MAX_TICK_BYTES 112                  // level marker, control byte and twenty 5 byte varints
+
+typedef struct
+{
+    unsigned int magic;
+    unsigned int version;
+    int tickCount;
+    int size;
+}GhostHeader;
+
+static const float channelScales[GHOST_CHANNELS] = {POSITION_SCALE, POSITION_SCALE, POSITION_SCALE, ANGLE_SCALE, ANGLE_SCALE};
+static const int channelTolerances[GHOST_CHANNELS] = {POSITION_TOLERANCE, POSITION_TOLERANCE, POSITION_TOLERANCE, ANGLE_TOLERANCE, ANGLE_TOLERANCE};
+
+static int ToFixed(float value, float scale)
+{
+    return (int)lroundf(value*scale);
+}
+
+static bool ReserveGhostBytes(GhostRecorder* recorder, int count)
+{
+    GhostTrack *track = &recorder->track;
+    if (track->size + count <= recorder->capacity)
+        return true;
+
+    int capacity = (recorder->capacity > 0)? recorder->capacity*2 : INITIAL_CAPACITY;
+    unsigned char *bytes = (unsigned char*)GameHeapAlloc(capacity);
+    if (bytes == NULL)
+        return false;
+
+    if (track->size > 0)
+        memcpy(bytes, track->bytes, track->size);
+    GameHeapFree(track->bytes);
+    track->bytes = bytes;
+    recorder->capacity = capacity;
+    return true;
+}
+
+static void WriteVarint(GhostTrack* track, int value)
+{
+    // zigzag keeps small negative values small
+    unsigned int bits = ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+    while (bits >= 0x80)
+    {
+        track->bytes[track->size++] = (unsigned char)(bits | 0x80);
+        bits >>= 7;
+    }
+    track->bytes[track->size++] = (unsigned char)bits;
+}
+
+static bool ReadVarint(GhostPlayer* player, int* value)
+{
+    unsigned int bits = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (player->cursor >= player->track->size)
+            return false;
+
+        unsigned char byte = player->track->bytes[player->cursor++];
+        bits |= (unsigned int)(byte & 0x7f) << shift;
+        if (byte < 0x80)
+        {
+            *value = (int)(bits >> 1) ^ -(int)(bits & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+// bytes the pending run takes once written
+static int GetPendingRunBytes(const GhostRecorder* recorder)
+{
+    return (recorder->pendingRun + MAX_RUN - 1)/MAX_RUN;
+}
+
+// the caller reserves GetPendingRunBytes first
+static void FlushGhostRun(GhostRecorder* recorder)
+{
+    while (recorder->pendingRun > 0)
+    {
+        int run = (recorder->pendingRun < MAX_RUN)? recorder->pendingRun : MAX_RUN;
+        recorder->track.bytes[recorder->track.size++] = (unsigned char)(CONTROL_RUN | (run - 1));
+        recorder->pendingRun -= run;
+    }
+}
+
+// move every channel one tick along its velocity and acceleration
+static void AdvancePredictor(GhostPredictor* predictor)
+{
+    for (int c = 0; c < GHOST_CHANNELS; c++)
+    {
+        predictor->velocity[c] += predictor->acceleration[c];
+        predictor->value[c] += predictor->velocity[c];
+    }
+}
+
+void BeginGhostRecording(GhostRecorder* recorder)
+{
+    GhostTrack track = recorder->track;
+    int capacity = recorder->capacity;
+    memset(recorder, 0, sizeof(GhostRecorder));
+    recorder->track.bytes = track.bytes;
+    recorder->capacity = capacity;
+}
+
+void RecordGhostTick(GhostRecorder* recorder, const GhostFrame* frame)
+{
+    if (!ReserveGhostBytes(recorder, GetPendingRunBytes(recorder) + MAX_TICK_BYTES))
+        return;
+
+    GhostTrack *track = &recorder->track;
+    if (frame->level != recorder->level)
+    {
+        FlushGhostRun(recorder);
+        track->bytes[track->size++] = CONTROL_LEVEL;
+        WriteVarint(track, frame->level);
+        recorder->level = frame->level;
+    }
+
+    // a channel is only corrected once the reader's guess drifts past the tolerance. the
+    // correction puts it exactly where it is and moving like it does, so errors never
+    // build up and the next one comes late
+    GhostPredictor *predictor = &recorder->predictor;
+    float values[GHOST_CHANNELS] = {frame->position.x, frame->position.y, frame->position.z, frame->viewAngles.x, frame->viewAngles.y};
+    int corrections[GHOST_CHANNELS][3] = { 0 };
+    unsigned char control = 0;
+    AdvancePredictor(predictor);
+    for (int c = 0; c < GHOST_CHANNELS; c++)
+    {
+        float scale = channelScales[c];
+        int target = ToFixed(values[c], scale);
+        if (abs(target - predictor->value[c]) > channelTolerances[c])
+        {
+            // the view follows the mouse and is noisy, it gets a velocity over two ticks
+            // and no acceleration
+            int velocity = ToFixed(values[c] - recorder->history[0][c], scale);
+            int acceleration = ToFixed(values[c] - 2.0f*recorder->history[0][c] + recorder->history[1][c], scale);
+            if (c >= FIRST_ANGLE_CHANNEL)
+            {
+                velocity = ToFixed(0.5f*(values[c] - recorder->history[1][c]), scale);
+                acceleration = 0;
+            }
+            corrections[c][0] = target - predictor->value[c];
+            corrections[c][1] = velocity - predictor->velocity[c];
+            corrections[c][2] = acceleration - predictor->acceleration[c];
+            predictor->value[c] = target;
+            predictor->velocity[c] = velocity;
+            predictor->acceleration[c] = acceleration;
+            control |= (unsigned char)(1 << c);
+        }
+        recorder->history[1][c] = recorder->history[0][c];
+        recorder->history[0][c] = values[c];
+    }
+
+    int hit[3] = { 0 };
+    bool newHit = false;
+    if (frame->grappling)
+    {
+        hit[0] = ToFixed(frame->grappleHit.x, POSITION_SCALE);
+        hit[1] = ToFixed(frame->grappleHit.y, POSITION_SCALE);
+        hit[2] = ToFixed(frame->grappleHit.z, POSITION_SCALE);
+        newHit = !recorder->grappling || memcmp(hit, recorder->grappleHit, sizeof(hit)) != 0;
+    }
+    if (frame->grappling) control |= CONTROL_GRAPPLING;
+    if (newHit) control |= CONTROL_GRAPPLE_HIT;
+    track->tickCount++;
+
+    if (control == 0 && !recorder->grappling)
+    {
+        recorder->pendingRun++;
+        return;
+    }
+    if (control == CONTROL_GRAPPLING && recorder->grappling)
+    {
+        recorder->pendingRun++;
+        return;
+    }
+
+    FlushGhostRun(recorder);
+    track->bytes[track->size++] = control;
+    for (int c = 0; c < GHOST_CHANNELS; c++)
+    {
+        if (!(control & (1 << c)))
+            continue;
+        for (int i = 0; i < 3; i++)
+            WriteVarint(track, corrections[c][i]);
+    }
+    if (newHit)
+    {
+        for (int i = 0; i < 3; i++)
+            WriteVarint(track, hit[i] - predictor->value[i]);
+        memcpy(recorder->grappleHit, hit, sizeof(hit));
+    }
+    recorder->grappling = frame->grappling;
+}
+
+GhostTrack FinishGhostRecording(GhostRecorder* recorder)
+{
+    GhostTrack track = { 0 };
+    if (!ReserveGhostBytes(recorder, GetPendingRunBytes(recorder)))
+        return track;
+
+    FlushGhostRun(recorder);
+    if (recorder->track.size == 0)
+        return track;
+
+    track.bytes = (unsigned char*)GameHeapAlloc(recorder->track.size);
+    if (track.bytes == NULL)
+        return track;
+
+    memcpy(track.bytes, recorder->track.bytes, recorder->track.size);
+    track.size = recorder->track.size;
+    track.tickCount = recorder->track.tickCount;
+    return track;
+}
+
+void UnloadGhostRecorder(GhostRecorder* recorder)
+{
+    GameHeapFree(recorder->track.bytes);
+    memset(recorder, 0, sizeof(GhostRecorder));
+}
+
+bool SaveGhostTrack(const char* fileName, GhostTrack track)
+{
+    if (track.size <= 0)
+        return false;
+
+    GhostHeader header = { GHOST_MAGIC, GHOST_VERSION, track.tickCount, track.size };
+    FILE *file = fopen(fileName, "wb");
+    bool written = file != NULL &&
+                   fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(track.bytes, 1, track.size, file) == (size_t)track.size;
+    if (file != NULL && fclose(file) != 0)
+        written = false;
+    if (!written)
+        TraceLog(LOG_WARNING, "GHOST: Could not write %s", fileName);
+    else
+        TraceLog(LOG_INFO, "GHOST: Wrote %s, %i ticks in %i bytes", fileName, track.tickCount, track.size);
+
+    return written;
+}
+
+GhostTrack LoadGhostTrack(const char* fileName)
+{
+    GhostTrack track = { 0 };
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL)
+        return track;
+
+    GhostHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != GHOST_MAGIC || header.version != GHOST_VERSION ||
+        header.tickCount <= 0 || header.size <= 0)
+    {
+        TraceLog(LOG_WARNING, "GHOST: %s is not a ghost of this version", fileName);
+        fclose(file);
+        return track;
+    }
+
+    track.bytes = (unsigned char*)GameHeapAlloc(header.size);
+    if (track.bytes != NULL && fread(track.bytes, 1, header.size, file) == (size_t)header.size)
+    {
+        track.size = header.size;
+        track.tickCount = header.tickCount;
+        TraceLog(LOG_INFO, "GHOST: Loaded %s, %i ticks in %i bytes", fileName, track.tickCount, track.size);
+    }
+    else
+    {
+        TraceLog(LOG_WARNING, "GHOST: Could not read %s", fileName);
+        GameHeapFree(track.bytes);
+        track.bytes = NULL;
+    }
+
+    fclose(file);
+    return track;
+}
+
+void UnloadGhostTrack(GhostTrack* track)
+{
+    GameHeapFree(track->bytes);
+    track->bytes = NULL;
+    track->size = 0;
+    track->tickCount = 0;
+}
+
+void StartGhostPlayer(GhostPlayer* player, const GhostTrack* track)
+{
+    memset(player, 0, sizeof(GhostPlayer));
+    player->track = track;
+    player->finished = track->size <= 0;
+}
+
+static void DecodeGhostFrame(GhostPlayer* player)
+{
+    const GhostPredictor *predictor = &player->predictor;
+    GhostFrame *frame = &player->frame;
+    frame->position = (Vector3){predictor->value[0]/POSITION_SCALE, predictor->value[1]/POSITION_SCALE, predictor->value[2]/POSITION_SCALE};
+    frame->viewAngles = (Vector2){predictor->value[3]/ANGLE_SCALE, predictor->value[4]/ANGLE_SCALE};
+    frame->grappleHit = (Vector3){player->grappleHit[0]/POSITION_SCALE, player->grappleHit[1]/POSITION_SCALE, player->grappleHit[2]/POSITION_SCALE};
+}
+
+bool StepGhostPlayer(GhostPlayer* player)
+{
+    if (player->finished)
+        return false;
+
+    if (player->run > 0)
+    {
+        player->run--;
+        AdvancePredictor(&player->predictor);
+        DecodeGhostFrame(player);
+        return true;
+    }
+
+    const GhostTrack *track = player->track;
+    while (player->cursor < track->size)
+    {
+        unsigned char control = track->bytes[player->cursor++];
+        if (control == CONTROL_LEVEL)
+        {
+            if (!ReadVarint(player, &player->frame.level))
+                break;
+            continue;
+        }
+        if (control > CONTROL_LEVEL)
+            break;
+
+        if (control & CONTROL_RUN)
+        {
+            player->run = control & (MAX_RUN - 1);
+            AdvancePredictor(&player->predictor);
+            DecodeGhostFrame(player);
+            return true;
+        }
+
+        GhostPredictor *predictor = &player->predictor;
+        AdvancePredictor(predictor);
+        for (int c = 0; c < GHOST_CHANNELS; c++)
+        {
+            if (!(control & (1 << c)))
+                continue;
+
+            int corrections[3];
+            if (!ReadVarint(player, &corrections[0]) || !ReadVarint(player, &corrections[1]) || !ReadVarint(player, &corrections[2]))
+            {
+                player->finished = true;
+                return false;
+            }
+            predictor->value[c] += corrections[0];
+            predictor->velocity[c] += corrections[1];
+            predictor->acceleration[c] += corrections[2];
+        }
+
+        player->frame.grappling = (control & CONTROL_GRAPPLING) != 0;
+        if (control & CONTROL_GRAPPLE_HIT)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                int offset = 0;
+                if (!ReadVarint(player, &offset))
+                {
+                    player->finished = true;
+                    return false;
+                }
+                player->grappleHit[i] = predictor->value[i] + offset;
+            }
+        }
+        DecodeGhostFrame(player);
+        return true;
+    }
+
+    // past the end or a control byte this version does not know
+    player->finished = true;
+    return false;
+}
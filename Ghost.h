@@ -0,0 +1,101 @@
+/**********************************************************************************************
+*
+*   RockyRoad * Ghost * Compact per-tick recording of runs to race against
+*
+*   A ghost track holds the player's position, view angles and grapple every SimSession
+*   tick. Values are stored in fixed point and every channel is dead reckoned: the reader
+*   keeps moving a channel with its last velocity and acceleration, and the recorder only
+*   writes a correction when that guess drifts further than the channel's tolerance. Steady
+*   running, falling and turning cost next to nothing, ticks without corrections collapse
+*   into runs, and a full run through all levels stays a few kilobytes.
+*
+*   Stream layout, one control byte at a time:
+*       0x00-0x7f   one tick. bits 0-4 flag a correction for x, y, z, yaw and pitch, three
+*                   zigzag varints for value, velocity and acceleration each. bit 5 is the
+*                   grapple state, bit 6 is followed by the grapple hit as three varints
+*                   relative to the new position
+*       0x80-0xbf   1 to 64 ticks without corrections or grapple changes
+*       0xc0        the following ticks play in the level given by a varint
+*
+**********************************************************************************************/
+
+#ifndef GHOST_H
+#define GHOST_H
+
+#include "raylib.h"
+
+#define GHOST_CHANNELS 5
+
+// state of one tick, what a ghost shows
+typedef struct
+{
+    int level;
+    Vector3 position;               // SimSession position, the base of the player
+    Vector2 viewAngles;
+    bool grappling;
+    Vector3 grappleHit;
+}GhostFrame;
+
+typedef struct
+{
+    unsigned char* bytes;
+    int size;
+    int tickCount;
+}GhostTrack;
+
+// reconstructed fixed point value, per tick velocity and acceleration of every channel
+typedef struct
+{
+    int value[GHOST_CHANNELS];
+    int velocity[GHOST_CHANNELS];
+    int acceleration[GHOST_CHANNELS];
+}GhostPredictor;
+
+typedef struct
+{
+    GhostTrack track;               // grows while recording
+    int capacity;
+    GhostPredictor predictor;
+    float history[2][GHOST_CHANNELS];   // exact values of the last two ticks
+    int pendingRun;                 // ticks without corrections not written yet
+    int level;
+    bool grappling;
+    int grappleHit[3];
+}GhostRecorder;
+
+typedef struct
+{
+    const GhostTrack* track;
+    int cursor;
+    int run;                        // ticks left of the current run
+    GhostPredictor predictor;
+    int grappleHit[3];
+    GhostFrame frame;
+    bool finished;
+}GhostPlayer;
+
+// start a new recording, the buffer of an earlier one is reused
+void BeginGhostRecording(GhostRecorder* recorder);
+
+// append one tick
+void RecordGhostTick(GhostRecorder* recorder, const GhostFrame* frame);
+
+// copy of everything recorded since BeginGhostRecording, unload it with UnloadGhostTrack
+GhostTrack FinishGhostRecording(GhostRecorder* recorder);
+
+void UnloadGhostRecorder(GhostRecorder* recorder);
+
+bool SaveGhostTrack(const char* fileName, GhostTrack track);
+
+// empty track when the file is missing or not a ghost
+GhostTrack LoadGhostTrack(const char* fileName);
+
+void UnloadGhostTrack(GhostTrack* track);
+
+// play a track from its first tick, the track has to outlive the player
+void StartGhostPlayer(GhostPlayer* player, const GhostTrack* track);
+
+// advance to the next tick and decode it into player->frame, false once the track is over
+bool StepGhostPlayer(GhostPlayer* player);
+
+#endif //GHOST_H
@@ -0,0 +1,352 @@
+/**********************************************************************************************
+*
+*   RockyRoad * JobSystem * Work-stealing job scheduler
+*
+*   Deques follow Chase and Lev: the owner pushes and pops at the bottom without locking,
+*   thieves take from the top with a single compare and swap. Jobs are stored by value in the
+*   deque ring, so queueing work never allocates.
+*
+**********************************************************************************************/
+
+#include "JobSystem.h"
+#include "raylib.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#define MAX_JOB_WORKERS 31
+#define JOB_DEQUE_SIZE 1024                 // must be a power of two
+#define JOB_DEQUE_MASK (JOB_DEQUE_SIZE - 1)
+#define JOB_SPIN_COUNT 64                   // failed fetches before a worker goes to sleep
+#define JOB_BATCHES_PER_THREAD 4            // ParallelFor oversubscription for load balancing
+
+typedef struct
+{
+    JobFunc func;
+    ParallelForFunc rangeFunc;
+    void *data;
+    JobCounter* counter;
+    int start;
+    int end;
+}Job;
+
+typedef struct
+{
+    // top and bottom are written by different threads, keep them on separate cache lines
+    volatile long long top;
+    char padTop[56];
+    volatile long long bottom;
+    char padBottom[56];
+    Job jobs[JOB_DEQUE_SIZE];
+}JobDeque;
+
+static JobDeque* deques = NULL;
+static pthread_t workerThreads[MAX_JOB_WORKERS];
+static int workerCount = 0;
+static volatile int running = 0;
+
+// jobs sitting in any deque, lets idle workers sleep instead of spinning
+static volatile int queuedJobs = 0;
+static volatile int sleepingWorkers = 0;
+static pthread_mutex_t sleepLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sleepCond = PTHREAD_COND_INITIALIZER;
+
+// index of the deque owned by the calling thread, the main thread owns deque 0
+static __thread int workerIndex = 0;
+static __thread unsigned int stealSeed = 0;
+
+static int GetCoreCount(void)
+{
+#if defined(_WIN32)
+    return pthread_num_processors_np();
+#else
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores > 0)? (int)cores : 1;
+#endif
+}
+
+// owner only
+static bool PushJob(JobDeque* deque, const Job* job)
+{
+    long long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    long long top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+
+    if (bottom - top >= JOB_DEQUE_SIZE)
+        return false;
+
+    deque->jobs[bottom & JOB_DEQUE_MASK] = *job;
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// owner only
+static bool PopJob(JobDeque* deque, Job* job)
+{
+    long long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long long top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+
+    if (top > bottom)
+    {
+        // deque was already empty
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    *job = deque->jobs[bottom & JOB_DEQUE_MASK];
+    if (top != bottom)
+        return true;
+
+    // last job left, race the thieves for it
+    bool won = __atomic_compare_exchange_n(&deque->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    return won;
+}
+
+// any thread
+static bool StealJob(JobDeque* deque, Job* job)
+{
+    long long top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+
+    if (top >= bottom)
+        return false;
+
+    // copy before claiming, the slot can only be reused once top has moved past it
+    *job = deque->jobs[top & JOB_DEQUE_MASK];
+    return __atomic_compare_exchange_n(&deque->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+static bool FetchJob(Job* job)
+{
+    if (PopJob(&deques[workerIndex], job))
+    {
+        __atomic_sub_fetch(&queuedJobs, 1, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    // start at a random victim so thieves do not all hammer the same deque
+    stealSeed = stealSeed*1103515245u + 12345u;
+    int victim = (int)((stealSeed >> 16) % (unsigned int)(workerCount + 1));
+
+    for (int i = 0; i <= workerCount; i++)
+    {
+        int index = (victim + i) % (workerCount + 1);
+        if (index != workerIndex && StealJob(&deques[index], job))
+        {
+            __atomic_sub_fetch(&queuedJobs, 1, __ATOMIC_RELAXED);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void ExecuteJob(const Job* job)
+{
+    if (job->rangeFunc != NULL)
+        job->rangeFunc(job->data, job->start, job->end);
+    else
+        job->func(job->data);
+
+    if (job->counter != NULL)
+        __atomic_sub_fetch(&job->counter->pending, 1, __ATOMIC_RELEASE);
+}
+
+static void WakeWorkers(void)
+{
+    if (__atomic_load_n(&sleepingWorkers, __ATOMIC_SEQ_CST) == 0)
+        return;
+
+    pthread_mutex_lock(&sleepLock);
+    pthread_cond_broadcast(&sleepCond);
+    pthread_mutex_unlock(&sleepLock);
+}
+
+static void SubmitJob(const Job* job)
+{
+    if (job->counter != NULL)
+        __atomic_add_fetch(&job->counter->pending, 1, __ATOMIC_RELAXED);
+
+    if (workerCount == 0)
+    {
+        ExecuteJob(job);
+        return;
+    }
+
+    // counted before it is published, a worker can take it and count it down right away
+    __atomic_add_fetch(&queuedJobs, 1, __ATOMIC_SEQ_CST);
+    if (!PushJob(&deques[workerIndex], job))
+    {
+        // our deque is full, just do the work now
+        __atomic_sub_fetch(&queuedJobs, 1, __ATOMIC_SEQ_CST);
+        ExecuteJob(job);
+        return;
+    }
+
+    WakeWorkers();
+}
+
+static void *JobWorkerMain(void *arg)
+{
+    workerIndex = (int)(intptr_t)arg;
+    stealSeed = (unsigned int)workerIndex*2654435761u;
+
+    int idle = 0;
+    while (__atomic_load_n(&running, __ATOMIC_ACQUIRE))
+    {
+        Job job;
+        if (FetchJob(&job))
+        {
+            ExecuteJob(&job);
+            idle = 0;
+        }
+        else if (++idle < JOB_SPIN_COUNT)
+        {
+            sched_yield();
+        }
+        else
+        {
+            pthread_mutex_lock(&sleepLock);
+            __atomic_add_fetch(&sleepingWorkers, 1, __ATOMIC_SEQ_CST);
+            while (__atomic_load_n(&running, __ATOMIC_ACQUIRE) && __atomic_load_n(&queuedJobs, __ATOMIC_SEQ_CST) == 0)
+                pthread_cond_wait(&sleepCond, &sleepLock);
+            __atomic_sub_fetch(&sleepingWorkers, 1, __ATOMIC_SEQ_CST);
+            pthread_mutex_unlock(&sleepLock);
+            idle = 0;
+        }
+    }
+
+    return NULL;
+}
+
+void InitJobSystem(int count)
+{
+    if (deques != NULL)
+        return;
+
+    if (count <= 0)
+        count = GetCoreCount() - 1;
+    if (count > MAX_JOB_WORKERS)
+        count = MAX_JOB_WORKERS;
+    if (count < 0)
+        count = 0;
+
+    deques = (JobDeque*)calloc(count + 1, sizeof(JobDeque));
+    if (deques == NULL)
+        return;
+
+    // workers read the count while stealing, so it is fixed before any of them starts
+    workerIndex = 0;
+    running = 1;
+    workerCount = count;
+    for (int i = 0; i < count; i++)
+    {
+        if (pthread_create(&workerThreads[i], NULL, JobWorkerMain, (void *)(intptr_t)(i + 1)) != 0)
+        {
+            TraceLog(LOG_WARNING, "JOBS: Failed to start worker thread %i, running jobs inline", i + 1);
+            __atomic_store_n(&running, 0, __ATOMIC_RELEASE);
+            pthread_mutex_lock(&sleepLock);
+            pthread_cond_broadcast(&sleepCond);
+            pthread_mutex_unlock(&sleepLock);
+            for (int j = 0; j < i; j++)
+                pthread_join(workerThreads[j], NULL);
+            workerCount = 0;
+            return;
+        }
+    }
+
+    TraceLog(LOG_INFO, "JOBS: Started %i worker threads", workerCount);
+}
+
+void CloseJobSystem(void)
+{
+    if (deques == NULL)
+        return;
+
+    __atomic_store_n(&running, 0, __ATOMIC_RELEASE);
+
+    pthread_mutex_lock(&sleepLock);
+    pthread_cond_broadcast(&sleepCond);
+    pthread_mutex_unlock(&sleepLock);
+
+    for (int i = 0; i < workerCount; i++)
+        pthread_join(workerThreads[i], NULL);
+
+    free(deques);
+    deques = NULL;
+    workerCount = 0;
+    queuedJobs = 0;
+}
+
+int GetJobWorkerCount(void)
+{
+    return workerCount;
+}
+
+void RunJob(JobFunc func, void *data, JobCounter* counter)
+{
+    Job job = { func, NULL, data, counter, 0, 0 };
+
+    if (deques == NULL)
+    {
+        func(data);
+        return;
+    }
+
+    SubmitJob(&job);
+}
+
+void WaitForJobs(JobCounter* counter)
+{
+    if (counter == NULL)
+        return;
+
+    while (__atomic_load_n(&counter->pending, __ATOMIC_ACQUIRE) > 0)
+    {
+        Job job;
+        if (deques != NULL && FetchJob(&job))
+            ExecuteJob(&job);
+        else
+            sched_yield();
+    }
+}
+
+void ParallelFor(int count, int minBatch, ParallelForFunc func, void *data)
+{
+    if (count <= 0)
+        return;
+
+    if (minBatch < 1)
+        minBatch = 1;
+
+    int batches = (workerCount + 1)*JOB_BATCHES_PER_THREAD;
+    if (batches > count/minBatch)
+        batches = count/minBatch;
+
+    if (deques == NULL || workerCount == 0 || batches < 2)
+    {
+        func(data, 0, count);
+        return;
+    }
+
+    int batchSize = (count + batches - 1)/batches;
+    JobCounter counter = { 0 };
+
+    for (int start = batchSize; start < count; start += batchSize)
+    {
+        Job job = { NULL, func, data, &counter, start, (start + batchSize < count)? start + batchSize : count };
+        SubmitJob(&job);
+    }
+
+    // the calling thread takes the first batch itself, then helps with the rest
+    func(data, 0, batchSize);
+    WaitForJobs(&counter);
+}
@@ -0,0 +1,49 @@
+/**********************************************************************************************
+*
+*   RockyRoad * JobSystem * Work-stealing job scheduler
+*
+*   Every worker thread owns a fixed size deque of jobs. A thread pushes and pops work at the
+*   bottom of its own deque while idle threads steal from the top of the others, so batches
+*   spread across all cores without a shared queue lock.
+*
+*   The main thread is worker 0: it can push jobs and it helps run them while it waits.
+*
+**********************************************************************************************/
+
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <stdbool.h>
+
+// a single unit of work
+typedef void (*JobFunc)(void *data);
+
+// a batch of iterations [start, end) from ParallelFor
+typedef void (*ParallelForFunc)(void *data, int start, int end);
+
+// counts the jobs still running for a group, wait on it with WaitForJobs
+typedef struct
+{
+    volatile int pending;
+}JobCounter;
+
+// start the worker threads, workerCount <= 0 uses one thread per extra core
+void InitJobSystem(int workerCount);
+
+// stop and join all worker threads
+void CloseJobSystem(void);
+
+// number of background worker threads (the main thread is not counted)
+int GetJobWorkerCount(void);
+
+// queue a job on the calling thread's deque, counter may be NULL
+void RunJob(JobFunc func, void *data, JobCounter* counter);
+
+// run queued jobs on the calling thread until the counter reaches zero
+void WaitForJobs(JobCounter* counter);
+
+// split [0, count) into batches of at least minBatch iterations and run them on all cores,
+// returns once every batch is done. Small counts run inline on the calling thread
+void ParallelFor(int count, int minBatch, ParallelForFunc func, void *data);
+
+#endif //JOB_SYSTEM_H
@@ -0,0 +1,276 @@
+/**********************************************************************************************
+*
+*   RockyRoad * LevelGen * Seeded course generation and reachability checks
+*
+**********************************************************************************************/
+
+#include "LevelGen.h"
+#include "JobSystem.h"
+#include "SimPhysics.h"
+
+#include <math.h>
+
+#define PLATFORM_HALF_SIZE 5.0f             // platforms are 10 x 1 x 10
+#define START_PLATFORM_Y -2.0f              // where the player lands at the start of every level
+#define GOAL_HEIGHT 5.0f                    // goal cube above the last platform, as in the hand-made levels
+#define SIGN_POSITION (Vector3){5, 0, 0}
+#define BOT_RUN_SPEED 20.0f                 // FPCamera move speed with sprint held
+#define BOT_HOP_FRAMES 600                  // give up on a hop after ten seconds
+#define DEATH_HEIGHT -90.0f
+
+// the bot first tries to jump from close to the edge, then from further in for high targets
+static const float takeoffMargins[] = {0.5f, 1.5f, 3.0f};
+
+typedef struct
+{
+    const LevelGenParams* params;
+    unsigned long long firstSeed;
+    CourseCandidate* results;
+}VetWork;
+
+typedef struct
+{
+    float x;
+    float z;
+    SimBody body;
+}Bot;
+
+void SeedLevelRng(LevelRng* rng, unsigned long long seed)
+{
+    // splitmix64 spreads nearby seeds apart, xorshift cannot start from zero
+    unsigned long long z = seed + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27))*0x94d049bb133111ebULL;
+    rng->state = (z ^ (z >> 31)) | 1ULL;
+}
+
+unsigned int NextLevelRng(LevelRng* rng)
+{
+    // xorshift64*
+    unsigned long long x = rng->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    rng->state = x;
+    return (unsigned int)((x*0x2545f4914f6cdd1dULL) >> 32);
+}
+
+float GetLevelRngRange(LevelRng* rng, float min, float max)
+{
+    float unit = (float)(NextLevelRng(rng) >> 8)*(1.0f/16777215.0f);
+    return min + (max - min)*unit;
+}
+
+LevelGenParams GetDefaultLevelGenParams(int platformCount)
+{
+    LevelGenParams params = { 0 };
+    params.platformCount = platformCount;
+    params.minGap = 3.0f;
+    params.maxGap = 12.0f;
+    params.maxRise = 8.0f;
+    params.maxDrop = 12.0f;
+    params.maxSideStep = 4.0f;
+    params.minY = -70.0f;
+    params.maxY = 20.0f;
+    params.allowGrapple = true;
+    return params;
+}
+
+static Vector3 NextPlatform(LevelRng* rng, const LevelGenParams* params, Vector3 previous)
+{
+    Vector3 next = previous;
+    next.x += 2.0f*PLATFORM_HALF_SIZE + GetLevelRngRange(rng, params->minGap, params->maxGap);
+    next.y = fminf(fmaxf(previous.y + GetLevelRngRange(rng, -params->maxDrop, params->maxRise), params->minY), params->maxY);
+    next.z += GetLevelRngRange(rng, -params->maxSideStep, params->maxSideStep);
+    return next;
+}
+
+int GenerateCourse(const LevelGenParams* params, unsigned long long seed, CourseElement* out, int capacity)
+{
+    if (params->platformCount < 1 || capacity < params->platformCount + 2)
+        return 0;
+
+    LevelRng rng;
+    SeedLevelRng(&rng, seed);
+
+    Vector3 platform = {0, START_PLATFORM_Y, 0};
+    int count = 0;
+    out[count++] = (CourseElement){ COURSE_SIGN, 0, SIGN_POSITION };
+    out[count++] = (CourseElement){ COURSE_PLATFORM, 0, platform };
+    for (int i = 1; i < params->platformCount; i++)
+    {
+        platform = NextPlatform(&rng, params, platform);
+        out[count++] = (CourseElement){ COURSE_PLATFORM, 0, platform };
+    }
+    out[count++] = (CourseElement){ COURSE_GOAL, 0, {platform.x, platform.y + GOAL_HEIGHT, platform.z} };
+
+    return count;
+}
+
+static bool IsOverPlatform(float x, float z, Vector3 platform)
+{
+    return fabsf(x - platform.x) <= PLATFORM_HALF_SIZE && fabsf(z - platform.z) <= PLATFORM_HALF_SIZE;
+}
+
+static Bot PlaceBot(Vector3 platform)
+{
+    Bot bot = { 0 };
+    bot.x = platform.x;
+    bot.z = platform.z;
+    bot.body.y = GetSimGroundTop(platform.y) - 0.5f;
+    bot.body.grounded = true;
+    return bot;
+}
+
+// move the bot towards a point at running speed, true once it is there
+static bool MoveBot(Bot* bot, float x, float z)
+{
+    float dx = x - bot->x;
+    float dz = z - bot->z;
+    float distance = sqrtf(dx*dx + dz*dz);
+    float step = BOT_RUN_SPEED*SIM_FRAME_TIME;
+    if (distance <= step)
+    {
+        bot->x = x;
+        bot->z = z;
+        return true;
+    }
+    bot->x += dx/distance*step;
+    bot->z += dz/distance*step;
+    return false;
+}
+
+// one game frame of physics. like the game, the ground is probed once per frame from the
+// position the camera moved to. returns 1 when standing on to, 0 on from, -1 otherwise
+static int StepBotFrame(Bot* bot, Vector3 from, Vector3 to)
+{
+    int over = IsOverPlatform(bot->x, bot->z, to)? 1 : IsOverPlatform(bot->x, bot->z, from)? 0 : -1;
+    float groundTop = (over == 1)? GetSimGroundTop(to.y) : (over == 0)? GetSimGroundTop(from.y) : SIM_NO_GROUND;
+
+    for (int i = 0; i < SIM_STEPS_PER_FRAME; i++)
+        StepSimBody(&bot->body, groundTop);
+
+    return bot->body.grounded? over : -1;
+}
+
+static bool TryJump(Vector3 from, Vector3 to, float margin)
+{
+    float dx = to.x - from.x;
+    float dz = to.z - from.z;
+    float length = sqrtf(dx*dx + dz*dz);
+    if (length == 0.0f)
+        return false;
+    dx /= length;
+    dz /= length;
+
+    // distance from the centre to the edge of the square along the direction of the hop
+    float edge = PLATFORM_HALF_SIZE/fmaxf(fabsf(dx), fabsf(dz));
+    float takeoffX = from.x + dx*(edge - margin);
+    float takeoffZ = from.z + dz*(edge - margin);
+
+    Bot bot = PlaceBot(from);
+    int jumpFrame = -1;
+    for (int frame = 0; frame < BOT_HOP_FRAMES; frame++)
+    {
+        if (jumpFrame < 0)
+        {
+            if (MoveBot(&bot, takeoffX, takeoffZ) && bot.body.grounded)
+            {
+                SimAddForce(&bot.body, SIM_JUMP_FORCE);
+                jumpFrame = frame;
+            }
+        }
+        else
+        {
+            MoveBot(&bot, to.x, to.z);
+        }
+
+        int standingOn = StepBotFrame(&bot, from, to);
+        if (standingOn == 1)
+            return true;
+        if (GetSimCameraY(&bot.body) < DEATH_HEIGHT)
+            return false;
+        if (jumpFrame >= 0 && frame > jumpFrame + 1 && standingOn == 0)
+            return false;
+    }
+    return false;
+}
+
+static bool TryGrapple(Vector3 from, Vector3 to)
+{
+    // the game clamps grapple hits to the platform's height, aim at the top face
+    Vector3 hit = {to.x, to.y + 0.5f, to.z};
+
+    Bot bot = PlaceBot(from);
+    for (int frame = 0; frame < BOT_HOP_FRAMES; frame++)
+    {
+        // same pull as the game: atan of the offset, sideways per frame and as a vertical force
+        float moveX = atanf(hit.x - bot.x);
+        float moveY = atanf(hit.y - GetSimCameraY(&bot.body));
+        float moveZ = atanf(hit.z - bot.z);
+        bot.x += moveX;
+        bot.z += moveZ;
+        SimAddForce(&bot.body, -moveY*SIM_GRAPPLE_PULL);
+
+        int standingOn = StepBotFrame(&bot, from, to);
+        if (standingOn == 1)
+            return true;
+        if (GetSimCameraY(&bot.body) < DEATH_HEIGHT)
+            return false;
+    }
+    return false;
+}
+
+HopResult SimulateHop(Vector3 from, Vector3 to, bool allowGrapple)
+{
+    for (int i = 0; i < (int)(sizeof(takeoffMargins)/sizeof(takeoffMargins[0])); i++)
+    {
+        if (TryJump(from, to, takeoffMargins[i]))
+            return HOP_JUMP;
+    }
+
+    if (allowGrapple && TryGrapple(from, to))
+        return HOP_GRAPPLE;
+
+    return HOP_UNREACHABLE;
+}
+
+CourseCandidate ValidateCourseSeed(const LevelGenParams* params, unsigned long long seed)
+{
+    CourseCandidate candidate = { seed, true, -1, 0 };
+
+    // the same sequence GenerateCourse produces, two platforms at a time
+    LevelRng rng;
+    SeedLevelRng(&rng, seed);
+    Vector3 platform = {0, START_PLATFORM_Y, 0};
+    for (int i = 1; i < params->platformCount; i++)
+    {
+        Vector3 next = NextPlatform(&rng, params, platform);
+        HopResult hop = SimulateHop(platform, next, params->allowGrapple);
+        if (hop == HOP_UNREACHABLE)
+        {
+            candidate.valid = false;
+            candidate.failedPlatform = i;
+            break;
+        }
+        if (hop == HOP_GRAPPLE)
+            candidate.grappleHops++;
+        platform = next;
+    }
+
+    return candidate;
+}
+
+static void VetSeedRange(void* data, int start, int end)
+{
+    VetWork *work = (VetWork*)data;
+
+    for (int i = start; i < end; i++)
+        work->results[i] = ValidateCourseSeed(work->params, work->firstSeed + (unsigned long long)i);
+}
+
+void VetCourseSeeds(const LevelGenParams* params, unsigned long long firstSeed, int count, CourseCandidate* results)
+{
+    VetWork work = { params, firstSeed, results };
+    ParallelFor(count, 1, VetSeedRange, &work);
+}
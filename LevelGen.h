@@ -0,0 +1,85 @@
+/**********************************************************************************************
+*
+*   RockyRoad * LevelGen * Seeded course generation and reachability checks
+*
+*   A course is a chain of platforms along +x. Every platform is placed relative to the one
+*   before it from a small seeded generator, so a seed and the parameters are the whole course
+*   and any length can be produced or checked without storing it.
+*
+*   A course is valid when a bot can reach every platform from the previous one through
+*   SimPhysics: sprinting off the edge and jumping, or pulling itself over with the grapple
+*   when that is allowed. Checking only needs two platforms at a time, so seeds are vetted
+*   without ever holding a course in memory and many of them are vetted at once with
+*   ParallelFor.
+*
+**********************************************************************************************/
+
+#ifndef LEVEL_GEN_H
+#define LEVEL_GEN_H
+
+#include "raylib.h"
+#include "CourseStream.h"
+
+typedef struct
+{
+    unsigned long long state;
+}LevelRng;
+
+typedef struct
+{
+    int platformCount;
+
+    // free space between the edges of consecutive platforms along x
+    float minGap;
+    float maxGap;
+
+    // height and sideways change from one platform to the next
+    float maxRise;
+    float maxDrop;
+    float maxSideStep;
+
+    // platforms stay in this height band, well above the death plane
+    float minY;
+    float maxY;
+
+    bool allowGrapple;
+}LevelGenParams;
+
+typedef enum
+{
+    HOP_UNREACHABLE = 0,
+    HOP_JUMP,
+    HOP_GRAPPLE
+}HopResult;
+
+typedef struct
+{
+    unsigned long long seed;
+    bool valid;
+    int failedPlatform;             // first platform the bot could not reach, -1 when valid
+    int grappleHops;
+}CourseCandidate;
+
+void SeedLevelRng(LevelRng* rng, unsigned long long seed);
+unsigned int NextLevelRng(LevelRng* rng);
+
+// uniform in [min, max]
+float GetLevelRngRange(LevelRng* rng, float min, float max);
+
+// parameters matching the spacing of the hand-made levels
+LevelGenParams GetDefaultLevelGenParams(int platformCount);
+
+// platforms, the start sign and the goal of a seed. returns the number of elements written,
+// platformCount + 2, or 0 when capacity is too small
+int GenerateCourse(const LevelGenParams* params, unsigned long long seed, CourseElement* out, int capacity);
+
+// how a bot standing on the platform centred at from gets onto the one centred at to
+HopResult SimulateHop(Vector3 from, Vector3 to, bool allowGrapple);
+
+// generate and check one seed
+CourseCandidate ValidateCourseSeed(const LevelGenParams* params, unsigned long long seed);
+
+// check count seeds starting at firstSeed across all cores, one result per seed
+void VetCourseSeeds(const LevelGenParams* params, unsigned long long firstSeed, int count, CourseCandidate* results);
+
+#endif //LEVEL_GEN_H
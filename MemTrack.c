@@ -0,0 +1,307 @@
+/**********************************************************************************************
+*
+*   RockyRoad * MemTrack * CPU and GPU memory accounting
+*
+**********************************************************************************************/
+
+#include "MemTrack.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#define MEM_TRACK_MAX_RECORDS 1024
+#define MEM_TRACK_NAME_LENGTH 48
+
+typedef struct
+{
+    MemCategory category;
+    unsigned long long key;
+    size_t size;
+    int refs;
+    char name[MEM_TRACK_NAME_LENGTH];
+}MemRecord;
+
+static const char *categoryNames[MEM_CATEGORY_COUNT] = {
+    "level", "frame", "mesh data", "heap", "textures", "meshes", "shaders", "framebuffers"
+};
+
+// records are kept packed, removal swaps the last one into the hole
+static MemRecord records[MEM_TRACK_MAX_RECORDS];
+static int recordCount = 0;
+static size_t categoryBytes[MEM_CATEGORY_COUNT] = { 0 };
+static int categoryCounts[MEM_CATEGORY_COUNT] = { 0 };
+static bool tableFullReported = false;
+
+// the streaming and audio threads load resources too
+static pthread_mutex_t trackLock = PTHREAD_MUTEX_INITIALIZER;
+
+static int FindRecord(MemCategory category, unsigned long long key)
+{
+    for (int i = 0; i < recordCount; i++)
+    {
+        if (records[i].key == key && records[i].category == category)
+            return i;
+    }
+
+    return -1;
+}
+
+void TrackMemory(MemCategory category, unsigned long long key, size_t size, const char* name)
+{
+    if (key == 0 || category < 0 || category >= MEM_CATEGORY_COUNT)
+        return;
+
+    pthread_mutex_lock(&trackLock);
+
+    int index = FindRecord(category, key);
+    if (index >= 0)
+    {
+        records[index].refs++;
+    }
+    else if (recordCount < MEM_TRACK_MAX_RECORDS)
+    {
+        MemRecord *record = &records[recordCount++];
+        record->category = category;
+        record->key = key;
+        record->size = size;
+        record->refs = 1;
+        strncpy(record->name, (name != NULL)? name : "unnamed", MEM_TRACK_NAME_LENGTH - 1);
+        record->name[MEM_TRACK_NAME_LENGTH - 1] = '\0';
+
+        categoryBytes[category] += size;
+        categoryCounts[category]++;
+    }
+    else if (!tableFullReported)
+    {
+        tableFullReported = true;
+        TraceLog(LOG_WARNING, "MEMTRACK: Record table full, [%s] and later objects are not counted", name);
+    }
+
+    pthread_mutex_unlock(&trackLock);
+}
+
+void UntrackMemory(MemCategory category, unsigned long long key)
+{
+    if (key == 0)
+        return;
+
+    pthread_mutex_lock(&trackLock);
+
+    int index = FindRecord(category, key);
+    if (index >= 0 && --records[index].refs == 0)
+    {
+        categoryBytes[category] -= records[index].size;
+        categoryCounts[category]--;
+        records[index] = records[--recordCount];
+    }
+
+    pthread_mutex_unlock(&trackLock);
+}
+
+size_t GetTrackedBytes(MemCategory category)
+{
+    if (category < 0 || category >= MEM_CATEGORY_COUNT)
+        return 0;
+
+    pthread_mutex_lock(&trackLock);
+    size_t bytes = categoryBytes[category];
+    pthread_mutex_unlock(&trackLock);
+
+    return bytes;
+}
+
+int GetTrackedCount(MemCategory category)
+{
+    if (category < 0 || category >= MEM_CATEGORY_COUNT)
+        return 0;
+
+    pthread_mutex_lock(&trackLock);
+    int count = categoryCounts[category];
+    pthread_mutex_unlock(&trackLock);
+
+    return count;
+}
+
+const char *GetMemCategoryName(MemCategory category)
+{
+    if (category < 0 || category >= MEM_CATEGORY_COUNT)
+        return "unknown";
+
+    return categoryNames[category];
+}
+
+bool IsGpuMemCategory(MemCategory category)
+{
+    return category >= MEM_GPU_TEXTURE && category < MEM_CATEGORY_COUNT;
+}
+
+int LogMemoryLeaks(void)
+{
+    pthread_mutex_lock(&trackLock);
+
+    for (int i = 0; i < recordCount; i++)
+    {
+        TraceLog(LOG_WARNING, "MEMTRACK: Leaked %s [%s] id %llu, %i bytes, %i refs", categoryNames[records[i].category], records[i].name,
+                 records[i].key, (int)records[i].size, records[i].refs);
+    }
+
+    int leaks = recordCount;
+    pthread_mutex_unlock(&trackLock);
+
+    if (leaks == 0)
+        TraceLog(LOG_INFO, "MEMTRACK: No leaks");
+
+    return leaks;
+}
+
+static size_t GetTextureBytes(Texture2D texture)
+{
+    size_t size = (size_t)GetPixelDataSize(texture.width, texture.height, texture.format);
+
+    // a full mip chain adds a third on top of the base level
+    if (texture.mipmaps > 1)
+        size += size/3;
+
+    return size;
+}
+
+void TrackTexture(Texture2D texture, const char* name)
+{
+    TrackMemory(MEM_GPU_TEXTURE, texture.id, GetTextureBytes(texture), name);
+}
+
+void UntrackTexture(Texture2D texture)
+{
+    UntrackMemory(MEM_GPU_TEXTURE, texture.id);
+}
+
+Texture2D LoadTextureTracked(const char* fileName)
+{
+    Texture2D texture = LoadTexture(fileName);
+    TrackTexture(texture, fileName);
+    return texture;
+}
+
+void UnloadTextureTracked(Texture2D texture)
+{
+    UntrackTexture(texture);
+    UnloadTexture(texture);
+}
+
+static size_t GetMeshGpuBytes(Mesh mesh)
+{
+    size_t perVertex = 3*sizeof(float);
+
+    if (mesh.texcoords != NULL) perVertex += 2*sizeof(float);
+    if (mesh.texcoords2 != NULL) perVertex += 2*sizeof(float);
+    if (mesh.normals != NULL) perVertex += 3*sizeof(float);
+    if (mesh.tangents != NULL) perVertex += 4*sizeof(float);
+    if (mesh.colors != NULL) perVertex += 4*sizeof(unsigned char);
+
+    size_t size = perVertex*mesh.vertexCount;
+    if (mesh.indices != NULL)
+        size += 3*sizeof(unsigned short)*mesh.triangleCount;
+
+    return size;
+}
+
+static size_t GetMeshCpuBytes(Mesh mesh)
+{
+    // raylib keeps the CPU copy of every uploaded attribute, plus the animation buffers
+    size_t size = GetMeshGpuBytes(mesh);
+
+    if (mesh.animVertices != NULL) size += 3*sizeof(float)*mesh.vertexCount;
+    if (mesh.animNormals != NULL) size += 3*sizeof(float)*mesh.vertexCount;
+    if (mesh.boneIds != NULL) size += 4*sizeof(mesh.boneIds[0])*mesh.vertexCount;
+    if (mesh.boneWeights != NULL) size += 4*sizeof(float)*mesh.vertexCount;
+
+    return size;
+}
+
+void TrackMesh(Mesh mesh, const char* name)
+{
+    TrackMemory(MEM_GPU_MESH, mesh.vaoId, GetMeshGpuBytes(mesh), name);
+    TrackMemory(MEM_CPU_MESH, (unsigned long long)(size_t)mesh.vertices, GetMeshCpuBytes(mesh), name);
+}
+
+void UntrackMesh(Mesh mesh)
+{
+    UntrackMemory(MEM_GPU_MESH, mesh.vaoId);
+    UntrackMemory(MEM_CPU_MESH, (unsigned long long)(size_t)mesh.vertices);
+}
+
+void TrackModel(Model model, const char* name)
+{
+    for (int i = 0; i < model.meshCount; i++)
+        TrackMesh(model.meshes[i], name);
+}
+
+void UntrackModel(Model model)
+{
+    for (int i = 0; i < model.meshCount; i++)
+        UntrackMesh(model.meshes[i]);
+}
+
+Model LoadModelTracked(const char* fileName)
+{
+    Model model = LoadModel(fileName);
+    TrackModel(model, fileName);
+    return model;
+}
+
+void UnloadModelTracked(Model model)
+{
+    UntrackModel(model);
+    UnloadModel(model);
+}
+
+// only the maps rlpbr and the game actually bind
+static const int trackedMaps[] = {
+    MATERIAL_MAP_ALBEDO, MATERIAL_MAP_METALNESS, MATERIAL_MAP_NORMAL, MATERIAL_MAP_ROUGHNESS,
+    MATERIAL_MAP_OCCLUSION, MATERIAL_MAP_CUBEMAP
+};
+
+void TrackMaterialTextures(Material material, const char* name)
+{
+    if (material.maps == NULL)
+        return;
+
+    for (int i = 0; i < (int)(sizeof(trackedMaps)/sizeof(trackedMaps[0])); i++)
+        TrackTexture(material.maps[trackedMaps[i]].texture, name);
+}
+
+void UntrackMaterialTextures(Material material)
+{
+    if (material.maps == NULL)
+        return;
+
+    for (int i = 0; i < (int)(sizeof(trackedMaps)/sizeof(trackedMaps[0])); i++)
+        UntrackTexture(material.maps[trackedMaps[i]].texture);
+}
+
+Shader LoadShaderTracked(const char* vsFileName, const char* fsFileName)
+{
+    Shader shader = LoadShader(vsFileName, fsFileName);
+
+    // driver side program size is unknown, shaders are only counted
+    TrackMemory(MEM_GPU_SHADER, shader.id, 0, (fsFileName != NULL)? fsFileName : vsFileName);
+    return shader;
+}
+
+void UnloadShaderTracked(Shader shader)
+{
+    UntrackMemory(MEM_GPU_SHADER, shader.id);
+    UnloadShader(shader);
+}
+
+void TrackRenderTexture(RenderTexture2D target, const char* name)
+{
+    // color attachment plus a 32 bit depth attachment
+    size_t size = GetTextureBytes(target.texture) + (size_t)target.depth.width*target.depth.height*4;
+    TrackMemory(MEM_GPU_FRAMEBUFFER, target.id, size, name);
+}
+
+void UntrackRenderTexture(RenderTexture2D target)
+{
+    UntrackMemory(MEM_GPU_FRAMEBUFFER, target.id);
+}
@@ -0,0 +1,76 @@
+/**********************************************************************************************
+*
+*   RockyRoad * MemTrack * CPU and GPU memory accounting
+*
+*   Every tracked allocation or GPU object is tagged with a category and an estimated size.
+*   Live totals per category feed the profiler overlay, and whatever is still tracked at
+*   shutdown is reported as a leak by LogMemoryLeaks.
+*
+*   GPU objects are keyed by their OpenGL id, CPU memory by its address. Tracking the same
+*   object twice adds a reference instead of counting it again, so shared resources (like the
+*   rlpbr default textures) are only counted once.
+*
+**********************************************************************************************/
+
+#ifndef MEM_TRACK_H
+#define MEM_TRACK_H
+
+#include "raylib.h"
+
+#include <stddef.h>
+
+typedef enum
+{
+    MEM_CPU_LEVEL = 0,
+    MEM_CPU_FRAME,
+    MEM_CPU_MESH,
+    MEM_CPU_HEAP,
+    MEM_GPU_TEXTURE,
+    MEM_GPU_MESH,
+    MEM_GPU_SHADER,
+    MEM_GPU_FRAMEBUFFER,
+    MEM_CATEGORY_COUNT
+}MemCategory;
+
+// record an allocation or GPU object, key is the address or the GL id
+void TrackMemory(MemCategory category, unsigned long long key, size_t size, const char* name);
+
+// drop one reference to a tracked object, it is forgotten once the last one is gone
+void UntrackMemory(MemCategory category, unsigned long long key);
+
+// live bytes and object count for a category
+size_t GetTrackedBytes(MemCategory category);
+int GetTrackedCount(MemCategory category);
+const char *GetMemCategoryName(MemCategory category);
+
+// true for the GPU side categories
+bool IsGpuMemCategory(MemCategory category);
+
+// report every object that is still tracked, returns how many there were
+int LogMemoryLeaks(void);
+
+// raylib resources with accounting attached
+void TrackTexture(Texture2D texture, const char* name);
+void UntrackTexture(Texture2D texture);
+Texture2D LoadTextureTracked(const char* fileName);
+void UnloadTextureTracked(Texture2D texture);
+
+void TrackMesh(Mesh mesh, const char* name);
+void UntrackMesh(Mesh mesh);
+
+void TrackModel(Model model, const char* name);
+void UntrackModel(Model model);
+Model LoadModelTracked(const char* fileName);
+void UnloadModelTracked(Model model);
+
+// every texture bound to the material's maps
+void TrackMaterialTextures(Material material, const char* name);
+void UntrackMaterialTextures(Material material);
+
+Shader LoadShaderTracked(const char* vsFileName, const char* fsFileName);
+void UnloadShaderTracked(Shader shader);
+
+void TrackRenderTexture(RenderTexture2D target, const char* name);
+void UntrackRenderTexture(RenderTexture2D target);
+
+#endif //MEM_TRACK_H
@@ -0,0 +1,966 @@
+/**********************************************************************************************
+*
+*   RockyRoad * MeshCache * Binary model cache for OBJ and glTF assets
+*
+**********************************************************************************************/
+
+#include "MeshCache.h"
+#include "Arena.h"
+#include "MeshLod.h"
+#include "raymath.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+    #include <direct.h>
+    #define MakeDirectory(path) _mkdir(path)
+#else
+    #include <sys/stat.h>
+    #define MakeDirectory(path) mkdir(path, 0755)
+#endif
+
+#define MESH_CACHE_MAGIC 0x434D5252         // "RRMC"
+#define MESH_CACHE_VERSION 2
+
+#define FNV64_OFFSET 14695981039346656037ULL
+#define FNV64_PRIME 1099511628211ULL
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+// size of the simulated post-transform cache the triangle order is tuned for
+#define VERTEX_CACHE_SIZE 32
+
+// raylib meshes use 16 bit indices
+#define MAX_INDEXED_VERTICES 65536
+
+// meshes smaller than this are cheap enough to always draw in full
+#define LOD_MIN_TRIANGLES 256
+
+// each level halves the triangles, within this error relative to the mesh radius
+static const float lodMaxError[MAX_MESH_LODS] = {0.0f, 0.01f, 0.03f, 0.08f};
+
+typedef enum
+{
+    ATTRIB_POSITION = 0,
+    ATTRIB_TEXCOORD = 1,
+    ATTRIB_TEXCOORD2 = 2,
+    ATTRIB_NORMAL = 4,
+    ATTRIB_TANGENT = 8,
+    ATTRIB_COLOR = 16,
+    ATTRIB_BONES = 32
+}MeshAttribute;
+
+// every vertex array is stored as 32 bit words, colors pack into one
+typedef struct
+{
+    MeshAttribute flag;
+    int words;
+}AttributeSlot;
+
+static const AttributeSlot slots[] = {
+    {ATTRIB_POSITION, 3},
+    {ATTRIB_TEXCOORD, 2},
+    {ATTRIB_TEXCOORD2, 2},
+    {ATTRIB_NORMAL, 3},
+    {ATTRIB_TANGENT, 4},
+    {ATTRIB_COLOR, 1},
+    {ATTRIB_BONES, 4},              // bone ids
+    {ATTRIB_BONES, 4}               // bone weights
+};
+
+#define SLOT_COUNT ((int)(sizeof(slots)/sizeof(slots[0])))
+
+typedef struct
+{
+    unsigned int magic;
+    unsigned int version;
+    int meshCount;
+    int materialCount;
+    int boneCount;
+}MeshCacheHeader;
+
+typedef struct
+{
+    int vertexCount;
+    int indexCount;
+    int indexBytes;
+    unsigned int attributes;
+    int material;
+
+    // the levels' index lists follow each other, indexCount is their sum
+    int lodCount;
+    int lodIndexCount[MAX_MESH_LODS];
+}MeshCacheEntry;
+
+// one mesh after welding and reordering, each vertex a record of 32 bit words
+typedef struct
+{
+    unsigned int* records;
+    int stride;
+    int vertexCount;
+    int* indices;
+    int indexCount;
+    unsigned char* indexData;
+    int indexBytes;
+    unsigned int attributes;
+    int material;
+    int lodCount;
+    int lodIndexCount[MAX_MESH_LODS];
+}BuiltMesh;
+
+static const void *GetMeshArray(const Mesh* mesh, int slot)
+{
+    switch (slot)
+    {
+    case 0: return mesh->vertices;
+    case 1: return mesh->texcoords;
+    case 2: return mesh->texcoords2;
+    case 3: return mesh->normals;
+    case 4: return mesh->tangents;
+    case 5: return mesh->colors;
+    case 6: return mesh->boneIds;
+    default: return mesh->boneWeights;
+    }
+}
+
+static void SetMeshArray(Mesh* mesh, int slot, void* data)
+{
+    switch (slot)
+    {
+    case 0: mesh->vertices = (float*)data; break;
+    case 1: mesh->texcoords = (float*)data; break;
+    case 2: mesh->texcoords2 = (float*)data; break;
+    case 3: mesh->normals = (float*)data; break;
+    case 4: mesh->tangents = (float*)data; break;
+    case 5: mesh->colors = (unsigned char*)data; break;
+    case 6: mesh->boneIds = (int*)data; break;
+    default: mesh->boneWeights = (float*)data; break;
+    }
+}
+
+static int Align4(int size)
+{
+    return (size + 3) & ~3;
+}
+
+//----------------------------------------------------------------------------------
+// Vertex cache optimization, after Tom Forsyth's linear-speed algorithm
+//----------------------------------------------------------------------------------
+
+static float VertexScore(int cachePosition, int remaining)
+{
+    if (remaining == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // the last triangle's vertices get a fixed score so strips don't double back
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = powf(1.0f - (float)(cachePosition - 3)/(VERTEX_CACHE_SIZE - 3), 1.5f);
+    }
+
+    // vertices with few triangles left are worth finishing off
+    return score + 2.0f/sqrtf((float)remaining);
+}
+
+static void OptimizeVertexCache(int* indices, int triangleCount, int vertexCount)
+{
+    int *remaining = (int*)GameHeapAlloc(vertexCount*sizeof(int));
+    int *offsets = (int*)GameHeapAlloc((vertexCount + 1)*sizeof(int));
+    int *adjacency = (int*)GameHeapAlloc(triangleCount*3*sizeof(int));
+    int *cachePosition = (int*)GameHeapAlloc(vertexCount*sizeof(int));
+    float *vertexScore = (float*)GameHeapAlloc(vertexCount*sizeof(float));
+    float *triangleScore = (float*)GameHeapAlloc(triangleCount*sizeof(float));
+    unsigned char *emitted = (unsigned char*)GameHeapAlloc(triangleCount);
+    int *output = (int*)GameHeapAlloc(triangleCount*3*sizeof(int));
+
+    if (remaining == NULL || offsets == NULL || adjacency == NULL || cachePosition == NULL ||
+        vertexScore == NULL || triangleScore == NULL || emitted == NULL || output == NULL)
+        goto cleanup;
+
+    for (int i = 0; i < triangleCount*3; i++)
+        remaining[indices[i]]++;
+
+    for (int v = 0; v < vertexCount; v++)
+    {
+        offsets[v + 1] = offsets[v] + remaining[v];
+        cachePosition[v] = -1;
+    }
+
+    // triangles of each vertex, filled using the cache positions as a temporary counter
+    for (int t = 0; t < triangleCount; t++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            int v = indices[t*3 + k];
+            adjacency[offsets[v] + (++cachePosition[v])] = t;
+        }
+    }
+
+    for (int v = 0; v < vertexCount; v++)
+    {
+        cachePosition[v] = -1;
+        vertexScore[v] = VertexScore(-1, remaining[v]);
+    }
+
+    int best = -1;
+    float bestScore = -1.0f;
+    for (int t = 0; t < triangleCount; t++)
+    {
+        triangleScore[t] = vertexScore[indices[t*3]] + vertexScore[indices[t*3 + 1]] + vertexScore[indices[t*3 + 2]];
+        if (triangleScore[t] > bestScore)
+        {
+            bestScore = triangleScore[t];
+            best = t;
+        }
+    }
+
+    int cache[VERTEX_CACHE_SIZE + 3];
+    int cacheCount = 0;
+    int scanCursor = 0;
+
+    for (int out = 0; out < triangleCount; out++)
+    {
+        // nothing in the cache has triangles left, continue with the next unused one
+        if (best < 0)
+        {
+            while (emitted[scanCursor])
+                scanCursor++;
+            best = scanCursor;
+        }
+
+        const int *corners = &indices[best*3];
+        memcpy(&output[out*3], corners, 3*sizeof(int));
+        emitted[best] = 1;
+
+        for (int k = 0; k < 3; k++)
+        {
+            int v = corners[k];
+            int *list = &adjacency[offsets[v]];
+            for (int i = 0; i < remaining[v]; i++)
+            {
+                if (list[i] == best)
+                {
+                    list[i] = list[remaining[v] - 1];
+                    break;
+                }
+            }
+            remaining[v]--;
+        }
+
+        // the triangle's vertices move to the front, everything else shifts back
+        int next[VERTEX_CACHE_SIZE + 3];
+        int nextCount = 0;
+        for (int k = 0; k < 3; k++)
+            next[nextCount++] = corners[k];
+        for (int i = 0; i < cacheCount; i++)
+        {
+            int v = cache[i];
+            if (v != corners[0] && v != corners[1] && v != corners[2])
+                next[nextCount++] = v;
+        }
+
+        for (int i = 0; i < nextCount; i++)
+        {
+            int v = next[i];
+            cachePosition[v] = (i < VERTEX_CACHE_SIZE)? i : -1;
+            vertexScore[v] = VertexScore(cachePosition[v], remaining[v]);
+        }
+
+        cacheCount = (nextCount < VERTEX_CACHE_SIZE)? nextCount : VERTEX_CACHE_SIZE;
+        memcpy(cache, next, cacheCount*sizeof(int));
+
+        // only triangles touching the cache changed score, the best next one is among them
+        best = -1;
+        bestScore = -1.0f;
+        for (int i = 0; i < nextCount; i++)
+        {
+            int v = next[i];
+            for (int a = 0; a < remaining[v]; a++)
+            {
+                int t = adjacency[offsets[v] + a];
+                triangleScore[t] = vertexScore[indices[t*3]] + vertexScore[indices[t*3 + 1]] + vertexScore[indices[t*3 + 2]];
+                if (triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+    }
+
+    memcpy(indices, output, triangleCount*3*sizeof(int));
+
+cleanup:
+    GameHeapFree(remaining);
+    GameHeapFree(offsets);
+    GameHeapFree(adjacency);
+    GameHeapFree(cachePosition);
+    GameHeapFree(vertexScore);
+    GameHeapFree(triangleScore);
+    GameHeapFree(emitted);
+    GameHeapFree(output);
+}
+
+// misses of a FIFO cache of the given size per triangle, 3.0 is no reuse at all
+static float AverageCacheMissRatio(const int* indices, int indexCount, int vertexCount, int cacheSize)
+{
+    int *stamp = (int*)GameHeapAlloc(vertexCount*sizeof(int));
+    if (stamp == NULL || indexCount == 0)
+    {
+        GameHeapFree(stamp);
+        return 0.0f;
+    }
+
+    // a vertex is cached while fewer than cacheSize misses happened since it was loaded
+    int misses = 0;
+    for (int i = 0; i < indexCount; i++)
+    {
+        int v = indices[i];
+        if (stamp[v] == 0 || misses - stamp[v] >= cacheSize)
+        {
+            misses++;
+            stamp[v] = misses;
+        }
+    }
+
+    GameHeapFree(stamp);
+    return (float)misses/(indexCount/3);
+}
+
+//----------------------------------------------------------------------------------
+// Building
+//----------------------------------------------------------------------------------
+
+static unsigned int HashRecord(const unsigned int* record, int stride)
+{
+    unsigned int hash = FNV_OFFSET;
+    const unsigned char *bytes = (const unsigned char*)record;
+    for (int i = 0; i < stride*4; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// merge vertices whose attributes are bit for bit identical, returns the unique count
+static int WeldVertices(const unsigned int* source, int vertexCount, int stride, unsigned int* records, int* remap)
+{
+    int tableSize = 1;
+    while (tableSize < vertexCount*2)
+        tableSize <<= 1;
+
+    int *table = (int*)GameHeapAlloc(tableSize*sizeof(int));
+    if (table == NULL)
+        return -1;
+
+    int unique = 0;
+    for (int v = 0; v < vertexCount; v++)
+    {
+        const unsigned int *record = &source[v*stride];
+        unsigned int slot = HashRecord(record, stride) & (tableSize - 1);
+
+        while (table[slot] != 0 && memcmp(&records[(table[slot] - 1)*stride], record, stride*sizeof(unsigned int)) != 0)
+            slot = (slot + 1) & (tableSize - 1);
+
+        if (table[slot] == 0)
+        {
+            memcpy(&records[unique*stride], record, stride*sizeof(unsigned int));
+            table[slot] = ++unique;
+        }
+        remap[v] = table[slot] - 1;
+    }
+
+    GameHeapFree(table);
+    return unique;
+}
+
+// renumber vertices in the order the triangles first use them and drop unused ones
+static int ReorderVertices(unsigned int* records, int stride, int vertexCount, int* indices, int indexCount)
+{
+    int *order = (int*)GameHeapAlloc(vertexCount*sizeof(int));
+    unsigned int *sorted = (unsigned int*)GameHeapAlloc(vertexCount*stride*sizeof(unsigned int));
+    if (order == NULL || sorted == NULL)
+    {
+        GameHeapFree(order);
+        GameHeapFree(sorted);
+        return vertexCount;
+    }
+
+    int next = 0;
+    for (int i = 0; i < indexCount; i++)
+    {
+        int v = indices[i];
+        if (order[v] == 0)
+        {
+            order[v] = ++next;
+            memcpy(&sorted[(next - 1)*stride], &records[v*stride], stride*sizeof(unsigned int));
+        }
+        indices[i] = order[v] - 1;
+    }
+
+    memcpy(records, sorted, next*stride*sizeof(unsigned int));
+    GameHeapFree(order);
+    GameHeapFree(sorted);
+    return next;
+}
+
+// indices as zigzag encoded deltas from the previous index, 7 bits per byte
+static int EncodeIndices(const int* indices, int count, unsigned char* out)
+{
+    int bytes = 0;
+    int previous = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        int delta = indices[i] - previous;
+        previous = indices[i];
+
+        unsigned int zigzag = ((unsigned int)delta << 1) ^ (unsigned int)(delta >> 31);
+        do
+        {
+            unsigned char byte = zigzag & 0x7F;
+            zigzag >>= 7;
+            out[bytes++] = byte | (zigzag? 0x80 : 0);
+        } while (zigzag);
+    }
+
+    return bytes;
+}
+
+static bool DecodeIndices(const unsigned char* data, int bytes, unsigned short* out, int count, int vertexCount)
+{
+    int cursor = 0;
+    int previous = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        unsigned int zigzag = 0;
+        int shift = 0;
+        unsigned char byte;
+        do
+        {
+            if (cursor >= bytes || shift > 28)
+                return false;
+            byte = data[cursor++];
+            zigzag |= (unsigned int)(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+
+        int delta = (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+        previous += delta;
+        if (previous < 0 || previous >= vertexCount)
+            return false;
+
+        out[i] = (unsigned short)previous;
+    }
+
+    return cursor == bytes;
+}
+
+// append simplified levels after the full index list, each optimized for the vertex cache
+static void BuildLods(BuiltMesh* built)
+{
+    built->lodCount = 1;
+    built->lodIndexCount[0] = built->indexCount;
+
+    if (built->indexCount/3 < LOD_MIN_TRIANGLES)
+        return;
+
+    int *indices = (int*)GameHeapAlloc(built->indexCount*MAX_MESH_LODS*sizeof(int));
+    if (indices == NULL)
+        return;
+
+    // positions lead every record
+    const float *positions = (const float*)built->records;
+    Vector3 low = {positions[0], positions[1], positions[2]};
+    Vector3 high = low;
+    for (int v = 1; v < built->vertexCount; v++)
+    {
+        Vector3 p = {positions[v*built->stride], positions[v*built->stride + 1], positions[v*built->stride + 2]};
+        low = Vector3Min(low, p);
+        high = Vector3Max(high, p);
+    }
+    float radius = Vector3Length(Vector3Subtract(high, low))*0.5f;
+
+    memcpy(indices, built->indices, built->indexCount*sizeof(int));
+    int total = built->indexCount;
+    int previous = 0;
+
+    for (int l = 1; l < MAX_MESH_LODS; l++)
+    {
+        int previousCount = built->lodIndexCount[l - 1];
+        int target = (previousCount/6)*3;
+        int count = SimplifyMeshIndices(positions, built->stride, built->vertexCount, &indices[previous], previousCount,
+                                        target, radius*lodMaxError[l], &indices[total]);
+
+        // not worth a level if the error limit stopped it early
+        if (count == 0 || count > previousCount*9/10)
+            break;
+
+        OptimizeVertexCache(&indices[total], count/3, built->vertexCount);
+        built->lodIndexCount[l] = count;
+        built->lodCount++;
+        previous = total;
+        total += count;
+    }
+
+    GameHeapFree(built->indices);
+    built->indices = indices;
+    built->indexCount = total;
+}
+
+static void FreeBuiltMesh(BuiltMesh* built)
+{
+    GameHeapFree(built->records);
+    GameHeapFree(built->indices);
+    GameHeapFree(built->indexData);
+}
+
+static bool BuildMesh(const Mesh* mesh, int material, BuiltMesh* built)
+{
+    memset(built, 0, sizeof(*built));
+    built->material = material;
+
+    if (mesh->vertices == NULL || mesh->vertexCount <= 0)
+        return false;
+
+    for (int s = 0; s < SLOT_COUNT; s++)
+    {
+        if (GetMeshArray(mesh, s) == NULL)
+            continue;
+
+        // ids without weights (or the other way around) can't be used for skinning
+        if (slots[s].flag == ATTRIB_BONES && (mesh->boneIds == NULL || mesh->boneWeights == NULL))
+            continue;
+
+        built->attributes |= slots[s].flag;
+        built->stride += slots[s].words;
+    }
+
+    int corners = (mesh->indices != NULL)? mesh->triangleCount*3 : mesh->vertexCount;
+    unsigned int *source = (unsigned int*)GameHeapAlloc(mesh->vertexCount*built->stride*sizeof(unsigned int));
+    int *remap = (int*)GameHeapAlloc(mesh->vertexCount*sizeof(int));
+    int records = (corners > mesh->vertexCount)? corners : mesh->vertexCount;
+    built->records = (unsigned int*)GameHeapAlloc(records*built->stride*sizeof(unsigned int));
+    built->indices = (int*)GameHeapAlloc(corners*sizeof(int));
+
+    if (source == NULL || remap == NULL || built->records == NULL || built->indices == NULL)
+    {
+        GameHeapFree(source);
+        GameHeapFree(remap);
+        FreeBuiltMesh(built);
+        return false;
+    }
+
+    // gather the separate raylib arrays into one record per vertex
+    int offset = 0;
+    for (int s = 0; s < SLOT_COUNT; s++)
+    {
+        if (!(built->attributes & slots[s].flag) && slots[s].flag != ATTRIB_POSITION)
+            continue;
+
+        const unsigned int *array = (const unsigned int*)GetMeshArray(mesh, s);
+        for (int v = 0; v < mesh->vertexCount; v++)
+            memcpy(&source[v*built->stride + offset], &array[v*slots[s].words], slots[s].words*sizeof(unsigned int));
+        offset += slots[s].words;
+    }
+
+    int unique = WeldVertices(source, mesh->vertexCount, built->stride, built->records, remap);
+
+    if (unique > 0 && unique <= MAX_INDEXED_VERTICES)
+    {
+        for (int i = 0; i < corners; i++)
+            built->indices[i] = remap[(mesh->indices != NULL)? mesh->indices[i] : i];
+
+        float before = AverageCacheMissRatio(built->indices, corners, unique, 16);
+        OptimizeVertexCache(built->indices, corners/3, unique);
+        built->vertexCount = ReorderVertices(built->records, built->stride, unique, built->indices, corners);
+        built->indexCount = corners;
+
+        TraceLog(LOG_DEBUG, "MESHCACHE: %i -> %i vertices, ACMR %.2f -> %.2f", mesh->vertexCount, built->vertexCount,
+                 before, AverageCacheMissRatio(built->indices, corners, built->vertexCount, 16));
+
+        BuildLods(built);
+        for (int l = 1; l < built->lodCount; l++)
+            TraceLog(LOG_DEBUG, "MESHCACHE: LOD %i has %i triangles", l, built->lodIndexCount[l]/3);
+
+        // varints of 16 bit deltas take at most three bytes
+        built->indexData = (unsigned char*)GameHeapAlloc(built->indexCount*3);
+        if (built->indexData != NULL)
+            built->indexBytes = EncodeIndices(built->indices, built->indexCount, built->indexData);
+    }
+    else
+    {
+        // too many vertices for 16 bit indices, store the triangles unindexed
+        for (int i = 0; i < corners; i++)
+        {
+            int v = (mesh->indices != NULL)? mesh->indices[i] : i;
+            memcpy(&built->records[i*built->stride], &source[v*built->stride], built->stride*sizeof(unsigned int));
+        }
+        built->vertexCount = corners;
+    }
+
+    GameHeapFree(source);
+    GameHeapFree(remap);
+
+    if (built->indexCount > 0 && built->indexData == NULL)
+    {
+        FreeBuiltMesh(built);
+        return false;
+    }
+
+    return true;
+}
+
+static unsigned char *BuildModelCache(Model model, int* size)
+{
+    BuiltMesh *built = (BuiltMesh*)GameHeapAlloc(model.meshCount*sizeof(BuiltMesh));
+    if (built == NULL)
+        return NULL;
+
+    bool valid = true;
+    for (int m = 0; m < model.meshCount && valid; m++)
+        valid = BuildMesh(&model.meshes[m], model.meshMaterial[m], &built[m]);
+
+    int total = sizeof(MeshCacheHeader) + model.boneCount*(sizeof(BoneInfo) + sizeof(Transform));
+    for (int m = 0; m < model.meshCount && valid; m++)
+        total += sizeof(MeshCacheEntry) + built[m].vertexCount*built[m].stride*sizeof(unsigned int) + Align4(built[m].indexBytes);
+
+    unsigned char *data = valid? (unsigned char*)GameHeapAlloc(total) : NULL;
+    if (data != NULL)
+    {
+        MeshCacheHeader header = {MESH_CACHE_MAGIC, MESH_CACHE_VERSION, model.meshCount, model.materialCount, model.boneCount};
+        unsigned char *cursor = data;
+
+        memcpy(cursor, &header, sizeof(header));
+        cursor += sizeof(header);
+        if (model.boneCount > 0)
+        {
+            memcpy(cursor, model.bones, model.boneCount*sizeof(BoneInfo));
+            cursor += model.boneCount*sizeof(BoneInfo);
+            memcpy(cursor, model.bindPose, model.boneCount*sizeof(Transform));
+            cursor += model.boneCount*sizeof(Transform);
+        }
+
+        for (int m = 0; m < model.meshCount; m++)
+        {
+            BuiltMesh *mesh = &built[m];
+            MeshCacheEntry entry = { 0 };
+            entry.vertexCount = mesh->vertexCount;
+            entry.indexCount = mesh->indexCount;
+            entry.indexBytes = mesh->indexBytes;
+            entry.attributes = mesh->attributes;
+            entry.material = mesh->material;
+            entry.lodCount = mesh->lodCount;
+            memcpy(entry.lodIndexCount, mesh->lodIndexCount, sizeof(entry.lodIndexCount));
+            memcpy(cursor, &entry, sizeof(entry));
+            cursor += sizeof(entry);
+
+            // scatter the records back into one array per attribute, the layout UploadMesh wants
+            int offset = 0;
+            for (int s = 0; s < SLOT_COUNT; s++)
+            {
+                if (!(mesh->attributes & slots[s].flag) && slots[s].flag != ATTRIB_POSITION)
+                    continue;
+
+                for (int v = 0; v < mesh->vertexCount; v++)
+                {
+                    memcpy(cursor, &mesh->records[v*mesh->stride + offset], slots[s].words*sizeof(unsigned int));
+                    cursor += slots[s].words*sizeof(unsigned int);
+                }
+                offset += slots[s].words;
+            }
+
+            memcpy(cursor, mesh->indexData, mesh->indexBytes);
+            memset(cursor + mesh->indexBytes, 0, Align4(mesh->indexBytes) - mesh->indexBytes);
+            cursor += Align4(mesh->indexBytes);
+        }
+
+        *size = total;
+    }
+
+    for (int m = 0; m < model.meshCount; m++)
+        FreeBuiltMesh(&built[m]);
+    GameHeapFree(built);
+
+    return data;
+}
+
+//----------------------------------------------------------------------------------
+// Loading
+//----------------------------------------------------------------------------------
+
+static void FreeMeshArrays(Mesh* mesh)
+{
+    for (int s = 0; s < SLOT_COUNT; s++)
+        MemFree((void*)GetMeshArray(mesh, s));
+
+    MemFree(mesh->indices);
+    MemFree(mesh->animVertices);
+    MemFree(mesh->animNormals);
+}
+
+// the mesh array is zeroed, so meshes that were never read have nothing to free
+static void FreeCachedModel(Model* model, int meshCount)
+{
+    for (int m = 0; m < meshCount; m++)
+        FreeMeshArrays(&model->meshes[m]);
+
+    MemFree(model->meshes);
+    MemFree(model->meshMaterial);
+    MemFree(model->bones);
+    MemFree(model->bindPose);
+}
+
+static bool ReadCacheBytes(const unsigned char* data, int size, int* cursor, void* out, int bytes)
+{
+    if (bytes < 0 || *cursor + bytes > size)
+        return false;
+
+    memcpy(out, data + *cursor, bytes);
+    *cursor += bytes;
+    return true;
+}
+
+// the bounding sphere LOD selection projects, around the center of the model's box
+static void ComputeLodBounds(Model model, ModelLods* lods)
+{
+    BoundingBox box = {model.meshes[0].vertices[0], model.meshes[0].vertices[1], model.meshes[0].vertices[2],
+                       model.meshes[0].vertices[0], model.meshes[0].vertices[1], model.meshes[0].vertices[2]};
+    for (int m = 0; m < model.meshCount; m++)
+    {
+        const float *v = model.meshes[m].vertices;
+        for (int i = 0; i < model.meshes[m].vertexCount; i++)
+        {
+            Vector3 p = {v[i*3], v[i*3 + 1], v[i*3 + 2]};
+            box.min = Vector3Min(box.min, p);
+            box.max = Vector3Max(box.max, p);
+        }
+    }
+
+    lods->center = Vector3Scale(Vector3Add(box.min, box.max), 0.5f);
+    lods->radius = Vector3Length(Vector3Subtract(box.max, box.min))*0.5f;
+}
+
+static Model ParseModelCache(const unsigned char* data, int size, ModelLods* lods)
+{
+    Model model = { 0 };
+    MeshCacheHeader header;
+    int cursor = 0;
+
+    if (!ReadCacheBytes(data, size, &cursor, &header, sizeof(header)) || header.magic != MESH_CACHE_MAGIC ||
+        header.version != MESH_CACHE_VERSION || header.meshCount <= 0 || header.boneCount < 0 || header.materialCount < 0)
+        return model;
+
+    model.transform = MatrixIdentity();
+    model.meshes = (Mesh*)MemAlloc(header.meshCount*sizeof(Mesh));
+    model.meshMaterial = (int*)MemAlloc(header.meshCount*sizeof(int));
+    // what each mesh draws once uploaded, level 0 of meshes with levels
+    int *drawTriangles = (int*)MemAlloc(header.meshCount*sizeof(int));
+
+    if (lods != NULL)
+    {
+        lods->meshes = (MeshLods*)GameHeapAlloc(header.meshCount*sizeof(MeshLods));
+        lods->meshCount = (lods->meshes != NULL)? header.meshCount : 0;
+    }
+
+    bool valid = true;
+    if (header.boneCount > 0)
+    {
+        model.boneCount = header.boneCount;
+        model.bones = (BoneInfo*)MemAlloc(header.boneCount*sizeof(BoneInfo));
+        model.bindPose = (Transform*)MemAlloc(header.boneCount*sizeof(Transform));
+        valid = ReadCacheBytes(data, size, &cursor, model.bones, header.boneCount*sizeof(BoneInfo)) &&
+                ReadCacheBytes(data, size, &cursor, model.bindPose, header.boneCount*sizeof(Transform));
+    }
+
+    for (int m = 0; m < header.meshCount && valid; m++)
+    {
+        Mesh *mesh = &model.meshes[m];
+        MeshCacheEntry entry;
+
+        valid = ReadCacheBytes(data, size, &cursor, &entry, sizeof(entry)) && entry.vertexCount > 0 &&
+                entry.indexCount >= 0 && entry.indexBytes >= 0 && entry.material >= 0 && entry.material < header.materialCount &&
+                entry.lodCount >= 0 && entry.lodCount <= MAX_MESH_LODS;
+        if (!valid)
+            break;
+
+        int lodTotal = 0;
+        for (int l = 0; l < entry.lodCount; l++)
+        {
+            valid = valid && entry.lodIndexCount[l] > 0;
+            lodTotal += entry.lodIndexCount[l];
+        }
+        if (!valid || (entry.lodCount > 0 && lodTotal != entry.indexCount))
+        {
+            valid = false;
+            break;
+        }
+
+        // uploads take every level's indices, draws default to the full mesh at level 0
+        mesh->vertexCount = entry.vertexCount;
+        mesh->triangleCount = ((entry.indexCount > 0)? entry.indexCount : entry.vertexCount)/3;
+        drawTriangles[m] = (entry.lodCount > 0)? entry.lodIndexCount[0]/3 : mesh->triangleCount;
+        model.meshMaterial[m] = entry.material;
+
+        if (lods != NULL && lods->meshes != NULL)
+        {
+            MeshLods *levels = &lods->meshes[m];
+            levels->lodCount = entry.lodCount;
+            for (int l = 0, offset = 0; l < entry.lodCount; l++)
+            {
+                levels->indexOffset[l] = offset;
+                levels->indexCount[l] = entry.lodIndexCount[l];
+                offset += entry.lodIndexCount[l];
+            }
+        }
+
+        for (int s = 0; s < SLOT_COUNT && valid; s++)
+        {
+            if (!(entry.attributes & slots[s].flag) && slots[s].flag != ATTRIB_POSITION)
+                continue;
+
+            int bytes = entry.vertexCount*slots[s].words*sizeof(unsigned int);
+            void *array = MemAlloc(bytes);
+            SetMeshArray(mesh, s, array);
+            valid = ReadCacheBytes(data, size, &cursor, array, bytes);
+        }
+
+        if (valid && entry.indexCount > 0)
+        {
+            mesh->indices = (unsigned short*)MemAlloc(entry.indexCount*sizeof(unsigned short));
+            valid = cursor + Align4(entry.indexBytes) <= size &&
+                    DecodeIndices(data + cursor, entry.indexBytes, mesh->indices, entry.indexCount, entry.vertexCount);
+            cursor += Align4(entry.indexBytes);
+        }
+
+        // same as what LoadModel hands out, so UpdateModelAnimation keeps working
+        if (valid && (entry.attributes & ATTRIB_BONES))
+        {
+            mesh->animVertices = (float*)MemAlloc(entry.vertexCount*3*sizeof(float));
+            memcpy(mesh->animVertices, mesh->vertices, entry.vertexCount*3*sizeof(float));
+            if (mesh->normals != NULL)
+            {
+                mesh->animNormals = (float*)MemAlloc(entry.vertexCount*3*sizeof(float));
+                memcpy(mesh->animNormals, mesh->normals, entry.vertexCount*3*sizeof(float));
+            }
+        }
+    }
+
+    if (!valid || cursor != size)
+    {
+        MemFree(drawTriangles);
+        FreeCachedModel(&model, header.meshCount);
+        UnloadModelLods(lods);
+        return (Model){ 0 };
+    }
+
+    model.meshCount = header.meshCount;
+    model.materialCount = (header.materialCount > 0)? header.materialCount : 1;
+    model.materials = (Material*)MemAlloc(model.materialCount*sizeof(Material));
+    for (int i = 0; i < model.materialCount; i++)
+        model.materials[i] = LoadMaterialDefault();
+
+    for (int m = 0; m < model.meshCount; m++)
+    {
+        Mesh *mesh = &model.meshes[m];
+        UploadMesh(mesh, false);
+
+        // from here on the mesh is its full detail level for DrawMesh, raycasts and the like,
+        // whether or not the caller wanted the other levels
+        mesh->triangleCount = drawTriangles[m];
+    }
+    MemFree(drawTriangles);
+
+    if (lods != NULL)
+        ComputeLodBounds(model, lods);
+
+    return model;
+}
+
+static unsigned long long HashFile(const unsigned char* data, unsigned int size)
+{
+    unsigned long long hash = FNV64_OFFSET;
+
+    // the format version is part of the key, so old entries are simply never looked up again
+    unsigned int version = MESH_CACHE_VERSION;
+    const unsigned char *bytes = (const unsigned char*)&version;
+    for (unsigned int i = 0; i < sizeof(version); i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV64_PRIME;
+    }
+
+    for (unsigned int i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= FNV64_PRIME;
+    }
+    return hash;
+}
+
+Model LoadModelCached(const char* fileName, ModelLods* lods)
+{
+    double start = GetTime();
+    if (lods != NULL)
+        *lods = (ModelLods){ 0 };
+
+    unsigned int sourceSize = 0;
+    unsigned char *source = LoadFileData(fileName, &sourceSize);
+    if (source == NULL)
+        return LoadModel(fileName);
+
+    char cachePath[64];
+    snprintf(cachePath, sizeof(cachePath), "%s/%016llx.mesh", MESH_CACHE_DIRECTORY, HashFile(source, sourceSize));
+    UnloadFileData(source);
+
+    if (FileExists(cachePath))
+    {
+        unsigned int size = 0;
+        unsigned char *data = LoadFileData(cachePath, &size);
+        Model model = (data != NULL)? ParseModelCache(data, (int)size, lods) : (Model){ 0 };
+        UnloadFileData(data);
+
+        if (model.meshCount > 0)
+        {
+            TraceLog(LOG_INFO, "MESHCACHE: [%s] Loaded from %s in %.2f ms", fileName, cachePath, (GetTime() - start)*1000.0);
+            return model;
+        }
+        TraceLog(LOG_WARNING, "MESHCACHE: [%s] Cache entry %s is corrupt, rebuilding", fileName, cachePath);
+    }
+
+    Model original = LoadModel(fileName);
+    if (original.meshCount == 0)
+        return original;
+
+    int size = 0;
+    unsigned char *data = BuildModelCache(original, &size);
+    if (data == NULL)
+    {
+        TraceLog(LOG_WARNING, "MESHCACHE: [%s] Failed to build the cache entry", fileName);
+        return original;
+    }
+
+    if (!DirectoryExists(MESH_CACHE_DIRECTORY))
+        MakeDirectory(MESH_CACHE_DIRECTORY);
+    if (!SaveFileData(cachePath, data, size))
+        TraceLog(LOG_WARNING, "MESHCACHE: [%s] Failed to write %s", fileName, cachePath);
+
+    // hand out the cached form on a miss too, so both paths produce the same model
+    Model model = ParseModelCache(data, size, lods);
+    GameHeapFree(data);
+
+    if (model.meshCount == 0)
+        return original;
+
+    UnloadModel(original);
+    TraceLog(LOG_INFO, "MESHCACHE: [%s] Built %s in %.2f ms", fileName, cachePath, (GetTime() - start)*1000.0);
+    return model;
+}
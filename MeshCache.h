@@ -0,0 +1,33 @@
+/**********************************************************************************************
+*
+*   RockyRoad * MeshCache * Binary model cache for OBJ and glTF assets
+*
+*   The first time a model file is loaded it goes through raylib's text/glTF parsers as
+*   usual, then every mesh is welded into an indexed mesh, its triangles are reordered for
+*   the post-transform vertex cache (Forsyth) and its vertices for fetch locality. The result
+*   is written to cache/<content hash>.mesh with the indices stored as zigzag varint deltas.
+*
+*   Meshes big enough to matter also get simplified levels of detail (see MeshLod.h), stored
+*   as extra index ranges over the same vertices.
+*
+*   Later launches read that file in one go and copy the arrays straight into the mesh
+*   buffers. Editing the source asset changes its hash, so a stale cache is never used.
+*
+*   Geometry, bones and the bind pose are cached. Materials come back as raylib defaults,
+*   the game assigns its own textures and shaders after loading anyway.
+*
+**********************************************************************************************/
+
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include "raylib.h"
+#include "MeshLod.h"
+
+#define MESH_CACHE_DIRECTORY "cache"
+
+// load a model through the cache, building the cache entry on a miss. lods can be NULL,
+// otherwise it receives the level ranges of every mesh and has to be unloaded separately
+Model LoadModelCached(const char* fileName, ModelLods* lods);
+
+#endif //MESH_CACHE_H
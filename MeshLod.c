@@ -0,0 +1,401 @@
+/**********************************************************************************************
+*
+*   RockyRoad * MeshLod * Simplified levels of detail and their selection
+*
+**********************************************************************************************/
+
+#include "MeshLod.h"
+#include "Arena.h"
+#include "raymath.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// collapse passes before giving up on reaching the target
+#define SIMPLIFY_MAX_PASSES 32
+
+// projected bounding sphere height in pixels below which each coarser level is used
+static const float lodScreenPixels[MAX_MESH_LODS - 1] = {160.0f, 80.0f, 40.0f};
+
+// how far past a threshold a model has to grow before a finer level comes back
+#define LOD_HYSTERESIS 0.2f
+
+// symmetric 4x4 error matrix, plus the summed weight of the planes in it
+typedef struct
+{
+    double a[10];
+    double weight;
+}Quadric;
+
+typedef struct
+{
+    unsigned long long key;
+    float cost;
+    int from;
+    int to;
+}Collapse;
+
+static void AddQuadric(Quadric* q, const Quadric* other)
+{
+    for (int i = 0; i < 10; i++)
+        q->a[i] += other->a[i];
+    q->weight += other->weight;
+}
+
+static void AddPlane(Quadric* q, double nx, double ny, double nz, double d, double weight)
+{
+    q->a[0] += weight*nx*nx; q->a[1] += weight*nx*ny; q->a[2] += weight*nx*nz; q->a[3] += weight*nx*d;
+    q->a[4] += weight*ny*ny; q->a[5] += weight*ny*nz; q->a[6] += weight*ny*d;
+    q->a[7] += weight*nz*nz; q->a[8] += weight*nz*d;
+    q->a[9] += weight*d*d;
+    q->weight += weight;
+}
+
+// mean squared distance of a point to the planes in the quadric
+static float QuadricError(const Quadric* q, const float* p)
+{
+    double x = p[0], y = p[1], z = p[2];
+    const double *a = q->a;
+    double error = a[0]*x*x + 2.0*a[1]*x*y + 2.0*a[2]*x*z + 2.0*a[3]*x +
+                   a[4]*y*y + 2.0*a[5]*y*z + 2.0*a[6]*y +
+                   a[7]*z*z + 2.0*a[8]*z + a[9];
+
+    return (q->weight > 0.0)? (float)fabs(error/q->weight) : 0.0f;
+}
+
+static Vector3 TriangleNormal(const float* a, const float* b, const float* c)
+{
+    Vector3 e1 = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    Vector3 e2 = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    return Vector3CrossProduct(e1, e2);
+}
+
+static unsigned long long EdgeKey(int a, int b)
+{
+    return (a < b)? ((unsigned long long)a << 32) | (unsigned int)b : ((unsigned long long)b << 32) | (unsigned int)a;
+}
+
+static int CompareKeys(const void* a, const void* b)
+{
+    unsigned long long keyA = *(const unsigned long long*)a;
+    unsigned long long keyB = *(const unsigned long long*)b;
+    return (keyA > keyB) - (keyA < keyB);
+}
+
+static int CompareCollapses(const void* a, const void* b)
+{
+    float costA = ((const Collapse*)a)->cost;
+    float costB = ((const Collapse*)b)->cost;
+    return (costA > costB) - (costA < costB);
+}
+
+// vertices sharing a position with another vertex sit on a UV or normal seam
+static void LockSeams(const float* positions, int stride, int vertexCount, unsigned char* locked)
+{
+    int tableSize = 1;
+    while (tableSize < vertexCount*2)
+        tableSize <<= 1;
+
+    int *table = (int*)GameHeapAlloc(tableSize*sizeof(int));
+    if (table == NULL)
+    {
+        memset(locked, 1, vertexCount);
+        return;
+    }
+
+    for (int v = 0; v < vertexCount; v++)
+    {
+        const float *p = &positions[v*stride];
+        unsigned int hash = 2166136261u;
+        const unsigned char *bytes = (const unsigned char*)p;
+        for (int i = 0; i < 3*(int)sizeof(float); i++)
+            hash = (hash ^ bytes[i])*16777619u;
+
+        unsigned int slot = hash & (tableSize - 1);
+        while (table[slot] != 0 && memcmp(&positions[(table[slot] - 1)*stride], p, 3*sizeof(float)) != 0)
+            slot = (slot + 1) & (tableSize - 1);
+
+        if (table[slot] == 0)
+        {
+            table[slot] = v + 1;
+        }
+        else
+        {
+            locked[v] = 1;
+            locked[table[slot] - 1] = 1;
+        }
+    }
+
+    GameHeapFree(table);
+}
+
+// edges used by a single triangle are on an open border
+static void LockBorders(const int* indices, int indexCount, unsigned long long* keys, unsigned char* locked)
+{
+    for (int t = 0; t < indexCount/3; t++)
+    {
+        for (int k = 0; k < 3; k++)
+            keys[t*3 + k] = EdgeKey(indices[t*3 + k], indices[t*3 + (k + 1)%3]);
+    }
+    qsort(keys, indexCount, sizeof(unsigned long long), CompareKeys);
+
+    for (int i = 0; i < indexCount; )
+    {
+        int run = 1;
+        while (i + run < indexCount && keys[i + run] == keys[i])
+            run++;
+
+        if (run == 1)
+        {
+            locked[keys[i] >> 32] = 1;
+            locked[keys[i] & 0xFFFFFFFF] = 1;
+        }
+        i += run;
+    }
+}
+
+// would moving from onto to flip or squash any triangle around from
+static bool CollapseFlips(const float* positions, int stride, const int* indices, const int* triangles, int triangleCount, int from, int to)
+{
+    for (int i = 0; i < triangleCount; i++)
+    {
+        const int *corners = &indices[triangles[i]*3];
+        if (corners[0] == to || corners[1] == to || corners[2] == to)
+            continue;
+        if (corners[0] != from && corners[1] != from && corners[2] != from)
+            continue;
+
+        const float *before[3];
+        const float *after[3];
+        for (int k = 0; k < 3; k++)
+        {
+            before[k] = &positions[corners[k]*stride];
+            after[k] = (corners[k] == from)? &positions[to*stride] : before[k];
+        }
+
+        Vector3 n0 = TriangleNormal(before[0], before[1], before[2]);
+        Vector3 n1 = TriangleNormal(after[0], after[1], after[2]);
+        if (Vector3DotProduct(n0, n1) <= 0.0f)
+            return true;
+    }
+    return false;
+}
+
+int SimplifyMeshIndices(const float* positions, int stride, int vertexCount, const int* indices, int indexCount,
+                        int targetIndexCount, float maxError, int* out)
+{
+    memcpy(out, indices, indexCount*sizeof(int));
+    if (indexCount <= targetIndexCount)
+        return indexCount;
+
+    Quadric *quadrics = (Quadric*)GameHeapAlloc(vertexCount*sizeof(Quadric));
+    unsigned char *locked = (unsigned char*)GameHeapAlloc(vertexCount);
+    int *touched = (int*)GameHeapAlloc(vertexCount*sizeof(int));
+    int *offsets = (int*)GameHeapAlloc((vertexCount + 1)*sizeof(int));
+    int *adjacency = (int*)GameHeapAlloc(indexCount*sizeof(int));
+    unsigned long long *keys = (unsigned long long*)GameHeapAlloc(indexCount*sizeof(unsigned long long));
+    Collapse *collapses = (Collapse*)GameHeapAlloc(indexCount*sizeof(Collapse));
+
+    int count = indexCount;
+    if (quadrics == NULL || locked == NULL || touched == NULL || offsets == NULL || adjacency == NULL || keys == NULL || collapses == NULL)
+        goto cleanup;
+
+    LockSeams(positions, stride, vertexCount, locked);
+    LockBorders(out, count, keys, locked);
+
+    for (int t = 0; t < count/3; t++)
+    {
+        const float *p[3];
+        for (int k = 0; k < 3; k++)
+            p[k] = &positions[out[t*3 + k]*stride];
+
+        Vector3 normal = TriangleNormal(p[0], p[1], p[2]);
+        float length = Vector3Length(normal);
+        if (length <= 0.0f)
+            continue;
+
+        // weighted by area, so many small triangles don't outvote one large one
+        Vector3 n = Vector3Scale(normal, 1.0f/length);
+        double d = -(n.x*p[0][0] + n.y*p[0][1] + n.z*p[0][2]);
+        for (int k = 0; k < 3; k++)
+            AddPlane(&quadrics[out[t*3 + k]], n.x, n.y, n.z, d, 0.5*length);
+    }
+
+    float errorLimit = maxError*maxError;
+
+    for (int pass = 1; pass <= SIMPLIFY_MAX_PASSES && count > targetIndexCount; pass++)
+    {
+        // unique edges of what is left
+        for (int t = 0; t < count/3; t++)
+        {
+            for (int k = 0; k < 3; k++)
+                keys[t*3 + k] = EdgeKey(out[t*3 + k], out[t*3 + (k + 1)%3]);
+        }
+        qsort(keys, count, sizeof(unsigned long long), CompareKeys);
+
+        int candidates = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (i > 0 && keys[i] == keys[i - 1])
+                continue;
+
+            int a = (int)(keys[i] >> 32);
+            int b = (int)(keys[i] & 0xFFFFFFFF);
+            Quadric merged = quadrics[a];
+            AddQuadric(&merged, &quadrics[b]);
+
+            // endpoint collapses only, so every level reuses the original vertices
+            float toB = locked[a]? INFINITY : QuadricError(&merged, &positions[b*stride]);
+            float toA = locked[b]? INFINITY : QuadricError(&merged, &positions[a*stride]);
+            if (isinf(toB) && isinf(toA))
+                continue;
+
+            Collapse *c = &collapses[candidates++];
+            c->key = keys[i];
+            c->cost = (toB <= toA)? toB : toA;
+            c->from = (toB <= toA)? a : b;
+            c->to = (toB <= toA)? b : a;
+        }
+        qsort(collapses, candidates, sizeof(Collapse), CompareCollapses);
+
+        // triangles around each vertex
+        memset(offsets, 0, (vertexCount + 1)*sizeof(int));
+        for (int i = 0; i < count; i++)
+            offsets[out[i] + 1]++;
+        for (int v = 0; v < vertexCount; v++)
+            offsets[v + 1] += offsets[v];
+        for (int v = vertexCount; v > 0; v--)
+            offsets[v] = offsets[v - 1];
+        offsets[0] = 0;
+        for (int i = 0; i < count; i++)
+            adjacency[offsets[out[i] + 1]++] = i/3;
+
+        // each collapse removes about two triangles, stop once the target is in reach
+        int budget = (count - targetIndexCount)/6 + 1;
+        int applied = 0;
+
+        for (int i = 0; i < candidates && applied < budget; i++)
+        {
+            const Collapse *c = &collapses[i];
+            if (c->cost > errorLimit)
+                break;
+            if (touched[c->from] == pass || touched[c->to] == pass)
+                continue;
+
+            const int *triangles = &adjacency[offsets[c->from]];
+            int triangleCount = offsets[c->from + 1] - offsets[c->from];
+            if (CollapseFlips(positions, stride, out, triangles, triangleCount, c->from, c->to))
+                continue;
+
+            for (int t = 0; t < triangleCount; t++)
+            {
+                int *corners = &out[triangles[t]*3];
+                for (int k = 0; k < 3; k++)
+                {
+                    if (corners[k] == c->from)
+                        corners[k] = c->to;
+                }
+            }
+
+            AddQuadric(&quadrics[c->to], &quadrics[c->from]);
+            touched[c->from] = pass;
+            touched[c->to] = pass;
+            applied++;
+        }
+
+        // drop the triangles that collapsed to a line
+        int kept = 0;
+        for (int t = 0; t < count/3; t++)
+        {
+            int a = out[t*3], b = out[t*3 + 1], c = out[t*3 + 2];
+            if (a == b || b == c || a == c)
+                continue;
+
+            out[kept++] = a;
+            out[kept++] = b;
+            out[kept++] = c;
+        }
+        count = kept;
+
+        if (applied == 0)
+            break;
+    }
+
+cleanup:
+    GameHeapFree(quadrics);
+    GameHeapFree(locked);
+    GameHeapFree(touched);
+    GameHeapFree(offsets);
+    GameHeapFree(adjacency);
+    GameHeapFree(keys);
+    GameHeapFree(collapses);
+
+    return count;
+}
+
+void UnloadModelLods(ModelLods* lods)
+{
+    if (lods == NULL)
+        return;
+
+    GameHeapFree(lods->meshes);
+    lods->meshes = NULL;
+    lods->meshCount = 0;
+}
+
+float GetSphereScreenPixels(Vector3 center, float radius, Camera camera, float screenHeight)
+{
+    if (camera.projection == CAMERA_ORTHOGRAPHIC)
+        return 2.0f*radius/camera.fovy*screenHeight;
+
+    // with the camera inside the sphere it covers the whole screen
+    float distance = Vector3Distance(center, camera.position);
+    if (distance <= radius)
+        return screenHeight;
+
+    return radius/(distance*tanf(camera.fovy*0.5f*DEG2RAD))*screenHeight;
+}
+
+int SelectModelLod(const ModelLods* lods, Matrix transform, Camera camera, float screenHeight, int currentLod)
+{
+    if (lods == NULL || lods->meshCount == 0)
+        return 0;
+
+    int lodCount = 1;
+    for (int m = 0; m < lods->meshCount; m++)
+    {
+        if (lods->meshes[m].lodCount > lodCount)
+            lodCount = lods->meshes[m].lodCount;
+    }
+
+    // largest axis scale of the transform, so the sphere still covers the model
+    float scale = fmaxf(Vector3Length((Vector3){transform.m0, transform.m1, transform.m2}),
+                  fmaxf(Vector3Length((Vector3){transform.m4, transform.m5, transform.m6}),
+                        Vector3Length((Vector3){transform.m8, transform.m9, transform.m10})));
+    float pixels = GetSphereScreenPixels(Vector3Transform(lods->center, transform), lods->radius*scale, camera, screenHeight);
+
+    int lod = (currentLod < 0)? 0 : (currentLod >= lodCount)? lodCount - 1 : currentLod;
+    while (lod > 0 && pixels > lodScreenPixels[lod - 1]*(1.0f + LOD_HYSTERESIS))
+        lod--;
+    while (lod < lodCount - 1 && pixels < lodScreenPixels[lod])
+        lod++;
+
+    return lod;
+}
+
+bool GetMeshLodRange(const ModelLods* lods, int mesh, int lod, int* indexOffset, int* indexCount)
+{
+    if (lods == NULL || mesh < 0 || mesh >= lods->meshCount || lods->meshes[mesh].lodCount == 0)
+        return false;
+
+    const MeshLods *levels = &lods->meshes[mesh];
+    if (lod >= levels->lodCount)
+        lod = levels->lodCount - 1;
+    if (lod < 0)
+        lod = 0;
+
+    *indexOffset = levels->indexOffset[lod];
+    *indexCount = levels->indexCount[lod];
+    return true;
+}
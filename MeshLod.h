@@ -0,0 +1,60 @@
+/**********************************************************************************************
+*
+*   RockyRoad * MeshLod * Simplified levels of detail and their selection
+*
+*   Levels of detail are built offline by the mesh cache with quadric error edge collapses.
+*   Collapses only ever move a vertex onto one of its neighbours, so every level keeps using
+*   the original vertex buffer: a mesh stores one index buffer with the level index lists
+*   back to back, and drawing a level is drawing a range of it.
+*
+*   Seam and border vertices never move, which keeps UV seams and open edges intact.
+*
+*   A level is picked from the projected height of the model's bounding sphere. Switching
+*   back to a finer level needs the model to grow past the threshold by a margin, so a
+*   model sitting right at a threshold does not flicker between two levels.
+*
+**********************************************************************************************/
+
+#ifndef MESH_LOD_H
+#define MESH_LOD_H
+
+#include "raylib.h"
+
+#define MAX_MESH_LODS 4
+
+// index ranges of every level of one mesh, level 0 is the full mesh
+typedef struct
+{
+    int lodCount;
+    int indexOffset[MAX_MESH_LODS];
+    int indexCount[MAX_MESH_LODS];
+}MeshLods;
+
+typedef struct
+{
+    int meshCount;
+    MeshLods* meshes;
+
+    // bounding sphere in model space
+    Vector3 center;
+    float radius;
+}ModelLods;
+
+// collapse edges until at most targetIndexCount indices are left or the error would pass
+// maxError (a distance in model units). positions are float triples with the given stride
+// in floats, returns the number of indices written to out
+int SimplifyMeshIndices(const float* positions, int stride, int vertexCount, const int* indices, int indexCount,
+                        int targetIndexCount, float maxError, int* out);
+
+void UnloadModelLods(ModelLods* lods);
+
+// projected height in pixels of a bounding sphere, as used for level selection
+float GetSphereScreenPixels(Vector3 center, float radius, Camera camera, float screenHeight);
+
+// level for a model drawn with the transform, seen by the camera on a screen of the given height
+int SelectModelLod(const ModelLods* lods, Matrix transform, Camera camera, float screenHeight, int currentLod);
+
+// index range of a level, clamped to the levels the mesh has. false without LODs
+bool GetMeshLodRange(const ModelLods* lods, int mesh, int lod, int* indexOffset, int* indexCount);
+
+#endif //MESH_LOD_H
@@ -0,0 +1,339 @@
+/**********************************************************************************************
+*
+*   RockyRoad * Net * UDP sockets and bit-packed packets
+*
+**********************************************************************************************/
+
+#include "Net.h"
+
+#if defined(_WIN32)
+// keep the parts of windows.h out that clash with raylib's names
+#define NOGDI
+#define NOUSER
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+#define CloseSocketHandle closesocket
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define CloseSocketHandle close
+#endif
+
+#include "raylib.h"
+#include "Arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INVALID_HANDLE -1
+
+bool InitNetwork(void)
+{
+#if defined(_WIN32)
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+    {
+        TraceLog(LOG_WARNING, "NET: Could not start Winsock");
+        return false;
+    }
+#endif
+    return true;
+}
+
+void CloseNetwork(void)
+{
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+static struct sockaddr_in ToSockAddr(NetAddress address)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(address.host);
+    addr.sin_port = htons(address.port);
+    return addr;
+}
+
+bool OpenNetSocket(NetSocket* netSocket, unsigned short port)
+{
+    memset(netSocket, 0, sizeof(NetSocket));
+    netSocket->handle = INVALID_HANDLE;
+
+    long long handle = (long long)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (handle == INVALID_HANDLE)
+    {
+        TraceLog(LOG_WARNING, "NET: Could not create a UDP socket");
+        return false;
+    }
+
+    struct sockaddr_in addr = ToSockAddr((NetAddress){ 0, port });
+    socklen_t length = sizeof(addr);
+#if defined(_WIN32)
+    u_long nonBlocking = 1;
+    bool configured = ioctlsocket((SOCKET)handle, FIONBIO, &nonBlocking) == 0;
+#else
+    bool configured = fcntl((int)handle, F_SETFL, fcntl((int)handle, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+    if (!configured || bind(handle, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        getsockname(handle, (struct sockaddr*)&addr, &length) != 0)
+    {
+        TraceLog(LOG_WARNING, "NET: Could not bind UDP port %i", port);
+        CloseSocketHandle(handle);
+        return false;
+    }
+
+    netSocket->handle = handle;
+    netSocket->port = ntohs(addr.sin_port);
+    return true;
+}
+
+void CloseNetSocket(NetSocket* netSocket)
+{
+    if (netSocket->handle != INVALID_HANDLE)
+        CloseSocketHandle(netSocket->handle);
+    GameHeapFree(netSocket->delayed);
+    netSocket->delayed = NULL;
+    netSocket->delayedCount = 0;
+    netSocket->handle = INVALID_HANDLE;
+}
+
+void SetNetConditions(NetSocket* netSocket, int latencyFlushes, float lossRate, unsigned int seed)
+{
+    if (latencyFlushes > 0 && netSocket->delayed == NULL)
+        netSocket->delayed = (NetDelayedPacket*)GameHeapAlloc(NET_MAX_DELAYED*sizeof(NetDelayedPacket));
+
+    netSocket->latencyFlushes = (netSocket->delayed != NULL)? latencyFlushes : 0;
+    netSocket->lossRate = lossRate;
+    netSocket->lossState = seed | 1u;
+}
+
+static void SendNow(NetSocket* netSocket, NetAddress to, const unsigned char* data, int size)
+{
+    struct sockaddr_in addr = ToSockAddr(to);
+    if (sendto(netSocket->handle, (const char*)data, size, 0, (struct sockaddr*)&addr, sizeof(addr)) == size)
+    {
+        netSocket->bytesSent += (unsigned long long)size;
+        netSocket->packetsSent++;
+    }
+}
+
+void SendNetPacket(NetSocket* netSocket, NetAddress to, const unsigned char* data, int size)
+{
+    if (netSocket->handle == INVALID_HANDLE || size <= 0 || size > NET_MAX_PACKET)
+        return;
+
+    if (netSocket->lossRate > 0.0f)
+    {
+        // xorshift32, only decides which packets the simulated link loses
+        unsigned int x = netSocket->lossState;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        netSocket->lossState = x;
+        if ((float)(x >> 8)*(1.0f/16777216.0f) < netSocket->lossRate)
+        {
+            netSocket->packetsDropped++;
+            return;
+        }
+    }
+
+    if (netSocket->latencyFlushes <= 0 || netSocket->delayedCount == NET_MAX_DELAYED)
+    {
+        SendNow(netSocket, to, data, size);
+        return;
+    }
+
+    NetDelayedPacket *packet = &netSocket->delayed[netSocket->delayedCount++];
+    packet->to = to;
+    packet->releaseFlush = netSocket->flushCount + netSocket->latencyFlushes;
+    packet->size = size;
+    memcpy(packet->data, data, size);
+}
+
+void FlushNetSocket(NetSocket* netSocket)
+{
+    netSocket->flushCount++;
+
+    // packets are queued in release order, send the due ones and close the gap
+    int sent = 0;
+    while (sent < netSocket->delayedCount && netSocket->delayed[sent].releaseFlush <= netSocket->flushCount)
+    {
+        NetDelayedPacket *packet = &netSocket->delayed[sent++];
+        SendNow(netSocket, packet->to, packet->data, packet->size);
+    }
+    if (sent > 0)
+    {
+        netSocket->delayedCount -= sent;
+        memmove(netSocket->delayed, netSocket->delayed + sent, netSocket->delayedCount*sizeof(NetDelayedPacket));
+    }
+}
+
+int ReceiveNetPacket(NetSocket* netSocket, NetAddress* from, unsigned char* data, int capacity)
+{
+    if (netSocket->handle == INVALID_HANDLE)
+        return 0;
+
+    struct sockaddr_in addr;
+    socklen_t length = sizeof(addr);
+    int size = (int)recvfrom(netSocket->handle, (char*)data, capacity, 0, (struct sockaddr*)&addr, &length);
+    if (size <= 0)
+        return 0;
+
+    from->host = ntohl(addr.sin_addr.s_addr);
+    from->port = ntohs(addr.sin_port);
+    netSocket->bytesReceived += (unsigned long long)size;
+    netSocket->packetsReceived++;
+    return size;
+}
+
+bool WaitNetSocket(NetSocket* netSocket, int timeoutMs)
+{
+    if (netSocket->handle == INVALID_HANDLE)
+        return false;
+
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(netSocket->handle, &readable);
+    struct timeval timeout = { timeoutMs/1000, (timeoutMs%1000)*1000 };
+    return select((int)netSocket->handle + 1, &readable, NULL, NULL, &timeout) > 0;
+}
+
+bool ParseNetAddress(const char* text, unsigned short defaultPort, NetAddress* address)
+{
+    char host[256];
+    snprintf(host, sizeof(host), "%s", text);
+
+    address->port = defaultPort;
+    char *colon = strrchr(host, ':');
+    if (colon != NULL)
+    {
+        *colon = '\0';
+        address->port = (unsigned short)atoi(colon + 1);
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    struct addrinfo *found = NULL;
+    if (getaddrinfo(host, NULL, &hints, &found) != 0 || found == NULL)
+    {
+        TraceLog(LOG_WARNING, "NET: Could not resolve %s", host);
+        return false;
+    }
+
+    address->host = ntohl(((struct sockaddr_in*)found->ai_addr)->sin_addr.s_addr);
+    freeaddrinfo(found);
+    return true;
+}
+
+bool NetAddressEqual(NetAddress a, NetAddress b)
+{
+    return a.host == b.host && a.port == b.port;
+}
+
+BitWriter StartBitWriter(unsigned char* data, int capacity)
+{
+    memset(data, 0, capacity);
+    BitWriter writer = { data, capacity, 0, false };
+    return writer;
+}
+
+void WriteBits(BitWriter* writer, unsigned int value, int bits)
+{
+    if (writer->bitCount + bits > writer->capacity*8)
+    {
+        writer->overflow = true;
+        return;
+    }
+
+    // least significant bit first, the buffer starts zeroed
+    for (int i = 0; i < bits; i++, writer->bitCount++)
+    {
+        if (value & (1u << i))
+            writer->data[writer->bitCount >> 3] |= (unsigned char)(1u << (writer->bitCount & 7));
+    }
+}
+
+void WriteBool(BitWriter* writer, bool value)
+{
+    WriteBits(writer, value? 1u : 0u, 1);
+}
+
+static int GetBitLength(unsigned int value)
+{
+    int length = 0;
+    while (value != 0)
+    {
+        length++;
+        value >>= 1;
+    }
+    return length;
+}
+
+void WriteVarBits(BitWriter* writer, int value)
+{
+    unsigned int zigzag = ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+
+    // 5 bits cover lengths up to 30, 31 stands for a full 32 bit value
+    int length = GetBitLength(zigzag);
+    if (length >= 31)
+    {
+        WriteBits(writer, 31, 5);
+        WriteBits(writer, zigzag, 32);
+        return;
+    }
+    WriteBits(writer, (unsigned int)length, 5);
+    WriteBits(writer, zigzag, length);
+}
+
+int GetBitWriterSize(const BitWriter* writer)
+{
+    return (writer->bitCount + 7)/8;
+}
+
+BitReader StartBitReader(const unsigned char* data, int size)
+{
+    BitReader reader = { data, size, 0, false };
+    return reader;
+}
+
+unsigned int ReadBits(BitReader* reader, int bits)
+{
+    if (reader->bitCount + bits > reader->size*8)
+    {
+        reader->overflow = true;
+        return 0;
+    }
+
+    unsigned int value = 0;
+    for (int i = 0; i < bits; i++, reader->bitCount++)
+    {
+        if (reader->data[reader->bitCount >> 3] & (1u << (reader->bitCount & 7)))
+            value |= 1u << i;
+    }
+    return value;
+}
+
+bool ReadBool(BitReader* reader)
+{
+    return ReadBits(reader, 1) != 0;
+}
+
+int ReadVarBits(BitReader* reader)
+{
+    int length = (int)ReadBits(reader, 5);
+    unsigned int zigzag = (length == 31)? ReadBits(reader, 32) : ReadBits(reader, length);
+    return (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+}
@@ -0,0 +1,115 @@
+/**********************************************************************************************
+*
+*   RockyRoad * Net * UDP sockets and bit-packed packets
+*
+*   Sockets are non-blocking IPv4 UDP. Every packet is built with a BitWriter and read back
+*   with a BitReader, so fields take exactly the bits they need instead of whole bytes.
+*
+*   A socket can hold its outgoing packets back for a number of flushes and drop a share of
+*   them. Flushing once per tick then plays a link with that latency and loss, which makes a
+*   loopback test behave like a real connection.
+*
+**********************************************************************************************/
+
+#ifndef NET_H
+#define NET_H
+
+#include <stdbool.h>
+
+#define NET_MAX_PACKET 1200                 // stays under common MTUs after IP and UDP headers
+#define NET_MAX_DELAYED 256                 // packets a socket holds back for its latency
+#define NET_LOOPBACK 0x7f000001u            // 127.0.0.1
+
+typedef struct
+{
+    unsigned int host;                      // IPv4 in host byte order
+    unsigned short port;
+}NetAddress;
+
+typedef struct
+{
+    NetAddress to;
+    int releaseFlush;
+    int size;
+    unsigned char data[NET_MAX_PACKET];
+}NetDelayedPacket;
+
+typedef struct
+{
+    long long handle;
+    unsigned short port;                    // bound port, also when the system picked it
+
+    // simulated link, applied to everything sent
+    int latencyFlushes;
+    float lossRate;
+    unsigned int lossState;
+    int flushCount;
+    NetDelayedPacket* delayed;
+    int delayedCount;
+
+    unsigned long long bytesSent;
+    unsigned long long bytesReceived;
+    unsigned int packetsSent;
+    unsigned int packetsReceived;
+    unsigned int packetsDropped;
+}NetSocket;
+
+typedef struct
+{
+    unsigned char* data;
+    int capacity;                           // bytes
+    int bitCount;
+    bool overflow;
+}BitWriter;
+
+typedef struct
+{
+    const unsigned char* data;
+    int size;                               // bytes
+    int bitCount;
+    bool overflow;
+}BitReader;
+
+// start and stop the platform's socket library, once per process
+bool InitNetwork(void);
+void CloseNetwork(void);
+
+// bind a non-blocking UDP socket, port 0 lets the system pick one
+bool OpenNetSocket(NetSocket* netSocket, unsigned short port);
+void CloseNetSocket(NetSocket* netSocket);
+
+// hold sent packets back for latencyFlushes calls to FlushNetSocket and drop lossRate of them
+void SetNetConditions(NetSocket* netSocket, int latencyFlushes, float lossRate, unsigned int seed);
+
+// send now, or queue for later when the socket simulates latency
+void SendNetPacket(NetSocket* netSocket, NetAddress to, const unsigned char* data, int size);
+
+// size of the next waiting packet, 0 when there is none
+int ReceiveNetPacket(NetSocket* netSocket, NetAddress* from, unsigned char* data, int capacity);
+
+// wait up to timeoutMs for a packet to arrive
+bool WaitNetSocket(NetSocket* netSocket, int timeoutMs);
+
+// send the held back packets that are due, call once per tick
+void FlushNetSocket(NetSocket* netSocket);
+
+// "host:port" or "host", names are resolved
+bool ParseNetAddress(const char* text, unsigned short defaultPort, NetAddress* address);
+bool NetAddressEqual(NetAddress a, NetAddress b);
+
+BitWriter StartBitWriter(unsigned char* data, int capacity);
+void WriteBits(BitWriter* writer, unsigned int value, int bits);
+void WriteBool(BitWriter* writer, bool value);
+
+// zigzag value preceded by its bit length in 5 bits, small deltas take a handful of bits
+void WriteVarBits(BitWriter* writer, int value);
+
+// bytes used so far, the last one padded with zeros
+int GetBitWriterSize(const BitWriter* writer);
+
+BitReader StartBitReader(const unsigned char* data, int size);
+unsigned int ReadBits(BitReader* reader, int bits);
+bool ReadBool(BitReader* reader);
+int ReadVarBits(BitReader* reader);
+
+#endif //NET_H
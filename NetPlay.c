@@ -0,0 +1,762 @@
+/**********************************************************************************************
+*
+*   RockyRoad * NetPlay * Racing one course with up to eight players over UDP
+*
+**********************************************************************************************/
+
+#include "NetPlay.h"
+#include "Arena.h"
+#include "LevelGen.h"
+#include "raymath.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NET_MAGIC 0x5252u                   // "RR", first 16 bits of every packet
+#define NET_VERSION 2
+
+#define POSITION_SCALE 64.0f                // fixed point steps per unit of remote positions
+#define ANGLE_SCALE (32768.0f/PI)           // a full turn wraps around 16 bits
+#define HISTORY_MASK (NET_HISTORY - 1)
+
+typedef enum
+{
+    PACKET_CONNECT = 0,
+    PACKET_ACCEPT,
+    PACKET_REJECT,
+    PACKET_INPUT,
+    PACKET_SNAPSHOT,
+    PACKET_DISCONNECT
+}PacketType;
+
+static const NetSnapshot emptySnapshot;
+
+static double GetSeconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec*1e-9;
+}
+
+static unsigned short QuantizeAngle(float angle)
+{
+    // yaw keeps growing while the player turns, only the angle within a turn matters
+    float wrapped = fmodf(angle, 2.0f*PI);
+    return (unsigned short)((unsigned int)lroundf(wrapped*ANGLE_SCALE) & 0xffffu);
+}
+
+static float DequantizeAngle(unsigned short angle)
+{
+    return (float)(short)angle/ANGLE_SCALE;
+}
+
+static SimInput QuantizeInput(SimInput input)
+{
+    input.viewAngles.x = DequantizeAngle(QuantizeAngle(input.viewAngles.x));
+    input.viewAngles.y = DequantizeAngle(QuantizeAngle(input.viewAngles.y));
+    return input;
+}
+
+// the step both sides run, a session that fell or finished starts the course over
+static void StepNetSession(SimSession* session, const SimLevel* level, SimInput input)
+{
+    if (session->state != SIM_SESSION_PLAYING)
+    {
+        InitSimSession(session);
+        return;
+    }
+    StepSimSession(session, level, input);
+}
+
+static int GetCourseChunk(const NetServer* server, const SimSession* session)
+{
+    return FindCourseChunk(server->chunks, server->chunkCount, session->position.x);
+}
+
+static BitWriter StartPacket(unsigned char* data, PacketType type)
+{
+    BitWriter writer = StartBitWriter(data, NET_MAX_PACKET);
+    WriteBits(&writer, NET_MAGIC, 16);
+    WriteBits(&writer, (unsigned int)type, 3);
+    return writer;
+}
+
+static void SendPacket(NetSocket* netSocket, NetAddress to, BitWriter* writer)
+{
+    if (!writer->overflow)
+        SendNetPacket(netSocket, to, writer->data, GetBitWriterSize(writer));
+}
+
+static void SendEmptyPacket(NetSocket* netSocket, NetAddress to, PacketType type)
+{
+    unsigned char data[NET_MAX_PACKET];
+    BitWriter writer = StartPacket(data, type);
+    SendPacket(netSocket, to, &writer);
+}
+
+static unsigned int GetFloatBits(float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float GetBitsFloat(unsigned int bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// a 32 bit field as its XOR with the baseline without the leading zeros, one bit if unchanged
+static void WriteWordDelta(BitWriter* writer, unsigned int value, unsigned int baseline)
+{
+    unsigned int changed = value ^ baseline;
+    WriteBool(writer, changed != 0);
+    if (changed == 0)
+        return;
+
+    int length = 32;
+    while (!(changed & (1u << (length - 1)))) length--;
+    WriteBits(writer, (unsigned int)(length - 1), 5);
+    WriteBits(writer, changed, length);
+}
+
+static unsigned int ReadWordDelta(BitReader* reader, unsigned int baseline)
+{
+    if (!ReadBool(reader))
+        return baseline;
+    int length = (int)ReadBits(reader, 5) + 1;
+    return baseline ^ ReadBits(reader, length);
+}
+
+// floats go as their exact bits, the client compares them with its own prediction
+static void WriteFloatDelta(BitWriter* writer, float value, float baseline)
+{
+    WriteWordDelta(writer, GetFloatBits(value), GetFloatBits(baseline));
+}
+
+static float ReadFloatDelta(BitReader* reader, float baseline)
+{
+    return GetBitsFloat(ReadWordDelta(reader, GetFloatBits(baseline)));
+}
+
+static void WriteVector3Delta(BitWriter* writer, Vector3 value, Vector3 baseline)
+{
+    WriteFloatDelta(writer, value.x, baseline.x);
+    WriteFloatDelta(writer, value.y, baseline.y);
+    WriteFloatDelta(writer, value.z, baseline.z);
+}
+
+static Vector3 ReadVector3Delta(BitReader* reader, Vector3 baseline)
+{
+    Vector3 value;
+    value.x = ReadFloatDelta(reader, baseline.x);
+    value.y = ReadFloatDelta(reader, baseline.y);
+    value.z = ReadFloatDelta(reader, baseline.z);
+    return value;
+}
+
+// every field of the session by itself, so neither the struct layout nor the byte order of
+// either side is part of the protocol
+static void WriteSessionDelta(BitWriter* writer, const SimSession* session, const SimSession* baseline)
+{
+    WriteBits(writer, (unsigned int)session->state, 2);
+    WriteWordDelta(writer, session->tick, baseline->tick);
+    WriteBits(writer, session->events, 4);
+
+    WriteVector3Delta(writer, session->position, baseline->position);
+    WriteFloatDelta(writer, session->viewAngles.x, baseline->viewAngles.x);
+    WriteFloatDelta(writer, session->viewAngles.y, baseline->viewAngles.y);
+
+    WriteFloatDelta(writer, session->body.y, baseline->body.y);
+    WriteFloatDelta(writer, session->body.velocityY, baseline->body.velocityY);
+    WriteFloatDelta(writer, session->body.force, baseline->body.force);
+    WriteBool(writer, session->body.grounded);
+
+    WriteWordDelta(writer, (unsigned int)session->groundIndex, (unsigned int)baseline->groundIndex);
+    WriteWordDelta(writer, (unsigned int)session->lastGroundIndex, (unsigned int)baseline->lastGroundIndex);
+
+    WriteFloatDelta(writer, session->unstableTimer, baseline->unstableTimer);
+    WriteFloatDelta(writer, session->slideX, baseline->slideX);
+    WriteFloatDelta(writer, session->slideVelocity, baseline->slideVelocity);
+    WriteFloatDelta(writer, session->slideOrient, baseline->slideOrient);
+
+    WriteWordDelta(writer, (unsigned int)session->wobbleIndex, (unsigned int)baseline->wobbleIndex);
+    float16 wobble = MatrixToFloatV(session->wobbleTransform);
+    float16 baseWobble = MatrixToFloatV(baseline->wobbleTransform);
+    for (int i = 0; i < 16; i++)
+        WriteFloatDelta(writer, wobble.v[i], baseWobble.v[i]);
+
+    WriteBool(writer, session->grappleEnabled);
+    WriteBool(writer, session->grappling);
+    WriteVector3Delta(writer, session->grappleHit, baseline->grappleHit);
+    WriteVector3Delta(writer, session->grapplePull, baseline->grapplePull);
+}
+
+// starts from a bytewise copy of the baseline, so the padding matches the client's prediction
+static void ReadSessionDelta(BitReader* reader, SimSession* session, const SimSession* baseline)
+{
+    memcpy(session, baseline, sizeof(SimSession));
+
+    session->state = (SimSessionState)ReadBits(reader, 2);
+    session->tick = ReadWordDelta(reader, baseline->tick);
+    session->events = ReadBits(reader, 4);
+
+    session->position = ReadVector3Delta(reader, baseline->position);
+    session->viewAngles.x = ReadFloatDelta(reader, baseline->viewAngles.x);
+    session->viewAngles.y = ReadFloatDelta(reader, baseline->viewAngles.y);
+
+    session->body.y = ReadFloatDelta(reader, baseline->body.y);
+    session->body.velocityY = ReadFloatDelta(reader, baseline->body.velocityY);
+    session->body.force = ReadFloatDelta(reader, baseline->body.force);
+    session->body.grounded = ReadBool(reader);
+
+    session->groundIndex = (int)ReadWordDelta(reader, (unsigned int)baseline->groundIndex);
+    session->lastGroundIndex = (int)ReadWordDelta(reader, (unsigned int)baseline->lastGroundIndex);
+
+    session->unstableTimer = ReadFloatDelta(reader, baseline->unstableTimer);
+    session->slideX = ReadFloatDelta(reader, baseline->slideX);
+    session->slideVelocity = ReadFloatDelta(reader, baseline->slideVelocity);
+    session->slideOrient = ReadFloatDelta(reader, baseline->slideOrient);
+
+    session->wobbleIndex = (int)ReadWordDelta(reader, (unsigned int)baseline->wobbleIndex);
+    float16 wobble = MatrixToFloatV(baseline->wobbleTransform);
+    for (int i = 0; i < 16; i++)
+        wobble.v[i] = ReadFloatDelta(reader, wobble.v[i]);
+    session->wobbleTransform = (Matrix){ wobble.v[0], wobble.v[4], wobble.v[8], wobble.v[12],
+                                         wobble.v[1], wobble.v[5], wobble.v[9], wobble.v[13],
+                                         wobble.v[2], wobble.v[6], wobble.v[10], wobble.v[14],
+                                         wobble.v[3], wobble.v[7], wobble.v[11], wobble.v[15] };
+
+    session->grappleEnabled = ReadBool(reader);
+    session->grappling = ReadBool(reader);
+    session->grappleHit = ReadVector3Delta(reader, baseline->grappleHit);
+    session->grapplePull = ReadVector3Delta(reader, baseline->grapplePull);
+}
+
+static NetRemote GetNetRemote(const SimSession* session)
+{
+    NetRemote remote = { 0 };
+    remote.present = true;
+    remote.position[0] = (int)lroundf(session->position.x*POSITION_SCALE);
+    remote.position[1] = (int)lroundf(session->position.y*POSITION_SCALE);
+    remote.position[2] = (int)lroundf(session->position.z*POSITION_SCALE);
+    remote.viewAngles[0] = QuantizeAngle(session->viewAngles.x);
+    remote.viewAngles[1] = QuantizeAngle(session->viewAngles.y);
+    remote.grappling = session->grappling;
+    if (session->grappling)
+    {
+        remote.grappleHit[0] = (int)lroundf((session->grappleHit.x - session->position.x)*POSITION_SCALE);
+        remote.grappleHit[1] = (int)lroundf((session->grappleHit.y - session->position.y)*POSITION_SCALE);
+        remote.grappleHit[2] = (int)lroundf((session->grappleHit.z - session->position.z)*POSITION_SCALE);
+    }
+    return remote;
+}
+
+// remotes missing from the baseline are written against zero, which costs their full size
+static void WriteRemoteDelta(BitWriter* writer, const NetRemote* remote, const NetRemote* baseline)
+{
+    for (int i = 0; i < 3; i++)
+        WriteVarBits(writer, remote->position[i] - baseline->position[i]);
+    for (int i = 0; i < 2; i++)
+        WriteVarBits(writer, (short)(remote->viewAngles[i] - baseline->viewAngles[i]));
+    WriteBool(writer, remote->grappling);
+    if (remote->grappling)
+    {
+        for (int i = 0; i < 3; i++)
+            WriteVarBits(writer, remote->grappleHit[i] - baseline->grappleHit[i]);
+    }
+}
+
+static void ReadRemoteDelta(BitReader* reader, NetRemote* remote, const NetRemote* baseline)
+{
+    memset(remote, 0, sizeof(NetRemote));
+    remote->present = true;
+    for (int i = 0; i < 3; i++)
+        remote->position[i] = baseline->position[i] + ReadVarBits(reader);
+    for (int i = 0; i < 2; i++)
+        remote->viewAngles[i] = (unsigned short)(baseline->viewAngles[i] + ReadVarBits(reader));
+    remote->grappling = ReadBool(reader);
+    if (remote->grappling)
+    {
+        for (int i = 0; i < 3; i++)
+            remote->grappleHit[i] = baseline->grappleHit[i] + ReadVarBits(reader);
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Server
+//----------------------------------------------------------------------------------
+
+bool StartNetServer(NetServer* server, unsigned short port, unsigned long long courseSeed, int coursePlatforms)
+{
+    memset(server, 0, sizeof(NetServer));
+    if (!OpenNetSocket(&server->socket, port))
+        return false;
+
+    server->courseSeed = courseSeed;
+    server->coursePlatforms = coursePlatforms;
+
+    // the clients generate the same course from the seed, only the server needs its chunks
+    LevelGenParams params = GetDefaultLevelGenParams(coursePlatforms);
+    int capacity = coursePlatforms + 2;
+    CourseElement *elements = (CourseElement*)GameHeapAlloc(capacity*sizeof(CourseElement));
+    server->chunks = (CourseChunk*)GameHeapAlloc(capacity*sizeof(CourseChunk));
+    int count = (elements != NULL && server->chunks != NULL)? GenerateCourse(&params, courseSeed, elements, capacity) : 0;
+    if (count > 0)
+        server->chunkCount = CutCourseChunks(elements, count, server->chunks);
+    GameHeapFree(elements);
+    if (server->chunkCount == 0)
+    {
+        TraceLog(LOG_WARNING, "NET: Could not generate the course of seed %llu", courseSeed);
+        StopNetServer(server);
+        return false;
+    }
+
+    TraceLog(LOG_INFO, "NET: Server listening on port %i, course seed %llu", server->socket.port, courseSeed);
+    return true;
+}
+
+void StopNetServer(NetServer* server)
+{
+    for (int i = 0; i < NET_MAX_PLAYERS; i++)
+    {
+        if (server->clients[i].connected)
+            SendEmptyPacket(&server->socket, server->clients[i].address, PACKET_DISCONNECT);
+    }
+    CloseNetSocket(&server->socket);
+    GameHeapFree(server->chunks);
+    server->chunks = NULL;
+    server->chunkCount = 0;
+}
+
+int GetNetServerPlayerCount(const NetServer* server)
+{
+    int count = 0;
+    for (int i = 0; i < NET_MAX_PLAYERS; i++)
+        count += server->clients[i].connected? 1 : 0;
+    return count;
+}
+
+static int FindNetClient(const NetServer* server, NetAddress address)
+{
+    for (int i = 0; i < NET_MAX_PLAYERS; i++)
+    {
+        if (server->clients[i].connected && NetAddressEqual(server->clients[i].address, address))
+            return i;
+    }
+    return -1;
+}
+
+static void SendAccept(NetServer* server, int id)
+{
+    unsigned char data[NET_MAX_PACKET];
+    BitWriter writer = StartPacket(data, PACKET_ACCEPT);
+    WriteBits(&writer, (unsigned int)id, 3);
+    WriteBits(&writer, (unsigned int)(server->courseSeed & 0xffffffffu), 32);
+    WriteBits(&writer, (unsigned int)(server->courseSeed >> 32), 32);
+    WriteBits(&writer, (unsigned int)server->coursePlatforms, 32);
+    SendPacket(&server->socket, server->clients[id].address, &writer);
+}
+
+static void AcceptNetClient(NetServer* server, NetAddress address, BitReader* reader)
+{
+    if (ReadBits(reader, 8) != NET_VERSION || reader->overflow)
+        return;
+
+    // a lost accept makes the client ask again
+    int id = FindNetClient(server, address);
+    if (id < 0)
+    {
+        for (int i = 0; i < NET_MAX_PLAYERS && id < 0; i++)
+        {
+            if (!server->clients[i].connected) id = i;
+        }
+        if (id < 0)
+        {
+            SendEmptyPacket(&server->socket, address, PACKET_REJECT);
+            return;
+        }
+
+        NetServerClient *client = &server->clients[id];
+        memset(client, 0, sizeof(NetServerClient));
+        client->connected = true;
+        client->address = address;
+        client->nextInput = 1;
+        InitSimSession(&client->session);
+        TraceLog(LOG_INFO, "NET: Player %i joined, %i playing", id, GetNetServerPlayerCount(server));
+    }
+    server->clients[id].idleTicks = 0;
+    SendAccept(server, id);
+}
+
+static void ReadClientInputs(NetServerClient* client, BitReader* reader)
+{
+    unsigned int ackedSnapshot = ReadBits(reader, 32);
+    unsigned int newest = ReadBits(reader, 32);
+    int count = (int)ReadBits(reader, 3);
+    if (reader->overflow || count < 1 || count > NET_INPUT_REDUNDANCY)
+        return;
+
+    // newest first, every older one relative to the one before it
+    SimInput inputs[NET_INPUT_REDUNDANCY];
+    unsigned short angles[2] = { 0 };
+    for (int i = 0; i < count; i++)
+    {
+        inputs[i].buttons = (unsigned char)ReadBits(reader, 8);
+        for (int j = 0; j < 2; j++)
+            angles[j] = (i == 0)? (unsigned short)ReadBits(reader, 16) : (unsigned short)(angles[j] + ReadVarBits(reader));
+        inputs[i].viewAngles = (Vector2){ DequantizeAngle(angles[0]), DequantizeAngle(angles[1]) };
+    }
+    if (reader->overflow)
+        return;
+
+    if (ackedSnapshot > client->ackedSnapshot) client->ackedSnapshot = ackedSnapshot;
+    if (newest > client->newestInput) client->newestInput = newest;
+    client->idleTicks = 0;
+
+    for (int i = 0; i < count && newest >= (unsigned int)i; i++)
+    {
+        unsigned int sequence = newest - (unsigned int)i;
+        if (sequence < client->nextInput || sequence >= client->nextInput + NET_HISTORY) continue;
+        client->inputs[sequence & HISTORY_MASK] = inputs[i];
+        client->inputSequences[sequence & HISTORY_MASK] = sequence;
+    }
+}
+
+static void ApplyClientInputs(NetServerClient* client, const SimLevel* level)
+{
+    for (int step = 0; step < NET_MAX_CATCHUP; step++)
+    {
+        unsigned int sequence = client->nextInput;
+        SimInput input;
+        if (client->inputSequences[sequence & HISTORY_MASK] == sequence)
+            input = client->inputs[sequence & HISTORY_MASK];
+        else if (client->newestInput >= sequence + NET_INPUT_REDUNDANCY)
+        {
+            // every packet that could have carried it is past, hold the buttons without presses
+            input = client->lastInput;
+            input.buttons &= (unsigned char)~(SIM_BUTTON_JUMP | SIM_BUTTON_FIRE);
+            client->stats.inputsFilled++;
+        }
+        else
+            break;
+
+        StepNetSession(&client->session, level, input);
+        client->lastInput = input;
+        client->nextInput++;
+    }
+}
+
+static void SendSnapshot(NetServer* server, int id)
+{
+    NetServerClient *client = &server->clients[id];
+
+    const NetSnapshot *baseline = &emptySnapshot;
+    const NetSnapshot *acked = &client->sent[client->ackedSnapshot & HISTORY_MASK];
+    if (client->ackedSnapshot != 0 && acked->sequence == client->ackedSnapshot && server->tick - client->ackedSnapshot < NET_HISTORY)
+        baseline = acked;
+
+    NetSnapshot *snapshot = &client->sent[server->tick & HISTORY_MASK];
+    memset(snapshot, 0, sizeof(NetSnapshot));
+    snapshot->sequence = server->tick;
+    snapshot->inputSequence = client->nextInput - 1;
+    memcpy(&snapshot->session, &client->session, sizeof(SimSession));
+
+    int chunk = GetCourseChunk(server, &client->session);
+    for (int i = 0; i < NET_MAX_PLAYERS; i++)
+    {
+        const NetServerClient *other = &server->clients[i];
+        if (i == id || !other->connected) continue;
+        if (abs(GetCourseChunk(server, &other->session) - chunk) > NET_INTEREST_CHUNKS) continue;
+        snapshot->remotes[i] = GetNetRemote(&other->session);
+    }
+
+    unsigned char data[NET_MAX_PACKET];
+    BitWriter writer = StartPacket(data, PACKET_SNAPSHOT);
+    WriteBits(&writer, snapshot->sequence, 32);
+    WriteBool(&writer, baseline->sequence != 0);
+    if (baseline->sequence != 0)
+        WriteBits(&writer, snapshot->sequence - baseline->sequence, 6);
+    WriteVarBits(&writer, (int)(snapshot->inputSequence - baseline->inputSequence));
+    WriteSessionDelta(&writer, &snapshot->session, &baseline->session);
+    for (int i = 0; i < NET_MAX_PLAYERS; i++)
+    {
+        WriteBool(&writer, snapshot->remotes[i].present);
+        if (!snapshot->remotes[i].present) continue;
+        WriteRemoteDelta(&writer, &snapshot->remotes[i], &baseline->remotes[i]);
+        client->stats.remotesSent++;
+    }
+
+    SendPacket(&server->socket, client->address, &writer);
+    client->stats.bytesDown += (unsigned long long)GetBitWriterSize(&writer);
+    client->stats.snapshots++;
+}
+
+void UpdateNetServer(NetServer* server, const SimLevel* level)
+{
+    unsigned char data[NET_MAX_PACKET];
+    NetAddress from;
+    int size;
+    while ((size = ReceiveNetPacket(&server->socket, &from, data, NET_MAX_PACKET)) > 0)
+    {
+        BitReader reader = StartBitReader(data, size);
+        if (ReadBits(&reader, 16) != NET_MAGIC) continue;
+        PacketType type = (PacketType)ReadBits(&reader, 3);
+
+        if (type == PACKET_CONNECT)
+        {
+            AcceptNetClient(server, from, &reader);
+            continue;
+        }
+
+        int id = FindNetClient(server, from);
+        if (id < 0) continue;
+        if (type == PACKET_INPUT)
+        {
+            server->clients[id].stats.bytesUp += (unsigned long long)size;
+            ReadClientInputs(&server->clients[id], &reader);
+        }
+        else if (type == PACKET_DISCONNECT)
+        {
+            server->clients[id].connected = false;
+            TraceLog(LOG_INFO, "NET: Player %i left, %i playing", id, GetNetServerPlayerCount(server));
+        }
+    }
+
+    for (int i = 0; i < NET_MAX_PLAYERS; i++)
+    {
+        NetServerClient *client = &server->clients[i];
+        if (!client->connected) continue;
+        if (++client->idleTicks > NET_TIMEOUT_TICKS)
+        {
+            client->connected = false;
+            TraceLog(LOG_INFO, "NET: Player %i timed out, %i playing", i, GetNetServerPlayerCount(server));
+            continue;
+        }
+        ApplyClientInputs(client, level);
+    }
+
+    // every session has moved before any snapshot is taken, all players see the same tick
+    server->tick++;
+    for (int i = 0; i < NET_MAX_PLAYERS; i++)
+    {
+        if (server->clients[i].connected)
+            SendSnapshot(server, i);
+    }
+    FlushNetSocket(&server->socket);
+}
+
+//----------------------------------------------------------------------------------
+// Client
+//----------------------------------------------------------------------------------
+
+bool StartNetClient(NetClient* client, NetAddress server)
+{
+    memset(client, 0, sizeof(NetClient));
+    client->server = server;
+    client->id = -1;
+    return OpenNetSocket(&client->socket, 0);
+}
+
+void StopNetClient(NetClient* client)
+{
+    if (client->accepted)
+        SendEmptyPacket(&client->socket, client->server, PACKET_DISCONNECT);
+    FlushNetSocket(&client->socket);
+    CloseNetSocket(&client->socket);
+    client->accepted = false;
+}
+
+static void ReadAccept(NetClient* client, BitReader* reader)
+{
+    int id = (int)ReadBits(reader, 3);
+    unsigned long long seed = ReadBits(reader, 32);
+    seed |= (unsigned long long)ReadBits(reader, 32) << 32;
+    int platforms = (int)ReadBits(reader, 32);
+    if (reader->overflow || client->accepted)
+        return;
+
+    client->accepted = true;
+    client->id = id;
+    client->courseSeed = seed;
+    client->coursePlatforms = platforms;
+    InitSimSession(&client->session);
+    memcpy(&client->states[0], &client->session, sizeof(SimSession));
+    TraceLog(LOG_INFO, "NET: Joined as player %i, course seed %llu", id, seed);
+}
+
+// -1 for no platform, anything else has to name one of the level's
+static bool IsPlatformIndexValid(int index, const SimLevel* level)
+{
+    return index == -1 || (index >= 0 && index < level->platformCount);
+}
+
+// the platform indices are checked once the level is known, a snapshot naming a platform the
+// course does not have is dropped before the session indexes the level with it
+static bool ReadSnapshot(NetClient* client, BitReader* reader, const SimLevel* level, NetSnapshot* snapshot)
+{
+    memset(snapshot, 0, sizeof(NetSnapshot));
+    snapshot->sequence = ReadBits(reader, 32);
+
+    const NetSnapshot *baseline = &emptySnapshot;
+    if (ReadBool(reader))
+    {
+        unsigned int sequence = snapshot->sequence - ReadBits(reader, 6);
+        baseline = &client->received[sequence & HISTORY_MASK];
+        if (baseline->sequence != sequence)
+            return false;
+    }
+    if (reader->overflow || snapshot->sequence <= client->newestSnapshot)
+        return false;
+
+    snapshot->inputSequence = baseline->inputSequence + (unsigned int)ReadVarBits(reader);
+    ReadSessionDelta(reader, &snapshot->session, &baseline->session);
+    for (int i = 0; i < NET_MAX_PLAYERS; i++)
+    {
+        if (ReadBool(reader))
+            ReadRemoteDelta(reader, &snapshot->remotes[i], &baseline->remotes[i]);
+    }
+    if (reader->overflow)
+        return false;
+
+    const SimSession *session = &snapshot->session;
+    return level == NULL || (IsPlatformIndexValid(session->groundIndex, level) && IsPlatformIndexValid(session->lastGroundIndex, level) &&
+                             IsPlatformIndexValid(session->wobbleIndex, level));
+}
+
+// replay the inputs the server has not applied yet on top of its state
+static void ReconcileNetClient(NetClient* client, const NetSnapshot* snapshot, const SimLevel* level)
+{
+    double start = GetSeconds();
+    unsigned int acked = snapshot->inputSequence;
+    client->stats.snapshots++;
+
+    if (acked > client->inputSequence || client->inputSequence - acked >= NET_HISTORY)
+    {
+        // the prediction to compare with is gone, take the server state as it is
+        memcpy(&client->session, &snapshot->session, sizeof(SimSession));
+        client->inputSequence = acked;
+        memcpy(&client->states[acked & HISTORY_MASK], &client->session, sizeof(SimSession));
+        client->stats.corrections++;
+    }
+    else if (memcmp(&client->states[acked & HISTORY_MASK], &snapshot->session, sizeof(SimSession)) != 0)
+    {
+        memcpy(&client->session, &snapshot->session, sizeof(SimSession));
+        memcpy(&client->states[acked & HISTORY_MASK], &client->session, sizeof(SimSession));
+        for (unsigned int sequence = acked + 1; sequence <= client->inputSequence; sequence++)
+        {
+            StepNetSession(&client->session, level, client->inputs[sequence & HISTORY_MASK]);
+            memcpy(&client->states[sequence & HISTORY_MASK], &client->session, sizeof(SimSession));
+            client->stats.resimulatedTicks++;
+        }
+        client->stats.corrections++;
+    }
+
+    double seconds = GetSeconds() - start;
+    client->stats.reconcileSeconds += seconds;
+    if (seconds > client->stats.maxReconcileSeconds) client->stats.maxReconcileSeconds = seconds;
+}
+
+void ReceiveNetClient(NetClient* client, const SimLevel* level)
+{
+    unsigned char data[NET_MAX_PACKET];
+    NetAddress from;
+    int size;
+    bool reconcile = false;
+    while ((size = ReceiveNetPacket(&client->socket, &from, data, NET_MAX_PACKET)) > 0)
+    {
+        BitReader reader = StartBitReader(data, size);
+        if (!NetAddressEqual(from, client->server) || ReadBits(&reader, 16) != NET_MAGIC) continue;
+        PacketType type = (PacketType)ReadBits(&reader, 3);
+
+        if (type == PACKET_ACCEPT)
+            ReadAccept(client, &reader);
+        else if (type == PACKET_REJECT && !client->accepted)
+            TraceLog(LOG_WARNING, "NET: Server is full");
+        else if (type == PACKET_DISCONNECT && client->accepted)
+        {
+            client->accepted = false;
+            TraceLog(LOG_WARNING, "NET: Server closed the connection");
+        }
+        else if (type == PACKET_SNAPSHOT && client->accepted)
+        {
+            NetSnapshot snapshot;
+            if (!ReadSnapshot(client, &reader, level, &snapshot)) continue;
+            memcpy(&client->received[snapshot.sequence & HISTORY_MASK], &snapshot, sizeof(NetSnapshot));
+            client->newestSnapshot = snapshot.sequence;
+            reconcile = true;
+        }
+    }
+
+    // older snapshots in the same batch are only baselines, the newest decides
+    if (reconcile && level != NULL)
+        ReconcileNetClient(client, &client->received[client->newestSnapshot & HISTORY_MASK], level);
+
+    if (!client->accepted && --client->retryTicks <= 0)
+    {
+        unsigned char packet[NET_MAX_PACKET];
+        BitWriter writer = StartPacket(packet, PACKET_CONNECT);
+        WriteBits(&writer, NET_VERSION, 8);
+        SendPacket(&client->socket, client->server, &writer);
+        client->retryTicks = NET_CONNECT_RETRY_TICKS;
+    }
+    FlushNetSocket(&client->socket);
+}
+
+void StepNetClient(NetClient* client, const SimLevel* level, SimInput input)
+{
+    if (!client->accepted)
+        return;
+
+    unsigned int sequence = ++client->inputSequence;
+    client->inputs[sequence & HISTORY_MASK] = QuantizeInput(input);
+    StepNetSession(&client->session, level, client->inputs[sequence & HISTORY_MASK]);
+    memcpy(&client->states[sequence & HISTORY_MASK], &client->session, sizeof(SimSession));
+
+    int count = (sequence < NET_INPUT_REDUNDANCY)? (int)sequence : NET_INPUT_REDUNDANCY;
+    unsigned char data[NET_MAX_PACKET];
+    BitWriter writer = StartPacket(data, PACKET_INPUT);
+    WriteBits(&writer, client->newestSnapshot, 32);
+    WriteBits(&writer, sequence, 32);
+    WriteBits(&writer, (unsigned int)count, 3);
+    unsigned short previous[2] = { 0 };
+    for (int i = 0; i < count; i++)
+    {
+        const SimInput *sent = &client->inputs[(sequence - (unsigned int)i) & HISTORY_MASK];
+        unsigned short angles[2] = { QuantizeAngle(sent->viewAngles.x), QuantizeAngle(sent->viewAngles.y) };
+        WriteBits(&writer, sent->buttons, 8);
+        for (int j = 0; j < 2; j++)
+        {
+            if (i == 0) WriteBits(&writer, angles[j], 16);
+            else WriteVarBits(&writer, (short)(angles[j] - previous[j]));
+            previous[j] = angles[j];
+        }
+    }
+    SendPacket(&client->socket, client->server, &writer);
+}
+
+bool GetNetRemoteFrame(const NetClient* client, int id, GhostFrame* frame)
+{
+    if (!client->accepted || id < 0 || id >= NET_MAX_PLAYERS || id == client->id)
+        return false;
+
+    const NetRemote *remote = &client->received[client->newestSnapshot & HISTORY_MASK].remotes[id];
+    if (!remote->present)
+        return false;
+
+    memset(frame, 0, sizeof(GhostFrame));
+    frame->position = (Vector3){ remote->position[0]/POSITION_SCALE, remote->position[1]/POSITION_SCALE, remote->position[2]/POSITION_SCALE };
+    frame->viewAngles = (Vector2){ DequantizeAngle(remote->viewAngles[0]), DequantizeAngle(remote->viewAngles[1]) };
+    frame->grappling = remote->grappling;
+    if (remote->grappling)
+    {
+        frame->grappleHit = (Vector3){ frame->position.x + remote->grappleHit[0]/POSITION_SCALE,
+                                       frame->position.y + remote->grappleHit[1]/POSITION_SCALE,
+                                       frame->position.z + remote->grappleHit[2]/POSITION_SCALE };
+    }
+    return true;
+}
@@ -0,0 +1,154 @@
+/**********************************************************************************************
+*
+*   RockyRoad * NetPlay * Racing one course with up to eight players over UDP
+*
+*   The server runs a SimSession per player on the shared generated course and steps it once
+*   for every input the player's client sends; the course itself travels as its seed. Clients
+*   predict their own session with the same inputs and keep the states they predicted. When a
+*   snapshot reports the server state after input n, the client compares it with its own
+*   prediction for n and, on a mismatch, restarts from the server state and replays the
+*   inputs it sent since. Inputs are quantized before the client predicts with them, so both
+*   sides step with identical values and a mismatch means a lost input or a real difference.
+*
+*   Input packets repeat the last NET_INPUT_REDUNDANCY inputs and acknowledge the newest
+*   snapshot the client has. Snapshots are delta compressed against that snapshot: the own
+*   session field by field, each as its bits XOR the baseline's, the other players as fixed
+*   point deltas. Only players within NET_INTEREST_CHUNKS chunks of the receiver are sent at
+*   all, cut from the seed's course the same way a saved course file is.
+*
+*   Nothing here waits on a socket or reads a clock besides timing the reconciliation, so a
+*   server and its clients can run in one process over loopback.
+*
+**********************************************************************************************/
+
+#ifndef NET_PLAY_H
+#define NET_PLAY_H
+
+#include "CourseStream.h"
+#include "Ghost.h"
+#include "Net.h"
+#include "SimSession.h"
+
+#define NET_MAX_PLAYERS 8
+#define NET_DEFAULT_PORT 27960
+#define NET_INPUT_REDUNDANCY 4              // inputs repeated in every input packet
+#define NET_HISTORY 64                      // ticks of inputs, states and snapshots kept, a power of two
+#define NET_INTEREST_CHUNKS 1               // course chunks on either side of a player that are sent
+#define NET_MAX_CATCHUP 4                   // inputs the server applies per player and tick
+#define NET_TIMEOUT_TICKS (SIM_TICK_RATE*5)
+#define NET_CONNECT_RETRY_TICKS (SIM_TICK_RATE/2)
+
+// another player as a snapshot carries it, fixed point
+typedef struct
+{
+    bool present;
+    int position[3];                        // 1/64 units
+    unsigned short viewAngles[2];
+    bool grappling;
+    int grappleHit[3];                      // relative to position
+}NetRemote;
+
+typedef struct
+{
+    unsigned int sequence;                  // server tick it was sent, 0 for none
+    unsigned int inputSequence;             // last input applied to the receiver's session
+    SimSession session;
+    NetRemote remotes[NET_MAX_PLAYERS];
+}NetSnapshot;
+
+// per client accounting, for the benchmark and the debug overlay
+typedef struct
+{
+    unsigned long long bytesUp;             // input packets received by the server
+    unsigned long long bytesDown;           // snapshots sent to the client
+    unsigned int snapshots;
+    unsigned int remotesSent;               // summed over snapshots
+    unsigned int inputsFilled;              // inputs lost beyond redundancy and repeated
+}NetServerStats;
+
+typedef struct
+{
+    bool connected;
+    NetAddress address;
+    int idleTicks;
+
+    SimSession session;
+    unsigned int nextInput;                 // sequence of the next input to apply
+    unsigned int newestInput;               // newest sequence received
+    SimInput lastInput;
+    SimInput inputs[NET_HISTORY];
+    unsigned int inputSequences[NET_HISTORY];
+
+    unsigned int ackedSnapshot;             // newest snapshot the client reported
+    NetSnapshot sent[NET_HISTORY];          // baselines, by sequence
+
+    NetServerStats stats;
+}NetServerClient;
+
+typedef struct
+{
+    NetSocket socket;
+    unsigned long long courseSeed;
+    int coursePlatforms;
+    CourseChunk* chunks;                    // of the generated course, for interest management
+    int chunkCount;
+    unsigned int tick;
+    NetServerClient clients[NET_MAX_PLAYERS];
+}NetServer;
+
+typedef struct
+{
+    unsigned int snapshots;
+    unsigned int corrections;               // snapshots that disagreed with the prediction
+    unsigned int resimulatedTicks;
+    double reconcileSeconds;
+    double maxReconcileSeconds;             // worst single snapshot
+}NetClientStats;
+
+typedef struct
+{
+    NetSocket socket;
+    NetAddress server;
+    bool accepted;
+    int id;
+    unsigned long long courseSeed;
+    int coursePlatforms;
+    int retryTicks;
+
+    // predicted own session, states[n] is the session after input n
+    SimSession session;
+    unsigned int inputSequence;
+    SimInput inputs[NET_HISTORY];
+    SimSession states[NET_HISTORY];
+
+    NetSnapshot received[NET_HISTORY];      // baselines, by sequence
+    unsigned int newestSnapshot;
+
+    NetClientStats stats;
+}NetClient;
+
+// open the server socket, port 0 lets the system pick one. the course is sent as its seed
+// and cut into chunks here
+bool StartNetServer(NetServer* server, unsigned short port, unsigned long long courseSeed, int coursePlatforms);
+void StopNetServer(NetServer* server);
+
+// read all waiting packets, apply the inputs that arrived and send every client a snapshot
+void UpdateNetServer(NetServer* server, const SimLevel* level);
+
+int GetNetServerPlayerCount(const NetServer* server);
+
+// open a client socket and start asking the server to let it in
+bool StartNetClient(NetClient* client, NetAddress server);
+void StopNetClient(NetClient* client);
+
+// read all waiting packets, reconcile with the newest snapshot and keep asking to connect
+void ReceiveNetClient(NetClient* client, const SimLevel* level);
+
+// predict one tick with input and send it, does nothing until the server accepted the client
+void StepNetClient(NetClient* client, const SimLevel* level, SimInput input);
+
+// the newest known state of another player, drawn like a ghost. false when they are absent or
+// too far away to be sent
+bool GetNetRemoteFrame(const NetClient* client, int id, GhostFrame* frame);
+
+#endif //NET_PLAY_H
@@ -0,0 +1,449 @@
+/**********************************************************************************************
+*
+*   RockyRoad * PoseCache * Baked animation clips for the GPU skin
+*
+**********************************************************************************************/
+
+#include "PoseCache.h"
+#include "Arena.h"
+#include "MemTrack.h"
+#include "Skinning.h"
+
+#include <math.h>
+#include <string.h>
+
+#define POSE_CACHE_MAGIC 0x43505252         // "RRPC"
+#define POSE_CACHE_VERSION 3
+
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+typedef struct
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned int sourceHash;
+    int boneCount;
+    int clipCount;
+}PoseCacheHeader;
+
+typedef struct
+{
+    char name[POSE_CLIP_NAME_SIZE];
+    int frameCount;
+    int loop;
+}PoseClipHeader;
+
+static unsigned int HashBytes(unsigned int hash, const void* data, size_t size)
+{
+    const unsigned char *bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static int ClipTableBytes(int boneCount, int frameCount)
+{
+    int values = boneCount*SKIN_BONE_ROW_FLOATS;
+    return values*2*(int)sizeof(float) + values*frameCount*(int)sizeof(unsigned short);
+}
+
+// clamp a clip description to the animation it points at, returns false if there is nothing to bake
+static bool ResolveClip(const ModelAnimation* anims, int animCount, PoseClipDesc desc, int* first, int* count)
+{
+    if (desc.animation < 0 || desc.animation >= animCount || anims[desc.animation].frameCount <= 0)
+        return false;
+
+    int frames = anims[desc.animation].frameCount;
+    *first = (desc.firstFrame < 0)? 0 : (desc.firstFrame >= frames)? frames - 1 : desc.firstFrame;
+    *count = (desc.frameCount < 0 || *first + desc.frameCount > frames)? frames - *first : desc.frameCount;
+    if (*count < 1)
+        *count = 1;
+
+    return true;
+}
+
+// the animation file is hashed as raw bytes so a cache can be checked without parsing it
+static unsigned int HashSource(Model model, const unsigned char* animData, unsigned int animDataSize, const PoseClipDesc* clips, int clipCount)
+{
+    unsigned int hash = FNV_OFFSET;
+    hash = HashBytes(hash, &model.boneCount, sizeof(model.boneCount));
+    if (model.bindPose != NULL)
+        hash = HashBytes(hash, model.bindPose, model.boneCount*sizeof(Transform));
+
+    for (int c = 0; c < clipCount; c++)
+    {
+        hash = HashBytes(hash, clips[c].name, strlen(clips[c].name));
+        hash = HashBytes(hash, &clips[c].animation, sizeof(clips[c].animation));
+        hash = HashBytes(hash, &clips[c].firstFrame, sizeof(clips[c].firstFrame));
+        hash = HashBytes(hash, &clips[c].frameCount, sizeof(clips[c].frameCount));
+        hash = HashBytes(hash, &clips[c].loop, sizeof(clips[c].loop));
+    }
+
+    if (animData != NULL)
+        hash = HashBytes(hash, animData, animDataSize);
+
+    return hash;
+}
+
+// lay the clips and their tables out in one block, clip headers have to be filled in
+static bool AllocatePoseCache(PoseCache* cache, const PoseClipHeader* headers)
+{
+    int size = cache->clipCount*(int)sizeof(PoseClip);
+    for (int c = 0; c < cache->clipCount; c++)
+        size += ClipTableBytes(cache->boneCount, headers[c].frameCount);
+
+    cache->block = GameHeapAlloc(size);
+    if (cache->block == NULL)
+        return false;
+
+    cache->blockSize = size;
+    cache->clips = (PoseClip*)cache->block;
+
+    unsigned char *cursor = (unsigned char*)cache->block + cache->clipCount*sizeof(PoseClip);
+    int values = cache->boneCount*SKIN_BONE_ROW_FLOATS;
+
+    for (int c = 0; c < cache->clipCount; c++)
+    {
+        PoseClip *clip = &cache->clips[c];
+        memcpy(clip->name, headers[c].name, POSE_CLIP_NAME_SIZE);
+        clip->name[POSE_CLIP_NAME_SIZE - 1] = '\0';
+        clip->frameCount = headers[c].frameCount;
+        clip->loop = headers[c].loop != 0;
+
+        clip->min = (float*)cursor;
+        cursor += values*sizeof(float);
+        clip->step = (float*)cursor;
+        cursor += values*sizeof(float);
+        clip->frames = (unsigned short*)cursor;
+        cursor += values*clip->frameCount*sizeof(unsigned short);
+    }
+
+    TrackMemory(MEM_CPU_MESH, (unsigned long long)(size_t)cache->block, size, "pose cache");
+    return true;
+}
+
+PoseCache BakePoseCache(Model model, const ModelAnimation* anims, int animCount, const PoseClipDesc* clips, int clipCount)
+{
+    PoseCache cache = { 0 };
+    if (model.boneCount <= 0 || model.bindPose == NULL || clipCount <= 0)
+        return cache;
+
+    PoseClipHeader *headers = (PoseClipHeader*)GameHeapAlloc(clipCount*sizeof(PoseClipHeader));
+    if (headers == NULL)
+        return cache;
+
+    int maxFrames = 1;
+    for (int c = 0; c < clipCount; c++)
+    {
+        int first = 0;
+        int count = 1;
+        if (!ResolveClip(anims, animCount, clips[c], &first, &count) || anims[clips[c].animation].boneCount != model.boneCount)
+        {
+            TraceLog(LOG_WARNING, "POSE: Clip [%s] does not match the model, baked as the bind pose", clips[c].name);
+            count = 1;
+        }
+
+        strncpy(headers[c].name, clips[c].name, POSE_CLIP_NAME_SIZE - 1);
+        headers[c].frameCount = count;
+        headers[c].loop = clips[c].loop;
+        if (count > maxFrames)
+            maxFrames = count;
+    }
+
+    cache.boneCount = model.boneCount;
+    cache.clipCount = clipCount;
+
+    int values = model.boneCount*SKIN_BONE_ROW_FLOATS;
+    float *rows = (float*)GameHeapAlloc(maxFrames*values*sizeof(float));
+
+    if (rows == NULL || !AllocatePoseCache(&cache, headers))
+    {
+        GameHeapFree(rows);
+        GameHeapFree(headers);
+        return (PoseCache){ 0 };
+    }
+
+    for (int c = 0; c < clipCount; c++)
+    {
+        PoseClip *clip = &cache.clips[c];
+        int first = 0;
+        int count = 1;
+        bool valid = ResolveClip(anims, animCount, clips[c], &first, &count) && anims[clips[c].animation].boneCount == model.boneCount;
+
+        for (int f = 0; f < clip->frameCount; f++)
+        {
+            for (int b = 0; b < model.boneCount; b++)
+            {
+                Transform pose = valid? anims[clips[c].animation].framePoses[first + f][b] : model.bindPose[b];
+                ComputeSkinBoneRows(model.bindPose[b], pose, &rows[(f*model.boneCount + b)*SKIN_BONE_ROW_FLOATS]);
+            }
+        }
+
+        // each component gets the full 16 bits over the range it actually covers in this clip
+        for (int i = 0; i < values; i++)
+        {
+            float low = rows[i];
+            float high = rows[i];
+            for (int f = 1; f < clip->frameCount; f++)
+            {
+                float value = rows[f*values + i];
+                low = fminf(low, value);
+                high = fmaxf(high, value);
+            }
+
+            clip->min[i] = low;
+            clip->step[i] = (high - low)/65535.0f;
+
+            for (int f = 0; f < clip->frameCount; f++)
+            {
+                float q = (clip->step[i] > 0.0f)? (rows[f*values + i] - low)/clip->step[i] : 0.0f;
+                clip->frames[f*values + i] = (unsigned short)fminf(roundf(q), 65535.0f);
+            }
+        }
+    }
+
+    GameHeapFree(rows);
+    GameHeapFree(headers);
+
+    TraceLog(LOG_INFO, "POSE: Baked %i clips for %i bones [%i bytes]", cache.clipCount, cache.boneCount, cache.blockSize);
+    return cache;
+}
+
+bool SavePoseCache(PoseCache cache, const char* fileName)
+{
+    if (cache.block == NULL)
+        return false;
+
+    int size = (int)sizeof(PoseCacheHeader) + cache.clipCount*(int)sizeof(PoseClipHeader);
+    for (int c = 0; c < cache.clipCount; c++)
+        size += ClipTableBytes(cache.boneCount, cache.clips[c].frameCount);
+
+    unsigned char *data = (unsigned char*)GameHeapAlloc(size);
+    if (data == NULL)
+        return false;
+
+    PoseCacheHeader header = {POSE_CACHE_MAGIC, POSE_CACHE_VERSION, cache.sourceHash, cache.boneCount, cache.clipCount};
+    memcpy(data, &header, sizeof(header));
+
+    unsigned char *cursor = data + sizeof(header);
+    for (int c = 0; c < cache.clipCount; c++)
+    {
+        PoseClipHeader clipHeader = { 0 };
+        memcpy(clipHeader.name, cache.clips[c].name, POSE_CLIP_NAME_SIZE);
+        clipHeader.frameCount = cache.clips[c].frameCount;
+        clipHeader.loop = cache.clips[c].loop;
+        memcpy(cursor, &clipHeader, sizeof(clipHeader));
+        cursor += sizeof(clipHeader);
+    }
+
+    // the tables follow the clip headers in the order they sit in the block
+    memcpy(cursor, (unsigned char*)cache.block + cache.clipCount*sizeof(PoseClip), cache.blockSize - cache.clipCount*sizeof(PoseClip));
+
+    bool saved = SaveFileData(fileName, data, size);
+    GameHeapFree(data);
+    return saved;
+}
+
+PoseCache LoadPoseCache(const char* fileName)
+{
+    PoseCache cache = { 0 };
+    if (!FileExists(fileName))
+        return cache;
+
+    unsigned int size = 0;
+    unsigned char *data = LoadFileData(fileName, &size);
+    if (data == NULL)
+        return cache;
+
+    PoseCacheHeader header;
+    if (size < sizeof(header))
+    {
+        UnloadFileData(data);
+        return cache;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if (header.magic != POSE_CACHE_MAGIC || header.version != POSE_CACHE_VERSION || header.boneCount <= 0 || header.clipCount <= 0 ||
+        size < sizeof(header) + header.clipCount*sizeof(PoseClipHeader))
+    {
+        TraceLog(LOG_WARNING, "POSE: [%s] Not a pose cache of this version", fileName);
+        UnloadFileData(data);
+        return cache;
+    }
+
+    const PoseClipHeader *headers = (const PoseClipHeader*)(data + sizeof(header));
+    unsigned int expected = sizeof(header) + header.clipCount*sizeof(PoseClipHeader);
+    bool valid = header.boneCount <= SKIN_MAX_BONES;
+    for (int c = 0; c < header.clipCount && valid; c++)
+    {
+        valid = headers[c].frameCount > 0 && headers[c].frameCount <= (int)size;
+        if (valid)
+            expected += ClipTableBytes(header.boneCount, headers[c].frameCount);
+    }
+
+    if (!valid || expected != size)
+    {
+        TraceLog(LOG_WARNING, "POSE: [%s] Truncated or corrupt pose cache", fileName);
+        UnloadFileData(data);
+        return cache;
+    }
+
+    cache.boneCount = header.boneCount;
+    cache.clipCount = header.clipCount;
+    cache.sourceHash = header.sourceHash;
+
+    if (AllocatePoseCache(&cache, headers))
+    {
+        unsigned int tables = sizeof(header) + header.clipCount*sizeof(PoseClipHeader);
+        memcpy((unsigned char*)cache.block + cache.clipCount*sizeof(PoseClip), data + tables, size - tables);
+    }
+    else
+    {
+        cache = (PoseCache){ 0 };
+    }
+
+    UnloadFileData(data);
+    return cache;
+}
+
+PoseCache LoadOrBakePoseCache(const char* fileName, Model model, const char* animFileName, const PoseClipDesc* clips, int clipCount)
+{
+    unsigned int animDataSize = 0;
+    unsigned char *animData = FileExists(animFileName)? LoadFileData(animFileName, &animDataSize) : NULL;
+    unsigned int sourceHash = HashSource(model, animData, animDataSize, clips, clipCount);
+    UnloadFileData(animData);
+
+    PoseCache cache = LoadPoseCache(fileName);
+    if (cache.block != NULL && cache.sourceHash == sourceHash && cache.boneCount == model.boneCount && cache.clipCount == clipCount)
+    {
+        TraceLog(LOG_INFO, "POSE: [%s] Loaded %i baked clips", fileName, cache.clipCount);
+        return cache;
+    }
+
+    // only a bake needs the animations themselves
+    UnloadPoseCache(&cache);
+    int animCount = 0;
+    ModelAnimation *anims = LoadModelAnimations(animFileName, &animCount);
+    cache = BakePoseCache(model, anims, animCount, clips, clipCount);
+    UnloadModelAnimations(anims, animCount);
+
+    cache.sourceHash = sourceHash;
+    if (cache.block != NULL && !SavePoseCache(cache, fileName))
+        TraceLog(LOG_WARNING, "POSE: [%s] Failed to save the pose cache", fileName);
+
+    return cache;
+}
+
+void UnloadPoseCache(PoseCache* cache)
+{
+    if (cache == NULL || cache->block == NULL)
+        return;
+
+    UntrackMemory(MEM_CPU_MESH, (unsigned long long)(size_t)cache->block);
+    GameHeapFree(cache->block);
+    *cache = (PoseCache){ 0 };
+}
+
+int FindPoseClip(const PoseCache* cache, const char* name)
+{
+    for (int c = 0; c < cache->clipCount; c++)
+    {
+        if (strcmp(cache->clips[c].name, name) == 0)
+            return c;
+    }
+    return -1;
+}
+
+// blend a clip sample into rows by weight, a weight of 1 overwrites them
+static void SampleClipInto(const PoseCache* cache, int clipIndex, float time, float* rows, float weight)
+{
+    const PoseClip *clip = &cache->clips[clipIndex];
+    float frame = time*SKIN_ANIMATION_FPS;
+    int last = clip->frameCount - 1;
+
+    int first;
+    int second;
+    float amount;
+
+    if (clip->loop)
+    {
+        frame = fmodf(frame, (float)clip->frameCount);
+        if (frame < 0.0f)
+            frame += (float)clip->frameCount;
+        first = (int)frame;
+        second = (first + 1) % clip->frameCount;
+        amount = frame - (float)first;
+    }
+    else
+    {
+        frame = (frame < 0.0f)? 0.0f : (frame > (float)last)? (float)last : frame;
+        first = (int)frame;
+        second = (first < last)? first + 1 : last;
+        amount = frame - (float)first;
+    }
+
+    int values = cache->boneCount*SKIN_BONE_ROW_FLOATS;
+    const unsigned short *a = &clip->frames[first*values];
+    const unsigned short *b = &clip->frames[second*values];
+
+    for (int i = 0; i < values; i++)
+    {
+        float q = (float)a[i] + ((float)b[i] - (float)a[i])*amount;
+        float value = clip->min[i] + clip->step[i]*q;
+        rows[i] = (weight >= 1.0f)? value : rows[i] + (value - rows[i])*weight;
+    }
+}
+
+void SamplePoseClip(const PoseCache* cache, int clip, float time, float* rows)
+{
+    if (clip < 0 || clip >= cache->clipCount)
+        return;
+
+    SampleClipInto(cache, clip, time, rows, 1.0f);
+}
+
+void PlayPoseClip(PosePlayer* player, int clip, float blendDuration)
+{
+    if (player->clip == clip)
+        return;
+
+    player->fromClip = player->clip;
+    player->fromTime = player->time;
+    player->clip = clip;
+    player->time = 0.0f;
+    player->blendDuration = blendDuration;
+    player->blend = (blendDuration > 0.0f)? 0.0f : 1.0f;
+}
+
+void UpdatePosePlayer(PosePlayer* player, float dt)
+{
+    player->time += dt;
+    player->fromTime += dt;
+
+    if (player->blend < 1.0f)
+    {
+        player->blend += dt/player->blendDuration;
+        if (player->blend > 1.0f)
+            player->blend = 1.0f;
+    }
+}
+
+void SamplePosePlayer(const PoseCache* cache, const PosePlayer* player, float* rows)
+{
+    if (player->clip < 0 || player->clip >= cache->clipCount)
+        return;
+
+    if (player->blend < 1.0f && player->fromClip >= 0 && player->fromClip < cache->clipCount)
+    {
+        SampleClipInto(cache, player->fromClip, player->fromTime, rows, 1.0f);
+        SampleClipInto(cache, player->clip, player->time, rows, player->blend);
+    }
+    else
+    {
+        SampleClipInto(cache, player->clip, player->time, rows, 1.0f);
+    }
+}
@@ -0,0 +1,96 @@
+/**********************************************************************************************
+*
+*   RockyRoad * PoseCache * Baked animation clips for the GPU skin
+*
+*   A clip is a window of frames out of one of the model's animations. Baking evaluates the
+*   glTF poses once and stores the finished bone matrix rows of every frame, quantized to 16
+*   bits against a per bone, per component range. Sampling a pose is then two table lookups
+*   and a lerp per component, with no quaternion or hierarchy work at runtime.
+*
+*   The baked tables are saved to disk and reloaded on later launches as long as the model,
+*   the animation file and the clip list are unchanged. The animations are only parsed when
+*   the tables have to be baked again.
+*
+**********************************************************************************************/
+
+#ifndef POSE_CACHE_H
+#define POSE_CACHE_H
+
+#include "raylib.h"
+
+#define POSE_CLIP_NAME_SIZE 32
+
+// what to bake, frameCount -1 runs to the end of the animation
+typedef struct
+{
+    const char* name;
+    int animation;
+    int firstFrame;
+    int frameCount;
+    bool loop;
+}PoseClipDesc;
+
+typedef struct
+{
+    char name[POSE_CLIP_NAME_SIZE];
+    int frameCount;
+    bool loop;
+
+    // value = min + step*q, boneCount*SKIN_BONE_ROW_FLOATS entries each
+    float* min;
+    float* step;
+
+    // frameCount*boneCount*SKIN_BONE_ROW_FLOATS quantized values
+    unsigned short* frames;
+}PoseClip;
+
+typedef struct
+{
+    int boneCount;
+    int clipCount;
+    PoseClip* clips;
+
+    // hash of everything the tables were baked from
+    unsigned int sourceHash;
+
+    // clips and their tables share one block
+    void* block;
+    int blockSize;
+}PoseCache;
+
+// playback state of one animated instance, cheap enough to keep one per ghost or character
+typedef struct
+{
+    int clip;
+    float time;
+
+    // clip being faded out, blend runs from 0 to 1
+    int fromClip;
+    float fromTime;
+    float blend;
+    float blendDuration;
+}PosePlayer;
+
+// evaluate the clips from the model's animations, sourceHash is left at 0
+PoseCache BakePoseCache(Model model, const ModelAnimation* anims, int animCount, const PoseClipDesc* clips, int clipCount);
+
+// load the cache file if it was baked from the same data, otherwise load the animations from
+// animFileName, bake them and save the result
+PoseCache LoadOrBakePoseCache(const char* fileName, Model model, const char* animFileName, const PoseClipDesc* clips, int clipCount);
+
+bool SavePoseCache(PoseCache cache, const char* fileName);
+PoseCache LoadPoseCache(const char* fileName);
+void UnloadPoseCache(PoseCache* cache);
+
+// index of the clip with the given name, -1 if there is none
+int FindPoseClip(const PoseCache* cache, const char* name);
+
+// write the bone rows of a clip at a time in seconds, ready for the skin
+void SamplePoseClip(const PoseCache* cache, int clip, float time, float* rows);
+
+// switch to a clip, fading from the current one over blendDuration seconds
+void PlayPoseClip(PosePlayer* player, int clip, float blendDuration);
+void UpdatePosePlayer(PosePlayer* player, float dt);
+void SamplePosePlayer(const PoseCache* cache, const PosePlayer* player, float* rows);
+
+#endif //POSE_CACHE_H
@@ -0,0 +1,108 @@
+/**********************************************************************************************
+*
+*   RockyRoad * Profiler * Frame timings and the debug overlay
+*
+**********************************************************************************************/
+
+#include "Profiler.h"
+#include "MemTrack.h"
+
+#define PROFILE_SMOOTHING 0.1f              // weight of the newest sample
+#define OVERLAY_FONT_SIZE 10
+#define OVERLAY_LINE_HEIGHT 12
+#define OVERLAY_WIDTH 220
+
+static const char *zoneNames[PROFILE_ZONE_COUNT] = { "update", "render" };
+static const char *valueNames[PROFILE_VALUE_COUNT] = { "res scale", "draw calls", "shader binds", "tex binds", "binds saved", "prepass draws", "sky last", "shadow redraws", "player lod", "stream MB", "chunk stalls", "input ms" };
+
+static double zoneStart[PROFILE_ZONE_COUNT] = { 0 };
+static float zoneMs[PROFILE_ZONE_COUNT] = { 0 };
+static float values[PROFILE_VALUE_COUNT] = { 0 };
+static bool overlayVisible = false;
+
+void BeginProfileZone(ProfileZone zone)
+{
+    zoneStart[zone] = GetTime();
+}
+
+void EndProfileZone(ProfileZone zone)
+{
+    float sample = (float)((GetTime() - zoneStart[zone])*1000.0);
+    zoneMs[zone] += (sample - zoneMs[zone])*PROFILE_SMOOTHING;
+}
+
+float GetProfileZoneMs(ProfileZone zone)
+{
+    return zoneMs[zone];
+}
+
+void SetProfileValue(ProfileValue value, float amount)
+{
+    values[value] = amount;
+}
+
+float GetProfileValue(ProfileValue value)
+{
+    return values[value];
+}
+
+void ToggleProfilerOverlay(void)
+{
+    overlayVisible = !overlayVisible;
+}
+
+bool IsProfilerOverlayVisible(void)
+{
+    return overlayVisible;
+}
+
+static float ToMegabytes(size_t bytes)
+{
+    return (float)bytes/(1024.0f*1024.0f);
+}
+
+void DrawProfilerOverlay(void)
+{
+    if (!overlayVisible)
+        return;
+
+    int lines = PROFILE_ZONE_COUNT + PROFILE_VALUE_COUNT + MEM_CATEGORY_COUNT + 3;
+    int x = 10;
+    int y = 10;
+
+    DrawRectangle(x - 5, y - 5, OVERLAY_WIDTH, lines*OVERLAY_LINE_HEIGHT + 10, Fade(BLACK, 0.6f));
+
+    DrawText(TextFormat("%i fps  %.2f ms", GetFPS(), GetFrameTime()*1000.0f), x, y, OVERLAY_FONT_SIZE, LIME);
+    y += OVERLAY_LINE_HEIGHT;
+
+    for (int i = 0; i < PROFILE_ZONE_COUNT; i++)
+    {
+        DrawText(TextFormat("%-8s %6.2f ms", zoneNames[i], zoneMs[i]), x, y, OVERLAY_FONT_SIZE, RAYWHITE);
+        y += OVERLAY_LINE_HEIGHT;
+    }
+
+    for (int i = 0; i < PROFILE_VALUE_COUNT; i++)
+    {
+        DrawText(TextFormat("%-12s %8.2f", valueNames[i], values[i]), x, y, OVERLAY_FONT_SIZE, RAYWHITE);
+        y += OVERLAY_LINE_HEIGHT;
+    }
+
+    y += OVERLAY_LINE_HEIGHT;
+
+    size_t cpuTotal = 0;
+    size_t gpuTotal = 0;
+    for (int i = 0; i < MEM_CATEGORY_COUNT; i++)
+    {
+        size_t bytes = GetTrackedBytes(i);
+        if (IsGpuMemCategory(i))
+            gpuTotal += bytes;
+        else
+            cpuTotal += bytes;
+
+        DrawText(TextFormat("%s %-12s %7.2f MB %4i", IsGpuMemCategory(i)? "gpu" : "cpu", GetMemCategoryName(i), ToMegabytes(bytes), GetTrackedCount(i)),
+                 x, y, OVERLAY_FONT_SIZE, IsGpuMemCategory(i)? SKYBLUE : RAYWHITE);
+        y += OVERLAY_LINE_HEIGHT;
+    }
+
+    DrawText(TextFormat("total cpu %.2f MB  gpu %.2f MB", ToMegabytes(cpuTotal), ToMegabytes(gpuTotal)), x, y, OVERLAY_FONT_SIZE, YELLOW);
+}
@@ -0,0 +1,57 @@
+/**********************************************************************************************
+*
+*   RockyRoad * Profiler * Frame timings and the debug overlay
+*
+*   Zones are timed on the main thread and smoothed over a few frames. The overlay (F3 in
+*   game) shows them next to the live memory totals from MemTrack.
+*
+**********************************************************************************************/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "raylib.h"
+
+typedef enum
+{
+    PROFILE_ZONE_UPDATE = 0,
+    PROFILE_ZONE_RENDER,
+    PROFILE_ZONE_COUNT
+}ProfileZone;
+
+// values published by other systems for display
+typedef enum
+{
+    PROFILE_VALUE_RESOLUTION_SCALE = 0,
+    PROFILE_VALUE_DRAW_CALLS,
+    PROFILE_VALUE_SHADER_BINDS,
+    PROFILE_VALUE_TEXTURE_BINDS,
+    PROFILE_VALUE_BINDS_SAVED,
+    PROFILE_VALUE_PREPASS_DRAWS,
+    PROFILE_VALUE_SKY_LAST,
+    PROFILE_VALUE_SHADOW_UPDATES,
+    PROFILE_VALUE_PLAYER_LOD,
+    PROFILE_VALUE_STREAMED_MB,
+    PROFILE_VALUE_COURSE_STALLS,
+    PROFILE_VALUE_INPUT_TO_PHOTON,
+    PROFILE_VALUE_COUNT
+}ProfileValue;
+
+// time the code between the two calls, zones should not nest with themselves
+void BeginProfileZone(ProfileZone zone);
+void EndProfileZone(ProfileZone zone);
+
+// smoothed zone time in milliseconds
+float GetProfileZoneMs(ProfileZone zone);
+
+// latest value of a published statistic
+void SetProfileValue(ProfileValue value, float amount);
+float GetProfileValue(ProfileValue value);
+
+void ToggleProfilerOverlay(void);
+bool IsProfilerOverlayVisible(void);
+
+// draw the overlay in screen space, call between BeginDrawing and EndDrawing
+void DrawProfilerOverlay(void);
+
+#endif //PROFILER_H
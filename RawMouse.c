@@ -0,0 +1,114 @@
+/**********************************************************************************************
+*
+*   RockyRoad * RawMouse * Mouse motion summed from every event between frames
+*
+**********************************************************************************************/
+
+#include "RawMouse.h"
+
+#if defined(PLATFORM_DESKTOP)
+// raylib links GLFW in on desktop but keeps its header to itself
+typedef struct GLFWwindow GLFWwindow;
+typedef void (*GLFWcursorposfun)(GLFWwindow* window, double x, double y);
+GLFWwindow* glfwGetCurrentContext(void);
+GLFWcursorposfun glfwSetCursorPosCallback(GLFWwindow* window, GLFWcursorposfun callback);
+int glfwGetInputMode(GLFWwindow* window, int mode);
+void glfwSetInputMode(GLFWwindow* window, int mode, int value);
+int glfwRawMouseMotionSupported(void);
+
+#define GLFW_CURSOR 0x00033001
+#define GLFW_RAW_MOUSE_MOTION 0x00033005
+
+static GLFWwindow* window = NULL;
+static GLFWcursorposfun chainedCallback = NULL;
+#endif
+
+static bool active = false;
+static bool rawMotion = false;
+
+// written by the cursor callback, which GLFW calls on the main thread while polling
+static double lastX = 0.0;
+static double lastY = 0.0;
+static int lastCursorMode = -1;
+static double deltaX = 0.0;
+static double deltaY = 0.0;
+
+#if defined(PLATFORM_DESKTOP)
+static void CursorPosCallback(GLFWwindow* eventWindow, double x, double y)
+{
+    int cursorMode = glfwGetInputMode(eventWindow, GLFW_CURSOR);
+    if (cursorMode == lastCursorMode)
+    {
+        deltaX += x - lastX;
+        deltaY += y - lastY;
+    }
+    else
+    {
+        deltaX = 0.0;
+        deltaY = 0.0;
+        lastCursorMode = cursorMode;
+    }
+    lastX = x;
+    lastY = y;
+
+    if (chainedCallback != NULL)
+        chainedCallback(eventWindow, x, y);
+}
+#endif
+
+bool InitRawMouse(void)
+{
+#if defined(PLATFORM_DESKTOP)
+    // GetWindowHandle gives the native window, not GLFW's. raylib's window is the one whose
+    // context is current on the main thread
+    window = glfwGetCurrentContext();
+    if (window == NULL)
+        return false;
+
+    chainedCallback = glfwSetCursorPosCallback(window, CursorPosCallback);
+    rawMotion = glfwRawMouseMotionSupported() != 0;
+    if (rawMotion)
+        glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, 1);
+
+    Vector2 position = GetMousePosition();
+    lastX = position.x;
+    lastY = position.y;
+    active = true;
+    TraceLog(LOG_INFO, "MOUSE: Summing cursor events, raw motion %s", rawMotion? "on" : "not supported");
+#endif
+    return active;
+}
+
+void CloseRawMouse(void)
+{
+#if defined(PLATFORM_DESKTOP)
+    if (active)
+    {
+        glfwSetCursorPosCallback(window, chainedCallback);
+        if (rawMotion)
+            glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, 0);
+    }
+    window = NULL;
+    chainedCallback = NULL;
+#endif
+    active = false;
+    rawMotion = false;
+}
+
+bool IsRawMouseActive(void)
+{
+    return active;
+}
+
+bool IsRawMouseMotionEnabled(void)
+{
+    return rawMotion;
+}
+
+Vector2 TakeRawMouseDelta(void)
+{
+    Vector2 delta = { (float)deltaX, (float)deltaY };
+    deltaX = 0.0;
+    deltaY = 0.0;
+    return delta;
+}
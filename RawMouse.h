@@ -0,0 +1,34 @@
+/**********************************************************************************************
+*
+*   RockyRoad * RawMouse * Mouse motion summed from every event between frames
+*
+*   raylib keeps one cursor position per frame, and the desktop moves that cursor with its
+*   acceleration curve. On desktop builds this module sits in front of raylib's GLFW cursor
+*   callback and passes every event on unchanged. It also adds the event's motion to a
+*   running delta in doubles, and switches GLFW to unaccelerated raw motion where that is
+*   supported while the cursor is captured. A look then turns by exactly what the mouse
+*   moved, however many frames it is split over. Nothing runs while the mouse rests.
+*
+*   The first event after the cursor is captured or released jumps to a new position, so
+*   it starts a new delta instead of adding to one.
+*
+**********************************************************************************************/
+
+#ifndef RAW_MOUSE_H
+#define RAW_MOUSE_H
+
+#include "raylib.h"
+
+// after InitWindow. false where there is no GLFW window, GetMousePosition is all there is then
+bool InitRawMouse(void);
+void CloseRawMouse(void);
+
+bool IsRawMouseActive(void);
+
+// true while GLFW reports motion without the desktop's acceleration
+bool IsRawMouseMotionEnabled(void);
+
+// the motion since the last call, then starts over
+Vector2 TakeRawMouseDelta(void);
+
+#endif //RAW_MOUSE_H
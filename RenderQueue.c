@@ -0,0 +1,406 @@
+/**********************************************************************************************
+*
+*   RockyRoad * RenderQueue * Sorted mesh submission with minimal state changes
+*
+**********************************************************************************************/
+
+#include "RenderQueue.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define KEY_PASS_SHIFT 60
+#define KEY_SHADER_SHIFT 48
+#define KEY_MATERIAL_SHIFT 32
+
+// blend state that leaves the color buffer untouched, rlgl has no color mask
+#define BLEND_FACTOR_ZERO 0
+#define BLEND_FACTOR_ONE 1
+#define BLEND_EQUATION_ADD 0x8006
+
+typedef struct
+{
+    unsigned int shader;
+    unsigned int textures[MAX_MATERIAL_MAPS];
+    const Material* material;
+    Matrix view;
+    Matrix projection;
+}BoundState;
+
+static bool IsCubemapMap(int map)
+{
+    return map == MATERIAL_MAP_CUBEMAP || map == MATERIAL_MAP_IRRADIANCE || map == MATERIAL_MAP_PREFILTER;
+}
+
+static unsigned int DepthBits(float distance)
+{
+    // positive floats keep their order when compared as integers
+    unsigned int bits;
+    memcpy(&bits, &distance, sizeof(bits));
+    return bits;
+}
+
+static unsigned long long PassOrder(const RenderQueue* queue, RenderPass pass)
+{
+    switch (pass)
+    {
+    case RENDER_PASS_SKY: return (queue->skyboxMode == SKYBOX_DRAW_FIRST)? 0 : 2;
+    case RENDER_PASS_OPAQUE: return 1;
+    default: return 3;
+    }
+}
+
+static unsigned long long MakeKey(const RenderQueue* queue, RenderPass pass, const Material* material, float distance)
+{
+    unsigned long long shader = material->shader.id & 0xFFF;
+
+    // the albedo texture stands in for the material, items that share it batch together
+    unsigned long long textures = (material->maps != NULL)? (material->maps[MATERIAL_MAP_ALBEDO].texture.id & 0xFFFF) : 0;
+
+    unsigned int depth = DepthBits(distance);
+    if (pass == RENDER_PASS_TRANSPARENT)
+        depth = ~depth;
+
+    return (PassOrder(queue, pass) << KEY_PASS_SHIFT) | (shader << KEY_SHADER_SHIFT) | (textures << KEY_MATERIAL_SHIFT) | depth;
+}
+
+static int CompareItems(const void *a, const void *b)
+{
+    unsigned long long keyA = ((const RenderItem*)a)->key;
+    unsigned long long keyB = ((const RenderItem*)b)->key;
+
+    return (keyA > keyB) - (keyA < keyB);
+}
+
+void BeginRenderQueue(RenderQueue* queue, Arena* arena, int capacity, Vector3 viewPosition)
+{
+    queue->items = (RenderItem*)ArenaAlloc(arena, capacity*sizeof(RenderItem));
+    queue->capacity = (queue->items != NULL)? capacity : 0;
+    queue->count = 0;
+    queue->viewPosition = viewPosition;
+    memset(&queue->stats, 0, sizeof(queue->stats));
+}
+
+void SetRenderQueueSkyboxMode(RenderQueue* queue, SkyboxMode mode)
+{
+    queue->skyboxMode = mode;
+}
+
+void SetRenderQueueDepthPrepass(RenderQueue* queue, Shader depthShader, unsigned int forShaderId)
+{
+    queue->depthShader = depthShader;
+    queue->prepassShaderId = forShaderId;
+}
+
+void SubmitMesh(RenderQueue* queue, RenderPass pass, const Mesh* mesh, const Material* material, Matrix transform)
+{
+    SubmitMeshRange(queue, pass, mesh, material, transform, 0, 0);
+}
+
+void SubmitMeshRange(RenderQueue* queue, RenderPass pass, const Mesh* mesh, const Material* material, Matrix transform,
+                     int indexOffset, int indexCount)
+{
+    if (queue->count >= queue->capacity)
+    {
+        TraceLog(LOG_WARNING, "RENDER: Queue full at %i items, draw dropped", queue->capacity);
+        return;
+    }
+
+    Vector3 position = {transform.m12, transform.m13, transform.m14};
+    float distance = Vector3Length(Vector3Subtract(position, queue->viewPosition));
+
+    RenderItem *item = &queue->items[queue->count++];
+    item->key = MakeKey(queue, pass, material, distance);
+    item->pass = pass;
+    item->mesh = mesh;
+    item->material = material;
+    item->transform = transform;
+    item->indexOffset = indexOffset;
+    item->indexCount = indexCount;
+}
+
+void SubmitModel(RenderQueue* queue, RenderPass pass, Model model, Matrix transform)
+{
+    Matrix placed = MatrixMultiply(model.transform, transform);
+
+    for (int i = 0; i < model.meshCount; i++)
+        SubmitMesh(queue, pass, &model.meshes[i], &model.materials[model.meshMaterial[i]], placed);
+}
+
+void SubmitModelLod(RenderQueue* queue, RenderPass pass, Model model, const ModelLods* lods, int lod, Matrix transform)
+{
+    Matrix placed = MatrixMultiply(model.transform, transform);
+
+    for (int i = 0; i < model.meshCount; i++)
+    {
+        int offset = 0;
+        int count = 0;
+        GetMeshLodRange(lods, i, lod, &offset, &count);
+        SubmitMeshRange(queue, pass, &model.meshes[i], &model.materials[model.meshMaterial[i]], placed, offset, count);
+    }
+}
+
+static void DrawItemElements(const RenderItem* item)
+{
+    if (item->indexCount > 0)
+        rlDrawVertexArrayElements(item->indexOffset, item->indexCount, 0);
+    else if (item->mesh->indices != NULL)
+        rlDrawVertexArrayElements(0, item->mesh->triangleCount*3, 0);
+    else
+        rlDrawVertexArray(0, item->mesh->vertexCount);
+}
+
+static void BindShader(RenderQueue* queue, BoundState* state, const Material* material)
+{
+    if (state->shader == material->shader.id)
+        return;
+
+    const int *locs = material->shader.locs;
+
+    rlEnableShader(material->shader.id);
+    state->shader = material->shader.id;
+    state->material = NULL;
+    queue->stats.shaderBinds++;
+
+    // view and projection are the same for every item, only set when the program changes
+    if (locs[SHADER_LOC_MATRIX_VIEW] != -1)
+        rlSetUniformMatrix(locs[SHADER_LOC_MATRIX_VIEW], state->view);
+    if (locs[SHADER_LOC_MATRIX_PROJECTION] != -1)
+        rlSetUniformMatrix(locs[SHADER_LOC_MATRIX_PROJECTION], state->projection);
+
+    for (int i = 0; i < MAX_MATERIAL_MAPS; i++)
+    {
+        if (locs[SHADER_LOC_MAP_ALBEDO + i] != -1)
+            rlSetUniform(locs[SHADER_LOC_MAP_ALBEDO + i], &i, SHADER_UNIFORM_INT, 1);
+    }
+}
+
+static void BindMaterial(RenderQueue* queue, BoundState* state, const Material* material)
+{
+    // DrawMesh binds every texture of the material for every item, same material or not
+    for (int i = 0; i < MAX_MATERIAL_MAPS; i++)
+    {
+        if (material->maps[i].texture.id != 0)
+            queue->stats.naiveTextureBinds++;
+    }
+
+    if (state->material == material)
+        return;
+
+    const int *locs = material->shader.locs;
+    state->material = material;
+
+    if (locs[SHADER_LOC_COLOR_DIFFUSE] != -1)
+    {
+        Color color = material->maps[MATERIAL_MAP_ALBEDO].color;
+        float values[4] = {color.r/255.0f, color.g/255.0f, color.b/255.0f, color.a/255.0f};
+        rlSetUniform(locs[SHADER_LOC_COLOR_DIFFUSE], values, SHADER_UNIFORM_VEC4, 1);
+    }
+
+    if (locs[SHADER_LOC_COLOR_SPECULAR] != -1)
+    {
+        Color color = material->maps[MATERIAL_MAP_METALNESS].color;
+        float values[4] = {color.r/255.0f, color.g/255.0f, color.b/255.0f, color.a/255.0f};
+        rlSetUniform(locs[SHADER_LOC_COLOR_SPECULAR], values, SHADER_UNIFORM_VEC4, 1);
+    }
+
+    for (int i = 0; i < MAX_MATERIAL_MAPS; i++)
+    {
+        unsigned int id = material->maps[i].texture.id;
+        if (id == 0)
+            continue;
+
+        if (state->textures[i] == id)
+            continue;
+
+        rlActiveTextureSlot(i);
+        if (IsCubemapMap(i))
+            rlEnableTextureCubemap(id);
+        else
+            rlEnableTexture(id);
+
+        state->textures[i] = id;
+        queue->stats.textureBinds++;
+    }
+}
+
+static void DrawItem(RenderQueue* queue, BoundState* state, const RenderItem* item)
+{
+    const int *locs = item->material->shader.locs;
+
+    Matrix model = MatrixMultiply(item->transform, rlGetMatrixTransform());
+    if (locs[SHADER_LOC_MATRIX_MODEL] != -1)
+        rlSetUniformMatrix(locs[SHADER_LOC_MATRIX_MODEL], model);
+    if (locs[SHADER_LOC_MATRIX_NORMAL] != -1)
+        rlSetUniformMatrix(locs[SHADER_LOC_MATRIX_NORMAL], MatrixTranspose(MatrixInvert(model)));
+
+    rlSetUniformMatrix(locs[SHADER_LOC_MATRIX_MVP], MatrixMultiply(MatrixMultiply(model, state->view), state->projection));
+
+    if (!rlEnableVertexArray(item->mesh->vaoId))
+    {
+        // no VAO support, let raylib bind the buffers one by one and forget what we had bound
+        rlDisableShader();
+        DrawMesh(*item->mesh, *item->material, item->transform);
+        memset(state->textures, 0, sizeof(state->textures));
+        state->shader = 0;
+        state->material = NULL;
+        queue->stats.drawCalls++;
+        return;
+    }
+
+    DrawItemElements(item);
+    queue->stats.drawCalls++;
+}
+
+static void UnbindState(const BoundState* state)
+{
+    for (int i = 0; i < MAX_MATERIAL_MAPS; i++)
+    {
+        if (state->textures[i] == 0)
+            continue;
+
+        rlActiveTextureSlot(i);
+        if (IsCubemapMap(i))
+            rlDisableTextureCubemap();
+        else
+            rlDisableTexture();
+    }
+    rlActiveTextureSlot(0);
+
+    rlDisableVertexArray();
+    rlDisableShader();
+}
+
+static void DrawDepthPrepass(RenderQueue* queue, const BoundState* state)
+{
+    int mvpLoc = queue->depthShader.locs[SHADER_LOC_MATRIX_MVP];
+    bool bound = false;
+
+    for (int i = 0; i < queue->count; i++)
+    {
+        const RenderItem *item = &queue->items[i];
+        if (item->pass != RENDER_PASS_OPAQUE || item->material->shader.id != queue->prepassShaderId)
+            continue;
+
+        if (!bound)
+        {
+            rlSetBlendFactors(BLEND_FACTOR_ZERO, BLEND_FACTOR_ONE, BLEND_EQUATION_ADD);
+            rlSetBlendMode(BLEND_CUSTOM);
+            rlEnableShader(queue->depthShader.id);
+            queue->stats.shaderBinds++;
+            bound = true;
+        }
+
+        Matrix model = MatrixMultiply(item->transform, rlGetMatrixTransform());
+        rlSetUniformMatrix(mvpLoc, MatrixMultiply(MatrixMultiply(model, state->view), state->projection));
+
+        // without a VAO the prepass is skipped for the item, the main pass still draws it
+        if (!rlEnableVertexArray(item->mesh->vaoId))
+            continue;
+
+        DrawItemElements(item);
+        queue->stats.prepassDrawCalls++;
+    }
+
+    if (bound)
+    {
+        rlDisableShader();
+        rlSetBlendMode(BLEND_ALPHA);
+    }
+}
+
+static void BeginPass(const RenderQueue* queue, RenderPass pass)
+{
+    if (pass == RENDER_PASS_SKY)
+    {
+        // the camera sits inside the sky cube and the sky never occludes anything
+        rlDisableBackfaceCulling();
+        rlDisableDepthMask();
+        if (queue->skyboxMode == SKYBOX_DRAW_FIRST)
+            rlDisableDepthTest();
+    }
+    else if (pass == RENDER_PASS_TRANSPARENT)
+    {
+        rlDisableDepthMask();
+    }
+}
+
+static void EndPass(const RenderQueue* queue, RenderPass pass)
+{
+    if (pass == RENDER_PASS_SKY)
+    {
+        rlEnableBackfaceCulling();
+        rlEnableDepthMask();
+        if (queue->skyboxMode == SKYBOX_DRAW_FIRST)
+            rlEnableDepthTest();
+    }
+    else if (pass == RENDER_PASS_TRANSPARENT)
+    {
+        rlEnableDepthMask();
+    }
+}
+
+void DrawRenderQueue(RenderQueue* queue)
+{
+    if (queue->count == 0)
+        return;
+
+    // anything already batched by immediate mode draws has to land first
+    rlDrawRenderBatchActive();
+
+    qsort(queue->items, queue->count, sizeof(RenderItem), CompareItems);
+
+    BoundState state = { 0 };
+    state.view = rlGetMatrixModelview();
+    state.projection = rlGetMatrixProjection();
+
+    if (queue->depthShader.id != 0)
+        DrawDepthPrepass(queue, &state);
+
+    RenderPass pass = RENDER_PASS_COUNT;
+    for (int i = 0; i < queue->count; i++)
+    {
+        const RenderItem *item = &queue->items[i];
+        RenderPass itemPass = item->pass;
+
+        if (itemPass != pass)
+        {
+            if (pass != RENDER_PASS_COUNT)
+                EndPass(queue, pass);
+            BeginPass(queue, itemPass);
+            pass = itemPass;
+        }
+
+        queue->stats.naiveShaderBinds++;
+        BindShader(queue, &state, item->material);
+        BindMaterial(queue, &state, item->material);
+        DrawItem(queue, &state, item);
+    }
+    EndPass(queue, pass);
+    UnbindState(&state);
+
+    queue->count = 0;
+}
+
+void DrawMeshRange(Mesh mesh, Material material, Matrix transform, int indexOffset, int indexCount)
+{
+    // a queue of one, drawn straight away. its stats are not kept
+    RenderQueue queue = { 0 };
+    BoundState state = { 0 };
+    state.view = rlGetMatrixModelview();
+    state.projection = rlGetMatrixProjection();
+
+    RenderItem item = { 0 };
+    item.mesh = &mesh;
+    item.material = &material;
+    item.transform = transform;
+    item.indexOffset = indexOffset;
+    item.indexCount = indexCount;
+
+    BindShader(&queue, &state, &material);
+    BindMaterial(&queue, &state, &material);
+    DrawItem(&queue, &state, &item);
+    UnbindState(&state);
+}
@@ -0,0 +1,111 @@
+/**********************************************************************************************
+*
+*   RockyRoad * RenderQueue * Sorted mesh submission with minimal state changes
+*
+*   Draws are collected during the frame and submitted in one go, sorted by a 64 bit key:
+*
+*       pass (4) | shader (12) | material (16) | depth (32)
+*
+*   Opaque items come out grouped by shader and material, front to back inside a group.
+*   The sky pass draws after everything opaque, at the far plane, so it only fills pixels
+*   nothing else covered. Transparent items are sorted back to front.
+*
+*   An optional depth prepass lays down depth for the opaque items of one expensive shader
+*   with a trivial one first, so the expensive fragment shader only runs once per pixel.
+*
+*   Submission does what DrawMesh does but only rebinds a shader or a texture slot when it
+*   actually changes. The item array lives in an arena, so a frame never touches the heap.
+*
+**********************************************************************************************/
+
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "raylib.h"
+#include "Arena.h"
+#include "MeshLod.h"
+
+typedef enum
+{
+    RENDER_PASS_OPAQUE = 0,
+    RENDER_PASS_SKY,
+    RENDER_PASS_TRANSPARENT,
+    RENDER_PASS_COUNT
+}RenderPass;
+
+typedef enum
+{
+    SKYBOX_DRAW_LAST = 0,           // after opaque geometry, only uncovered pixels are shaded
+    SKYBOX_DRAW_FIRST               // old behaviour, full screen with depth test off
+}SkyboxMode;
+
+typedef struct
+{
+    unsigned long long key;
+    RenderPass pass;
+    const Mesh* mesh;
+    const Material* material;
+    Matrix transform;
+
+    // part of the index buffer to draw, a count of 0 draws the whole mesh
+    int indexOffset;
+    int indexCount;
+}RenderItem;
+
+typedef struct
+{
+    int drawCalls;
+    int prepassDrawCalls;
+    int shaderBinds;
+    int textureBinds;
+
+    // what the same items would have cost through DrawMesh
+    int naiveShaderBinds;
+    int naiveTextureBinds;
+}RenderStats;
+
+typedef struct
+{
+    RenderItem* items;
+    int count;
+    int capacity;
+    Vector3 viewPosition;
+    RenderStats stats;
+
+    // settings, kept across frames
+    SkyboxMode skyboxMode;
+    Shader depthShader;
+    unsigned int prepassShaderId;
+}RenderQueue;
+
+// choose when the sky pass is drawn
+void SetRenderQueueSkyboxMode(RenderQueue* queue, SkyboxMode mode);
+
+// prepass depth for opaque items drawn with the given shader, whose vertex shader has to
+// declare gl_Position invariant. a depth shader id of 0 turns the prepass off
+void SetRenderQueueDepthPrepass(RenderQueue* queue, Shader depthShader, unsigned int forShaderId);
+
+// start collecting items, the storage comes from the arena and lives until it is reset
+void BeginRenderQueue(RenderQueue* queue, Arena* arena, int capacity, Vector3 viewPosition);
+
+// queue one mesh, mesh and material have to stay alive until the queue is drawn
+void SubmitMesh(RenderQueue* queue, RenderPass pass, const Mesh* mesh, const Material* material, Matrix transform);
+
+// queue a range of a mesh's indices, used to draw one level of detail
+void SubmitMeshRange(RenderQueue* queue, RenderPass pass, const Mesh* mesh, const Material* material, Matrix transform,
+                     int indexOffset, int indexCount);
+
+// queue every mesh of a model, placed like DrawModel would with the given transform
+void SubmitModel(RenderQueue* queue, RenderPass pass, Model model, Matrix transform);
+
+// same as SubmitModel at a level of detail, lods can be NULL for the full model
+void SubmitModelLod(RenderQueue* queue, RenderPass pass, Model model, const ModelLods* lods, int lod, Matrix transform);
+
+// sort and draw everything queued, call inside a 3D mode. the queue is empty afterwards
+void DrawRenderQueue(RenderQueue* queue);
+
+// DrawMesh for part of the index buffer, bound and drawn the way the queue does it. a count
+// of 0 draws the whole mesh
+void DrawMeshRange(Mesh mesh, Material material, Matrix transform, int indexOffset, int indexCount);
+
+#endif //RENDER_QUEUE_H
@@ -20,13 +20,35 @@
 ********************************************************************************************/
 
 #define RL_VECTOR2_TYPE
-#define PHYSAC_IMPLEMENTATION
 #include "raylib.h"
 #include "rlgl.h"
+#include "Arena.h"
+#include "AudioThread.h"
+#include "CourseStream.h"
+#include "DynamicResolution.h"
 #include "FPCamera.h"
+#include "FramePacer.h"
+#include "Frustum.h"
+#include "Ghost.h"
+#include "JobSystem.h"
+#include "LevelGen.h"
+#include "MemTrack.h"
+#include "MeshCache.h"
+#include "NetPlay.h"
+#include "PoseCache.h"
+#include "Profiler.h"
+#include "RawMouse.h"
+#include "RenderQueue.h"
+#include "Scene.h"
+#include "SimSession.h"
+#include "SimdMath.h"
+#include "Skinning.h"
+#include "TextureStream.h"
 #include "rlpbr.h"
-#include "physac.h"
 #include "stdio.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #define RAYGUI_IMPLEMENTATION
 #include "extras/raygui.h"
 
@@ -34,71 +56,382 @@
 #define TEXT_MAX_LAYERS 32
 #define LETTER_BOUNDRY_COLOR VIOLET
 
+#define LEVEL_MAX_ELEMENTS 8
+#define LEVEL_ARENA_SIZE (256*1024)
+// per-platform scratch and render items for a full window of streamed course chunks
+#define FRAME_ARENA_SIZE (512*1024)
+
+// smallest run of platforms handed to one job, below this the loops stay on the main thread
+#define PLATFORM_BATCH_SIZE 64
+
+// fixed draws per frame besides the platforms: skybox, goal, grappling gun and player meshes
+#define RENDER_QUEUE_EXTRA 32
+
+#define SHADOW_MAP_SIZE 1024
+
+// seconds to fade between two player animation clips
+#define PLAYER_CLIP_BLEND 0.25f
+
+// VRAM the streamed material textures may take above their mip tails
+#define TEXTURE_BUDGET_MB 64
+
+// inputs kept to replay a level from its checkpoint, ten minutes of ticks
+#define REPLAY_MAX_TICKS (SIM_TICK_RATE*600)
+
+// the best run through the hand-made levels so far, raced against as a ghost
+#define GHOST_FILE "best.ghost"
+#define GHOST_TINT (Color){180, 220, 255, 110}
+#define GHOST_BEST 0
+#define GHOST_LAST 1
+#define GHOST_COUNT 2
+
+// the other players online, drawn like the ghosts in their own colour
+#define NET_TINT (Color){255, 190, 120, 160}
+#define NET_CONNECT_SECONDS 5
+
+// Playing's presses, kept when they first show up in the late input poll. raylib would count
+// them as held already by the time the next frame reads input
+#define LATE_PRESS_JUMP 1
+#define LATE_PRESS_FIRE 2
+#define LATE_PRESS_ESCAPE 4
+#define LATE_PRESS_RETRY 8
+
+// the menus draw at MENU_IDLE_FPS until input wakes them to the full rate for MENU_WAKE_SECONDS.
+// while idle their 3D view is cached and redrawn at most MENU_VIEW_FPS, half the idle rate, so
+// an idle frame only renders the view every other time. awake frames draw it live
+#define MENU_IDLE_FPS 20
+#define MENU_VIEW_FPS 10
+#define MENU_WAKE_SECONDS 0.5
+// menu animations step at the rate they were written for, whatever the frame rate
+#define MENU_TICK_RATE 60
+#define MENU_MAX_TICKS 8
+
 bool SHOW_LETTER_BOUNDRY = false;
 bool SHOW_TEXT_BOUNDRY = true;
 
+typedef struct Level
+{
+    Model *groundArr;
+    int elementAmount;
+} Level;
+
+// platform offsets for every hand-made level, built into the level arena by LoadLevel
+typedef struct LevelLayout
+{
+    int elementAmount;
+    Vector3 offsets[LEVEL_MAX_ELEMENTS];
+} LevelLayout;
+
+// everything a run is at one moment, physics body included. it holds no pointers, so a
+// snapshot and a restore are one memcpy each
+typedef struct RunState
+{
+    SimSession sim;
+    int currentLevel;
+    bool grapplingUnlocked;
+} RunState;
+
+// player.glb has a single animation, the clips are windows starting at the frames the
+// menus used to freeze on
+static const PoseClipDesc playerClips[] = {
+    {"idle", 0, 0, -1, true},
+    {"run", 0, 0, -1, true},
+    {"fall", 0, 7, -1, false},
+    {"victory", 0, 20, -1, true}
+};
+
+static const LevelLayout levelLayouts[] = {
+    {2, {{0, -2, 0}, {15, -2, 0}}},
+    {3, {{0, -2, 0}, {15, -2, 0}, {30, -2, 0}}},
+    {4, {{0, -2, 0}, {20, -2, 0}, {40, -2, 0}, {60, -2, 0}}},
+    {6, {{0, -2, 0}, {15, 5, 0}, {30, 10, 0}, {45, -10, 0}, {60, -10, 0}, {75, -10, 0}}},
+    {7, {{0, -2, 0}, {15, -10, 0}, {30, -20, 0}, {45, -30, 0}, {60, -40, 0}, {80, -30, 0}, {95, -30, 0}}},
+    {7, {{0, -2, 0}, {15, -80, 0}, {30, -75, 0}, {45, -70, 0}, {60, -50, 0}, {80, -75, 0}, {95, -80, 0}}},
+};
+
+// shared state for the per-platform loops that are fanned out with ParallelFor
+typedef struct PlatformWork
+{
+    Model *groundArr;
+    SimdPoints centers;
+    BoundingBox localBounds;
+    Frustum frustum;
+    bool *visible;
+    Matrix *drawTransforms;
+} PlatformWork;
+
+// the screens, in the order of gameScenes
+typedef enum GameScene
+{
+    SCENE_INTRO = 0,
+    SCENE_START,
+    SCENE_PLAYING,
+    SCENE_RESPAWN,
+    SCENE_FINISH,
+    SCENE_COUNT
+} GameScene;
+
+// the raylib logo animation the game opens with
+typedef struct IntroLogo
+{
+    int positionX;
+    int positionY;
+    int framesCounter;
+    int lettersCount;
+    int topSideRecWidth;
+    int leftSideRecHeight;
+    int bottomSideRecWidth;
+    int rightSideRecHeight;
+    int state;                      // Tracking animation states (State Machine)
+    float alpha;                    // Useful for fading
+} IntroLogo;
+
+// everything the scenes share. main loads most of it up front, the Playing scene loads what
+// only it draws in its preload hook
+typedef struct Game
+{
+    SceneManager scenes;
+    FPCamera cam;
+
+    // the whole run in one block, Respawn and retry copy the checkpoint back over it
+    RunState run;
+    // the start of the current level. the inputs since then replay the level from it, which
+    // has to end exactly where the game did
+    RunState checkpoint;
+    SimInput *replayInputs;
+    int replayCount;
+    bool newRun;                    // the next Playing is a run from Start, not a respawn
+
+    // the Playing scene runs on a fixed tick, presses are kept until a tick has seen them
+    SimLevel simLevel;
+    float simAccumulator;
+    unsigned char pendingPresses;
+    unsigned char latePresses;
+    int simTickRate;
+
+    Model playerModel;
+    ModelLods playerLods;
+    int playerLod;
+    Skin playerSkin;
+    PoseCache playerPoses;
+    PosePlayer playerPose;
+    const char *playerClip;         // played by the shared pose pass, NULL while nobody sees it
+
+    Model skybox;
+    Model platform;
+    float platformRadius;
+    Model nextLevel;
+    float nextLevelRadius;
+    Vector3 cubePosition;
+    Model grapplingGun;
+    Model instructions;
+    Texture2D instructions1;
+    Font font;
+
+    Arena levelArena;
+    Arena frameArena;
+    Level level;
+    Model *groundArr;
+    int groundArrSize;
+    bool goalResident;
+    CourseStream course;
+    bool courseMode;
+
+    NetServer *netServer;
+    NetClient *netClient;
+    SimLevel netLevel;
+    bool netMode;
+
+    // every run through the hand-made levels is recorded, the best and the last one race along
+    GhostRecorder ghostRecorder;
+    GhostTrack ghostTracks[GHOST_COUNT];
+    GhostPlayer ghostPlayers[GHOST_COUNT];
+
+    PlatformWork platformWork;
+    RenderQueue renderQueue;
+    int shadowRedraws;
+    FramePacer pacer;
+    DynamicResolution dynamicRes;
+    Vector2 lastViewAngle;
+
+    // the fall after a death
+    float timeSinceDeath;
+    float fallYVel;
+    Vector3 targetAtDeath;
+
+    IntroLogo intro;
+
+    // power saving on the menus
+    RenderTexture2D menuView;
+    bool menuViewValid;
+    double menuViewTime;
+    float menuAccumulator;
+    Vector2 lastMousePosition;
+} Game;
+
 bool getCurrentGround(Vector3 pos, Model groundArr);
+static Level LoadLevel(Arena *arena, int index, Model platform);
+static void CullPlatformsRange(void *data, int start, int end);
+static void PublishRenderStats(const RenderQueue *queue);
 void DrawTextCodepoint3D(Font font, int codepoint, Vector3 position, float fontSize, bool backface, Color tint);
 void DrawText3D(Font font, const char *text, Vector3 position, float fontSize, float fontSpacing, float lineSpacing, bool backface, Color tint);
 static TextureCubemap GenTextureCubemap(Shader shader, Texture2D panorama, int size, int format);
-static float GetSpeedForAxis(FPCamera *camera, CameraControls axis, float speed);
-
-int main()
+static SimInput ReadSimInput(const FPCamera *camera, unsigned char pressed);
+static unsigned char ReadLatePresses(void);
+static bool IsAnyKeyDown(void);
+static Matrix GetGhostTransform(const GhostFrame *frame);
+static int RunCourseGenerator(const char *fileName, unsigned long long firstSeed, int platformCount, int candidateCount);
+static int RunBatchHost(int sessionCount, int tickCount, unsigned long long seed, int platformCount);
+static int LoadGeneratedCourse(unsigned long long seed, int platformCount, Model platform, Model **platforms, SimLevel *level);
+static void UnloadGeneratedCourse(Model *platforms, SimLevel *level);
+static int RunSimdBench(unsigned long long seed, int platformCount);
+static bool ConnectNetGame(NetServer *server, NetClient *client, const SimLevel *level);
+static void StepNetTick(NetServer *server, NetClient *client, const SimLevel *level, SimInput input);
+static int RunNetBench(int playerCount, int tickCount, unsigned long long seed, int platformCount, int latencyTicks, float lossRate);
+static void EnterIntroScene(void *data);
+static void UpdateIntroScene(void *data, float dt);
+static void DrawIntroScene(void *data);
+static void ExitMenuScene(void *data);
+static void EnterStartScene(void *data);
+static void UpdateStartScene(void *data, float dt);
+static void DrawStartScene(void *data);
+static void PreloadPlayingScene(void *data);
+static void UnloadPlayingScene(void *data);
+static void EnterPlayingScene(void *data);
+static void UpdatePlayingScene(void *data, float dt);
+static void DrawPlayingScene(void *data);
+static void ExitPlayingScene(void *data);
+static void EnterRespawnScene(void *data);
+static void UpdateRespawnScene(void *data, float dt);
+static void DrawRespawnScene(void *data);
+static void EnterFinishScene(void *data);
+static void UpdateFinishScene(void *data, float dt);
+static void DrawFinishScene(void *data);
+
+// name, preload, enter, update, draw, exit, unload
+static const Scene gameScenes[SCENE_COUNT] = {
+    {"intro", NULL, EnterIntroScene, UpdateIntroScene, DrawIntroScene, ExitMenuScene, NULL},
+    {"start", NULL, EnterStartScene, UpdateStartScene, DrawStartScene, ExitMenuScene, NULL},
+    {"playing", PreloadPlayingScene, EnterPlayingScene, UpdatePlayingScene, DrawPlayingScene, ExitPlayingScene, UnloadPlayingScene},
+    {"respawn", NULL, EnterRespawnScene, UpdateRespawnScene, DrawRespawnScene, NULL, NULL},
+    {"finish", NULL, EnterFinishScene, UpdateFinishScene, DrawFinishScene, ExitMenuScene, NULL}
+};
+
+int main(int argc, char *argv[])
 {
     // Initialization
     //--------------------------------------------------------------------------------------
+    // --course <file> plays one long streamed course instead of the hand-made levels,
+    // --generate <file> writes the first valid course out of --candidates seeds and exits,
+    // --batch <sessions> runs that many bot sessions on the --seed course for --ticks and exits,
+    // --host <port> races the --seed course online, 0 for the default port, and --join
+    // <host[:port]> joins such a race, --netbench <players> races bots over loopback for
+    // --ticks with --latency ticks and --loss percent on every link and exits, --bench-simd
+    // times the batched platform tests against their scalar path on the --seed course and exits,
+    // --tick-rate <hz> runs the simulation at fewer ticks per second on slow machines,
+    // --pacing <vsync|uncapped|latency> picks how frames are paced and --late-latch turns the
+    // view by the mouse once more right before drawing
+    const char *courseFile = NULL;
+    const char *generateFile = NULL;
+    unsigned long long generateSeed = 1;
+    int generatePlatforms = 1000;
+    int generateCandidates = 1000;
+    int batchSessions = 0;
+    int batchTicks = 600;
+    int hostPort = -1;
+    const char *joinAddress = NULL;
+    int netBenchPlayers = 0;
+    int netLatency = 0;
+    float netLoss = 0.0f;
+    bool benchSimd = false;
+    int simTickRate = SIM_TICK_RATE;
+    FramePacingMode pacingMode = FRAME_PACING_VSYNC;
+    bool lateLatch = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--course") == 0 && i + 1 < argc) courseFile = argv[++i];
+        else if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc) generateFile = argv[++i];
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) generateSeed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--platforms") == 0 && i + 1 < argc) generatePlatforms = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--candidates") == 0 && i + 1 < argc) generateCandidates = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) batchSessions = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) batchTicks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) hostPort = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--join") == 0 && i + 1 < argc) joinAddress = argv[++i];
+        else if (strcmp(argv[i], "--netbench") == 0 && i + 1 < argc) netBenchPlayers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc) netLatency = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) netLoss = (float)atof(argv[++i])/100.0f;
+        else if (strcmp(argv[i], "--bench-simd") == 0) benchSimd = true;
+        else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) simTickRate = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--late-latch") == 0) lateLatch = true;
+        else if (strcmp(argv[i], "--pacing") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "uncapped") == 0) pacingMode = FRAME_PACING_UNCAPPED;
+            else if (strcmp(argv[i], "latency") == 0) pacingMode = FRAME_PACING_LOW_LATENCY;
+            else pacingMode = FRAME_PACING_VSYNC;
+        }
+    }
+    if (generateFile != NULL)
+        return RunCourseGenerator(generateFile, generateSeed, generatePlatforms, generateCandidates);
+    if (batchSessions > 0)
+        return RunBatchHost(batchSessions, batchTicks, generateSeed, generatePlatforms);
+    if (netBenchPlayers > 0)
+        return RunNetBench(netBenchPlayers, batchTicks, generateSeed, generatePlatforms, netLatency, netLoss);
+    if (benchSimd)
+        return RunSimdBench(generateSeed, generatePlatforms);
+
+    // everything the scenes share, whatever is not loaded below starts out zero
+    Game *game = (Game*)GameHeapAlloc(sizeof(Game));
+    if (game == NULL)
+        return 1;
+    memset(game, 0, sizeof(Game));
+    game->simTickRate = simTickRate;
+
     const int screenWidth = 800;
     const int screenHeight = 450;
 
     SetConfigFlags(FLAG_MSAA_4X_HINT | FLAG_WINDOW_RESIZABLE);
     InitWindow(screenWidth, screenHeight, "Rocky Road");
-    SetWindowIcon(LoadImage("icon.png"));
-
-    FPCamera cam;
-    InitFPCamera(&cam, 60, Vector3Zero());
-    cam.CameraPosition = Vector3Zero();
-    cam.ViewCamera.target = (Vector3) {15, 0, 0};
-    SetCameraMode(cam.ViewCamera, CAMERA_ORBITAL);
-
-    typedef enum GameState
-    {
-        Start = 0,
-        Intro,
-        Playing,
-        Respawn,
-        Finish
-    } GameState;
-
-    typedef struct Level
-    {
-        Model *groundArr;
-        int elementAmount;
-    } Level;
-
-    GameState currentState = Intro;
-    int currentLevel = 0;
-
-    Model playerModel = LoadModel("player.glb");
-    int playerAnimsCount;
-    ModelAnimation *playerAni = LoadModelAnimations("player.glb", &playerAnimsCount);
-    UpdateModelAnimation(playerModel, *playerAni, 10);
-    Texture playerAlbedo = LoadTexture("playerAlbedo.png");
-    playerModel.materials[0].maps[MATERIAL_MAP_ALBEDO].texture = playerAlbedo;
+    Image icon = LoadImage("icon.png");
+    SetWindowIcon(icon);
+    UnloadImage(icon);
+    InitRawMouse();
+
+    InitFPCamera(&game->cam, 60, Vector3Zero());
+    game->cam.CameraPosition = Vector3Zero();
+    // walking is simulated by the SimSession, the camera only turns
+    game->cam.MoveSpeed = Vector3Zero();
+    game->cam.ViewCamera.target = (Vector3) {15, 0, 0};
+    SetCameraMode(game->cam.ViewCamera, CAMERA_ORBITAL);
+
+    InitSimSession(&game->run.sim);
+
+    game->playerModel = LoadModelCached("player.glb", &game->playerLods);
+    TrackModel(game->playerModel, "player.glb");
+    Texture playerAlbedo = LoadTextureTracked("playerAlbedo.png");
+    game->playerModel.materials[0].maps[MATERIAL_MAP_ALBEDO].texture = playerAlbedo;
     SetTextureFilter(playerAlbedo, TEXTURE_FILTER_ANISOTROPIC_16X);
+    Shader skinShader = LoadShaderTracked("skin.vs", "skin.fs");
+    game->playerSkin = LoadSkin(&game->playerModel, skinShader);
+    game->playerPoses = LoadOrBakePoseCache("player.pose", game->playerModel, "player.glb",
+                                                playerClips, sizeof(playerClips)/sizeof(playerClips[0]));
+    game->playerPose = (PosePlayer){FindPoseClip(&game->playerPoses, "idle"), 0.0f, -1, 0.0f, 1.0f, 0.0f};
 
     Mesh cube = GenMeshCube(1.0f, 1.0f, 1.0f);
-    Model skybox = LoadModelFromMesh(cube);
-    skybox.materials[0].shader = LoadShader(TextFormat("skybox.vs"),
-                                            TextFormat("skybox.fs"));
+    game->skybox = LoadModelFromMesh(cube);
+    TrackModel(game->skybox, "skybox");
+    game->skybox.materials[0].shader = LoadShaderTracked(TextFormat("skybox.vs"),
+                                                   TextFormat("skybox.fs"));
     int cubemap = MATERIAL_MAP_CUBEMAP;
     int numberone = 1;
     bool useHDR = false;
-    SetShaderValue(skybox.materials[0].shader, GetShaderLocation(skybox.materials[0].shader, "environmentMap"), (int[1]){MATERIAL_MAP_CUBEMAP}, SHADER_UNIFORM_INT);
-    SetShaderValue(skybox.materials[0].shader, GetShaderLocation(skybox.materials[0].shader, "doGamma"), (int[1]){useHDR ? 1 : 0}, SHADER_UNIFORM_INT);
-    SetShaderValue(skybox.materials[0].shader, GetShaderLocation(skybox.materials[0].shader, "vflipped"), (int[1]){useHDR ? 1 : 0}, SHADER_UNIFORM_INT);
+    SetShaderValue(game->skybox.materials[0].shader, GetShaderLocation(game->skybox.materials[0].shader, "environmentMap"), (int[1]){MATERIAL_MAP_CUBEMAP}, SHADER_UNIFORM_INT);
+    SetShaderValue(game->skybox.materials[0].shader, GetShaderLocation(game->skybox.materials[0].shader, "doGamma"), (int[1]){useHDR ? 1 : 0}, SHADER_UNIFORM_INT);
+    SetShaderValue(game->skybox.materials[0].shader, GetShaderLocation(game->skybox.materials[0].shader, "vflipped"), (int[1]){useHDR ? 1 : 0}, SHADER_UNIFORM_INT);
 
-    Shader shdrCubemap = LoadShader(TextFormat("cubemap.vs"),
-                                    TextFormat("cubemap.fs"));
+    Shader shdrCubemap = LoadShaderTracked(TextFormat("cubemap.vs"),
+                                           TextFormat("cubemap.fs"));
 
     SetShaderValue(shdrCubemap, GetShaderLocation(shdrCubemap, "equirectangularMap"), (int[1]){0}, SHADER_UNIFORM_INT);
 
@@ -117,730 +450,1417 @@ int main()
         // NOTE 1: New texture is generated rendering to texture, shader calculates the sphere->cube coordinates mapping
         // NOTE 2: It seems on some Android devices WebGL, fbo does not properly support a FLOAT-based attachment,
         // despite texture can be successfully created.. so using PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 instead of PIXELFORMAT_UNCOMPRESSED_R32G32B32A32
-        skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = GenTextureCubemap(shdrCubemap, panorama, 1024, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        game->skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = GenTextureCubemap(shdrCubemap, panorama, 1024, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
 
         //UnloadTexture(panorama);    // Texture not required anymore, cubemap already generated
     }
     else
     {
         Image img = LoadImage("skybox.png");
-        skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = LoadTextureCubemap(img, CUBEMAP_LAYOUT_AUTO_DETECT); // CUBEMAP_LAYOUT_PANORAMA
+        game->skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture = LoadTextureCubemap(img, CUBEMAP_LAYOUT_AUTO_DETECT); // CUBEMAP_LAYOUT_PANORAMA
         UnloadImage(img);
     }
+    Texture2D skyboxCubemap = game->skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture;
+    TrackMemory(MEM_GPU_TEXTURE, skyboxCubemap.id, 6*(size_t)GetPixelDataSize(skyboxCubemap.width, skyboxCubemap.height, skyboxCubemap.format), "skybox cubemap");
 
-    InitPhysics();
-    SetPhysicsGravity(0, 0.1);
     InitPBR();
     InitAudioDevice();
-    AddLight((Light){.pos = (Vector3){0, 5, 0}, .target = Vector3Zero(), .color = WHITE, .intensity = 1.0f, .type = SPOT, .on = 1});
+    InitJobSystem(0);
+    InitTextureStreaming((size_t)TEXTURE_BUDGET_MB*1024*1024);
+    void *sceneLight = AddLight((Light){.pos = (Vector3){0, 5, 0}, .target = Vector3Zero(), .color = WHITE, .intensity = 1.0f, .type = SPOT, .on = 1});
+    EnableLightShadows(sceneLight, SHADOW_MAP_SIZE);
 
     GuiEnable();
 
-    Vector3 moveVelocity = Vector3Zero();
-
-    Model grapplingGun = LoadModel("grapplingGun.glb");
-    Ray grapple;
-    Vector3 grappleHitPos;
-    int grappleHitIndex;
-    bool grappleAlreadyHit = false;
-    bool isGrappling = true;
-    grapplingGun.materials[0].maps[MATERIAL_MAP_ALBEDO].texture = LoadTexture("GrapplingAlbedo.png");
-    SetTextureFilter(grapplingGun.materials[0].maps[MATERIAL_MAP_ALBEDO].texture, TEXTURE_FILTER_ANISOTROPIC_16X);
-    grapplingGun.transform = MatrixTranslate(-1.0f, 0, 2.0f);
-    bool grapplingUnlocked = false;
-    bool grapplingEnabled = false;
+    game->platform = LoadModelFromMesh(GenMeshCube(10, 1, 10));
+    // the colour, normal and roughness maps start as the PBR defaults and are streamed in
+    game->platform.materials[0] = LoadPBRMaterial(NULL, NULL, NULL, NULL, NULL, TEXTURE_FILTER_ANISOTROPIC_16X, false);
+    TrackModel(game->platform, "platform");
+    TrackMaterialTextures(game->platform.materials[0], "wood");
+    StreamMaterialMap(&game->platform.materials[0], MATERIAL_MAP_ALBEDO, "wood_color.png", TEXTURE_FILTER_ANISOTROPIC_16X);
+    StreamMaterialMap(&game->platform.materials[0], MATERIAL_MAP_NORMAL, "wood_normals.png", TEXTURE_FILTER_ANISOTROPIC_16X);
+    StreamMaterialMap(&game->platform.materials[0], MATERIAL_MAP_ROUGHNESS, "wood_roughness.png", TEXTURE_FILTER_ANISOTROPIC_16X);
+    unsigned int pbrShaderId = game->platform.materials[0].shader.id;
+    TrackMemory(MEM_GPU_SHADER, pbrShaderId, 0, "pbr");
+    game->levelArena = LoadArena("level", LEVEL_ARENA_SIZE);
+    game->frameArena = LoadArena("frame", FRAME_ARENA_SIZE);
+    TrackMemory(MEM_CPU_LEVEL, (size_t)game->levelArena.base, game->levelArena.capacity, "level arena");
+    TrackMemory(MEM_CPU_FRAME, (size_t)game->frameArena.base, game->frameArena.capacity, "frame arena");
+
+    game->level = LoadLevel(&game->levelArena, 0, game->platform);
+    game->groundArr = game->level.groundArr;
+
+    Shader depthShader = LoadShaderTracked("depth.vs", "depth.fs");
+    bool depthPrepass = false;
+    game->platformWork.localBounds = GetMeshBoundingBox(game->platform.meshes[0]);
+    game->platformRadius = Vector3Distance(game->platformWork.localBounds.min, game->platformWork.localBounds.max)*0.5f;
+
+
+    game->nextLevel = LoadModelFromMesh(GenMeshCube(3, 3, 3));
+    game->nextLevel.materials[0] = LoadPBRMaterial(NULL, NULL, NULL, NULL, NULL, TEXTURE_FILTER_ANISOTROPIC_16X, false);
+    TrackModel(game->nextLevel, "next level");
+    TrackMaterialTextures(game->nextLevel.materials[0], "gold");
+    StreamMaterialMap(&game->nextLevel.materials[0], MATERIAL_MAP_ALBEDO, "gold_color.png", TEXTURE_FILTER_ANISOTROPIC_16X);
+    StreamMaterialMap(&game->nextLevel.materials[0], MATERIAL_MAP_NORMAL, "gold_normals.png", TEXTURE_FILTER_ANISOTROPIC_16X);
+    StreamMaterialMap(&game->nextLevel.materials[0], MATERIAL_MAP_ROUGHNESS, "gold_roughness.png", TEXTURE_FILTER_ANISOTROPIC_16X);
+    game->nextLevel.transform = MatrixMultiply(game->nextLevel.transform, MatrixTranslate(15, 3, 0));
+    BoundingBox nextLevelBounds = GetMeshBoundingBox(game->nextLevel.meshes[0]);
+    game->nextLevelRadius = Vector3Distance(nextLevelBounds.min, nextLevelBounds.max)*0.5f;
 
-    float unstableTimer = 0;
-    int currentGroundIndex;
-    int lastGroundIndex;
-    float lastPlayerPos;
-
-    Mesh platformHitBox = GenMeshCube(10, 150, 10);
-    Model platform = LoadModelFromMesh(GenMeshCube(10, 1, 10));
-    platform.materials[0] = LoadPBRMaterial("wood_color.png", 0, 0, "wood_normals.png", "wood_roughness.png", TEXTURE_FILTER_ANISOTROPIC_16X, false);
-    Level lvl1;
-    lvl1.elementAmount = 2;
-    lvl1.groundArr = (Model*)malloc(lvl1.elementAmount*sizeof(Model));
-    lvl1.groundArr[0] = platform;
-    lvl1.groundArr[0].transform = MatrixMultiply(lvl1.groundArr[0].transform, MatrixTranslate(0, -2, 0));
+    SetExitKey(KEY_NULL);
 
-    lvl1.groundArr[1] = platform;
-    lvl1.groundArr[1].transform = MatrixMultiply(lvl1.groundArr[1].transform, MatrixTranslate(15, -2, 0));
+    game->groundArrSize = game->level.elementAmount;
 
-    Level lvl2;
-    lvl2.elementAmount = 3;
-    lvl2.groundArr = (Model*)malloc(lvl2.elementAmount*sizeof(Model));
-    lvl2.groundArr[0] = platform;
-    lvl2.groundArr[0].transform = MatrixMultiply(lvl2.groundArr[0].transform, MatrixTranslate(0, -2, 0));
+    game->courseMode = courseFile != NULL && LoadCourseStream(&game->course, courseFile, game->platform);
+    if (game->courseMode)
+    {
+        TrackMemory(MEM_CPU_LEVEL, (size_t)game->course.arena.base, game->course.arena.capacity, "course stream");
+        // generated courses are validated with the grapple available
+        game->run.grapplingUnlocked = true;
+        UpdateCourseStream(&game->course, 0.0f);
+        game->groundArr = game->course.groundArr;
+        game->groundArrSize = game->course.platformCount;
+    }
+    // the goal of a course only exists once its chunk is resident
+    game->goalResident = !game->courseMode;
 
-    lvl2.groundArr[1] = platform;
-    lvl2.groundArr[1].transform = MatrixMultiply(lvl2.groundArr[1].transform, MatrixTranslate(15, -2, 0));
+    // online every player builds the course from the seed the server sends, the platforms stay
+    // where they are for the whole race so the sessions on all sides index them alike
+    Model *netPlatforms = NULL;
+    if ((hostPort >= 0 || joinAddress != NULL) && !game->courseMode && InitNetwork())
+    {
+        NetAddress serverAddress = { NET_LOOPBACK, (hostPort > 0)? (unsigned short)hostPort : NET_DEFAULT_PORT };
+        bool addressed = true;
+        if (hostPort >= 0)
+        {
+            game->netServer = (NetServer*)GameHeapAlloc(sizeof(NetServer));
+            if (game->netServer == NULL || !StartNetServer(game->netServer, serverAddress.port, generateSeed, generatePlatforms) ||
+                LoadGeneratedCourse(generateSeed, generatePlatforms, game->platform, &netPlatforms, &game->netLevel) == 0)
+                addressed = false;
+        }
+        else addressed = ParseNetAddress(joinAddress, NET_DEFAULT_PORT, &serverAddress);
 
-    lvl2.groundArr[2] = platform;
-    lvl2.groundArr[2].transform = MatrixMultiply(lvl2.groundArr[2].transform, MatrixTranslate(30, -2, 0));
+        game->netClient = (NetClient*)GameHeapAlloc(sizeof(NetClient));
+        if (!addressed || game->netClient == NULL || !StartNetClient(game->netClient, serverAddress) || !ConnectNetGame(game->netServer, game->netClient, &game->netLevel) ||
+            (netPlatforms == NULL && LoadGeneratedCourse(game->netClient->courseSeed, game->netClient->coursePlatforms, game->platform, &netPlatforms, &game->netLevel) == 0))
+        {
+            TraceLog(LOG_WARNING, "NET: Could not start the online race, playing alone");
+            if (game->netClient != NULL) StopNetClient(game->netClient);
+            if (game->netServer != NULL) StopNetServer(game->netServer);
+            GameHeapFree(game->netClient);
+            GameHeapFree(game->netServer);
+            UnloadGeneratedCourse(netPlatforms, &game->netLevel);
+            game->netClient = NULL;
+            game->netServer = NULL;
+            netPlatforms = NULL;
+            CloseNetwork();
+        }
+    }
+    game->netMode = game->netClient != NULL;
+    if (!IsSimTickRateValid(game->simTickRate) || (game->netMode && game->simTickRate != SIM_TICK_RATE))
+    {
+        // every side of a race steps alike, ghosts are kept at the default rate either way
+        TraceLog(LOG_WARNING, "SIM: Tick rate %i not usable, running at %i", game->simTickRate, SIM_TICK_RATE);
+        game->simTickRate = SIM_TICK_RATE;
+    }
+    if (game->netMode)
+    {
+        game->groundArr = netPlatforms;
+        game->groundArrSize = game->netLevel.platformCount;
+        game->goalResident = game->netLevel.hasGoal;
+        game->nextLevel.transform = MatrixTranslate(game->netLevel.goal.x, game->netLevel.goal.y, game->netLevel.goal.z);
+        game->run.grapplingUnlocked = true;
+    }
 
-    Level lvl3;
-    lvl3.elementAmount = 4;
-    lvl3.groundArr = (Model*)malloc(lvl3.elementAmount*sizeof(Model));
-    lvl3.groundArr[0] = platform;
-    lvl3.groundArr[0].transform = MatrixMultiply(lvl3.groundArr[0].transform, MatrixTranslate(0, -2, 0));
+    memcpy(&game->checkpoint, &game->run, sizeof(RunState));
 
-    lvl3.groundArr[1] = platform;
-    lvl3.groundArr[1].transform = MatrixMultiply(lvl3.groundArr[1].transform, MatrixTranslate(20, -2, 0));
+    Sound jump = LoadSound("Jump.mp3");
 
-    lvl3.groundArr[2] = platform;
-    lvl3.groundArr[2].transform = MatrixMultiply(lvl3.groundArr[2].transform, MatrixTranslate(40, -2, 0));
+    Sound grappleShot = LoadSound("Jump.mp3");
+    SetSoundPitch(grappleShot, 1.5f);
 
-    lvl3.groundArr[3] = platform;
-    lvl3.groundArr[3].transform = MatrixMultiply(lvl3.groundArr[3].transform, MatrixTranslate(60, -2, 0));
+    Music bgMusic = LoadMusicStream("background-music.mp3");
 
-    Level lvl4;
-    lvl4.elementAmount = 6;
-    lvl4.groundArr = (Model*)malloc(lvl4.elementAmount*sizeof(Model));
-    lvl4.groundArr[0] = platform;
-    lvl4.groundArr[0].transform = MatrixMultiply(lvl4.groundArr[0].transform, MatrixTranslate(0, -2, 0));
+    // from here on only the audio thread touches raylib audio
+    SetAudioEventSound(AUDIO_EVENT_JUMP, jump);
+    SetAudioEventSound(AUDIO_EVENT_GRAPPLE, grappleShot);
+    InitAudioThread(bgMusic);
 
-    lvl4.groundArr[1] = platform;
-    lvl4.groundArr[1].transform = MatrixMultiply(lvl4.groundArr[1].transform, MatrixTranslate(15, 5, 0));
+    InitFramePacer(&game->pacer, GetMonitorRefreshRate(GetCurrentMonitor()), pacingMode);
+    game->pacer.lateLatch = lateLatch;
+    game->dynamicRes = LoadDynamicResolution(GetMonitorRefreshRate(GetCurrentMonitor()));
+    game->font = LoadFont("Debrosee-ALPnL.ttf");
+    TrackTexture(game->font.texture, "font atlas");
 
-    lvl4.groundArr[2] = platform;
-    lvl4.groundArr[2].transform = MatrixMultiply(lvl4.groundArr[2].transform, MatrixTranslate(30, 10, 0));
+    // the intro comes first and preloads the game behind its logo
+    InitSceneManager(&game->scenes, gameScenes, SCENE_COUNT, game);
+    ChangeScene(&game->scenes, SCENE_INTRO);
+    //--------------------------------------------------------------------------------------
+    // Main game loop
+    while (!WindowShouldClose()) // Detect window close button or ESC key
+    {
+        BeginFramePacing(&game->pacer);
+        BeginSceneFrame(&game->scenes);
+#if defined(_DEBUG)
+        int heapAllocsAtFrameStart = GetGameHeapAllocCount();
+#endif
+        UpdateTextureStreaming();
+        SetProfileValue(PROFILE_VALUE_STREAMED_MB, (float)GetStreamedTextureBytes()/(1024.0f*1024.0f));
+        float dt = GetFrameTime();
+        if (game->netMode && GetCurrentScene(&game->scenes) != SCENE_PLAYING)
+        {
+            // the server drops players that go quiet, the menus keep sending idle ticks
+            game->simAccumulator += dt;
+            for (int ticks = 0; game->simAccumulator >= SIM_TICK_TIME && ticks < SIM_MAX_TICKS_PER_FRAME; ticks++)
+            {
+                StepNetTick(game->netServer, game->netClient, &game->netLevel, (SimInput){ 0, game->cam.ViewAngles });
+                game->simAccumulator -= SIM_TICK_TIME;
+            }
+            if (game->simAccumulator >= SIM_TICK_TIME) game->simAccumulator = 0.0f;
+        }
+        if (IsKeyPressed(KEY_F11))
+        {
+            ToggleFullscreen();
+        }
+        if (IsKeyPressed(KEY_F3))
+        {
+            ToggleProfilerOverlay();
+        }
+        if (IsKeyPressed(KEY_F4))
+        {
+            SetRenderQueueSkyboxMode(&game->renderQueue, (game->renderQueue.skyboxMode == SKYBOX_DRAW_LAST)? SKYBOX_DRAW_FIRST : SKYBOX_DRAW_LAST);
+        }
+        if (IsKeyPressed(KEY_F5))
+        {
+            depthPrepass = !depthPrepass;
+            SetRenderQueueDepthPrepass(&game->renderQueue, depthPrepass? depthShader : (Shader){ 0 }, pbrShaderId);
+        }
+        if (IsKeyPressed(KEY_F6))
+        {
+            SetFramePacingMode(&game->pacer, (FramePacingMode)((game->pacer.mode + 1)%FRAME_PACING_COUNT));
+        }
+        if (IsKeyPressed(KEY_F7))
+        {
+            game->pacer.lateLatch = !game->pacer.lateLatch;
+            TraceLog(LOG_INFO, "PACING: Late latching %s", game->pacer.lateLatch? "on" : "off");
+        }
+        if (game->pacer.idleRate > 0)
+        {
+            // anything the player does on a menu brings it back to the full frame rate
+            Vector2 mouse = GetMousePosition();
+            if (mouse.x != game->lastMousePosition.x || mouse.y != game->lastMousePosition.y || IsAnyKeyDown() ||
+                IsMouseButtonDown(MOUSE_LEFT_BUTTON) || GetMouseWheelMove() != 0.0f || IsWindowResized())
+                WakeFramePacer(&game->pacer, MENU_WAKE_SECONDS);
+            game->lastMousePosition = mouse;
+        }
+        if (game->playerClip != NULL)
+        {
+            // the player only shows up outside of gameplay and as the ghosts during it
+            PlayPoseClip(&game->playerPose, FindPoseClip(&game->playerPoses, game->playerClip), PLAYER_CLIP_BLEND);
+            UpdatePosePlayer(&game->playerPose, dt);
+            if (game->playerSkin.boneRows != NULL)
+                SamplePosePlayer(&game->playerPoses, &game->playerPose, game->playerSkin.boneRows);
+        }
 
-    lvl4.groundArr[3] = platform;
-    lvl4.groundArr[3].transform = MatrixMultiply(lvl4.groundArr[3].transform, MatrixTranslate(45, -10, 0));
+        UpdateScene(&game->scenes, dt);
+        BeginDrawing();
+        DrawScene(&game->scenes);
+        DrawProfilerOverlay();
+        EndDrawing();
 
-    lvl4.groundArr[4] = platform;
-    lvl4.groundArr[4].transform = MatrixMultiply(lvl4.groundArr[4].transform, MatrixTranslate(60, -10, 0));
+#if defined(_DEBUG)
+        if (GetCurrentScene(&game->scenes) == SCENE_PLAYING && GetGameHeapAllocCount() != heapAllocsAtFrameStart)
+            TraceLog(LOG_WARNING, "MEMORY: %i GameHeapAlloc calls during a gameplay frame", GetGameHeapAllocCount() - heapAllocsAtFrameStart);
+#endif
+        // preloads may use the scratch memory too, it is free again once they are done
+        EndSceneFrame(&game->scenes);
+        ResetArena(&game->frameArena);
+        //----------------------------------------------------------------------------------
+    }
 
-    lvl4.groundArr[5] = platform;
-    lvl4.groundArr[5].transform = MatrixMultiply(lvl4.groundArr[5].transform, MatrixTranslate(75, -10, 0));
+    // De-Initialization
+    //--------------------------------------------------------------------------------------
+    // GPU resources have to go before the context does, so the window is closed last
+    CloseSceneManager(&game->scenes);
+    CloseTextureStreaming();
+    UntrackModel(game->platform);
+    UntrackMaterialTextures(game->platform.materials[0]);
+    UnloadPBRModel(game->platform);
+    UntrackModel(game->nextLevel);
+    UntrackMaterialTextures(game->nextLevel.materials[0]);
+    UnloadPBRModel(game->nextLevel);
+    UnloadShaderTracked(game->skybox.materials[0].shader);
+    UnloadShaderTracked(shdrCubemap);
+    UntrackMemory(MEM_GPU_TEXTURE, skyboxCubemap.id);
+    UnloadTexture(skyboxCubemap);
+    UnloadTextureTracked(playerAlbedo);
+    UnloadSkin(&game->playerSkin);
+    if (game->netMode)
+    {
+        StopNetClient(game->netClient);
+        if (game->netServer != NULL) StopNetServer(game->netServer);
+        GameHeapFree(game->netClient);
+        GameHeapFree(game->netServer);
+        UnloadGeneratedCourse(netPlatforms, &game->netLevel);
+        CloseNetwork();
+    }
+    UnloadPoseCache(&game->playerPoses);
+    UnloadModelLods(&game->playerLods);
+    UnloadModelTracked(game->playerModel);
+    UnloadShaderTracked(skinShader);
+    UnloadDynamicResolution(&game->dynamicRes);
+    UnloadShaderTracked(depthShader);
+    UntrackTexture(game->font.texture);
+    UnloadFont(game->font);
+    if (game->courseMode)
+    {
+        UntrackMemory(MEM_CPU_LEVEL, (size_t)game->course.arena.base);
+        UnloadCourseStream(&game->course);
+    }
+    UntrackMemory(MEM_CPU_LEVEL, (size_t)game->levelArena.base);
+    UntrackMemory(MEM_CPU_FRAME, (size_t)game->frameArena.base);
+    UnloadArena(&game->levelArena);
+    UnloadArena(&game->frameArena);
 
-    Level lvl5;
-    lvl5.elementAmount = 7;
-    lvl5.groundArr = (Model*)malloc(lvl5.elementAmount*sizeof(Model));
-    lvl5.groundArr[0] = platform;
-    lvl5.groundArr[0].transform = MatrixMultiply(lvl5.groundArr[0].transform, MatrixTranslate(0, -2, 0));
+    // the cube mesh belongs to the skybox model and goes with it
+    UnloadModelTracked(game->skybox); // Unload skybox model
 
-    lvl5.groundArr[1] = platform;
-    lvl5.groundArr[1].transform = MatrixMultiply(lvl5.groundArr[1].transform, MatrixTranslate(15, -10, 0));
+    UntrackMemory(MEM_GPU_SHADER, pbrShaderId);
+    ClosePBR();
+    CloseJobSystem();
+    CloseAudioThread();
+    UnloadSound(jump);
+    UnloadSound(grappleShot);
+    UnloadMusicStream(bgMusic);
+    CloseAudioDevice();
+    GameHeapFree(game);
 
-    lvl5.groundArr[2] = platform;
-    lvl5.groundArr[2].transform = MatrixMultiply(lvl5.groundArr[2].transform, MatrixTranslate(30, -20, 0));
+    LogMemoryLeaks();
+    CloseRawMouse();
+    CloseWindow(); // Close window and OpenGL context
+    //--------------------------------------------------------------------------------------
 
-    lvl5.groundArr[3] = platform;
-    lvl5.groundArr[3].transform = MatrixMultiply(lvl5.groundArr[3].transform, MatrixTranslate(45, -30, 0));
+    return 0;
+}
 
-    lvl5.groundArr[4] = platform;
-    lvl5.groundArr[4].transform = MatrixMultiply(lvl5.groundArr[4].transform, MatrixTranslate(60, -40, 0));
+// the camera the Start and Finish scenes circle the goal platform with
+static void UseMenuCamera(FPCamera *cam)
+{
+    UseFPCameraMouse(cam, false);
+    cam->ViewCamera.position = Vector3Zero();
+    cam->ViewCamera.target = (Vector3) {15, 0, 0};
+    SetCameraMode(cam->ViewCamera, CAMERA_ORBITAL);
+}
 
-    lvl5.groundArr[5] = platform;
-    lvl5.groundArr[5].transform = MatrixMultiply(lvl5.groundArr[5].transform, MatrixTranslate(80, -30, 0));
+// the 3D part every menu shares: the sky, one platform or none and the player
+static void DrawMenuView(Game *game, Model *prop, Matrix playerTransform)
+{
+    UpdatePBR(game->cam.ViewCamera);
+    BeginMode3D(game->cam.ViewCamera);
+    BeginRenderQueue(&game->renderQueue, &game->frameArena, RENDER_QUEUE_EXTRA, game->cam.ViewCamera.position);
+    SubmitModel(&game->renderQueue, RENDER_PASS_SKY, game->skybox, MatrixIdentity());
+    if (prop != NULL)
+    {
+        SubmitModel(&game->renderQueue, RENDER_PASS_OPAQUE, *prop, MatrixTranslate(game->cubePosition.x, game->cubePosition.y, game->cubePosition.z));
+        RequestMaterialTextures(&prop->materials[0], GetSphereScreenPixels(game->cubePosition, game->platformRadius, game->cam.ViewCamera, (float)GetScreenHeight()));
+    }
+    DrawRenderQueue(&game->renderQueue);
+    game->playerLod = SelectModelLod(&game->playerLods, playerTransform, game->cam.ViewCamera, (float)GetScreenHeight(), game->playerLod);
+    SetProfileValue(PROFILE_VALUE_PLAYER_LOD, (float)game->playerLod);
+    DrawSkinnedModelLod(&game->playerSkin, game->playerModel, &game->playerLods, game->playerLod, playerTransform);
+    PublishRenderStats(&game->renderQueue);
+    EndMode3D();
+}
 
-    lvl5.groundArr[6] = platform;
-    lvl5.groundArr[6].transform = MatrixMultiply(lvl5.groundArr[6].transform, MatrixTranslate(95, -30, 0));
+// DrawMenuView straight to the screen while the pacer is awake. idle, it goes into a texture
+// the size of the screen that is reused until the view is due again. the texture has no
+// multisampling, so the idle view is drawn without the window's antialiasing
+static void DrawCachedMenuView(Game *game, Model *prop, Matrix playerTransform)
+{
+    if (!IsFramePacerIdle(&game->pacer))
+    {
+        // the cache is stale by the time the pacer idles again
+        game->menuViewValid = false;
+        DrawMenuView(game, prop, playerTransform);
+        return;
+    }
 
-    Level lvl6;
-    lvl6.elementAmount = 7;
-    lvl6.groundArr = (Model*)malloc(lvl6.elementAmount*sizeof(Model));
-    lvl6.groundArr[0] = platform;
-    lvl6.groundArr[0].transform = MatrixMultiply(lvl6.groundArr[0].transform, MatrixTranslate(0, -2, 0));
+    int width = GetScreenWidth();
+    int height = GetScreenHeight();
+    if (game->menuView.id == 0 || game->menuView.texture.width != width || game->menuView.texture.height != height)
+    {
+        if (game->menuView.id != 0)
+        {
+            UntrackRenderTexture(game->menuView);
+            UnloadRenderTexture(game->menuView);
+        }
+        game->menuView = LoadRenderTexture(width, height);
+        TrackRenderTexture(game->menuView, "menu view");
+        game->menuViewValid = false;
+    }
 
-    lvl6.groundArr[1] = platform;
-    lvl6.groundArr[1].transform = MatrixMultiply(lvl6.groundArr[1].transform, MatrixTranslate(15, -80, 0));
+    double now = GetTime();
+    if (!game->menuViewValid || now - game->menuViewTime >= 1.0/MENU_VIEW_FPS)
+    {
+        BeginTextureMode(game->menuView);
+        ClearBackground(WHITE);
+        DrawMenuView(game, prop, playerTransform);
+        EndTextureMode();
+        game->menuViewValid = true;
+        game->menuViewTime = now;
+    }
+    // render textures are stored upside down
+    DrawTextureRec(game->menuView.texture, (Rectangle){0, 0, (float)width, (float)-height}, (Vector2){0, 0}, WHITE);
+}
 
-    lvl6.groundArr[2] = platform;
-    lvl6.groundArr[2].transform = MatrixMultiply(lvl6.groundArr[2].transform, MatrixTranslate(30, -75, 0));
+// the menus idle at a low frame rate, the cached view goes with them
+static void UseMenuPowerSaving(Game *game, bool enabled)
+{
+    SetFramePacerIdleRate(&game->pacer, enabled? MENU_IDLE_FPS : 0);
+    game->menuAccumulator = 0.0f;
+    game->menuViewValid = false;
+    if (!enabled && game->menuView.id != 0)
+    {
+        UntrackRenderTexture(game->menuView);
+        UnloadRenderTexture(game->menuView);
+        game->menuView = (RenderTexture2D){ 0 };
+    }
+}
 
-    lvl6.groundArr[3] = platform;
-    lvl6.groundArr[3].transform = MatrixMultiply(lvl6.groundArr[3].transform, MatrixTranslate(45, -70, 0));
+// the menu animations used to step once per frame, now once per MENU_TICK_RATE tick of dt
+static int TakeMenuTicks(Game *game, float dt)
+{
+    game->menuAccumulator += dt;
+    int ticks = (int)(game->menuAccumulator*MENU_TICK_RATE);
+    if (ticks > MENU_MAX_TICKS)
+    {
+        game->menuAccumulator = 0.0f;
+        return MENU_MAX_TICKS;
+    }
+    game->menuAccumulator -= (float)ticks/MENU_TICK_RATE;
+    return ticks;
+}
 
-    lvl6.groundArr[4] = platform;
-    lvl6.groundArr[4].transform = MatrixMultiply(lvl6.groundArr[4].transform, MatrixTranslate(60, -50, 0));
+static void ExitMenuScene(void *data)
+{
+    UseMenuPowerSaving((Game*)data, false);
+}
 
-    lvl6.groundArr[5] = platform;
-    lvl6.groundArr[5].transform = MatrixMultiply(lvl6.groundArr[5].transform, MatrixTranslate(80, -75, 0));
+static void EnterIntroScene(void *data)
+{
+    Game *game = (Game*)data;
+    game->playerClip = NULL;
+    game->intro = (IntroLogo){ 0 };
+    game->intro.positionX = GetScreenWidth()/2 - 128;
+    game->intro.positionY = GetScreenHeight()/2 - 128;
+    game->intro.topSideRecWidth = 16;
+    game->intro.leftSideRecHeight = 16;
+    game->intro.bottomSideRecWidth = 16;
+    game->intro.rightSideRecHeight = 16;
+    game->intro.alpha = 1.0f;
+    UseMenuPowerSaving(game, true);
+
+    // the logo takes seconds, plenty to get the game's own assets loaded and streaming
+    QueueScenePreload(&game->scenes, SCENE_START);
+    QueueScenePreload(&game->scenes, SCENE_PLAYING);
+}
 
-    lvl6.groundArr[6] = platform;
-    lvl6.groundArr[6].transform = MatrixMultiply(lvl6.groundArr[6].transform, MatrixTranslate(95, -80, 0));
+static void StepIntroLogo(Game *game)
+{
+    IntroLogo *intro = &game->intro;
 
-    Model* groundArr = lvl1.groundArr;
+    if (intro->state == 0)                 // State 0: Small box blinking
+    {
+        intro->framesCounter++;
 
+        if (intro->framesCounter == 120)
+        {
+            intro->state = 1;
+            intro->framesCounter = 0;      // Reset counter... will be used later...
+        }
+    }
+    else if (intro->state == 1)            // State 1: Top and left bars growing
+    {
+        intro->topSideRecWidth += 4;
+        intro->leftSideRecHeight += 4;
 
-    Model nextLevel = LoadModelFromMesh(GenMeshCube(3, 3, 3));
-    nextLevel.materials[0] = LoadPBRMaterial("gold_color.png", 0, 0, "gold_normals.png", "gold_roughness.png", TEXTURE_FILTER_ANISOTROPIC_16X, false);
-    nextLevel.transform = MatrixMultiply(nextLevel.transform, MatrixTranslate(15, 3, 0));
+        if (intro->topSideRecWidth == 256) intro->state = 2;
+    }
+    else if (intro->state == 2)            // State 2: Bottom and right bars growing
+    {
+        intro->bottomSideRecWidth += 4;
+        intro->rightSideRecHeight += 4;
 
-    PhysicsBody groundPhysics = CreatePhysicsBodyRectangle((Vector2){0, 2}, 10, 1, 10);
-    groundPhysics->enabled = false;
-    groundPhysics->useGravity = false;
-    groundPhysics->freezeOrient = true;
-    PhysicsBody player = CreatePhysicsBodyRectangle(Vector2Zero(), 1, 1, 10);
+        if (intro->bottomSideRecWidth == 256) intro->state = 3;
+    }
+    else if (intro->state == 3)            // State 3: Letters appearing (one by one)
+    {
+        intro->framesCounter++;
 
-    SetExitKey(KEY_NULL);
+        if (intro->framesCounter/12)       // Every 12 frames, one more letter!
+        {
+            intro->lettersCount++;
+            intro->framesCounter = 0;
+        }
 
-    Vector3 cubePosition = {0};
+        if (intro->lettersCount >= 10)     // When all letters have appeared, just fade out everything
+        {
+            intro->alpha -= 0.02f;
 
-    float fallYVel;
+            if (intro->alpha <= 0.0f)
+            {
+                intro->alpha = 0.0f;
+                intro->state = 4;
+            }
+        }
+    }
+    else if (intro->state == 4)            // State 4: Go to homescreen
+    {
+        ChangeScene(&game->scenes, SCENE_START);
+    }
+}
 
-    float timeSinceDeath;
-    Vector3 targetAtDeath;
+static void UpdateIntroScene(void *data, float dt)
+{
+    Game *game = (Game*)data;
+    for (int ticks = TakeMenuTicks(game, dt); ticks > 0; ticks--)
+        StepIntroLogo(game);
+}
 
-    Vector2 lastViewAngle;
+static void DrawIntroScene(void *data)
+{
+    const IntroLogo *intro = &((Game*)data)->intro;
+    int logoPositionX = intro->positionX;
+    int logoPositionY = intro->positionY;
 
-    int groundArrSize = lvl1.elementAmount;
+    ClearBackground(RAYWHITE);
 
-    int logoPositionX = screenWidth/2 - 128;
-    int logoPositionY = screenHeight/2 - 128;
+    if (intro->state == 0)
+    {
+        if ((intro->framesCounter/15)%2) DrawRectangle(logoPositionX, logoPositionY, 16, 16, BLACK);
+    }
+    else if (intro->state == 1)
+    {
+        DrawRectangle(logoPositionX, logoPositionY, intro->topSideRecWidth, 16, BLACK);
+        DrawRectangle(logoPositionX, logoPositionY, 16, intro->leftSideRecHeight, BLACK);
+    }
+    else if (intro->state == 2)
+    {
+        DrawRectangle(logoPositionX, logoPositionY, intro->topSideRecWidth, 16, BLACK);
+        DrawRectangle(logoPositionX, logoPositionY, 16, intro->leftSideRecHeight, BLACK);
 
-    int framesCounter = 0;
-    int lettersCount = 0;
+        DrawRectangle(logoPositionX + 240, logoPositionY, 16, intro->rightSideRecHeight, BLACK);
+        DrawRectangle(logoPositionX, logoPositionY + 240, intro->bottomSideRecWidth, 16, BLACK);
+    }
+    else if (intro->state == 3)
+    {
+        DrawRectangle(logoPositionX, logoPositionY, intro->topSideRecWidth, 16, Fade(BLACK, intro->alpha));
+        DrawRectangle(logoPositionX, logoPositionY + 16, 16, intro->leftSideRecHeight - 32, Fade(BLACK, intro->alpha));
 
-    int topSideRecWidth = 16;
-    int leftSideRecHeight = 16;
+        DrawRectangle(logoPositionX + 240, logoPositionY + 16, 16, intro->rightSideRecHeight - 32, Fade(BLACK, intro->alpha));
+        DrawRectangle(logoPositionX, logoPositionY + 240, intro->bottomSideRecWidth, 16, Fade(BLACK, intro->alpha));
 
-    int bottomSideRecWidth = 16;
-    int rightSideRecHeight = 16;
+        DrawRectangle(GetScreenWidth()/2 - 112, GetScreenHeight()/2 - 112, 224, 224, Fade(RAYWHITE, intro->alpha));
 
-    int state = 0;                  // Tracking animation states (State Machine)
-    float alpha = 1.0f;             // Useful for fading
+        DrawText(TextSubtext("raylib", 0, intro->lettersCount), GetScreenWidth()/2 - 44, GetScreenHeight()/2 + 48, 50, Fade(BLACK, intro->alpha));
+    }
+    else if (intro->state == 4)
+    {
+        DrawText("[R] REPLAY", 340, 200, 20, GRAY);
+    }
+}
 
-    int framesSinceLaunch = 0;
+static void EnterStartScene(void *data)
+{
+    Game *game = (Game*)data;
+    game->playerClip = "idle";
+    UseMenuCamera(&game->cam);
+    UseMenuPowerSaving(game, true);
+}
 
-    Sound jump = LoadSound("Jump.mp3");
+static void UpdateStartScene(void *data, float dt)
+{
+    Game *game = (Game*)data;
+    for (int ticks = TakeMenuTicks(game, dt); ticks > 0; ticks--)
+        UpdateCamera(&game->cam.ViewCamera);
+}
 
-    Music bgMusic = LoadMusicStream("background-music.mp3");
+static void DrawStartScene(void *data)
+{
+    Game *game = (Game*)data;
+    int width = GetScreenWidth();
+    int height = GetScreenHeight();
+    ClearBackground(WHITE);
+    //DrawTexturePro(background, (Rectangle){0, 0, background.width, background.height}, (Rectangle){0, 0, width, height}, Vector2Zero(), 0, WHITE);
+    DrawCachedMenuView(game, &game->level.groundArr[1], MatrixMultiply(MatrixScale(0.5f, 0.5f, 0.5f), MatrixTranslate(15, -5, -5)));
+    if (GuiButton((Rectangle){width / 2 - width / 20, height / 2 - height / 20, width / 10, height / 10}, "PLAY"))
+    {
+        game->newRun = true;
+        ChangeScene(&game->scenes, SCENE_PLAYING);
+    }
+    DrawTextEx(game->font, "ROCKY ROAD", (Vector2){width/2-MeasureText("ROCKY ROAD", 20)*2, 100}, 100, 2.0f, RED);
+}
 
-    Model instructions = LoadModelFromMesh(GenMeshCube(1, 20, 20));
-    instructions.materials[0].maps[MATERIAL_MAP_ALBEDO].texture = LoadTexture("Instructions.png");
-    instructions.transform = MatrixRotateXYZ((Vector3) {180*DEG2RAD, 0, 0});
+// what only Playing draws, and a first shadow map and texture requests for where the run starts
+static void PreloadPlayingScene(void *data)
+{
+    Game *game = (Game*)data;
+
+    game->grapplingGun = LoadModelCached("grapplingGun.glb", NULL);
+    TrackModel(game->grapplingGun, "grapplingGun.glb");
+    game->grapplingGun.materials[0].maps[MATERIAL_MAP_ALBEDO].texture = LoadTextureTracked("GrapplingAlbedo.png");
+    SetTextureFilter(game->grapplingGun.materials[0].maps[MATERIAL_MAP_ALBEDO].texture, TEXTURE_FILTER_ANISOTROPIC_16X);
+    game->grapplingGun.transform = MatrixTranslate(-1.0f, 0, 2.0f);
+
+    game->instructions = LoadModelFromMesh(GenMeshCube(1, 20, 20));
+    TrackModel(game->instructions, "instructions");
+    game->instructions.materials[0].maps[MATERIAL_MAP_ALBEDO].texture = LoadTextureTracked("Instructions.png");
+    game->instructions.transform = MatrixRotateXYZ((Vector3) {180*DEG2RAD, 0, 0});
+    game->instructions1 = LoadTextureTracked("Instructions-1.png");
+
+    game->replayInputs = (SimInput*)GameHeapAlloc(REPLAY_MAX_TICKS*sizeof(SimInput));
+
+    // every run through the hand-made levels is recorded, the best and the last one race along
+    game->ghostTracks[GHOST_BEST] = LoadGhostTrack(GHOST_FILE);
+    for (int i = 0; i < GHOST_COUNT; i++)
+        StartGhostPlayer(&game->ghostPlayers[i], &game->ghostTracks[i]);
+
+    // the platforms stand still until the run starts, so the first frame finds this map current
+    ShadowCaster *casters = (ShadowCaster*)ArenaAlloc(&game->frameArena, (game->groundArrSize + 1)*sizeof(ShadowCaster));
+    if (casters != NULL)
+    {
+        for (int i = 0; i < game->groundArrSize; i++)
+            casters[i] = (ShadowCaster){&game->groundArr[i].meshes[0], game->groundArr[i].transform};
+        casters[game->groundArrSize] = (ShadowCaster){&game->nextLevel.meshes[0], game->nextLevel.transform};
+        if (UpdateShadowMap(casters, game->groundArrSize + (game->goalResident? 1 : 0))) game->shadowRedraws++;
+    }
+    // the loader thread decodes these while the menus are up, the first frames ask again
+    RequestMaterialTextures(&game->platform.materials[0], (float)GetScreenHeight());
+    if (game->goalResident) RequestMaterialTextures(&game->nextLevel.materials[0], (float)GetScreenHeight());
+}
 
-    Texture2D instructions1 = LoadTexture("Instructions-1.png");
+static void UnloadPlayingScene(void *data)
+{
+    Game *game = (Game*)data;
+    UnloadGhostRecorder(&game->ghostRecorder);
+    for (int i = 0; i < GHOST_COUNT; i++)
+        UnloadGhostTrack(&game->ghostTracks[i]);
+    GameHeapFree(game->replayInputs);
+    game->replayInputs = NULL;
+    UnloadTextureTracked(game->grapplingGun.materials[0].maps[MATERIAL_MAP_ALBEDO].texture);
+    UnloadModelTracked(game->grapplingGun);
+    UnloadTextureTracked(game->instructions.materials[0].maps[MATERIAL_MAP_ALBEDO].texture);
+    UnloadTextureTracked(game->instructions1);
+    UnloadModelTracked(game->instructions);
+}
 
-    SetTargetFPS(GetMonitorRefreshRate(GetCurrentMonitor())); // Set our game to run at 60 frames-per-second
-    Font font = LoadFont("Debrosee-ALPnL.ttf");
-    //--------------------------------------------------------------------------------------
+// a new run from Start races the ghosts from their beginning, a respawn only goes back to the
+// checkpoint
+static void EnterPlayingScene(void *data)
+{
+    Game *game = (Game*)data;
+    game->playerClip = game->courseMode? NULL : "run";
+    game->cam.CameraPosition = Vector3Zero();
+    UseFPCameraMouse(&game->cam, true);
+    memcpy(&game->run, &game->checkpoint, sizeof(RunState));
+    game->simAccumulator = 0.0f;
+    game->replayCount = 0;
+    game->lastViewAngle = game->cam.ViewAngles;
+    // the music starts with the first run and keeps going on the menus after it
+    PlayMusicAsync();
+    if (game->newRun)
+    {
+        BeginGhostRecording(&game->ghostRecorder);
+        for (int i = 0; i < GHOST_COUNT; i++)
+            StartGhostPlayer(&game->ghostPlayers[i], &game->ghostTracks[i]);
+        game->newRun = false;
+    }
+}
 
-    // Main game loop
-    while (!WindowShouldClose()) // Detect window close button or ESC key
+// simulation, camera and the shadow map, everything before BeginDrawing
+static void UpdatePlayingScene(void *data, float dt)
+{
+    Game *game = (Game*)data;
+    BeginProfileZone(PROFILE_ZONE_UPDATE);
+    if (game->courseMode)
     {
-        if (framesSinceLaunch < 10) framesSinceLaunch++;
-        if (framesSinceLaunch == 1)
-        {
-            currentState = Playing;
-        }
-        else if (framesSinceLaunch == 2)
+        // platforms that stay resident can move within groundArr, keep following ours
+        int platformShift = UpdateCourseStream(&game->course, game->run.sim.position.x);
+        ShiftSimSessionPlatforms(&game->run.sim, platformShift);
+        ShiftSimSessionPlatforms(&game->checkpoint.sim, platformShift);
+        game->groundArr = game->course.groundArr;
+        game->groundArrSize = game->course.platformCount;
+        game->goalResident = game->course.hasGoal;
+        if (game->goalResident) game->nextLevel.transform = MatrixTranslate(game->course.goal.x, game->course.goal.y, game->course.goal.z);
+        SetProfileValue(PROFILE_VALUE_COURSE_STALLS, (float)game->course.stalls);
+    }
+    // the platform positions are gathered once per frame for the ticks and the culling
+    SimdPoints platformCenters = MakeSimdPoints((float*)ArenaAlloc(&game->frameArena, 3*game->groundArrSize*sizeof(float)), game->groundArrSize);
+    GatherModelPositions(game->groundArr, game->groundArrSize, &platformCenters);
+    game->simLevel = (SimLevel){game->groundArr, game->groundArrSize, game->goalResident, {game->nextLevel.transform.m12, game->nextLevel.transform.m13, game->nextLevel.transform.m14}, game->run.grapplingUnlocked, platformCenters, game->simTickRate};
+    float tickTime = GetSimTickTime(&game->simLevel);
+    unsigned char latePresses = game->latePresses;
+    game->latePresses = 0;
+    if (IsKeyPressed(KEY_ESCAPE) || (latePresses & LATE_PRESS_ESCAPE))
+    {
+        if (IsCursorHidden())
         {
-            currentState = Respawn;
+            UseFPCameraMouse(&game->cam, false);
         }
-        else if (framesSinceLaunch == 3)
+        else
         {
-            currentState = Intro;
-            cam.ViewCamera.target = (Vector3) {15, 0, 0};
+            UseFPCameraMouse(&game->cam, true);
         }
-        int currentGround = -100;
-        float dt = GetFrameTime();
-        if (IsKeyPressed(KEY_F11))
+    }
+    // Update
+    //----------------------------------------------------------------------------------
+    if (IsKeyPressed(KEY_SPACE) || (latePresses & LATE_PRESS_JUMP)) game->pendingPresses |= SIM_BUTTON_JUMP;
+    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) || (latePresses & LATE_PRESS_FIRE)) game->pendingPresses |= SIM_BUTTON_FIRE;
+    if ((IsKeyPressed(KEY_R) || (latePresses & LATE_PRESS_RETRY)) && !game->netMode)
+    {
+        // instant retry from the start of the level
+        memcpy(&game->run, &game->checkpoint, sizeof(RunState));
+        game->simAccumulator = 0.0f;
+        game->replayCount = 0;
+    }
+    game->simAccumulator += dt;
+    int ticks = 0;
+    // online the server owns the session, falling or finishing starts the course over
+    while (game->simAccumulator >= tickTime && (game->netMode || game->run.sim.state == SIM_SESSION_PLAYING))
+    {
+        SimInput input = ReadSimInput(&game->cam, game->pendingPresses);
+        if (game->netMode)
         {
-            ToggleFullscreen();
+            StepNetTick(game->netServer, game->netClient, &game->simLevel, input);
+            memcpy(&game->run.sim, &game->netClient->session, sizeof(SimSession));
         }
-        if (currentState == Playing)
+        else StepSimSession(&game->run.sim, &game->simLevel, input);
+        game->pendingPresses = 0;
+        if (game->replayInputs != NULL && game->replayCount < REPLAY_MAX_TICKS) game->replayInputs[game->replayCount++] = input;
+        if (!game->courseMode && !game->netMode)
         {
-            PlayMusicStream(bgMusic);
-            UpdateMusicStream(bgMusic);
-            if (cam.CameraPosition.y < -90)
+            // one ghost tick per default length tick, so tracks play back at any rate
+            GhostFrame ghostFrame = {game->run.currentLevel, game->run.sim.position, game->run.sim.viewAngles, game->run.sim.grappling, game->run.sim.grappleHit};
+            for (int frame = 0; frame < SIM_TICK_RATE/game->simTickRate; frame++)
             {
-                timeSinceDeath = 0.0f;
-                targetAtDeath = cam.ViewCamera.target;
-                currentState = Respawn;
-                UpdateModelAnimation(playerModel, *playerAni, 7);
-                fallYVel = 10;
-                UseFPCameraMouse(&cam, false);
+                RecordGhostTick(&game->ghostRecorder, &ghostFrame);
+                for (int i = 0; i < GHOST_COUNT; i++)
+                    StepGhostPlayer(&game->ghostPlayers[i]);
             }
-            currentGroundIndex = -1;
-            for (int i = 0; i < groundArrSize; i++)
-            {
-                RayHitInfo hit = GetCollisionRayMesh((Ray){Vector3Add(cam.CameraPosition, (Vector3){0, 100, 0}), (Vector3){0, -1, 0}}, groundArr[i].meshes[0], MatrixTranslate(groundArr[i].transform.m12, groundArr[i].transform.m13, groundArr[i].transform.m14));
-                if (hit.hit)
-                {
-                    currentGround = hit.position.y;
-                    currentGroundIndex = i;
-                    break;
-                }
-            }
-            if (IsKeyPressed(KEY_ESCAPE))
-            {
-                if (IsCursorHidden())
-                {
-                    UseFPCameraMouse(&cam, false);
-                }
-                else
-                {
-                    UseFPCameraMouse(&cam, true);
-                }
-            }
-            if (IsKeyPressed(KEY_SPACE) && player->isGrounded)
-            {
-                PhysicsAddForce(player, (Vector2){0, -0.25});
-                PlaySound(jump);
-            }
-            // Update
-            //----------------------------------------------------------------------------------
-            if (unstableTimer >= 3.0f)
-            {
-                groundArr[currentGroundIndex].transform = MatrixMultiply(groundArr[currentGroundIndex].transform, MatrixTranslate(sin(unstableTimer) / 100, 0, 0));
-                groundArr[currentGroundIndex].transform = MatrixMultiply(groundArr[currentGroundIndex].transform, MatrixRotateX(sin(unstableTimer * 2) / 100));
-                groundPhysics->enabled = true;
-                groundPhysics->freezeOrient = false;
-                groundPhysics->orient = groundPhysics->orient - (sin(unstableTimer * 2) / 100);
-                float direction[MOVE_DOWN + 1] = {GetSpeedForAxis(&cam, MOVE_FRONT, cam.MoveSpeed.z),
-                                                  GetSpeedForAxis(&cam, MOVE_BACK, cam.MoveSpeed.z),
-                                                  GetSpeedForAxis(&cam, MOVE_RIGHT, cam.MoveSpeed.x),
-                                                  GetSpeedForAxis(&cam, MOVE_LEFT, cam.MoveSpeed.x),
-                                                  GetSpeedForAxis(&cam, MOVE_UP, cam.MoveSpeed.y),
-                                                  GetSpeedForAxis(&cam, MOVE_DOWN, cam.MoveSpeed.y)};
-                Vector3 Forward = Vector3Transform((Vector3){0, 0, 1}, MatrixRotateXYZ((Vector3){0, -cam.ViewAngles.x, 0}));
-
-                Vector3 Right = (Vector3){Forward.z * -1.0f, 0, Forward.x};
-
-                Vector3 move1 = Vector3Add(Vector3Zero(), Vector3Scale(Forward, direction[MOVE_FRONT] - direction[MOVE_BACK]));
-                Vector3 move2 = Vector3Add(Vector3Zero(), Vector3Scale(Right, direction[MOVE_RIGHT] - direction[MOVE_LEFT]));
-                player->velocity = Vector2Add((Vector2){(move1.z + move2.z)/75, 0}, player->velocity);
-            }
-            if (CheckCollisionBoxes((BoundingBox) {Vector3Add(cam.CameraPosition, (Vector3) {-2.5, -1, -2.5}), Vector3Add(cam.CameraPosition, (Vector3) {2.5, 1, 2.5})}, (BoundingBox) {Vector3Add((Vector3) {nextLevel.transform.m12, nextLevel.transform.m13, nextLevel.transform.m14}, (Vector3) {-2.5, -2.5, -2.5}), Vector3Add((Vector3) {nextLevel.transform.m12, nextLevel.transform.m13, nextLevel.transform.m14}, (Vector3) {2.5, 0.5, 2.5})}))
-            {
-                currentLevel++;
-                cam.CameraPosition = Vector3Zero();
-                player->velocity = Vector2Zero();
-                player->force = Vector2Zero();
-                player->position = Vector2Zero();
-                unstableTimer = 0.0f;
-                if (currentLevel == 1)
-                {
-                    groundArr = lvl2.groundArr;
-                    nextLevel.transform.m12 = 30.0f;
-                    groundArrSize = lvl2.elementAmount;
-                }
-                if (currentLevel == 2)
-                {
-                    groundArr = lvl3.groundArr;
-                    nextLevel.transform.m12 = 60.0f;
-                    groundArrSize = lvl3.elementAmount;
-                    grapplingUnlocked = true;
-                }
-                if (currentLevel == 3)
-                {
-                    groundArr = lvl4.groundArr;
-                    nextLevel.transform.m12 = 75.0f;
-                    nextLevel.transform.m13 = -5.0f;
-                    groundArrSize = lvl4.elementAmount;
-                }
-                if (currentLevel == 4)
-                {
-                    groundArr = lvl5.groundArr;
-                    nextLevel.transform.m12 = 95.0f;
-                    nextLevel.transform.m13 = -25.0f;
-                    groundArrSize = lvl5.elementAmount;
-                }
-                if (currentLevel == 4)
-                {
-                    groundArr = lvl6.groundArr;
-                    nextLevel.transform.m12 = 95.0f;
-                    nextLevel.transform.m13 = -75.0f;
-                    groundArrSize = lvl6.elementAmount;
-                }
-                if (currentLevel == 5)
-                {
-                    currentState = Finish;
-                    UpdateModelAnimation(playerModel, *playerAni, 20);
-                    cam.ViewCamera.position = Vector3Zero();
-                    cam.CameraPosition = Vector3Zero();
-                    cam.ViewCamera.target =  (Vector3) {15, 0, 0};
-                    SetCameraMode(cam.ViewCamera, CAMERA_ORBITAL);
-                    platform.transform = MatrixTranslate(15.0f, -2.0f, 0.0f);
-                }
-            }
-            if (!player->isGrounded)
-            {
-                if (unstableTimer >= 3.0f)
-                {
-                    groundPhysics->freezeOrient = false;
-                    groundPhysics->orient = 0.0f;
-                    player->position.x = 0.0f;
-                    player->velocity.x = 0.0f;
-                    for (int i = 0; i < groundArrSize; i++)
-                    {
-                        groundArr[i].transform = MatrixTranslate(groundArr[i].transform.m12, groundArr[i].transform.m13, groundArr[i].transform.m14);
-                    }
-                }
-                unstableTimer = 0;
-            }
-            else if (lastGroundIndex == currentGroundIndex)
-            {
-                unstableTimer += 1 * dt;
-            }
-            groundPhysics->position.y = -currentGround;
-            UpdateFPCamera(&cam, unstableTimer >= 3.0f);
-            UpdatePBR(cam.ViewCamera);
-            grapplingGun.transform = MatrixMultiply(grapplingGun.transform,  MatrixRotateXYZ((Vector3){0, -(cam.ViewAngles.x - lastViewAngle.x), 0}));
-            //grapplingGun.transform = MatrixRotateXYZ((Vector3){(cam.ViewAngles.y - lastViewAngle.y), 0, 0});
-            if (isGrappling)
-            {
-                PhysicsAddForce(player, (Vector2) {0, -moveVelocity.y/100});
-            }
-            //printf("%f", groundPhysics->orient);
-            UpdatePhysics();
-            //printf("%f", groundPhysics->orient);
-            groundPhysics->enabled = false;
-            groundPhysics->freezeOrient = true;
-            if (unstableTimer < 3.0f)
-            {
-                groundPhysics->freezeOrient = false;
-                groundPhysics->orient = 0.0f;
-                player->position.x = 0.0f;
-                player->velocity.x = 0.0f;
-            }
-            cam.CameraPosition.y = -player->position.y;
-            cam.CameraPosition.z += player->position.x - lastPlayerPos;
-            // if (player->position.y > 10)
-            // {
-            //     ResetPhysics();
-            //     cam.CameraPosition = Vector3Zero();
-            //     for (int i = 0; i < groundArrSize; i++)
-            //     {
-            //         groundArr[i].transform = MatrixTranslate(groundArr[i].transform.m3, groundArr[i].transform.m7, groundArr[i].transform.m11);
-            //     }
-            //     unstableTimer = 0.0f;
-            // }
-            //----------------------------------------------------------------------------------
-
-            // Draw
-            //----------------------------------------------------------------------------------
-            BeginDrawing();
-            int bodiesCount = GetPhysicsBodiesCount();
-            for (int i = 0; i < bodiesCount; i++)
-            {
-                PhysicsBody body = GetPhysicsBody(i);
-
-                int vertexCount = GetPhysicsShapeVerticesCount(i);
-                for (int j = 0; j < vertexCount; j++)
-                {
-                    // Get physics bodies shape vertices to draw lines
-                    // Note: GetPhysicsShapeVertex() already calculates rotation transformations
-                    Vector2 vertexA = GetPhysicsShapeVertex(body, j);
-
-                    int jj = (((j + 1) < vertexCount) ? (j + 1) : 0); // Get next vertex or first to close the shape
-                    Vector2 vertexB = GetPhysicsShapeVertex(body, jj);
-
-                    //DrawLineV(Vector2Add(vertexA, (Vector2){screenWidth / 2, screenHeight / 2}), Vector2Add(vertexB, (Vector2){screenWidth / 2, screenHeight / 2}), GREEN); // Draw a line between two vertex positions
-                }
-            }
-
-            ClearBackground(RAYWHITE);
-
-            BeginModeFP3D(&cam);
-
-            rlDisableDepthTest();
-            rlDisableBackfaceCulling();
-            rlDisableDepthMask();
-            DrawModel(skybox, (Vector3){0, 0, 0}, 1.0f, WHITE);
-            rlEnableBackfaceCulling();
-            rlEnableDepthMask();
-            rlEnableDepthTest();
-            //DrawGrid(10, 1.0f);
-            if (currentLevel == 0) DrawBillboard(cam.ViewCamera, instructions.materials[0].maps[MATERIAL_MAP_ALBEDO].texture, (Vector3) {5, 0, 0}, 10.0, WHITE);
-            if (currentLevel == 2) DrawBillboard(cam.ViewCamera, instructions1, (Vector3) {5, 0, 0}, 10.0, WHITE);
-
-            for (int i = 0; i < groundArrSize; i++)
-            {
-                DrawModel(groundArr[i], cubePosition, 1.0f, WHITE);
-            }
-            DrawModel(nextLevel, cubePosition, 1.0f, WHITE);
-            if (grapplingUnlocked) DrawModel(grapplingGun, cam.CameraPosition, 1.0f, WHITE);
-            if (grapplingUnlocked && IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
-            {
-                grapple.direction = cam.Forward;
-                grappleAlreadyHit = false;
-                for (int i = 0; i < groundArrSize; i++)
-                {
-                    if (i != currentGroundIndex && CheckCollisionRayBox((Ray) {Vector3Transform(Vector3Zero(), MatrixMultiply(grapplingGun.transform, MatrixTranslate(cam.CameraPosition.x, cam.CameraPosition.y, cam.CameraPosition.z))), cam.Forward}, (BoundingBox) {(Vector3) {groundArr[i].transform.m12 - 5, groundArr[i].transform.m13 - 50, groundArr[i].transform.m14 - 5}, (Vector3) {groundArr[i].transform.m12 + 5, groundArr[i].transform.m13 + 50, groundArr[i].transform.m14 + 5}}))
-                    {
-                        grapplingEnabled= true;
-                        grappleHitIndex = i;
-                        grappleAlreadyHit = true;
-                        grappleHitPos = GetCollisionRayMesh((Ray) {Vector3Transform(Vector3Zero(), MatrixMultiply(grapplingGun.transform, MatrixTranslate(cam.CameraPosition.x, cam.CameraPosition.y, cam.CameraPosition.z))), cam.Forward}, platformHitBox, MatrixTranslate(groundArr[i].transform.m12, groundArr[i].transform.m13, groundArr[i].transform.m14)).position;
-                        if (grappleHitPos.y > groundArr[i].transform.m13 + 0.5)
-                        {
-                            grappleHitPos.y = groundArr[i].transform.m13 + 0.5;
-                        }
-                        if (grappleHitPos.y < groundArr[i].transform.m13 - 0.5)
-                        {
-                            grappleHitPos.y = groundArr[i].transform.m13 - 0.5;
-                        }
-                        break;
-                    }
-                    else
-                    {
-                        if (!grappleAlreadyHit) grapplingEnabled = false;
-                    }
-                }
-            }
-            if (IsMouseButtonDown(MOUSE_LEFT_BUTTON) && grapplingUnlocked && grapplingEnabled)
-            {
-                isGrappling = true;
-                Vector3 startPos = Vector3Transform(Vector3Zero(), MatrixMultiply(MatrixTranslate(cam.CameraPosition.x, cam.CameraPosition.y, cam.CameraPosition.z), MatrixTranslate(grapplingGun.transform.m12, grapplingGun.transform.m13, grapplingGun.transform.m14)));
-                DrawLine3D(startPos, grappleHitPos, BLUE);
-                grapple.position = Vector3Transform(Vector3Zero(), MatrixMultiply(grapplingGun.transform, MatrixTranslate(cam.CameraPosition.x, cam.CameraPosition.y, cam.CameraPosition.z)));
-                moveVelocity = (Vector3) {atan(grappleHitPos.x-startPos.x), atan(grappleHitPos.y-startPos.y), atan(grappleHitPos.z-startPos.z)};
-                if (moveVelocity.x == 0.0f && moveVelocity.y == 0.0f && moveVelocity.z == 0.0f) isGrappling = false;
-                cam.CameraPosition = Vector3Add(cam.CameraPosition, (Vector3) {moveVelocity.x, 0, moveVelocity.z});
-            }
-            else
-            {
-                moveVelocity = Vector3Zero();
-                grapplingEnabled= false;
-                isGrappling = false;
-            }
-            //DrawModel(playerModel, cubePosition, 1.0f, WHITE);
-
-            EndModeFP3D();
-
-            EndDrawing();
-            lastGroundIndex = currentGroundIndex;
-            lastPlayerPos = player->position.x;
-            lastViewAngle = cam.ViewAngles;
         }
-        else if (currentState == Start)
+        game->simAccumulator -= tickTime;
+        if (game->run.sim.events & SIM_EVENT_JUMP) PostAudioEvent(AUDIO_EVENT_JUMP);
+        if (game->run.sim.events & SIM_EVENT_GRAPPLE) PostAudioEvent(AUDIO_EVENT_GRAPPLE);
+        if (++ticks == SIM_MAX_TICKS_PER_FRAME)
         {
-            UpdateMusicStream(bgMusic);
-            int width = GetScreenWidth();
-            int height = GetScreenHeight();
-            UseFPCameraMouse(&cam, false);
-            UpdateCamera(&cam.ViewCamera);
-            BeginDrawing();
-            ClearBackground(WHITE);
-            //DrawTexturePro(background, (Rectangle){0, 0, background.width, background.height}, (Rectangle){0, 0, width, height}, Vector2Zero(), 0, WHITE);
-            UpdatePBR(cam.ViewCamera);
-            BeginMode3D(cam.ViewCamera);
-            rlDisableDepthTest();
-            rlDisableBackfaceCulling();
-            rlDisableDepthMask();
-            DrawModel(skybox, (Vector3){0, 0, 0}, 1.0f, WHITE);
-            rlEnableBackfaceCulling();
-            rlEnableDepthMask();
-            rlEnableDepthTest();
-            DrawModel(groundArr[1], cubePosition, 1.0f, WHITE);
-            DrawModel(playerModel, (Vector3) {15, -5, -5}, 0.5f, WHITE);
-            EndMode3D();
-            if (GuiButton((Rectangle){width / 2 - width / 20, height / 2 - height / 20, width / 10, height / 10}, "PLAY"))
-            {
-                currentState = Playing;
-                cam.CameraPosition = Vector3Zero();
-                UseFPCameraMouse(&cam, true);
-                player->velocity = Vector2Zero();
-                player->force = Vector2Zero();
-                player->position = Vector2Zero();
-                unstableTimer = 0.0f;
-            }
-            DrawTextEx(font, "ROCKY ROAD", (Vector2){width/2-MeasureText("ROCKY ROAD", 20)*2, 100}, 100, 2.0f, RED);
-            EndDrawing();
+            game->simAccumulator = 0.0f;
+            break;
         }
-        else if (currentState == Respawn)
+    }
+    if (game->run.sim.state == SIM_SESSION_DEAD && !game->netMode)
+    {
+        ChangeScene(&game->scenes, SCENE_RESPAWN);
+    }
+    else if (game->run.sim.state == SIM_SESSION_FINISHED && !game->netMode)
+    {
+        // streamed courses move their platforms around, only fixed levels replay
+        if (!game->courseMode && game->replayInputs != NULL && game->replayCount < REPLAY_MAX_TICKS)
         {
-            UpdateMusicStream(bgMusic);
-            timeSinceDeath += 0.01;
-            int width = GetScreenWidth();
-            int height = GetScreenHeight();
-            fallYVel += 1;
-            cam.CameraPosition = (Vector3){0, -90, 0};
-            if (timeSinceDeath < 1.0f)
-                cam.ViewCamera.target = Vector3Lerp(targetAtDeath, (Vector3){0, -90 - fallYVel, 0}, timeSinceDeath);
+            if (VerifySimReplay(&game->checkpoint.sim, game->replayInputs, game->replayCount, &game->simLevel, &game->run.sim))
+                TraceLog(LOG_INFO, "REPLAY: Level %i replayed to the same state after %i ticks", game->run.currentLevel, game->replayCount);
             else
-                cam.ViewCamera.target = (Vector3) {0, -90 - fallYVel, 0};
-            BeginDrawing();
-            ClearBackground(WHITE);
-            BeginMode3D(cam.ViewCamera);
-            rlDisableDepthTest();
-            rlDisableBackfaceCulling();
-            rlDisableDepthMask();
-            DrawModel(skybox, (Vector3){0, 0, 0}, 1.0f, WHITE);
-            rlEnableBackfaceCulling();
-            rlEnableDepthMask();
-            rlEnableDepthTest();
-            DrawModel(playerModel, (Vector3){0, -90 - fallYVel, 0}, 1.0f, WHITE);
-            EndMode3D();
-            if (GuiButton((Rectangle){width / 2 - width / 20 - 100, height / 2 - height / 20 - 100, width / 10, height / 10}, "RESPAWN"))
-            {
-                currentState = Playing;
-                cam.CameraPosition = Vector3Zero();
-                UseFPCameraMouse(&cam, true);
-                player->velocity = Vector2Zero();
-                player->force = Vector2Zero();
-                player->position = Vector2Zero();
-                unstableTimer = 0.0f;
-            }
-            EndDrawing();
+                TraceLog(LOG_WARNING, "REPLAY: Level %i came out different when replayed", game->run.currentLevel);
         }
-        else if (currentState == Intro)
+        game->run.currentLevel++;
+        InitSimSession(&game->run.sim);
+        game->simAccumulator = 0.0f;
+        // a course is one run from start to goal
+        if (game->courseMode) game->run.currentLevel = 5;
+        if (game->run.currentLevel == 1)
         {
-            UpdateMusicStream(bgMusic);
-            if (state == 0)                 // State 0: Small box blinking
+            game->level = LoadLevel(&game->levelArena, 1, game->platform);
+            game->nextLevel.transform.m12 = 30.0f;
+        }
+        if (game->run.currentLevel == 2)
         {
-            framesCounter++;
-
-            if (framesCounter == 120)
-            {
-                state = 1;
-                framesCounter = 0;      // Reset counter... will be used later...
-            }
+            game->level = LoadLevel(&game->levelArena, 2, game->platform);
+            game->nextLevel.transform.m12 = 60.0f;
+            game->run.grapplingUnlocked = true;
         }
-        else if (state == 1)            // State 1: Top and left bars growing
+        if (game->run.currentLevel == 3)
         {
-            topSideRecWidth += 4;
-            leftSideRecHeight += 4;
-
-            if (topSideRecWidth == 256) state = 2;
+            game->level = LoadLevel(&game->levelArena, 3, game->platform);
+            game->nextLevel.transform.m12 = 75.0f;
+            game->nextLevel.transform.m13 = -5.0f;
         }
-        else if (state == 2)            // State 2: Bottom and right bars growing
+        if (game->run.currentLevel == 4)
         {
-            bottomSideRecWidth += 4;
-            rightSideRecHeight += 4;
-
-            if (bottomSideRecWidth == 256) state = 3;
+            game->level = LoadLevel(&game->levelArena, 4, game->platform);
+            game->nextLevel.transform.m12 = 95.0f;
+            game->nextLevel.transform.m13 = -25.0f;
         }
-        else if (state == 3)            // State 3: Letters appearing (one by one)
+        if (game->run.currentLevel == 4)
         {
-            framesCounter++;
-
-            if (framesCounter/12)       // Every 12 frames, one more letter!
+            game->level = LoadLevel(&game->levelArena, 5, game->platform);
+            game->nextLevel.transform.m12 = 95.0f;
+            game->nextLevel.transform.m13 = -75.0f;
+        }
+        game->groundArr = game->level.groundArr;
+        game->groundArrSize = game->level.elementAmount;
+        game->simLevel.platforms = game->groundArr;
+        game->simLevel.platformCount = game->groundArrSize;
+        memcpy(&game->checkpoint, &game->run, sizeof(RunState));
+        game->replayCount = 0;
+        if (game->run.currentLevel == 5 && !game->courseMode)
+        {
+            // a faster run replaces the best ghost, a slower one races along next time
+            GhostTrack run = FinishGhostRecording(&game->ghostRecorder);
+            UnloadGhostTrack(&game->ghostTracks[GHOST_LAST]);
+            if (run.tickCount > 0 && (game->ghostTracks[GHOST_BEST].tickCount == 0 || run.tickCount < game->ghostTracks[GHOST_BEST].tickCount))
             {
-                lettersCount++;
-                framesCounter = 0;
+                SaveGhostTrack(GHOST_FILE, run);
+                UnloadGhostTrack(&game->ghostTracks[GHOST_BEST]);
+                game->ghostTracks[GHOST_BEST] = run;
             }
+            else game->ghostTracks[GHOST_LAST] = run;
+        }
+        if (game->run.currentLevel == 5)
+        {
+            ChangeScene(&game->scenes, SCENE_FINISH);
+        }
+    }
+    // the camera only looks, where it stands comes from the session
+    game->cam.CameraPosition = game->run.sim.position;
+    UpdateFPCamera(&game->cam, game->run.sim.unstableTimer >= SIM_WOBBLE_DELAY);
+    UpdatePBR(game->cam.ViewCamera);
+    game->grapplingGun.transform = MatrixMultiply(game->grapplingGun.transform,  MatrixRotateXYZ((Vector3){0, -(game->cam.ViewAngles.x - game->lastViewAngle.x), 0}));
+    //grapplingGun.transform = MatrixRotateXYZ((Vector3){(cam.ViewAngles.y - lastViewAngle.y), 0, 0});
+    //----------------------------------------------------------------------------------
+
+    UpdateDynamicResolution(&game->dynamicRes, dt);
+    SetProfileValue(PROFILE_VALUE_RESOLUTION_SCALE, game->dynamicRes.scale);
+    SetProfileValue(PROFILE_VALUE_INPUT_TO_PHOTON, game->pacer.inputToPhotonMs);
+    EndProfileZone(PROFILE_ZONE_UPDATE);
+
+    // the render zone starts with the shadow map and ends in DrawPlayingScene
+    BeginProfileZone(PROFILE_ZONE_RENDER);
+
+    // the shadow map is only redrawn when a platform or the goal moved
+    int casterCount = game->groundArrSize + (game->goalResident? 1 : 0);
+    ShadowCaster *casters = (ShadowCaster*)ArenaAlloc(&game->frameArena, (game->groundArrSize + 1)*sizeof(ShadowCaster));
+    if (casters != NULL)
+    {
+        for (int i = 0; i < game->groundArrSize; i++)
+            casters[i] = (ShadowCaster){&game->groundArr[i].meshes[0], GetSimPlatformTransform(&game->run.sim, &game->simLevel, i)};
+        casters[game->groundArrSize] = (ShadowCaster){&game->nextLevel.meshes[0], game->nextLevel.transform};
+        if (UpdateShadowMap(casters, casterCount)) game->shadowRedraws++;
+    }
+    SetProfileValue(PROFILE_VALUE_SHADOW_UPDATES, (float)game->shadowRedraws);
 
-            if (lettersCount >= 10)     // When all letters have appeared, just fade out everything
-            {
-                alpha -= 0.02f;
+    // the shadows and the simulation are done, whatever the mouse did meanwhile still
+    // turns the view and the gun with it
+    if (game->pacer.lateLatch)
+    {
+        float latchedYaw = game->cam.ViewAngles.x;
+        unsigned char heldBefore = ReadLatePresses();
+        PollLateInput(&game->pacer);
+        game->latePresses |= ReadLatePresses() & ~heldBefore;
+        LatchFPCameraLook(&game->cam);
+        game->grapplingGun.transform = MatrixMultiply(game->grapplingGun.transform, MatrixRotateXYZ((Vector3){0, -(game->cam.ViewAngles.x - latchedYaw), 0}));
+    }
+}
 
-                if (alpha <= 0.0f)
-                {
-                    alpha = 0.0f;
-                    state = 4;
-                }
-            }
+static void DrawPlayingScene(void *data)
+{
+    Game *game = (Game*)data;
+    ClearBackground(RAYWHITE);
+
+    BeginDynamicResolutionFP3D(&game->dynamicRes, &game->cam, RAYWHITE);
+
+    //DrawGrid(10, 1.0f);
+    BeginRenderQueue(&game->renderQueue, &game->frameArena, game->groundArrSize + RENDER_QUEUE_EXTRA, game->cam.ViewCamera.position);
+    SubmitModel(&game->renderQueue, RENDER_PASS_SKY, game->skybox, MatrixIdentity());
+
+    ExtractFrustum(&game->platformWork.frustum);
+    game->platformWork.groundArr = game->groundArr;
+    game->platformWork.centers = game->simLevel.centers;
+    game->platformWork.visible = (bool*)ArenaAlloc(&game->frameArena, game->groundArrSize*sizeof(bool));
+    game->platformWork.drawTransforms = (Matrix*)ArenaAlloc(&game->frameArena, game->groundArrSize*sizeof(Matrix));
+    ParallelFor(game->groundArrSize, PLATFORM_BATCH_SIZE, CullPlatformsRange, &game->platformWork);
+    if (game->run.sim.wobbleIndex >= 0 && game->run.sim.wobbleIndex < game->groundArrSize)
+        game->platformWork.drawTransforms[game->run.sim.wobbleIndex] = game->run.sim.wobbleTransform;
+    // the platforms share one material, the closest visible one decides its texture size
+    float platformPixels = 0.0f;
+    for (int i = 0; i < game->groundArrSize; i++)
+    {
+        if (!game->platformWork.visible[i]) continue;
+        SubmitMesh(&game->renderQueue, RENDER_PASS_OPAQUE, &game->groundArr[i].meshes[0], &game->groundArr[i].materials[0], game->platformWork.drawTransforms[i]);
+        Vector3 platformCenter = {game->platformWork.drawTransforms[i].m12, game->platformWork.drawTransforms[i].m13, game->platformWork.drawTransforms[i].m14};
+        platformPixels = fmaxf(platformPixels, GetSphereScreenPixels(platformCenter, game->platformRadius, game->cam.ViewCamera, (float)GetScreenHeight()));
+    }
+    if (platformPixels > 0.0f) RequestMaterialTextures(&game->platform.materials[0], platformPixels);
+    if (game->goalResident)
+    {
+        Vector3 goalCenter = {game->nextLevel.transform.m12, game->nextLevel.transform.m13, game->nextLevel.transform.m14};
+        SubmitModel(&game->renderQueue, RENDER_PASS_OPAQUE, game->nextLevel, MatrixTranslate(game->cubePosition.x, game->cubePosition.y, game->cubePosition.z));
+        RequestMaterialTextures(&game->nextLevel.materials[0], GetSphereScreenPixels(goalCenter, game->nextLevelRadius, game->cam.ViewCamera, (float)GetScreenHeight()));
+    }
+    if (game->run.grapplingUnlocked) SubmitModel(&game->renderQueue, RENDER_PASS_OPAQUE, game->grapplingGun, MatrixTranslate(game->cam.CameraPosition.x, game->cam.CameraPosition.y, game->cam.CameraPosition.z));
+    if (game->run.sim.grappling) DrawLine3D(GetSimGrappleOrigin(&game->run.sim), game->run.sim.grappleHit, BLUE);
+    //DrawModel(playerModel, cubePosition, 1.0f, WHITE);
+
+    DrawRenderQueue(&game->renderQueue);
+    PublishRenderStats(&game->renderQueue);
+
+    // ghosts are see-through, they go over everything opaque in one instanced draw
+    Matrix ghostTransforms[GHOST_COUNT];
+    int ghostCount = 0;
+    for (int i = 0; i < GHOST_COUNT && !game->courseMode && !game->netMode; i++)
+    {
+        const GhostFrame *ghost = &game->ghostPlayers[i].frame;
+        if (game->ghostPlayers[i].finished || game->ghostPlayers[i].track->tickCount == 0 || ghost->level != game->run.currentLevel) continue;
+        ghostTransforms[ghostCount++] = GetGhostTransform(ghost);
+        if (ghost->grappling) DrawLine3D(ghost->position, ghost->grappleHit, Fade(SKYBLUE, 0.5f));
+    }
+    DrawSkinnedModelInstanced(&game->playerSkin, game->playerModel, ghostTransforms, ghostCount, GHOST_TINT);
+
+    // the other players, as far as the server sends them
+    Matrix remoteTransforms[NET_MAX_PLAYERS];
+    int remoteCount = 0;
+    for (int i = 0; i < NET_MAX_PLAYERS && game->netMode; i++)
+    {
+        GhostFrame remote;
+        if (!GetNetRemoteFrame(game->netClient, i, &remote)) continue;
+        remoteTransforms[remoteCount++] = GetGhostTransform(&remote);
+        if (remote.grappling) DrawLine3D(remote.position, remote.grappleHit, Fade(ORANGE, 0.5f));
+    }
+    DrawSkinnedModelInstanced(&game->playerSkin, game->playerModel, remoteTransforms, remoteCount, NET_TINT);
+
+    // the instruction billboards have see-through texels, so they go over the sky
+    if (game->courseMode)
+    {
+        for (int i = 0; i < game->course.signCount; i++)
+            DrawBillboard(game->cam.ViewCamera, (game->course.signs[i].variant == 0)? game->instructions.materials[0].maps[MATERIAL_MAP_ALBEDO].texture : game->instructions1, game->course.signs[i].position, 10.0, WHITE);
+    }
+    else
+    {
+        if (game->run.currentLevel == 0) DrawBillboard(game->cam.ViewCamera, game->instructions.materials[0].maps[MATERIAL_MAP_ALBEDO].texture, (Vector3) {5, 0, 0}, 10.0, WHITE);
+        if (game->run.currentLevel == 2) DrawBillboard(game->cam.ViewCamera, game->instructions1, (Vector3) {5, 0, 0}, 10.0, WHITE);
+    }
+
+    EndDynamicResolutionFP3D(&game->dynamicRes);
+
+    EndProfileZone(PROFILE_ZONE_RENDER);
+    game->lastViewAngle = game->cam.ViewAngles;
+}
+
+// the menus want the cursor back
+static void ExitPlayingScene(void *data)
+{
+    Game *game = (Game*)data;
+    UseFPCameraMouse(&game->cam, false);
+}
+
+static void EnterRespawnScene(void *data)
+{
+    Game *game = (Game*)data;
+    game->playerClip = "fall";
+    game->timeSinceDeath = 0.0f;
+    game->targetAtDeath = game->cam.ViewCamera.target;
+    game->fallYVel = 10;
+}
+
+static void UpdateRespawnScene(void *data, float dt)
+{
+    Game *game = (Game*)data;
+    (void)dt;
+    game->timeSinceDeath += 0.01;
+    game->fallYVel += 1;
+    game->cam.CameraPosition = (Vector3){0, -90, 0};
+    if (game->timeSinceDeath < 1.0f)
+        game->cam.ViewCamera.target = Vector3Lerp(game->targetAtDeath, (Vector3){0, -90 - game->fallYVel, 0}, game->timeSinceDeath);
+    else
+        game->cam.ViewCamera.target = (Vector3) {0, -90 - game->fallYVel, 0};
+}
+
+static void DrawRespawnScene(void *data)
+{
+    Game *game = (Game*)data;
+    int width = GetScreenWidth();
+    int height = GetScreenHeight();
+    ClearBackground(WHITE);
+    DrawMenuView(game, NULL, MatrixTranslate(0, -90 - game->fallYVel, 0));
+    if (GuiButton((Rectangle){width / 2 - width / 20 - 100, height / 2 - height / 20 - 100, width / 10, height / 10}, "RESPAWN"))
+    {
+        ChangeScene(&game->scenes, SCENE_PLAYING);
+    }
+}
+
+static void EnterFinishScene(void *data)
+{
+    Game *game = (Game*)data;
+    game->playerClip = "victory";
+    UseMenuCamera(&game->cam);
+    game->platform.transform = MatrixTranslate(15.0f, -2.0f, 0.0f);
+    UseMenuPowerSaving(game, true);
+}
+
+static void UpdateFinishScene(void *data, float dt)
+{
+    Game *game = (Game*)data;
+    for (int ticks = TakeMenuTicks(game, dt); ticks > 0; ticks--)
+        UpdateCamera(&game->cam.ViewCamera);
+}
+
+static void DrawFinishScene(void *data)
+{
+    Game *game = (Game*)data;
+    ClearBackground(WHITE);
+    DrawCachedMenuView(game, &game->platform, MatrixMultiply(MatrixScale(0.5f, 0.5f, 0.5f), MatrixTranslate(15, 2, 0)));
+    DrawTextEx(game->font, "VICTORY", (Vector2){GetScreenWidth()/2-MeasureText("VICTORY", 20)*2, 100}, 100, 2.0f, RED);
+}
+
+bool getCurrentGround(Vector3 pos, Model groundArr)
+{
+    if (pos.x > groundArr.meshes[0].vertices[0] && pos.x < groundArr.meshes[0].vertices[3] && pos.z > groundArr.meshes[0].vertices[14] && pos.z < groundArr.meshes[0].vertices[2])
+    {
+        return true;
+    }
+    return false;
+}
+
+static Level LoadLevel(Arena *arena, int index, Model platform)
+{
+    const LevelLayout *layout = &levelLayouts[index];
+    Level level = { 0 };
+
+    // the previous level's platforms are dropped all at once
+    ResetArena(arena);
+    level.groundArr = (Model*)ArenaAlloc(arena, layout->elementAmount*sizeof(Model));
+    if (level.groundArr == NULL)
+        return level;
+
+    level.elementAmount = layout->elementAmount;
+    for (int i = 0; i < layout->elementAmount; i++)
+    {
+        level.groundArr[i] = platform;
+        level.groundArr[i].transform = MatrixMultiply(platform.transform, MatrixTranslate(layout->offsets[i].x, layout->offsets[i].y, layout->offsets[i].z));
+    }
+
+    return level;
+}
+
+static void CullPlatformsRange(void *data, int start, int end)
+{
+    PlatformWork *work = (PlatformWork *)data;
+
+    // the platform mesh is centred on its origin. wobbling platforms tilt a little, pad the box
+    // so their corners are not clipped
+    Vector3 pad = {0.5f, 0.5f, 0.5f};
+    Vector3 halfSize = Vector3Add(Vector3Scale(Vector3Subtract(work->localBounds.max, work->localBounds.min), 0.5f), pad);
+    TestBoxesInFrustum(&work->frustum, &work->centers, start, end, halfSize, work->visible);
+
+    for (int i = start; i < end; i++)
+        work->drawTransforms[i] = work->groundArr[i].transform;
+}
+
+static int RunCourseGenerator(const char *fileName, unsigned long long firstSeed, int platformCount, int candidateCount)
+{
+    if (platformCount < 2 || candidateCount < 1)
+        return 1;
+
+    LevelGenParams params = GetDefaultLevelGenParams(platformCount);
+    CourseCandidate *candidates = (CourseCandidate*)GameHeapAlloc(candidateCount*sizeof(CourseCandidate));
+    if (candidates == NULL)
+        return 1;
+
+    InitJobSystem(0);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    VetCourseSeeds(&params, firstSeed, candidateCount, candidates);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    int threads = GetJobWorkerCount() + 1;
+    CloseJobSystem();
+
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec)*1e-9;
+    int validCount = 0;
+    int chosen = -1;
+    for (int i = 0; i < candidateCount; i++)
+    {
+        if (!candidates[i].valid) continue;
+        if (chosen < 0) chosen = i;
+        validCount++;
+    }
+    TraceLog(LOG_INFO, "COURSE: %i of %i candidates of %i platforms valid, %.0f candidates per minute on %i threads",
+             validCount, candidateCount, platformCount, (seconds > 0.0)? candidateCount*60.0/seconds : 0.0, threads);
+
+    bool saved = false;
+    if (chosen < 0)
+    {
+        TraceLog(LOG_WARNING, "COURSE: No valid course among seeds %llu to %llu", firstSeed, firstSeed + candidateCount - 1);
+    }
+    else
+    {
+        int capacity = platformCount + 2;
+        CourseElement *elements = (CourseElement*)GameHeapAlloc(capacity*sizeof(CourseElement));
+        if (elements != NULL)
+        {
+            int count = GenerateCourse(&params, candidates[chosen].seed, elements, capacity);
+            TraceLog(LOG_INFO, "COURSE: Seed %llu, %i hops need the grapple", candidates[chosen].seed, candidates[chosen].grappleHops);
+            saved = SaveCourse(fileName, elements, count);
+            GameHeapFree(elements);
         }
-        else if (state == 4)            // State 4: Go to homescreen
+    }
+
+    GameHeapFree(candidates);
+    return saved? 0 : 1;
+}
+
+// every session plays its own bot, sessions that finish or fall start over. returns seconds
+static double RunBatchTicks(SimSession *sessions, SimInput *inputs, int sessionCount, int tickCount, const SimLevel *level, int *finished, int *died)
+{
+    *finished = 0;
+    *died = 0;
+    for (int i = 0; i < sessionCount; i++)
+        InitSimSession(&sessions[i]);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int tick = 0; tick < tickCount; tick++)
+    {
+        for (int i = 0; i < sessionCount; i++)
         {
-            currentState = Start;
+            if (sessions[i].state == SIM_SESSION_PLAYING) continue;
+            if (sessions[i].events & SIM_EVENT_GOAL) (*finished)++;
+            if (sessions[i].events & SIM_EVENT_DIED) (*died)++;
+            InitSimSession(&sessions[i]);
         }
-        //----------------------------------------------------------------------------------
+        GetSimBotInputs(sessions, inputs, sessionCount, level);
+        StepSimSessions(sessions, inputs, sessionCount, level);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
 
-        // Draw
-        //----------------------------------------------------------------------------------
-        BeginDrawing();
+    return (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec)*1e-9;
+}
 
-            ClearBackground(RAYWHITE);
+static int RunBatchHost(int sessionCount, int tickCount, unsigned long long seed, int platformCount)
+{
+    if (platformCount < 2 || tickCount < 1)
+        return 1;
+
+    // sessions only read the platform transforms, no meshes are loaded
+    Model *platforms = NULL;
+    SimLevel level = { 0 };
+    SimSession *sessions = (SimSession*)GameHeapAlloc(sessionCount*sizeof(SimSession));
+    SimInput *inputs = (SimInput*)GameHeapAlloc(sessionCount*sizeof(SimInput));
+    if (sessions == NULL || inputs == NULL || LoadGeneratedCourse(seed, platformCount, (Model){ 0 }, &platforms, &level) == 0)
+    {
+        GameHeapFree(sessions);
+        GameHeapFree(inputs);
+        return 1;
+    }
 
-            if (state == 0)
-            {
-                if ((framesCounter/15)%2) DrawRectangle(logoPositionX, logoPositionY, 16, 16, BLACK);
-            }
-            else if (state == 1)
-            {
-                DrawRectangle(logoPositionX, logoPositionY, topSideRecWidth, 16, BLACK);
-                DrawRectangle(logoPositionX, logoPositionY, 16, leftSideRecHeight, BLACK);
-            }
-            else if (state == 2)
-            {
-                DrawRectangle(logoPositionX, logoPositionY, topSideRecWidth, 16, BLACK);
-                DrawRectangle(logoPositionX, logoPositionY, 16, leftSideRecHeight, BLACK);
+    // once inline for the baseline, then one batch per core. both runs play the same bots, so
+    // their counts only differ if the threaded step is not deterministic
+    int singleFinished = 0;
+    int singleDied = 0;
+    double singleSeconds = RunBatchTicks(sessions, inputs, sessionCount, tickCount, &level, &singleFinished, &singleDied);
+    int finished = 0;
+    int died = 0;
+    InitJobSystem(0);
+    int threads = GetJobWorkerCount() + 1;
+    double seconds = RunBatchTicks(sessions, inputs, sessionCount, tickCount, &level, &finished, &died);
+    CloseJobSystem();
+
+    double sessionTicks = (double)sessionCount*tickCount;
+    double singleRate = (singleSeconds > 0.0)? sessionTicks/singleSeconds : 0.0;
+    double rate = (seconds > 0.0)? sessionTicks/seconds : 0.0;
+    TraceLog(LOG_INFO, "BATCH: %i sessions for %i ticks on %i threads, %.0f session-ticks per second (%.0f on one thread, %.1fx)",
+             sessionCount, tickCount, threads, rate, singleRate, (singleRate > 0.0)? rate/singleRate : 0.0);
+    TraceLog(LOG_INFO, "BATCH: Seed %llu, bots finished %i runs and fell %i times", seed, finished, died);
+    if (finished != singleFinished || died != singleDied)
+        TraceLog(LOG_WARNING, "BATCH: One thread finished %i runs and fell %i times, threaded results differ", singleFinished, singleDied);
+
+    UnloadGeneratedCourse(platforms, &level);
+    GameHeapFree(sessions);
+    GameHeapFree(inputs);
+    return 0;
+}
 
-                DrawRectangle(logoPositionX + 240, logoPositionY, 16, rightSideRecHeight, BLACK);
-                DrawRectangle(logoPositionX, logoPositionY + 240, bottomSideRecWidth, 16, BLACK);
-            }
-            else if (state == 3)
-            {
-                DrawRectangle(logoPositionX, logoPositionY, topSideRecWidth, 16, Fade(BLACK, alpha));
-                DrawRectangle(logoPositionX, logoPositionY + 16, 16, leftSideRecHeight - 32, Fade(BLACK, alpha));
+// one pass of every batched test over the whole course, each result folded into checksum so
+// both paths can be compared. returns seconds
+static double RunSimdKernels(const SimLevel *level, const Frustum *frustum, SimdPoints *transformed, bool *visible, int passes, unsigned int *checksum)
+{
+    const SimdPoints *centers = &level->centers;
+    int count = level->platformCount;
+    Vector3 halfSize = {5.0f, 0.5f, 5.0f};                  // platforms are 10 x 1 x 10
+    Matrix wobble = MatrixMultiply(MatrixRotateXYZ((Vector3){0.05f, 0.0f, 0.03f}), MatrixTranslate(0.0f, 0.5f, 0.0f));
+    *checksum = 0;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int pass = 0; pass < passes; pass++)
+    {
+        // columns and rays from above and beside platforms spread over the course
+        int i = (pass*7919)%count;
+        Vector3 column = {centers->x[i] + 0.25f, centers->y[i] + 0.25f*(pass%8), centers->z[i] - 0.25f};
+        Ray ray = {{centers->x[i], centers->y[i] + 1.0f, centers->z[i] - 20.0f}, {0.0f, 0.0f, 1.0f}};
+        *checksum = *checksum*31 + (unsigned int)FindFirstPointBelow(centers, 0, count, column, halfSize.x, halfSize.y);
+        *checksum = *checksum*31 + (unsigned int)FindFirstRayBoxHit(centers, 0, count, ray, halfSize);
+        Vector3 landing = {column.x + 3.0f, column.y - 4.0f, column.z + 1.0f};
+        float time = 0.0f;
+        SweptFace face = SWEPT_FACE_TOP;
+        Vector3 reach = {halfSize.x + 0.5f, 1.0f, halfSize.z + 0.5f};
+        int hit = FindFirstSweptLanding(centers, 0, count, column, landing, reach, 1.0f, &time, &face);
+        *checksum = *checksum*31 + (unsigned int)hit + (unsigned int)face;
+
+        TestBoxesInFrustum(frustum, centers, 0, count, halfSize, visible);
+        for (int j = 0; j < count; j++) *checksum += visible[j]? (unsigned int)j : 0;
+        TestSpheresInFrustum(frustum, centers, 0, count, halfSize.x, visible);
+        for (int j = 0; j < count; j++) *checksum += visible[j]? (unsigned int)j : 0;
+
+        TransformSimdPoints(wobble, centers, 0, count, transformed);
+        unsigned int bits;
+        memcpy(&bits, &transformed->y[i], sizeof(bits));
+        *checksum = *checksum*31 + bits;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
 
-                DrawRectangle(logoPositionX + 240, logoPositionY + 16, 16, rightSideRecHeight - 32, Fade(BLACK, alpha));
-                DrawRectangle(logoPositionX, logoPositionY + 240, bottomSideRecWidth, 16, Fade(BLACK, alpha));
+    return (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec)*1e-9;
+}
 
-                DrawRectangle(GetScreenWidth()/2 - 112, GetScreenHeight()/2 - 112, 224, 224, Fade(RAYWHITE, alpha));
+static int RunSimdBench(unsigned long long seed, int platformCount)
+{
+    Model *platforms = NULL;
+    SimLevel level = { 0 };
+    if (LoadGeneratedCourse(seed, platformCount, (Model){ 0 }, &platforms, &level) == 0)
+        return 1;
+
+    SimdPoints transformed = LoadSimdPoints(level.platformCount);
+    bool *visible = (bool*)GameHeapAlloc(level.platformCount*sizeof(bool));
+    if (transformed.x == NULL || visible == NULL)
+    {
+        UnloadSimdPoints(&transformed);
+        GameHeapFree(visible);
+        UnloadGeneratedCourse(platforms, &level);
+        return 1;
+    }
 
-                DrawText(TextSubtext("raylib", 0, lettersCount), GetScreenWidth()/2 - 44, GetScreenHeight()/2 + 48, 50, Fade(BLACK, alpha));
-            }
-            else if (state == 4)
-            {
-                DrawText("[R] REPLAY", 340, 200, 20, GRAY);
-            }
+    // ExtractFrustum needs a GL context, so the view is a box around the middle of the course
+    // that keeps about half the platforms
+    int middle = level.platformCount/2;
+    Vector3 center = {level.centers.x[middle], level.centers.y[middle], level.centers.z[middle]};
+    Vector3 first = {level.centers.x[0], level.centers.y[0], level.centers.z[0]};
+    float reach = 0.5f*Vector3Distance(first, center) + 10.0f;
+    Frustum frustum = {{
+        {0.0f, 0.0f, 1.0f, reach - center.z}, {0.0f, 0.0f, -1.0f, reach + center.z},
+        {0.0f, 1.0f, 0.0f, reach - center.y}, {0.0f, -1.0f, 0.0f, reach + center.y},
+        {-1.0f, 0.0f, 0.0f, reach + center.x}, {1.0f, 0.0f, 0.0f, reach - center.x}
+    }};
+
+    int passes = 2000;
+    unsigned int scalarChecksum = 0;
+    unsigned int checksum = 0;
+    UseSimdKernels(false);
+    double scalarSeconds = RunSimdKernels(&level, &frustum, &transformed, visible, passes, &scalarChecksum);
+    UseSimdKernels(true);
+    double seconds = RunSimdKernels(&level, &frustum, &transformed, visible, passes, &checksum);
+
+    double tests = (double)passes*level.platformCount*6;
+    TraceLog(LOG_INFO, "SIMD: %i platforms, %i passes, %s %.1f Mtests per second, scalar %.1f (%.1fx)",
+             level.platformCount, passes, GetSimdKernelName(), (seconds > 0.0)? tests/seconds*1e-6 : 0.0,
+             (scalarSeconds > 0.0)? tests/scalarSeconds*1e-6 : 0.0, (seconds > 0.0)? scalarSeconds/seconds : 0.0);
+    if (checksum != scalarChecksum)
+        TraceLog(LOG_WARNING, "SIMD: Results differ from the scalar path (%08x, %08x)", checksum, scalarChecksum);
+
+    UnloadSimdPoints(&transformed);
+    GameHeapFree(visible);
+    UnloadGeneratedCourse(platforms, &level);
+    return (checksum == scalarChecksum)? 0 : 1;
+}
 
-        EndDrawing();
+// the whole generated course at once as copies of platform, unloaded with UnloadGeneratedCourse.
+// returns the platform count, 0 when the course could not be built
+static int LoadGeneratedCourse(unsigned long long seed, int platformCount, Model platform, Model **platforms, SimLevel *level)
+{
+    *platforms = NULL;
+    memset(level, 0, sizeof(SimLevel));
+    if (platformCount < 2)
+        return 0;
+
+    LevelGenParams params = GetDefaultLevelGenParams(platformCount);
+    int capacity = platformCount + 2;
+    CourseElement *elements = (CourseElement*)GameHeapAlloc(capacity*sizeof(CourseElement));
+    Model *models = (Model*)GameHeapAlloc(platformCount*sizeof(Model));
+    if (elements == NULL || models == NULL)
+    {
+        GameHeapFree(elements);
+        GameHeapFree(models);
+        return 0;
+    }
+
+    level->platforms = models;
+    level->grappleUnlocked = true;
+    int count = GenerateCourse(&params, seed, elements, capacity);
+    for (int i = 0; i < count; i++)
+    {
+        if (elements[i].type == COURSE_PLATFORM && level->platformCount < platformCount)
+        {
+            models[level->platformCount] = platform;
+            models[level->platformCount++].transform = MatrixTranslate(elements[i].position.x, elements[i].position.y, elements[i].position.z);
         }
-        else if (currentState == Finish)
+        else if (elements[i].type == COURSE_GOAL)
         {
-            UpdateMusicStream(bgMusic);
-            BeginDrawing();
-            ClearBackground(WHITE);
-            UpdateCamera(&cam.ViewCamera);
-            UpdatePBR(cam.ViewCamera);
-            BeginMode3D(cam.ViewCamera);
-            rlDisableDepthTest();
-            rlDisableBackfaceCulling();
-            rlDisableDepthMask();
-            DrawModel(skybox, (Vector3){0, 0, 0}, 1.0f, WHITE);
-            rlEnableBackfaceCulling();
-            rlEnableDepthMask();
-            rlEnableDepthTest();
-            DrawModel(platform, cubePosition, 1.0f, WHITE);
-            DrawModel(playerModel, (Vector3) {15, 2, 0}, 0.5f, WHITE);
-            EndMode3D();
-            DrawTextEx(font, "VICTORY", (Vector2){GetScreenWidth()/2-MeasureText("VICTORY", 20)*2, 100}, 100, 2.0f, RED);
-            EndDrawing();
+            level->hasGoal = true;
+            level->goal = elements[i].position;
         }
+    }
+    GameHeapFree(elements);
 
-        //----------------------------------------------------------------------------------
+    level->centers = LoadSimdPoints(level->platformCount);
+    if (level->centers.x == NULL)
+    {
+        GameHeapFree(models);
+        memset(level, 0, sizeof(SimLevel));
+        return 0;
     }
+    GatherModelPositions(models, level->platformCount, &level->centers);
 
-    // De-Initialization
-    //--------------------------------------------------------------------------------------
-    CloseWindow(); // Close window and OpenGL context
-    UnloadPBRModel(platform);
-    UnloadPBRModel(nextLevel);
-    UnloadShader(skybox.materials[0].shader);
-    UnloadShader(shdrCubemap);
-    UnloadTexture(skybox.materials[0].maps[MATERIAL_MAP_CUBEMAP].texture);
-    UnloadTexture(playerAlbedo);
-    UnloadModel(playerModel);
-    UnloadModel(grapplingGun);
-    UnloadMesh(platformHitBox);
-    UnloadTexture(instructions.materials[0].maps[MATERIAL_MAP_ALBEDO].texture);
-    UnloadTexture(instructions1);
-    UnloadModel(instructions);
-    free(lvl1.groundArr);
-    free(lvl2.groundArr);
-    free(lvl3.groundArr);
-    free(lvl4.groundArr);
-    free(lvl5.groundArr);
-    free(lvl6.groundArr);
-
-    UnloadModel(skybox); // Unload skybox model
-
-    UnloadMesh(cube);
-    ClosePBR();
-    ClosePhysics();
-    CloseAudioDevice();
-    //--------------------------------------------------------------------------------------
+    *platforms = models;
+    return level->platformCount;
+}
 
-    return 0;
+static void UnloadGeneratedCourse(Model *platforms, SimLevel *level)
+{
+    UnloadSimdPoints(&level->centers);
+    GameHeapFree(platforms);
+    memset(level, 0, sizeof(SimLevel));
 }
 
-bool getCurrentGround(Vector3 pos, Model groundArr)
+// wait for the server to let the client in, the host runs its own server meanwhile
+static bool ConnectNetGame(NetServer *server, NetClient *client, const SimLevel *level)
 {
-    if (pos.x > groundArr.meshes[0].vertices[0] && pos.x < groundArr.meshes[0].vertices[3] && pos.z > groundArr.meshes[0].vertices[14] && pos.z < groundArr.meshes[0].vertices[2])
+    for (int tick = 0; tick < NET_CONNECT_SECONDS*SIM_TICK_RATE && !client->accepted; tick++)
     {
-        return true;
+        if (server != NULL) UpdateNetServer(server, level);
+        WaitNetSocket(&client->socket, 1000/SIM_TICK_RATE);
+        ReceiveNetClient(client, NULL);
     }
-    return false;
+    return client->accepted;
+}
+
+// one online tick: the host's server moves first, then the client reconciles and predicts
+static void StepNetTick(NetServer *server, NetClient *client, const SimLevel *level, SimInput input)
+{
+    if (server != NULL) UpdateNetServer(server, level);
+    ReceiveNetClient(client, level);
+    StepNetClient(client, level, input);
+}
+
+// a server and bot clients in one process over loopback, every socket plays the same link
+static int RunNetBench(int playerCount, int tickCount, unsigned long long seed, int platformCount, int latencyTicks, float lossRate)
+{
+    if (playerCount > NET_MAX_PLAYERS) playerCount = NET_MAX_PLAYERS;
+    if (tickCount < 1 || !InitNetwork())
+        return 1;
+
+    Model *platforms = NULL;
+    SimLevel level = { 0 };
+    NetServer *server = (NetServer*)GameHeapAlloc(sizeof(NetServer));
+    NetClient *clients = (NetClient*)GameHeapAlloc(playerCount*sizeof(NetClient));
+    bool started = server != NULL && clients != NULL && LoadGeneratedCourse(seed, platformCount, (Model){ 0 }, &platforms, &level) > 0 &&
+                   StartNetServer(server, 0, seed, platformCount);
+    int clientCount = 0;
+    NetAddress serverAddress = { NET_LOOPBACK, started? server->socket.port : 0 };
+    while (started && clientCount < playerCount && StartNetClient(&clients[clientCount], serverAddress))
+        clientCount++;
+    if (!started || clientCount < playerCount)
+    {
+        for (int i = 0; i < clientCount; i++)
+            StopNetClient(&clients[i]);
+        if (started) StopNetServer(server);
+        GameHeapFree(server);
+        GameHeapFree(clients);
+        UnloadGeneratedCourse(platforms, &level);
+        CloseNetwork();
+        return 1;
+    }
+
+    SetNetConditions(&server->socket, latencyTicks, lossRate, (unsigned int)seed);
+    for (int i = 0; i < clientCount; i++)
+        SetNetConditions(&clients[i].socket, latencyTicks, lossRate, (unsigned int)seed + i + 1);
+
+    // players join a quarter second apart, so the server sees the field grow
+    double serverSeconds = 0.0;
+    struct timespec start, end, tickStart, tickEnd;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int tick = 0; tick < tickCount; tick++)
+    {
+        for (int i = 0; i < clientCount; i++)
+        {
+            if (tick < i*SIM_TICK_RATE/4) continue;
+            ReceiveNetClient(&clients[i], &level);
+            if (clients[i].accepted)
+                StepNetClient(&clients[i], &level, GetSimBotInput(&clients[i].session, &level));
+        }
+        clock_gettime(CLOCK_MONOTONIC, &tickStart);
+        UpdateNetServer(server, &level);
+        clock_gettime(CLOCK_MONOTONIC, &tickEnd);
+        serverSeconds += (double)(tickEnd.tv_sec - tickStart.tv_sec) + (double)(tickEnd.tv_nsec - tickStart.tv_nsec)*1e-9;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec)*1e-9;
+
+    TraceLog(LOG_INFO, "NETBENCH: %i players for %i ticks, %i ticks latency, %.0f%% loss, seed %llu",
+             clientCount, tickCount, latencyTicks, lossRate*100.0f, seed);
+    double reconcileSeconds = 0.0;
+    unsigned int reconcileTicks = 0;
+    for (int i = 0; i < clientCount; i++)
+    {
+        const NetClient *client = &clients[i];
+        const NetClientStats *stats = &client->stats;
+        if (!client->accepted)
+        {
+            TraceLog(LOG_WARNING, "NETBENCH: Player %i never joined", i);
+            continue;
+        }
+
+        // rates over the time the player was in, at the simulated tick rate
+        const NetServerStats *serverStats = &server->clients[client->id].stats;
+        float playedSeconds = (client->inputSequence > 0)? (float)client->inputSequence/SIM_TICK_RATE : 1.0f;
+        unsigned int snapshots = (serverStats->snapshots > 0)? serverStats->snapshots : 1;
+        TraceLog(LOG_INFO, "NETBENCH: Player %i up %.0f B/s, down %.0f B/s, %.1f B and %.2f remotes per snapshot, %u inputs lost",
+                 client->id, serverStats->bytesUp/playedSeconds, serverStats->bytesDown/playedSeconds,
+                 (float)serverStats->bytesDown/snapshots, (float)serverStats->remotesSent/snapshots, serverStats->inputsFilled);
+        TraceLog(LOG_INFO, "NETBENCH: Player %i reconciled %u snapshots, %u corrections, %u ticks resimulated, %.2f us per tick, %.2f us worst",
+                 client->id, stats->snapshots, stats->corrections, stats->resimulatedTicks,
+                 stats->reconcileSeconds*1e6/(playedSeconds*SIM_TICK_RATE), stats->maxReconcileSeconds*1e6);
+        reconcileSeconds += stats->reconcileSeconds;
+        reconcileTicks += client->inputSequence;
+    }
+    TraceLog(LOG_INFO, "NETBENCH: Server %.2f us per tick, reconciliation %.2f us per client tick, %.0f ticks per second overall",
+             serverSeconds*1e6/tickCount, (reconcileTicks > 0)? reconcileSeconds*1e6/reconcileTicks : 0.0, (seconds > 0.0)? tickCount/seconds : 0.0);
+
+    for (int i = 0; i < clientCount; i++)
+        StopNetClient(&clients[i]);
+    StopNetServer(server);
+    GameHeapFree(server);
+    GameHeapFree(clients);
+    UnloadGeneratedCourse(platforms, &level);
+    CloseNetwork();
+    return 0;
+}
+
+static void PublishRenderStats(const RenderQueue *queue)
+{
+    const RenderStats *stats = &queue->stats;
+
+    SetProfileValue(PROFILE_VALUE_SKY_LAST, (queue->skyboxMode == SKYBOX_DRAW_LAST)? 1.0f : 0.0f);
+    SetProfileValue(PROFILE_VALUE_DRAW_CALLS, (float)stats->drawCalls);
+    SetProfileValue(PROFILE_VALUE_SHADER_BINDS, (float)stats->shaderBinds);
+    SetProfileValue(PROFILE_VALUE_TEXTURE_BINDS, (float)stats->textureBinds);
+    SetProfileValue(PROFILE_VALUE_BINDS_SAVED, (float)(stats->naiveShaderBinds + stats->naiveTextureBinds - stats->shaderBinds - stats->textureBinds));
+    SetProfileValue(PROFILE_VALUE_PREPASS_DRAWS, (float)stats->prepassDrawCalls);
 }
 
 void DrawTextCodepoint3D(Font font, int codepoint, Vector3 position, float fontSize, bool backface, Color tint)
@@ -1051,21 +2071,46 @@ static TextureCubemap GenTextureCubemap(Shader shader, Texture2D panorama, int s
     return cubemap;
 }
 
-static float GetSpeedForAxis(FPCamera *camera, CameraControls axis, float speed)
+static SimInput ReadSimInput(const FPCamera *camera, unsigned char pressed)
 {
-    if (camera == NULL)
-        return 0;
-
-    int key = camera->ControlsKeys[axis];
-    if (key == -1)
-        return 0;
+    // the camera's key bindings, presses are collected by the caller since the last tick
+    SimInput input = {pressed, camera->ViewAngles};
+    if (IsKeyDown(camera->ControlsKeys[MOVE_FRONT])) input.buttons |= SIM_BUTTON_FORWARD;
+    if (IsKeyDown(camera->ControlsKeys[MOVE_BACK])) input.buttons |= SIM_BUTTON_BACK;
+    if (IsKeyDown(camera->ControlsKeys[MOVE_RIGHT])) input.buttons |= SIM_BUTTON_RIGHT;
+    if (IsKeyDown(camera->ControlsKeys[MOVE_LEFT])) input.buttons |= SIM_BUTTON_LEFT;
+    if (IsKeyDown(camera->ControlsKeys[SPRINT])) input.buttons |= SIM_BUTTON_SPRINT;
+    if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) input.buttons |= SIM_BUTTON_GRAPPLE;
+
+    return input;
+}
 
-    float factor = 1.0f;
-    if (IsKeyDown(camera->ControlsKeys[SPRINT]))
-        factor = 2;
+// Playing's press keys that are down right now, compared around the late input poll
+static unsigned char ReadLatePresses(void)
+{
+    unsigned char held = 0;
+    if (IsKeyDown(KEY_SPACE)) held |= LATE_PRESS_JUMP;
+    if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) held |= LATE_PRESS_FIRE;
+    if (IsKeyDown(KEY_ESCAPE)) held |= LATE_PRESS_ESCAPE;
+    if (IsKeyDown(KEY_R)) held |= LATE_PRESS_RETRY;
+    return held;
+}
 
-    if (IsKeyDown(camera->ControlsKeys[axis]))
-        return speed * GetFrameTime() * factor;
+// unlike GetKeyPressed this takes nothing out of raylib's key queue
+static bool IsAnyKeyDown(void)
+{
+    for (int key = KEY_SPACE; key <= KEY_KB_MENU; key++)
+    {
+        if (IsKeyDown(key))
+            return true;
+    }
+    return false;
+}
 
-    return 0.0f;
-}
\ No newline at end of file
+static Matrix GetGhostTransform(const GhostFrame *frame)
+{
+    // the session's position is a unit above the feet, the model stands on its origin and
+    // faces +z like the view at yaw 0
+    Matrix placed = MatrixMultiply(MatrixScale(0.5f, 0.5f, 0.5f), MatrixRotateY(frame->viewAngles.x));
+    return MatrixMultiply(placed, MatrixTranslate(frame->position.x, frame->position.y - 1.0f, frame->position.z));
+}
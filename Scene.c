@@ -0,0 +1,121 @@
+/**********************************************************************************************
+*
+*   RockyRoad * Scene * The game's screens as scenes with enter, update and exit hooks
+*
+**********************************************************************************************/
+
+#include "Scene.h"
+
+#include "raylib.h"
+
+static bool IsSceneValid(const SceneManager* manager, int scene)
+{
+    return scene >= 0 && scene < manager->sceneCount;
+}
+
+static void PreloadScene(SceneManager* manager, int scene)
+{
+    if (manager->preloaded[scene])
+        return;
+
+    double start = GetTime();
+    if (manager->scenes[scene].preload != NULL)
+        manager->scenes[scene].preload(manager->game);
+    manager->preloaded[scene] = true;
+    TraceLog(LOG_INFO, "SCENE: Preloaded %s in %.1f ms", manager->scenes[scene].name, (GetTime() - start)*1000.0);
+}
+
+void InitSceneManager(SceneManager* manager, const Scene* scenes, int sceneCount, void* game)
+{
+    *manager = (SceneManager){ 0 };
+    manager->scenes = scenes;
+    manager->sceneCount = (sceneCount < SCENE_MAX)? sceneCount : SCENE_MAX;
+    manager->game = game;
+    manager->current = SCENE_NONE;
+    manager->next = SCENE_NONE;
+}
+
+void CloseSceneManager(SceneManager* manager)
+{
+    if (manager->current != SCENE_NONE && manager->scenes[manager->current].exit != NULL)
+        manager->scenes[manager->current].exit(manager->game);
+    manager->current = SCENE_NONE;
+    manager->next = SCENE_NONE;
+    manager->queueCount = 0;
+
+    for (int i = manager->sceneCount - 1; i >= 0; i--)
+    {
+        if (manager->preloaded[i] && manager->scenes[i].unload != NULL)
+            manager->scenes[i].unload(manager->game);
+        manager->preloaded[i] = false;
+    }
+}
+
+void ChangeScene(SceneManager* manager, int scene)
+{
+    if (IsSceneValid(manager, scene))
+        manager->next = scene;
+}
+
+void QueueScenePreload(SceneManager* manager, int scene)
+{
+    if (!IsSceneValid(manager, scene) || manager->preloaded[scene])
+        return;
+    for (int i = 0; i < manager->queueCount; i++)
+    {
+        if (manager->queue[i] == scene)
+            return;
+    }
+    manager->queue[manager->queueCount++] = scene;
+}
+
+int GetCurrentScene(const SceneManager* manager)
+{
+    return manager->current;
+}
+
+void BeginSceneFrame(SceneManager* manager)
+{
+    if (manager->next == SCENE_NONE)
+        return;
+
+    int scene = manager->next;
+    manager->next = SCENE_NONE;
+    if (manager->current != SCENE_NONE && manager->scenes[manager->current].exit != NULL)
+        manager->scenes[manager->current].exit(manager->game);
+
+    PreloadScene(manager, scene);
+    TraceLog(LOG_INFO, "SCENE: Entered %s", manager->scenes[scene].name);
+    manager->current = scene;
+    if (manager->scenes[scene].enter != NULL)
+        manager->scenes[scene].enter(manager->game);
+}
+
+void UpdateScene(SceneManager* manager, float dt)
+{
+    if (manager->current != SCENE_NONE && manager->scenes[manager->current].update != NULL)
+        manager->scenes[manager->current].update(manager->game, dt);
+}
+
+void DrawScene(SceneManager* manager)
+{
+    if (manager->current != SCENE_NONE && manager->scenes[manager->current].draw != NULL)
+        manager->scenes[manager->current].draw(manager->game);
+}
+
+void EndSceneFrame(SceneManager* manager)
+{
+    // scenes entered in the meantime have been loaded already, skip them
+    while (manager->queueCount > 0)
+    {
+        int scene = manager->queue[0];
+        manager->queueCount--;
+        for (int i = 0; i < manager->queueCount; i++)
+            manager->queue[i] = manager->queue[i + 1];
+        if (!manager->preloaded[scene])
+        {
+            PreloadScene(manager, scene);
+            break;
+        }
+    }
+}
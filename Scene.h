@@ -0,0 +1,75 @@
+/**********************************************************************************************
+*
+*   RockyRoad * Scene * The game's screens as scenes with enter, update and exit hooks
+*
+*   Every screen is a scene: a set of hooks on one shared game pointer, any of which may be
+*   NULL. A scene's preload hook loads what only it uses and runs once, either before the
+*   scene is first entered or earlier, when another scene queues it. Queued preloads run one
+*   per frame after the picture is handed off, so a scene can get the next one's assets and
+*   texture requests going while it is still on screen. Scenes that were preloaded are
+*   unloaded when the manager closes.
+*
+*   Changes are only asked for during a frame and applied when the next one begins, so a
+*   frame always updates and draws the same scene and exit always runs before enter.
+*
+**********************************************************************************************/
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <stdbool.h>
+
+#define SCENE_MAX 8
+#define SCENE_NONE -1
+
+typedef void (*SceneHook)(void* game);
+typedef void (*SceneUpdateHook)(void* game, float dt);
+
+typedef struct
+{
+    const char* name;
+    SceneHook preload;
+    SceneHook enter;
+    SceneUpdateHook update;         // before BeginDrawing
+    SceneHook draw;                 // between BeginDrawing and EndDrawing
+    SceneHook exit;
+    SceneHook unload;
+}Scene;
+
+typedef struct
+{
+    const Scene* scenes;
+    int sceneCount;
+    void* game;
+
+    int current;
+    int next;
+    bool preloaded[SCENE_MAX];
+    int queue[SCENE_MAX];           // preloads waiting for the end of a frame
+    int queueCount;
+}SceneManager;
+
+// nothing is entered until the first ChangeScene and BeginSceneFrame
+void InitSceneManager(SceneManager* manager, const Scene* scenes, int sceneCount, void* game);
+
+// exit the current scene and unload every preloaded one, the last preloaded first
+void CloseSceneManager(SceneManager* manager);
+
+// switch scenes when the next frame begins
+void ChangeScene(SceneManager* manager, int scene);
+
+// preload a scene at the end of some coming frame, if it is not loaded by then
+void QueueScenePreload(SceneManager* manager, int scene);
+
+int GetCurrentScene(const SceneManager* manager);
+
+// apply the change asked for last frame, preloading the new scene first if it was not yet
+void BeginSceneFrame(SceneManager* manager);
+
+void UpdateScene(SceneManager* manager, float dt);
+void DrawScene(SceneManager* manager);
+
+// run one queued preload, after EndDrawing
+void EndSceneFrame(SceneManager* manager);
+
+#endif //SCENE_H
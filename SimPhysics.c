@@ -0,0 +1,71 @@
+/**********************************************************************************************
+*
+*   RockyRoad * SimPhysics * Headless mirror of the player's physac motion
+*
+**********************************************************************************************/
+
+#include "SimPhysics.h"
+
+#define SIM_HALF_SIZE 0.5f                  // both the player and the ground box are 1 unit tall
+
+static void IntegrateSimForces(SimBody* body)
+{
+    // physac applies forces and gravity in two half steps around the velocity integration
+    body->velocityY += (body->force/SIM_PLAYER_DENSITY)*(SIM_STEP_MS/2.0f);
+    body->velocityY += SIM_GRAVITY*(SIM_STEP_MS/1000.0f/2.0f);
+}
+
+void SimAddForce(SimBody* body, float force)
+{
+    body->force += force;
+}
+
+void StepSimBody(SimBody* body, float groundTop)
+{
+    body->grounded = false;
+
+    IntegrateSimForces(body);
+
+    // contact with the ground box: stop a body that overlaps it and is not moving away
+    float bottom = body->y + SIM_HALF_SIZE;
+    float top = body->y - SIM_HALF_SIZE;
+    bool touching = groundTop != SIM_NO_GROUND && bottom >= groundTop && top < groundTop + 2.0f*SIM_HALF_SIZE;
+    if (touching && body->velocityY >= 0.0f)
+    {
+        body->velocityY = 0.0f;
+        body->grounded = true;
+    }
+
+    body->y += body->velocityY*SIM_STEP_MS;
+    IntegrateSimForces(body);
+
+    // physac eases penetration out over a few steps, resting on the surface is where it ends up
+    if (body->grounded)
+    {
+        body->y = groundTop - SIM_HALF_SIZE;
+        body->velocityY = 0.0f;
+    }
+
+    body->force = 0.0f;
+}
+
+void LandSimBody(SimBody* body, float groundTop)
+{
+    body->y = groundTop - SIM_HALF_SIZE;
+    body->velocityY = 0.0f;
+    body->force = 0.0f;
+    body->grounded = true;
+}
+
+float GetSimGroundTop(float platformY)
+{
+    // the game moves the ground box centre to the top face of the platform it probed, which it
+    // has always kept as a whole number
+    float surface = (float)(int)(platformY + SIM_HALF_SIZE);
+    return -surface - SIM_HALF_SIZE;
+}
+
+float GetSimCameraY(const SimBody* body)
+{
+    return -body->y;
+}
@@ -0,0 +1,55 @@
+/**********************************************************************************************
+*
+*   RockyRoad * SimPhysics * Headless mirror of the player's physac motion
+*
+*   Only the vertical axis of the player is simulated as a body: a 1x1 box with gravity, jump
+*   impulses and the grapple pull, standing on a ground box that is moved under whichever
+*   platform the player is over. The game used to run it through physac; this module repeats
+*   physac's fixed step for that one body with all of its state in a SimBody, so any number of
+*   simulations can run at once on any thread without physac's globals. SimSession builds the
+*   rest of the gameplay on top of it.
+*
+*   Units are physac's: y grows downwards, time is in milliseconds and velocity in units per
+*   millisecond, with the same constants the game was tuned with under physac.
+*
+**********************************************************************************************/
+
+#ifndef SIM_PHYSICS_H
+#define SIM_PHYSICS_H
+
+#include <stdbool.h>
+
+#define SIM_STEP_MS (1000.0f/600.0f)        // physac's fixed step
+#define SIM_STEPS_PER_FRAME 10              // at the 60 fps the game was tuned for
+#define SIM_FRAME_TIME (1.0f/60.0f)
+#define SIM_GRAVITY 0.1f
+#define SIM_PLAYER_DENSITY 10.0f            // the player box is 1x1, so this is also its mass
+#define SIM_JUMP_FORCE -0.25f
+#define SIM_GRAPPLE_PULL 0.01f              // vertical force per radian of the grapple angle
+#define SIM_NO_GROUND 1e9f
+
+typedef struct
+{
+    float y;                        // centre of the 1x1 box
+    float velocityY;
+    float force;                    // cleared after every step, like physac
+    bool grounded;
+}SimBody;
+
+// queue a vertical force for the next step, negative is up
+void SimAddForce(SimBody* body, float force);
+
+// one physac step against a ground box whose top is at groundTop, SIM_NO_GROUND for none
+void StepSimBody(SimBody* body, float groundTop);
+
+// put the body at rest on a ground box whose top is at groundTop, for contacts found outside
+// of the steps
+void LandSimBody(SimBody* body, float groundTop);
+
+// ground box top under a platform centred at platformY in world space (y up)
+float GetSimGroundTop(float platformY);
+
+// world height of the camera for a body, which is how the game reads the player back
+float GetSimCameraY(const SimBody* body);
+
+#endif //SIM_PHYSICS_H
@@ -0,0 +1,564 @@
+/**********************************************************************************************
+*
+*   RockyRoad * SimSession * Re-entrant gameplay simulation at a fixed tick
+*
+**********************************************************************************************/
+
+#include "SimSession.h"
+#include "JobSystem.h"
+#include "raymath.h"
+
+#include <math.h>
+#include <string.h>
+
+#define PLATFORM_HALF_SIZE 5.0f             // platforms are 10 x 1 x 10
+#define PROBE_HEIGHT 100.0f                 // the ground ray starts this far above the player
+#define LANDING_HEIGHT 1.0f                 // the body centre rests this far above a platform's centre
+#define PLAYER_HALF_SIZE 0.5f               // the body is SimPhysics' 1x1x1 box
+#define PLATFORM_REACH (Vector3){PLATFORM_HALF_SIZE + PLAYER_HALF_SIZE, LANDING_HEIGHT, PLATFORM_HALF_SIZE + PLAYER_HALF_SIZE}
+#define STEP_HEIGHT 1.0f                    // sides this close to the top are stepped onto, covers GetSimGroundTop's rounding
+#define SIDE_SKIN 0.001f                    // a blocked body is kept this far outside the side
+#define MAX_SWEEP_HITS 4                    // sides slid along in one tick before the rest of the move is dropped
+#define GRAPPLE_BOX (Vector3){PLATFORM_HALF_SIZE, 50.0f, PLATFORM_HALF_SIZE}   // what a grapple shot can hit
+#define GRAPPLE_GUN_OFFSET (Vector3){-1.0f, 0.0f, 2.0f}
+#define SLIDE_PUSH (1.0f/75.0f)             // walking on a wobbling platform pushes this much of the step
+#define BOT_TAKEOFF_MARGIN 1.0f             // bots jump this far before the edge at the latest
+#define BOT_LANDING_RADIUS 0.5f             // bots stop steering once over the target's centre
+
+typedef struct
+{
+    SimSession* sessions;
+    SimInput* inputs;
+    const SimLevel* level;
+}SessionBatch;
+
+static Vector3 GetPlatformPosition(const SimSession* session, const SimLevel* level, int index)
+{
+    Matrix transform = GetSimPlatformTransform(session, level, index);
+    return (Vector3){transform.m12, transform.m13, transform.m14};
+}
+
+// FPCamera's flat forward vector, the grapple and the walk directions follow it
+static Vector3 GetForward(Vector2 viewAngles)
+{
+    return Vector3Transform((Vector3){0, 0, 1}, MatrixRotateXYZ((Vector3){0, -viewAngles.x, 0}));
+}
+
+// the level's positions hold up to the next platform that is skipped or wobbles, the wobbling
+// one stands where its own transform puts it and is tested alone
+static int GetPlainRangeEnd(const SimSession* session, const SimLevel* level, int start, int skip)
+{
+    int end = level->platformCount;
+    if (skip >= start && skip < end) end = skip;
+    if (session->wobbleIndex >= start && session->wobbleIndex < end) end = session->wobbleIndex;
+    return end;
+}
+
+// the first platform whose top a ray cast straight down from above the player hits
+static int ProbeGround(const SimSession* session, const SimLevel* level, float* platformY)
+{
+    Vector3 column = {session->position.x, session->position.y + PROBE_HEIGHT, session->position.z};
+    for (int start = 0; start < level->platformCount;)
+    {
+        int end = GetPlainRangeEnd(session, level, start, -1);
+        int hit = FindFirstPointBelow(&level->centers, start, end, column, PLATFORM_HALF_SIZE, 0.5f);
+        if (hit < 0 && end == session->wobbleIndex)
+        {
+            Vector3 wobbling = GetPlatformPosition(session, level, end);
+            SimdPoints single = {&wobbling.x, &wobbling.y, &wobbling.z, 1};
+            if (FindFirstPointBelow(&single, 0, 1, column, PLATFORM_HALF_SIZE, 0.5f) == 0) hit = end;
+        }
+        if (hit >= 0)
+        {
+            *platformY = GetPlatformPosition(session, level, hit).y;
+            return hit;
+        }
+        start = end + 1;
+    }
+    return -1;
+}
+
+// 60 fps frames one tick covers
+static int GetTickFrames(const SimLevel* level)
+{
+    return (level->tickRate > 0)? SIM_TICK_RATE/level->tickRate : 1;
+}
+
+static float GetAxisSpeed(const SimLevel* level, SimInput input, SimButton button)
+{
+    if (!(input.buttons & button))
+        return 0.0f;
+
+    float factor = (input.buttons & SIM_BUTTON_SPRINT)? SIM_SPRINT_FACTOR : 1.0f;
+    return SIM_MOVE_SPEED*GetSimTickTime(level)*factor;
+}
+
+static void WobbleGround(SimSession* session, const SimLevel* level, SimInput input)
+{
+    if (session->wobbleIndex != session->groundIndex)
+    {
+        session->wobbleIndex = session->groundIndex;
+        session->wobbleTransform = level->platforms[session->groundIndex].transform;
+    }
+    float frames = (float)GetTickFrames(level);
+    session->wobbleTransform = MatrixMultiply(session->wobbleTransform, MatrixTranslate(sinf(session->unstableTimer)/100.0f*frames, 0, 0));
+    session->wobbleTransform = MatrixMultiply(session->wobbleTransform, MatrixRotateX(sinf(session->unstableTimer*2.0f)/100.0f*frames));
+    session->slideOrient -= sinf(session->unstableTimer*2.0f)/100.0f*frames;
+
+    // every key pushes along the slide, sideways walking itself is locked while it wobbles
+    Vector3 forward = GetForward(input.viewAngles);
+    Vector3 right = {-forward.z, 0, forward.x};
+    float front = GetAxisSpeed(level, input, SIM_BUTTON_FORWARD) - GetAxisSpeed(level, input, SIM_BUTTON_BACK);
+    float side = GetAxisSpeed(level, input, SIM_BUTTON_RIGHT) - GetAxisSpeed(level, input, SIM_BUTTON_LEFT);
+    session->slideVelocity += (forward.z*front + right.z*side)*SLIDE_PUSH;
+}
+
+static void SettleGround(SimSession* session)
+{
+    // the platform keeps where it drifted to but stands level again
+    session->wobbleTransform = MatrixTranslate(session->wobbleTransform.m12, session->wobbleTransform.m13, session->wobbleTransform.m14);
+    session->slideX = 0.0f;
+    session->slideVelocity = 0.0f;
+    session->slideOrient = 0.0f;
+}
+
+static bool IsTouchingGoal(const SimSession* session, const SimLevel* level)
+{
+    Vector3 p = session->position;
+    Vector3 g = level->goal;
+    return fabsf(p.x - g.x) <= 5.0f && fabsf(p.z - g.z) <= 5.0f && p.y - 1.0f <= g.y + 0.5f && p.y + 1.0f >= g.y - 2.5f;
+}
+
+static void MoveSession(SimSession* session, const SimLevel* level, SimInput input, bool sliding)
+{
+    Vector3 forward = GetForward(session->viewAngles);
+    Vector3 right = {-forward.z, 0, forward.x};
+    float front = GetAxisSpeed(level, input, SIM_BUTTON_FORWARD) - GetAxisSpeed(level, input, SIM_BUTTON_BACK);
+    float side = sliding? 0.0f : GetAxisSpeed(level, input, SIM_BUTTON_RIGHT) - GetAxisSpeed(level, input, SIM_BUTTON_LEFT);
+    session->position = Vector3Add(session->position, Vector3Scale(forward, front));
+    session->position = Vector3Add(session->position, Vector3Scale(right, side));
+}
+
+static void StepSessionPhysics(SimSession* session, const SimLevel* level, float groundTop, bool sliding)
+{
+    // the grapple pulled once per frame when the game stepped physac every frame
+    for (int i = 0; i < SIM_STEPS_PER_FRAME*GetTickFrames(level); i++)
+    {
+        if (session->grappling && i%SIM_STEPS_PER_FRAME == 0)
+            SimAddForce(&session->body, -session->grapplePull.y*SIM_GRAPPLE_PULL);
+        StepSimBody(&session->body, groundTop);
+        if (sliding)
+        {
+            // physac's tilted ground box is approximated by the downhill pull of gravity
+            session->slideVelocity += SIM_GRAVITY*sinf(session->slideOrient)*(SIM_STEP_MS/1000.0f);
+            session->slideX += session->slideVelocity*SIM_STEP_MS;
+        }
+    }
+}
+
+// entry point of the horizontal shot on the side of a platform's grapple box it hits
+static Vector3 GetGrappleHit(Vector3 origin, Vector3 direction, Vector3 platform)
+{
+    float tMin = -INFINITY;
+    float tMax = INFINITY;
+    float o[2] = {origin.x - platform.x, origin.z - platform.z};
+    float d[2] = {direction.x, direction.z};
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if (fabsf(d[axis]) < 1e-6f) continue;
+        float t0 = (-PLATFORM_HALF_SIZE - o[axis])/d[axis];
+        float t1 = (PLATFORM_HALF_SIZE - o[axis])/d[axis];
+        tMin = fmaxf(tMin, fminf(t0, t1));
+        tMax = fminf(tMax, fmaxf(t0, t1));
+    }
+
+    // from inside the box the shot lands on the far side
+    float t = (tMin > 0.0f)? tMin : tMax;
+    return Vector3Add(origin, Vector3Scale(direction, t));
+}
+
+// platforms are hit in level order, not nearest first, as the game always did
+static int CastGrapple(const SimSession* session, const SimLevel* level, Ray shot)
+{
+    for (int start = 0; start < level->platformCount;)
+    {
+        int end = GetPlainRangeEnd(session, level, start, session->groundIndex);
+        int hit = FindFirstRayBoxHit(&level->centers, start, end, shot, GRAPPLE_BOX);
+        if (hit >= 0)
+            return hit;
+        if (end == session->wobbleIndex && end != session->groundIndex)
+        {
+            Vector3 wobbling = GetPlatformPosition(session, level, end);
+            SimdPoints single = {&wobbling.x, &wobbling.y, &wobbling.z, 1};
+            if (FindFirstRayBoxHit(&single, 0, 1, shot, GRAPPLE_BOX) == 0)
+                return end;
+        }
+        start = end + 1;
+    }
+    return -1;
+}
+
+// the pull of the frames a tick covers, which stops at the hit instead of passing it on long
+// ticks. a single frame's pull is always short of the hit
+static float GetGrappleStep(float pull, float offset, const SimLevel* level)
+{
+    float step = pull*(float)GetTickFrames(level);
+    return (fabsf(step) > fabsf(offset))? offset : step;
+}
+
+static void UpdateGrapple(SimSession* session, const SimLevel* level, SimInput input)
+{
+    Vector3 origin = GetSimGrappleOrigin(session);
+
+    if (level->grappleUnlocked && (input.buttons & SIM_BUTTON_FIRE))
+    {
+        // the shot flies flat, so the grapple box's height is only a reach check
+        Ray shot = {origin, GetForward(session->viewAngles)};
+        shot.direction.y = 0.0f;
+        int target = CastGrapple(session, level, shot);
+        session->grappleEnabled = target >= 0;
+        if (target >= 0)
+        {
+            Vector3 platform = GetPlatformPosition(session, level, target);
+            Vector3 hit = GetGrappleHit(shot.position, shot.direction, platform);
+            hit.y = fminf(fmaxf(hit.y, platform.y - 0.5f), platform.y + 0.5f);
+            session->grappleHit = hit;
+            session->events |= SIM_EVENT_GRAPPLE;
+        }
+    }
+
+    if ((input.buttons & SIM_BUTTON_GRAPPLE) && level->grappleUnlocked && session->grappleEnabled)
+    {
+        Vector3 offset = Vector3Subtract(session->grappleHit, origin);
+        session->grapplePull = (Vector3){atanf(offset.x), atanf(offset.y), atanf(offset.z)};
+        session->grappling = session->grapplePull.x != 0.0f || session->grapplePull.y != 0.0f || session->grapplePull.z != 0.0f;
+        session->position.x += GetGrappleStep(session->grapplePull.x, offset.x, level);
+        session->position.z += GetGrappleStep(session->grapplePull.z, offset.z, level);
+    }
+    else
+    {
+        session->grapplePull = Vector3Zero();
+        session->grappleEnabled = false;
+        session->grappling = false;
+    }
+}
+
+// the earliest platform other than the probed ground the body runs into along the move from from
+static int SweepLanding(const SimSession* session, const SimLevel* level, Vector3 from, float* time, SweptFace* face)
+{
+    int best = -1;
+    *time = INFINITY;
+    for (int start = 0; start < level->platformCount;)
+    {
+        int end = GetPlainRangeEnd(session, level, start, session->groundIndex);
+        float t;
+        SweptFace f;
+        int hit = FindFirstSweptLanding(&level->centers, start, end, from, session->position, PLATFORM_REACH, STEP_HEIGHT, &t, &f);
+        if (hit >= 0 && t < *time)
+        {
+            best = hit;
+            *time = t;
+            *face = f;
+        }
+        if (end == session->wobbleIndex && end != session->groundIndex)
+        {
+            Vector3 wobbling = GetPlatformPosition(session, level, end);
+            SimdPoints single = {&wobbling.x, &wobbling.y, &wobbling.z, 1};
+            if (FindFirstSweptLanding(&single, 0, 1, from, session->position, PLATFORM_REACH, STEP_HEIGHT, &t, &f) == 0 && t < *time)
+            {
+                best = end;
+                *time = t;
+                *face = f;
+            }
+        }
+        start = end + 1;
+    }
+    return best;
+}
+
+// the player's body swept from where the tick started to where it ended against the platform
+// boxes. a side stops the move across it and the rest of the move slides along it. the first
+// top the body comes down on is landed on, and the rest of the move carries on along the top
+// as long as it stays over the platform
+static void CatchLanding(SimSession* session, const SimLevel* level, Vector3 from)
+{
+    for (int sweep = 0; sweep < MAX_SWEEP_HITS; sweep++)
+    {
+        float time;
+        SweptFace face = SWEPT_FACE_TOP;
+        int hit = SweepLanding(session, level, from, &time, &face);
+        if (hit < 0)
+            return;
+
+        Vector3 platform = GetPlatformPosition(session, level, hit);
+        Vector3 contact = Vector3Lerp(from, session->position, time);
+        if (face == SWEPT_FACE_TOP)
+        {
+            if (fabsf(session->position.x - platform.x) > PLATFORM_HALF_SIZE || fabsf(session->position.z - platform.z) > PLATFORM_HALF_SIZE)
+            {
+                session->position.x = contact.x;
+                session->position.z = contact.z;
+            }
+            LandSimBody(&session->body, GetSimGroundTop(platform.y));
+            session->position.y = GetSimCameraY(&session->body);
+            session->groundIndex = hit;
+            return;
+        }
+
+        // the next sweep starts from the contact, just clear of the side
+        float reach = PLATFORM_HALF_SIZE + PLAYER_HALF_SIZE + SIDE_SKIN;
+        if (face == SWEPT_FACE_X)
+        {
+            session->position.x = (from.x < platform.x)? platform.x - reach : platform.x + reach;
+            contact.x = session->position.x;
+        }
+        else
+        {
+            session->position.z = (from.z < platform.z)? platform.z - reach : platform.z + reach;
+            contact.z = session->position.z;
+        }
+        from = contact;
+    }
+
+    // still running into sides, stay where the last one stopped the body
+    session->position.x = from.x;
+    session->position.z = from.z;
+}
+
+bool IsSimTickRateValid(int tickRate)
+{
+    return tickRate >= SIM_MIN_TICK_RATE && tickRate <= SIM_TICK_RATE && SIM_TICK_RATE%tickRate == 0;
+}
+
+float GetSimTickTime(const SimLevel* level)
+{
+    return SIM_TICK_TIME*(float)GetTickFrames(level);
+}
+
+void InitSimSession(SimSession* session)
+{
+    memset(session, 0, sizeof(SimSession));
+    session->state = SIM_SESSION_PLAYING;
+    session->groundIndex = -1;
+    session->lastGroundIndex = -1;
+    session->wobbleIndex = -1;
+    session->wobbleTransform = MatrixIdentity();
+}
+
+void StepSimSession(SimSession* session, const SimLevel* level, SimInput input)
+{
+    session->events = 0;
+    if (session->state != SIM_SESSION_PLAYING)
+        return;
+
+    if (session->position.y < SIM_DEATH_HEIGHT)
+    {
+        session->state = SIM_SESSION_DEAD;
+        session->events |= SIM_EVENT_DIED;
+        return;
+    }
+
+    float platformY = 0.0f;
+    session->groundIndex = ProbeGround(session, level, &platformY);
+    float groundTop = (session->groundIndex >= 0)? GetSimGroundTop(platformY) : SIM_NO_GROUND;
+
+    if ((input.buttons & SIM_BUTTON_JUMP) && session->body.grounded)
+    {
+        SimAddForce(&session->body, SIM_JUMP_FORCE);
+        session->events |= SIM_EVENT_JUMP;
+    }
+
+    if (session->unstableTimer >= SIM_WOBBLE_DELAY && session->groundIndex >= 0)
+        WobbleGround(session, level, input);
+
+    if (level->hasGoal && IsTouchingGoal(session, level))
+    {
+        session->state = SIM_SESSION_FINISHED;
+        session->events |= SIM_EVENT_GOAL;
+        return;
+    }
+
+    if (!session->body.grounded)
+    {
+        if (session->unstableTimer >= SIM_WOBBLE_DELAY)
+            SettleGround(session);
+        session->unstableTimer = 0.0f;
+    }
+    else if (session->lastGroundIndex == session->groundIndex)
+    {
+        session->unstableTimer += GetSimTickTime(level);
+    }
+
+    bool sliding = session->unstableTimer >= SIM_WOBBLE_DELAY;
+    Vector3 from = session->position;
+    session->viewAngles = input.viewAngles;
+    MoveSession(session, level, input, sliding);
+
+    float lastSlideX = session->slideX;
+    StepSessionPhysics(session, level, groundTop, sliding);
+    if (!sliding)
+    {
+        session->slideX = 0.0f;
+        session->slideVelocity = 0.0f;
+        session->slideOrient = 0.0f;
+    }
+    session->position.y = GetSimCameraY(&session->body);
+    session->position.z += session->slideX - lastSlideX;
+
+    UpdateGrapple(session, level, input);
+    CatchLanding(session, level, from);
+
+    session->lastGroundIndex = session->groundIndex;
+    session->tick++;
+}
+
+static int ShiftPlatformIndex(int index, int shift)
+{
+    if (index < 0)
+        return -1;
+
+    index += shift;
+    return (index < 0)? -1 : index;
+}
+
+static void StepSessionRange(void* data, int start, int end)
+{
+    SessionBatch* batch = (SessionBatch*)data;
+
+    for (int i = start; i < end; i++)
+        StepSimSession(&batch->sessions[i], batch->level, batch->inputs[i]);
+}
+
+bool VerifySimReplay(const SimSession* start, const SimInput* inputs, int count, const SimLevel* level, const SimSession* end)
+{
+    SimSession replay;
+    memcpy(&replay, start, sizeof(SimSession));
+    for (int i = 0; i < count; i++)
+        StepSimSession(&replay, level, inputs[i]);
+
+    return memcmp(&replay, end, sizeof(SimSession)) == 0;
+}
+
+static void BotInputRange(void* data, int start, int end)
+{
+    SessionBatch* batch = (SessionBatch*)data;
+
+    for (int i = start; i < end; i++)
+        batch->inputs[i] = GetSimBotInput(&batch->sessions[i], batch->level);
+}
+
+// sessions cost about the same, so one even batch per core beats finer stealing
+static int GetSessionBatchSize(int count)
+{
+    int threads = GetJobWorkerCount() + 1;
+    return (count + threads - 1)/threads;
+}
+
+void StepSimSessions(SimSession* sessions, const SimInput* inputs, int count, const SimLevel* level)
+{
+    // the batch only reads the inputs
+    SessionBatch batch = { sessions, (SimInput*)inputs, level };
+    ParallelFor(count, GetSessionBatchSize(count), StepSessionRange, &batch);
+}
+
+void GetSimBotInputs(const SimSession* sessions, SimInput* inputs, int count, const SimLevel* level)
+{
+    SessionBatch batch = { (SimSession*)sessions, inputs, level };
+    ParallelFor(count, GetSessionBatchSize(count), BotInputRange, &batch);
+}
+
+void ShiftSimSessionPlatforms(SimSession* session, int shift)
+{
+    if (shift == 0)
+        return;
+
+    session->groundIndex = ShiftPlatformIndex(session->groundIndex, shift);
+    session->lastGroundIndex = ShiftPlatformIndex(session->lastGroundIndex, shift);
+    session->wobbleIndex = ShiftPlatformIndex(session->wobbleIndex, shift);
+
+    // the platform left the window, its drift goes with it
+    if (session->wobbleIndex < 0)
+        session->wobbleTransform = MatrixIdentity();
+}
+
+Matrix GetSimPlatformTransform(const SimSession* session, const SimLevel* level, int index)
+{
+    return (index == session->wobbleIndex)? session->wobbleTransform : level->platforms[index].transform;
+}
+
+Vector3 GetSimGrappleOrigin(const SimSession* session)
+{
+    Vector3 offset = Vector3Transform(GRAPPLE_GUN_OFFSET, MatrixRotateXYZ((Vector3){0, -session->viewAngles.x, 0}));
+    return Vector3Add(session->position, offset);
+}
+
+// how far a sprinting jump from here carries before it drops back to the top of a platform
+static float GetBotJumpReach(const SimSession* session, Vector3 platform)
+{
+    float jumpSpeed = -SIM_JUMP_FORCE/SIM_PLAYER_DENSITY*SIM_STEP_MS*1000.0f;
+    float gravity = SIM_GRAVITY*1000.0f;
+    SimBody landed = { 0 };
+    landed.y = GetSimGroundTop(platform.y) - 0.5f;
+    float rise = GetSimCameraY(&landed) - session->position.y;
+    float discriminant = jumpSpeed*jumpSpeed - 2.0f*gravity*rise;
+    if (discriminant < 0.0f)
+        return 0.0f;
+
+    float airTime = (jumpSpeed + sqrtf(discriminant))/gravity;
+    return SIM_MOVE_SPEED*SIM_SPRINT_FACTOR*airTime;
+}
+
+SimInput GetSimBotInput(const SimSession* session, const SimLevel* level)
+{
+    SimInput input = { SIM_BUTTON_FORWARD | SIM_BUTTON_SPRINT, session->viewAngles };
+
+    // head for the platform after the one underfoot, in the air for the first centre not yet passed
+    int target = level->platformCount;
+    if (session->groundIndex >= 0 && session->body.grounded)
+    {
+        target = session->groundIndex + 1;
+    }
+    else
+    {
+        for (int i = 0; i < level->platformCount && target == level->platformCount; i++)
+        {
+            if (GetPlatformPosition(session, level, i).x >= session->position.x - BOT_LANDING_RADIUS)
+                target = i;
+        }
+    }
+
+    Vector3 goal = (target < level->platformCount)? GetPlatformPosition(session, level, target) : level->goal;
+    float dx = goal.x - session->position.x;
+    float dz = goal.z - session->position.z;
+    if (dx != 0.0f || dz != 0.0f)
+        input.viewAngles.x = atan2f(dx, dz);
+
+    float length = sqrtf(dx*dx + dz*dz);
+    if (!session->body.grounded && length < BOT_LANDING_RADIUS)
+        input.buttons = 0;
+
+    if (session->groundIndex >= 0 && session->body.grounded && target >= level->platformCount)
+    {
+        // the goal sits above the last platform, hop into it
+        if (length < PLATFORM_HALF_SIZE*0.5f)
+            input.buttons |= SIM_BUTTON_JUMP;
+    }
+    else if (session->groundIndex >= 0 && session->body.grounded && length > 0.0f)
+    {
+        // jump once past the takeoff point towards the target
+        Vector3 ground = GetPlatformPosition(session, level, session->groundIndex);
+        float ux = dx/length;
+        float uz = dz/length;
+        float edge = PLATFORM_HALF_SIZE/fmaxf(fabsf(ux), fabsf(uz));
+        float along = (session->position.x - ground.x)*ux + (session->position.z - ground.z)*uz;
+        if (along >= edge - BOT_TAKEOFF_MARGIN || length <= GetBotJumpReach(session, goal))
+            input.buttons |= SIM_BUTTON_JUMP;
+    }
+    else if (session->groundIndex < 0 && level->grappleUnlocked && session->body.velocityY > 0.0f && goal.y + 0.5f > session->position.y)
+    {
+        // falling short of a higher platform, pull up with the grapple
+        input.buttons |= session->grappleEnabled? SIM_BUTTON_GRAPPLE : SIM_BUTTON_FIRE | SIM_BUTTON_GRAPPLE;
+    }
+
+    return input;
+}
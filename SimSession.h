@@ -0,0 +1,160 @@
+/**********************************************************************************************
+*
+*   RockyRoad * SimSession * Re-entrant gameplay simulation at a fixed tick
+*
+*   Everything the Playing state simulates lives in a SimSession: the ground probe, the
+*   SimPhysics body, jumping, the grapple, the wobble of a platform the player stands on for
+*   too long and the fall. A session only reads the level it is given and the input for the
+*   tick, it owns no globals and touches no window, audio or GPU state, so the game runs one
+*   and a headless host can run thousands of them on all cores.
+*
+*   Sessions advance in fixed ticks of the level's tick rate, SIM_TICK_RATE unless a slow
+*   machine asks for fewer. A tick covers whole 60 fps frames, the physics still takes its
+*   steps at physac's rate and the moves tuned per frame are scaled up. The game runs as many
+*   ticks per frame as the frame time covers and reacts to the events a tick reports.
+*
+*   The ground probe only looks under the player at the start of a tick. The path the player
+*   takes during the tick, walking, sliding and pulled by the grapple, is swept as the player's
+*   body against the whole box of every other platform afterwards. Coming down through a top
+*   lands, running into a side stops the move across it and the rest slides along the side,
+*   and a side within a step of the top is left to the ground probe to step onto. So neither
+*   a long tick nor a fast grapple pull can pass through a platform.
+*
+*   The platforms of a level are shared between all sessions playing it; the one platform a
+*   session wobbles is kept in the session as its own transform. The level also carries the
+*   platform positions as SimdPoints, which the ground probe and the grapple test four
+*   platforms at a time.
+*
+**********************************************************************************************/
+
+#ifndef SIM_SESSION_H
+#define SIM_SESSION_H
+
+#include "raylib.h"
+#include "SimPhysics.h"
+#include "SimdMath.h"
+
+#define SIM_TICK_RATE 60                    // what the game was tuned at
+#define SIM_MIN_TICK_RATE 15
+#define SIM_TICK_TIME SIM_FRAME_TIME        // at SIM_TICK_RATE, SimPhysics runs SIM_STEPS_PER_FRAME steps per frame
+#define SIM_MAX_TICKS_PER_FRAME 8           // a long hitch drops time instead of spiralling
+#define SIM_DEATH_HEIGHT -90.0f
+#define SIM_WOBBLE_DELAY 3.0f               // seconds on one platform before it starts to wobble
+#define SIM_MOVE_SPEED 10.0f                // FPCamera move speed, doubled by sprint
+#define SIM_SPRINT_FACTOR 2.0f
+
+// held and pressed buttons of one tick
+typedef enum
+{
+    SIM_BUTTON_FORWARD = 1,
+    SIM_BUTTON_BACK = 2,
+    SIM_BUTTON_RIGHT = 4,
+    SIM_BUTTON_LEFT = 8,
+    SIM_BUTTON_SPRINT = 16,
+    SIM_BUTTON_JUMP = 32,               // pressed this tick
+    SIM_BUTTON_GRAPPLE = 64,            // held
+    SIM_BUTTON_FIRE = 128               // grapple pressed this tick
+}SimButton;
+
+// what happened during a tick, for sounds and state changes outside the simulation
+typedef enum
+{
+    SIM_EVENT_JUMP = 1,
+    SIM_EVENT_GRAPPLE = 2,
+    SIM_EVENT_GOAL = 4,
+    SIM_EVENT_DIED = 8
+}SimEvent;
+
+typedef enum
+{
+    SIM_SESSION_PLAYING = 0,
+    SIM_SESSION_DEAD,
+    SIM_SESSION_FINISHED
+}SimSessionState;
+
+typedef struct
+{
+    unsigned char buttons;
+    Vector2 viewAngles;             // FPCamera view angles to play this tick with
+}SimInput;
+
+// read only during a tick, any number of sessions can share one
+typedef struct
+{
+    const Model* platforms;         // only the transforms are read
+    int platformCount;
+    bool hasGoal;
+    Vector3 goal;
+    bool grappleUnlocked;
+    SimdPoints centers;             // platform positions for the batched ground and grapple tests
+    int tickRate;                   // ticks per second, 0 for SIM_TICK_RATE, see IsSimTickRateValid
+}SimLevel;
+
+typedef struct
+{
+    SimSessionState state;
+    unsigned int tick;
+    unsigned int events;            // SimEvent flags of the last tick
+
+    // FPCamera.CameraPosition, the base of the player, and where they look
+    Vector3 position;
+    Vector2 viewAngles;
+
+    SimBody body;
+
+    // platform under the player, -1 over nothing
+    int groundIndex;
+    int lastGroundIndex;
+
+    // the wobbling platform slides the player sideways, along x in physac's plane
+    float unstableTimer;
+    float slideX;
+    float slideVelocity;
+    float slideOrient;
+
+    // the last platform that wobbled keeps its own transform until another one does
+    int wobbleIndex;
+    Matrix wobbleTransform;
+
+    bool grappleEnabled;
+    bool grappling;
+    Vector3 grappleHit;
+    Vector3 grapplePull;            // atan of the offset to the hit, also the next vertical force
+}SimSession;
+
+// SIM_TICK_RATE or a divisor of it down to SIM_MIN_TICK_RATE, so every tick is whole frames
+bool IsSimTickRateValid(int tickRate);
+
+// seconds of one tick of the level
+float GetSimTickTime(const SimLevel* level);
+
+// a session standing at the start of a level. sessions hold no pointers and are cleared
+// bytewise here, so copies made with memcpy compare equal with memcmp
+void InitSimSession(SimSession* session);
+
+// advance one tick
+void StepSimSession(SimSession* session, const SimLevel* level, SimInput input);
+
+// step a copy of start through the inputs and check it ends bytewise equal to end
+bool VerifySimReplay(const SimSession* start, const SimInput* inputs, int count, const SimLevel* level, const SimSession* end);
+
+// step every playing session one tick, sessions[i] gets inputs[i]. the sessions are cut
+// into one batch per core
+void StepSimSessions(SimSession* sessions, const SimInput* inputs, int count, const SimLevel* level);
+
+// platforms that stay in the level moved by shift places, like UpdateCourseStream reports
+void ShiftSimSessionPlatforms(SimSession* session, int shift);
+
+// transform to draw a platform with, the wobbling one differs from the level
+Matrix GetSimPlatformTransform(const SimSession* session, const SimLevel* level, int index);
+
+// where the grapple line starts, the muzzle of the gun at the player's side
+Vector3 GetSimGrappleOrigin(const SimSession* session);
+
+// input of a bot that runs and jumps from platform to platform towards the goal
+SimInput GetSimBotInput(const SimSession* session, const SimLevel* level);
+
+// bot input for every session, batched across cores like StepSimSessions
+void GetSimBotInputs(const SimSession* sessions, SimInput* inputs, int count, const SimLevel* level);
+
+#endif //SIM_SESSION_H
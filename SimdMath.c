@@ -0,0 +1,424 @@
+/**********************************************************************************************
+*
+*   RockyRoad * SimdMath * Geometry tests four points at a time
+*
+**********************************************************************************************/
+
+#include "SimdMath.h"
+#include "Arena.h"
+
+#include <math.h>
+
+#if defined(SIMD_MATH_SSE2)
+#include <emmintrin.h>
+
+typedef __m128 Lanes;
+typedef __m128 LaneMask;
+
+#define LoadLanes(p) _mm_loadu_ps(p)
+#define StoreLanes(p, v) _mm_storeu_ps(p, v)
+#define SplatLanes(f) _mm_set1_ps(f)
+#define AddLanes(a, b) _mm_add_ps(a, b)
+#define SubLanes(a, b) _mm_sub_ps(a, b)
+#define MulLanes(a, b) _mm_mul_ps(a, b)
+#define DivLanes(a, b) _mm_div_ps(a, b)
+#define MinLanes(a, b) _mm_min_ps(a, b)
+#define MaxLanes(a, b) _mm_max_ps(a, b)
+#define AbsLanes(v) _mm_andnot_ps(_mm_set1_ps(-0.0f), v)
+#define LessLanes(a, b) _mm_cmplt_ps(a, b)
+#define LessEqualLanes(a, b) _mm_cmple_ps(a, b)
+#define AndMasks(a, b) _mm_and_ps(a, b)
+#define AllLanesMask() _mm_castsi128_ps(_mm_set1_epi32(-1))
+#define GetMaskBits(m) _mm_movemask_ps(m)
+
+#elif defined(SIMD_MATH_NEON)
+#include <arm_neon.h>
+
+typedef float32x4_t Lanes;
+typedef uint32x4_t LaneMask;
+
+#define LoadLanes(p) vld1q_f32(p)
+#define StoreLanes(p, v) vst1q_f32(p, v)
+#define SplatLanes(f) vdupq_n_f32(f)
+#define AddLanes(a, b) vaddq_f32(a, b)
+#define SubLanes(a, b) vsubq_f32(a, b)
+#define MulLanes(a, b) vmulq_f32(a, b)
+#define DivLanes(a, b) vdivq_f32(a, b)
+#define MinLanes(a, b) vminq_f32(a, b)
+#define MaxLanes(a, b) vmaxq_f32(a, b)
+#define AbsLanes(v) vabsq_f32(v)
+#define LessLanes(a, b) vcltq_f32(a, b)
+#define LessEqualLanes(a, b) vcleq_f32(a, b)
+#define AndMasks(a, b) vandq_u32(a, b)
+#define AllLanesMask() vdupq_n_u32(0xffffffffu)
+
+// one bit per lane like SSE's movemask
+static int GetMaskBits(LaneMask mask)
+{
+    static const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+    return (int)vaddvq_u32(vandq_u32(mask, vld1q_u32(laneBits)));
+}
+#endif
+
+#if SIMD_LANES > 1
+static bool simdEnabled = true;
+#else
+static bool simdEnabled = false;
+#endif
+
+SimdPoints MakeSimdPoints(float* data, int count)
+{
+    SimdPoints points = { data, data + count, data + 2*count, count };
+    return points;
+}
+
+SimdPoints LoadSimdPoints(int count)
+{
+    float *data = (float*)GameHeapAlloc(3*(size_t)count*sizeof(float));
+    if (data == NULL)
+        return (SimdPoints){ 0 };
+    return MakeSimdPoints(data, count);
+}
+
+void UnloadSimdPoints(SimdPoints* points)
+{
+    GameHeapFree(points->x);
+    *points = (SimdPoints){ 0 };
+}
+
+void GatherModelPositions(const Model* models, int count, SimdPoints* out)
+{
+    for (int i = 0; i < count; i++)
+    {
+        out->x[i] = models[i].transform.m12;
+        out->y[i] = models[i].transform.m13;
+        out->z[i] = models[i].transform.m14;
+    }
+}
+
+void UseSimdKernels(bool enabled)
+{
+    simdEnabled = enabled && SIMD_LANES > 1;
+}
+
+const char* GetSimdKernelName(void)
+{
+    if (!simdEnabled)
+        return "scalar";
+#if defined(SIMD_MATH_SSE2)
+    return "SSE2";
+#elif defined(SIMD_MATH_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+#if SIMD_LANES > 1
+static int GetLowestLane(int bits)
+{
+    int lane = 0;
+    while (!(bits & (1 << lane))) lane++;
+    return lane;
+}
+#endif
+
+static bool IsPointBelow(const SimdPoints* points, int i, Vector3 column, float halfSize, float topOffset)
+{
+    return fabsf(column.x - points->x[i]) <= halfSize && fabsf(column.z - points->z[i]) <= halfSize && points->y[i] + topOffset <= column.y;
+}
+
+int FindFirstPointBelow(const SimdPoints* points, int start, int end, Vector3 column, float halfSize, float topOffset)
+{
+    int i = start;
+#if SIMD_LANES > 1
+    if (simdEnabled)
+    {
+        Lanes x = SplatLanes(column.x);
+        Lanes z = SplatLanes(column.z);
+        Lanes maxY = SplatLanes(column.y);
+        Lanes half = SplatLanes(halfSize);
+        Lanes offset = SplatLanes(topOffset);
+        for (; i + SIMD_LANES <= end; i += SIMD_LANES)
+        {
+            LaneMask inside = AndMasks(LessEqualLanes(AbsLanes(SubLanes(x, LoadLanes(points->x + i))), half),
+                                       LessEqualLanes(AbsLanes(SubLanes(z, LoadLanes(points->z + i))), half));
+            inside = AndMasks(inside, LessEqualLanes(AddLanes(LoadLanes(points->y + i), offset), maxY));
+            int bits = GetMaskBits(inside);
+            if (bits != 0)
+                return i + GetLowestLane(bits);
+        }
+    }
+#endif
+    for (; i < end; i++)
+    {
+        if (IsPointBelow(points, i, column, halfSize, topOffset))
+            return i;
+    }
+    return -1;
+}
+
+static bool RayHitsBox(const float* origin, const float* direction, const float* half, const float* center)
+{
+    float tMin = -INFINITY;
+    float tMax = INFINITY;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float offset = origin[axis] - center[axis];
+        if (fabsf(direction[axis]) < 1e-6f)
+        {
+            if (fabsf(offset) > half[axis]) return false;
+            continue;
+        }
+        float t0 = (-half[axis] - offset)/direction[axis];
+        float t1 = (half[axis] - offset)/direction[axis];
+        tMin = fmaxf(tMin, fminf(t0, t1));
+        tMax = fminf(tMax, fmaxf(t0, t1));
+    }
+    return !(tMax < 0.0f || tMin > tMax);
+}
+
+int FindFirstRayBoxHit(const SimdPoints* centers, int start, int end, Ray ray, Vector3 halfSize)
+{
+    const float origin[3] = { ray.position.x, ray.position.y, ray.position.z };
+    const float direction[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+    const float half[3] = { halfSize.x, halfSize.y, halfSize.z };
+    const float *axes[3] = { centers->x, centers->y, centers->z };
+
+    int i = start;
+#if SIMD_LANES > 1
+    if (simdEnabled)
+    {
+        for (; i + SIMD_LANES <= end; i += SIMD_LANES)
+        {
+            Lanes tMin = SplatLanes(-INFINITY);
+            Lanes tMax = SplatLanes(INFINITY);
+            LaneMask hit = AllLanesMask();
+            for (int axis = 0; axis < 3; axis++)
+            {
+                Lanes offset = SubLanes(SplatLanes(origin[axis]), LoadLanes(axes[axis] + i));
+                if (fabsf(direction[axis]) < 1e-6f)
+                {
+                    hit = AndMasks(hit, LessEqualLanes(AbsLanes(offset), SplatLanes(half[axis])));
+                    continue;
+                }
+                Lanes t0 = DivLanes(SubLanes(SplatLanes(-half[axis]), offset), SplatLanes(direction[axis]));
+                Lanes t1 = DivLanes(SubLanes(SplatLanes(half[axis]), offset), SplatLanes(direction[axis]));
+                tMin = MaxLanes(tMin, MinLanes(t0, t1));
+                tMax = MinLanes(tMax, MaxLanes(t0, t1));
+            }
+            hit = AndMasks(hit, AndMasks(LessEqualLanes(SplatLanes(0.0f), tMax), LessEqualLanes(tMin, tMax)));
+            int bits = GetMaskBits(hit);
+            if (bits != 0)
+                return i + GetLowestLane(bits);
+        }
+    }
+#endif
+    for (; i < end; i++)
+    {
+        const float center[3] = { centers->x[i], centers->y[i], centers->z[i] };
+        if (RayHitsBox(origin, direction, half, center))
+            return i;
+    }
+    return -1;
+}
+
+// the slab test of RayHitsBox over the move's length, keeping the axis that was entered last.
+// y comes first so a move that reaches a top edge and a side at once lands
+static bool GetSweptHit(const SimdPoints* points, int i, const float* origin, const float* move, const float* half, float stepHeight,
+                        float* time, SweptFace* face)
+{
+    static const int axes[3] = { 1, 0, 2 };
+    const float center[3] = { points->x[i], points->y[i], points->z[i] };
+    float tEnter = -INFINITY;
+    float tExit = INFINITY;
+    int enterAxis = -1;
+    for (int a = 0; a < 3; a++)
+    {
+        int axis = axes[a];
+        float offset = origin[axis] - center[axis];
+        if (move[axis] == 0.0f)
+        {
+            if (!(fabsf(offset) < half[axis])) return false;
+            continue;
+        }
+        float t0 = (-half[axis] - offset)/move[axis];
+        float t1 = (half[axis] - offset)/move[axis];
+        if (fminf(t0, t1) > tEnter)
+        {
+            tEnter = fminf(t0, t1);
+            enterAxis = axis;
+        }
+        tExit = fminf(tExit, fmaxf(t0, t1));
+    }
+    if (enterAxis < 0 || !(0.0f <= tEnter && tEnter <= 1.0f && tEnter < tExit))
+        return false;
+
+    // up through the bottom is left to the body, a side just under the top is stepped onto
+    if (enterAxis == 1 && move[1] > 0.0f)
+        return false;
+    if (enterAxis != 1 && origin[1] + move[1]*tEnter > center[1] + half[1] - stepHeight)
+        return false;
+
+    *time = tEnter;
+    *face = (enterAxis == 1)? SWEPT_FACE_TOP : (enterAxis == 0)? SWEPT_FACE_X : SWEPT_FACE_Z;
+    return true;
+}
+
+int FindFirstSweptLanding(const SimdPoints* points, int start, int end, Vector3 from, Vector3 to, Vector3 halfSize, float stepHeight,
+                          float* time, SweptFace* face)
+{
+    const float origin[3] = { from.x, from.y, from.z };
+    const float move[3] = { to.x - from.x, to.y - from.y, to.z - from.z };
+    const float half[3] = { halfSize.x, halfSize.y, halfSize.z };
+
+    // hits are rare, the lanes only find the candidates and ties go to the lowest index
+    int best = -1;
+    float bestTime = INFINITY;
+    SweptFace bestFace = SWEPT_FACE_TOP;
+    int i = start;
+#if SIMD_LANES > 1
+    if (simdEnabled)
+    {
+        const float *axes[3] = { points->x, points->y, points->z };
+        for (; i + SIMD_LANES <= end; i += SIMD_LANES)
+        {
+            Lanes tEnter = SplatLanes(-INFINITY);
+            Lanes tExit = SplatLanes(INFINITY);
+            LaneMask hit = AllLanesMask();
+            for (int axis = 0; axis < 3; axis++)
+            {
+                Lanes offset = SubLanes(SplatLanes(origin[axis]), LoadLanes(axes[axis] + i));
+                if (move[axis] == 0.0f)
+                {
+                    hit = AndMasks(hit, LessLanes(AbsLanes(offset), SplatLanes(half[axis])));
+                    continue;
+                }
+                Lanes t0 = DivLanes(SubLanes(SplatLanes(-half[axis]), offset), SplatLanes(move[axis]));
+                Lanes t1 = DivLanes(SubLanes(SplatLanes(half[axis]), offset), SplatLanes(move[axis]));
+                tEnter = MaxLanes(tEnter, MinLanes(t0, t1));
+                tExit = MinLanes(tExit, MaxLanes(t0, t1));
+            }
+            hit = AndMasks(hit, AndMasks(LessEqualLanes(SplatLanes(0.0f), tEnter), LessEqualLanes(tEnter, SplatLanes(1.0f))));
+            hit = AndMasks(hit, LessLanes(tEnter, tExit));
+            int bits = GetMaskBits(hit);
+            for (int lane = 0; bits != 0 && lane < SIMD_LANES; lane++)
+            {
+                float t;
+                SweptFace f;
+                if ((bits & (1 << lane)) && GetSweptHit(points, i + lane, origin, move, half, stepHeight, &t, &f) && t < bestTime)
+                {
+                    best = i + lane;
+                    bestTime = t;
+                    bestFace = f;
+                }
+            }
+        }
+    }
+#endif
+    for (; i < end; i++)
+    {
+        float t;
+        SweptFace f;
+        if (GetSweptHit(points, i, origin, move, half, stepHeight, &t, &f) && t < bestTime)
+        {
+            best = i;
+            bestTime = t;
+            bestFace = f;
+        }
+    }
+
+    if (best >= 0)
+    {
+        *time = bestTime;
+        *face = bestFace;
+    }
+    return best;
+}
+
+// a box is behind a plane when even its corner furthest along the normal is, radius covers
+// that corner's extra distance and is the radius itself for spheres
+static void TestFrustumPlanes(const Frustum* frustum, const SimdPoints* centers, int start, int end, const Vector3* halfSize, float radius, bool* visible)
+{
+    float extent[6];
+    for (int p = 0; p < 6; p++)
+    {
+        const Vector4 *plane = &frustum->Planes[p];
+        extent[p] = (halfSize != NULL)? fabsf(plane->x)*halfSize->x + fabsf(plane->y)*halfSize->y + fabsf(plane->z)*halfSize->z : radius;
+    }
+
+    int i = start;
+#if SIMD_LANES > 1
+    if (simdEnabled)
+    {
+        for (; i + SIMD_LANES <= end; i += SIMD_LANES)
+        {
+            Lanes x = LoadLanes(centers->x + i);
+            Lanes y = LoadLanes(centers->y + i);
+            Lanes z = LoadLanes(centers->z + i);
+            LaneMask inside = AllLanesMask();
+            for (int p = 0; p < 6; p++)
+            {
+                const Vector4 *plane = &frustum->Planes[p];
+                Lanes distance = AddLanes(AddLanes(MulLanes(x, SplatLanes(plane->x)), MulLanes(y, SplatLanes(plane->y))),
+                                          AddLanes(MulLanes(z, SplatLanes(plane->z)), SplatLanes(plane->w)));
+                inside = AndMasks(inside, LessEqualLanes(SplatLanes(-extent[p]), distance));
+            }
+            int bits = GetMaskBits(inside);
+            for (int lane = 0; lane < SIMD_LANES; lane++)
+                visible[i + lane] = (bits & (1 << lane)) != 0;
+        }
+    }
+#endif
+    for (; i < end; i++)
+    {
+        visible[i] = true;
+        for (int p = 0; p < 6 && visible[i]; p++)
+        {
+            const Vector4 *plane = &frustum->Planes[p];
+            float distance = (centers->x[i]*plane->x + centers->y[i]*plane->y) + (centers->z[i]*plane->z + plane->w);
+            visible[i] = -extent[p] <= distance;
+        }
+    }
+}
+
+void TestBoxesInFrustum(const Frustum* frustum, const SimdPoints* centers, int start, int end, Vector3 halfSize, bool* visible)
+{
+    TestFrustumPlanes(frustum, centers, start, end, &halfSize, 0.0f, visible);
+}
+
+void TestSpheresInFrustum(const Frustum* frustum, const SimdPoints* centers, int start, int end, float radius, bool* visible)
+{
+    TestFrustumPlanes(frustum, centers, start, end, NULL, radius, visible);
+}
+
+void TransformSimdPoints(Matrix matrix, const SimdPoints* points, int start, int end, SimdPoints* out)
+{
+    int i = start;
+#if SIMD_LANES > 1
+    if (simdEnabled)
+    {
+        for (; i + SIMD_LANES <= end; i += SIMD_LANES)
+        {
+            Lanes x = LoadLanes(points->x + i);
+            Lanes y = LoadLanes(points->y + i);
+            Lanes z = LoadLanes(points->z + i);
+            StoreLanes(out->x + i, AddLanes(AddLanes(MulLanes(SplatLanes(matrix.m0), x), MulLanes(SplatLanes(matrix.m4), y)),
+                                            AddLanes(MulLanes(SplatLanes(matrix.m8), z), SplatLanes(matrix.m12))));
+            StoreLanes(out->y + i, AddLanes(AddLanes(MulLanes(SplatLanes(matrix.m1), x), MulLanes(SplatLanes(matrix.m5), y)),
+                                            AddLanes(MulLanes(SplatLanes(matrix.m9), z), SplatLanes(matrix.m13))));
+            StoreLanes(out->z + i, AddLanes(AddLanes(MulLanes(SplatLanes(matrix.m2), x), MulLanes(SplatLanes(matrix.m6), y)),
+                                            AddLanes(MulLanes(SplatLanes(matrix.m10), z), SplatLanes(matrix.m14))));
+        }
+    }
+#endif
+    for (; i < end; i++)
+    {
+        float x = points->x[i];
+        float y = points->y[i];
+        float z = points->z[i];
+        out->x[i] = (matrix.m0*x + matrix.m4*y) + (matrix.m8*z + matrix.m12);
+        out->y[i] = (matrix.m1*x + matrix.m5*y) + (matrix.m9*z + matrix.m13);
+        out->z[i] = (matrix.m2*x + matrix.m6*y) + (matrix.m10*z + matrix.m14);
+    }
+}
@@ -0,0 +1,86 @@
+/**********************************************************************************************
+*
+*   RockyRoad * SimdMath * Geometry tests four points at a time
+*
+*   The per-platform loops test one point or box against one ray, column or frustum, over
+*   and over. The kernels here take the platform positions as separate x, y and z arrays and
+*   test four of them per instruction with SSE2 on x86 and NEON on 64 bit ARM; anything else,
+*   and the last few points of a range, run the same tests one at a time. The tests use only
+*   exact IEEE operations in the order the scalar code does them, so both paths give the same
+*   answers and simulations stay deterministic between builds.
+*
+**********************************************************************************************/
+
+#ifndef SIMD_MATH_H
+#define SIMD_MATH_H
+
+#include "raylib.h"
+#include "Frustum.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_MATH_SSE2
+#define SIMD_LANES 4
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_MATH_NEON
+#define SIMD_LANES 4
+#else
+#define SIMD_LANES 1
+#endif
+
+// which face of a box a swept point entered through
+typedef enum
+{
+    SWEPT_FACE_TOP = 0,
+    SWEPT_FACE_X,                   // one of the two sides facing along x
+    SWEPT_FACE_Z
+}SweptFace;
+
+// points in structure of arrays layout
+typedef struct
+{
+    float* x;
+    float* y;
+    float* z;
+    int count;
+}SimdPoints;
+
+// split data, 3*count floats, into the three arrays
+SimdPoints MakeSimdPoints(float* data, int count);
+
+// on the game heap, free with UnloadSimdPoints
+SimdPoints LoadSimdPoints(int count);
+void UnloadSimdPoints(SimdPoints* points);
+
+// the translation of every model, where the platforms stand
+void GatherModelPositions(const Model* models, int count, SimdPoints* out);
+
+// switch between the vector and the scalar path, for benchmarks. on by default where supported
+void UseSimdKernels(bool enabled);
+const char* GetSimdKernelName(void);
+
+// first point in [start, end) within halfSize of column.x and column.z whose y + topOffset is
+// at most column.y, -1 for none
+int FindFirstPointBelow(const SimdPoints* points, int start, int end, Vector3 column, float halfSize, float topOffset);
+
+// first box in [start, end), centred on its point, the ray hits ahead of its origin or from
+// inside, -1 for none. axes the ray runs parallel to only check the origin is within the box
+int FindFirstRayBoxHit(const SimdPoints* centers, int start, int end, Ray ray, Vector3 halfSize);
+
+// earliest box in [start, end), centred on its point, that a point moving straight from from to
+// to enters. sweeping a body's centre against boxes grown by the body's size is sweeping the
+// body against the boxes. entering through the top is a landing and through a side a hit on
+// that side, unless the point is within stepHeight of the top there. coming up through the
+// bottom or starting inside a box is no hit. returns -1 for none and leaves time and face
+// untouched, otherwise time gets the fraction of the move at the contact
+int FindFirstSweptLanding(const SimdPoints* points, int start, int end, Vector3 from, Vector3 to, Vector3 halfSize, float stepHeight,
+                          float* time, SweptFace* face);
+
+// visible[i] for every box or sphere in [start, end) that is not wholly behind a frustum plane
+void TestBoxesInFrustum(const Frustum* frustum, const SimdPoints* centers, int start, int end, Vector3 halfSize, bool* visible);
+void TestSpheresInFrustum(const Frustum* frustum, const SimdPoints* centers, int start, int end, float radius, bool* visible);
+
+// out[i] = matrix*points[i] for [start, end), like Vector3Transform. not used by the simulation,
+// builds that fuse multiply-adds may round the two paths differently
+void TransformSimdPoints(Matrix matrix, const SimdPoints* points, int start, int end, SimdPoints* out);
+
+#endif //SIMD_MATH_H
@@ -0,0 +1,248 @@
+/**********************************************************************************************
+*
+*   RockyRoad * Skinning * Skeletal animation on the GPU
+*
+**********************************************************************************************/
+
+#include "Skinning.h"
+#include "Arena.h"
+#include "MemTrack.h"
+#include "RenderQueue.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+#include <math.h>
+
+// vertex buffers share the id space of vertex arrays in MEM_GPU_MESH, keep them apart
+#define SKIN_BUFFER_KEY(id) ((1ULL << 32) | (id))
+
+static unsigned int UploadBoneAttribute(unsigned int vaoId, int location, const float* data, int vertexCount)
+{
+    if (location < 0)
+        return 0;
+
+    rlEnableVertexArray(vaoId);
+    unsigned int vbo = rlLoadVertexBuffer((void*)data, vertexCount*4*sizeof(float), false);
+    rlSetVertexAttribute(location, 4, RL_FLOAT, false, 0, 0);
+    rlEnableVertexAttribute(location);
+    rlDisableVertexArray();
+
+    TrackMemory(MEM_GPU_MESH, SKIN_BUFFER_KEY(vbo), vertexCount*4*sizeof(float), "skin attributes");
+    return vbo;
+}
+
+Skin LoadSkin(Model* model, Shader shader)
+{
+    Skin skin = { 0 };
+    skin.shader = shader;
+    skin.bonesLoc = GetShaderLocation(shader, "bones");
+    skin.instancedLoc = GetShaderLocation(shader, "instanced");
+    skin.instanceTransformLoc = rlGetLocationAttrib(shader.id, "instanceTransform");
+
+    if (model->boneCount > SKIN_MAX_BONES)
+    {
+        TraceLog(LOG_WARNING, "SKIN: %i bones, only %i fit the shader, model left unskinned", model->boneCount, SKIN_MAX_BONES);
+        return skin;
+    }
+
+    int idsLoc = rlGetLocationAttrib(shader.id, "vertexBoneIds");
+    int weightsLoc = rlGetLocationAttrib(shader.id, "vertexBoneWeights");
+
+    skin.boneCount = model->boneCount;
+    skin.meshCount = model->meshCount;
+    skin.boneIdBuffers = (unsigned int*)GameHeapAlloc(model->meshCount*sizeof(unsigned int));
+    skin.weightBuffers = (unsigned int*)GameHeapAlloc(model->meshCount*sizeof(unsigned int));
+    skin.boneRows = (float*)GameHeapAlloc((model->boneCount + 1)*SKIN_BONE_ROW_FLOATS*sizeof(float));
+
+    if (skin.boneIdBuffers == NULL || skin.weightBuffers == NULL || skin.boneRows == NULL)
+    {
+        UnloadSkin(&skin);
+        return skin;
+    }
+
+    for (int m = 0; m < model->meshCount; m++)
+    {
+        Mesh *mesh = &model->meshes[m];
+        if (mesh->boneIds == NULL || mesh->boneWeights == NULL)
+            continue;
+
+        // ids go up as floats, the element type of boneIds does not matter then
+        float *ids = (float*)GameHeapAlloc(mesh->vertexCount*4*sizeof(float));
+        if (ids == NULL)
+            continue;
+
+        for (int i = 0; i < mesh->vertexCount*4; i++)
+            ids[i] = (float)mesh->boneIds[i];
+
+        skin.boneIdBuffers[m] = UploadBoneAttribute(mesh->vaoId, idsLoc, ids, mesh->vertexCount);
+        skin.weightBuffers[m] = UploadBoneAttribute(mesh->vaoId, weightsLoc, mesh->boneWeights, mesh->vertexCount);
+        GameHeapFree(ids);
+    }
+
+    for (int i = 0; i < model->materialCount; i++)
+        model->materials[i].shader = shader;
+
+    // start in the bind pose
+    for (int b = 0; b < skin.boneCount; b++)
+    {
+        float *row = &skin.boneRows[b*SKIN_BONE_ROW_FLOATS];
+        row[0] = 1.0f; row[5] = 1.0f; row[10] = 1.0f;
+    }
+
+    return skin;
+}
+
+void UnloadSkin(Skin* skin)
+{
+    if (skin == NULL)
+        return;
+
+    for (int m = 0; m < skin->meshCount; m++)
+    {
+        if (skin->boneIdBuffers != NULL && skin->boneIdBuffers[m] != 0)
+        {
+            UntrackMemory(MEM_GPU_MESH, SKIN_BUFFER_KEY(skin->boneIdBuffers[m]));
+            rlUnloadVertexBuffer(skin->boneIdBuffers[m]);
+        }
+        if (skin->weightBuffers != NULL && skin->weightBuffers[m] != 0)
+        {
+            UntrackMemory(MEM_GPU_MESH, SKIN_BUFFER_KEY(skin->weightBuffers[m]));
+            rlUnloadVertexBuffer(skin->weightBuffers[m]);
+        }
+    }
+
+    GameHeapFree(skin->boneIdBuffers);
+    GameHeapFree(skin->weightBuffers);
+    GameHeapFree(skin->boneRows);
+
+    skin->boneIdBuffers = NULL;
+    skin->weightBuffers = NULL;
+    skin->boneRows = NULL;
+    skin->meshCount = 0;
+    skin->boneCount = 0;
+}
+
+static Transform LerpTransform(Transform a, Transform b, float amount)
+{
+    Transform result;
+    result.translation = Vector3Lerp(a.translation, b.translation, amount);
+    result.rotation = QuaternionNlerp(a.rotation, b.rotation, amount);
+    result.scale = Vector3Lerp(a.scale, b.scale, amount);
+    return result;
+}
+
+// rows of T(pose.translation) * R(pose.rotation*inverse(bind.rotation)) * S(pose.scale) * T(-bind.translation),
+// the order raylib's UpdateModelAnimation applies them to a vertex
+void ComputeSkinBoneRows(Transform bind, Transform pose, float* rows)
+{
+    Quaternion q = QuaternionNormalize(QuaternionMultiply(pose.rotation, QuaternionInvert(bind.rotation)));
+
+    float r[3][3] = {
+        {1.0f - 2.0f*(q.y*q.y + q.z*q.z), 2.0f*(q.x*q.y - q.z*q.w), 2.0f*(q.x*q.z + q.y*q.w)},
+        {2.0f*(q.x*q.y + q.z*q.w), 1.0f - 2.0f*(q.x*q.x + q.z*q.z), 2.0f*(q.y*q.z - q.x*q.w)},
+        {2.0f*(q.x*q.z - q.y*q.w), 2.0f*(q.y*q.z + q.x*q.w), 1.0f - 2.0f*(q.x*q.x + q.y*q.y)}
+    };
+    float scale[3] = {pose.scale.x, pose.scale.y, pose.scale.z};
+    float bindT[3] = {bind.translation.x, bind.translation.y, bind.translation.z};
+    float poseT[3] = {pose.translation.x, pose.translation.y, pose.translation.z};
+
+    for (int i = 0; i < 3; i++)
+    {
+        float translation = poseT[i];
+        for (int j = 0; j < 3; j++)
+        {
+            rows[i*4 + j] = r[i][j]*scale[j];
+            translation -= r[i][j]*scale[j]*bindT[j];
+        }
+        rows[i*4 + 3] = translation;
+    }
+}
+
+void UpdateSkinPose(Skin* skin, Model model, ModelAnimation anim, float frame)
+{
+    if (skin->boneRows == NULL || anim.frameCount <= 0 || anim.boneCount != skin->boneCount)
+        return;
+
+    frame = fmodf(frame, (float)anim.frameCount);
+    if (frame < 0.0f)
+        frame += (float)anim.frameCount;
+
+    int first = (int)frame;
+    int second = (first + 1) % anim.frameCount;
+    float amount = frame - (float)first;
+
+    for (int b = 0; b < skin->boneCount; b++)
+    {
+        Transform pose = LerpTransform(anim.framePoses[first][b], anim.framePoses[second][b], amount);
+        ComputeSkinBoneRows(model.bindPose[b], pose, &skin->boneRows[b*SKIN_BONE_ROW_FLOATS]);
+    }
+}
+
+void DrawSkinnedModel(const Skin* skin, Model model, Matrix transform)
+{
+    DrawSkinnedModelLod(skin, model, NULL, 0, transform);
+}
+
+void DrawSkinnedModelLod(const Skin* skin, Model model, const ModelLods* lods, int lod, Matrix transform)
+{
+    if (skin->boneRows != NULL && skin->bonesLoc != -1)
+        SetShaderValueV(skin->shader, skin->bonesLoc, skin->boneRows, SHADER_UNIFORM_VEC4, skin->boneCount*3);
+
+    Matrix placed = MatrixMultiply(model.transform, transform);
+    for (int i = 0; i < model.meshCount; i++)
+    {
+        int offset = 0;
+        int count = 0;
+        GetMeshLodRange(lods, i, lod, &offset, &count);
+        DrawMeshRange(model.meshes[i], model.materials[model.meshMaterial[i]], placed, offset, count);
+    }
+}
+
+void DrawSkinnedModelInstanced(const Skin* skin, Model model, const Matrix* transforms, int count, Color tint)
+{
+    if (count <= 0)
+        return;
+    if (count > SKIN_MAX_INSTANCES)
+        count = SKIN_MAX_INSTANCES;
+
+    if (skin->boneRows != NULL && skin->bonesLoc != -1)
+        SetShaderValueV(skin->shader, skin->bonesLoc, skin->boneRows, SHADER_UNIFORM_VEC4, skin->boneCount*3);
+
+    Matrix placed[SKIN_MAX_INSTANCES];
+    for (int i = 0; i < count; i++)
+        placed[i] = MatrixMultiply(model.transform, transforms[i]);
+
+    // DrawMeshInstanced only instances from two copies on, a single one is a regular draw
+    bool instancing = count > 1 && skin->instancedLoc != -1 && skin->instanceTransformLoc != -1;
+    int modelLoc = skin->shader.locs[SHADER_LOC_MATRIX_MODEL];
+    int instanced = 1;
+    if (instancing)
+    {
+        // raylib takes the model matrix location as the first of the instance attributes
+        skin->shader.locs[SHADER_LOC_MATRIX_MODEL] = skin->instanceTransformLoc;
+        SetShaderValue(skin->shader, skin->instancedLoc, &instanced, SHADER_UNIFORM_INT);
+    }
+
+    for (int m = 0; m < model.meshCount; m++)
+    {
+        // the maps are shared with the model, the tint only lasts for this draw
+        Material material = model.materials[model.meshMaterial[m]];
+        Color color = material.maps[MATERIAL_MAP_ALBEDO].color;
+        material.maps[MATERIAL_MAP_ALBEDO].color = tint;
+        if (instancing)
+            DrawMeshInstanced(model.meshes[m], material, placed, count);
+        else
+        {
+            for (int i = 0; i < count; i++)
+                DrawMesh(model.meshes[m], material, placed[i]);
+        }
+        material.maps[MATERIAL_MAP_ALBEDO].color = color;
+    }
+
+    if (instancing)
+    {
+        instanced = 0;
+        SetShaderValue(skin->shader, skin->instancedLoc, &instanced, SHADER_UNIFORM_INT);
+        skin->shader.locs[SHADER_LOC_MATRIX_MODEL] = modelLoc;
+    }
+}
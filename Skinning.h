@@ -0,0 +1,64 @@
+/**********************************************************************************************
+*
+*   RockyRoad * Skinning * Skeletal animation on the GPU
+*
+*   The bind pose vertices stay in the mesh buffers untouched. Bone ids and weights are
+*   uploaded once as two extra vertex attributes, and every frame only the bone matrices
+*   (three vec4 rows each) go to the shader. The vertex shader blends them per vertex, so
+*   playing an animation never rewrites or re-uploads vertex data.
+*
+*   Bone matrices follow raylib's CPU skinning: scale by the frame pose, move out of the
+*   bind pose, rotate by pose*inverse(bind), then move to the pose translation.
+*
+**********************************************************************************************/
+
+#ifndef SKINNING_H
+#define SKINNING_H
+
+#include "raylib.h"
+#include "MeshLod.h"
+
+#define SKIN_MAX_BONES 64                   // must match MAX_BONES in skin.vs
+#define SKIN_ANIMATION_FPS 60.0f            // rate raylib bakes glTF animation frames at
+#define SKIN_BONE_ROW_FLOATS 12             // three vec4 rows per bone
+#define SKIN_MAX_INSTANCES 16
+
+typedef struct
+{
+    Shader shader;
+    int bonesLoc;
+    int boneCount;
+
+    // instanced draws switch the shader to per instance transforms
+    int instancedLoc;
+    int instanceTransformLoc;
+
+    // extra attribute buffers, one pair per mesh (0 for meshes without bone data)
+    int meshCount;
+    unsigned int* boneIdBuffers;
+    unsigned int* weightBuffers;
+
+    // current pose, three rows of four floats per bone
+    float* boneRows;
+}Skin;
+
+// attach the bone attributes to the model's meshes and switch its materials to the skin shader
+Skin LoadSkin(Model* model, Shader shader);
+void UnloadSkin(Skin* skin);
+
+// pose the skin from an animation, frames are fractional and wrap around
+void UpdateSkinPose(Skin* skin, Model model, ModelAnimation anim, float frame);
+
+// bone matrix rows for one bone in the given pose, relative to its bind pose
+void ComputeSkinBoneRows(Transform bind, Transform pose, float* rows);
+
+// upload the pose and draw every mesh of the model, placed like DrawModel with a transform
+void DrawSkinnedModel(const Skin* skin, Model model, Matrix transform);
+
+// same at a level of detail, lods can be NULL for the full model
+void DrawSkinnedModelLod(const Skin* skin, Model model, const ModelLods* lods, int lod, Matrix transform);
+
+// copies of the model in the current pose, one draw per mesh for all of them, tinted
+void DrawSkinnedModelInstanced(const Skin* skin, Model model, const Matrix* transforms, int count, Color tint);
+
+#endif //SKINNING_H
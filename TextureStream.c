@@ -0,0 +1,587 @@
+/**********************************************************************************************
+*
+*   RockyRoad * TextureStream * Material textures streamed in by on-screen size
+*
+**********************************************************************************************/
+
+#include "TextureStream.h"
+#include "MemTrack.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+    #include <direct.h>
+    #define MakeDirectory(path) _mkdir(path)
+#else
+    #include <sys/stat.h>
+    #define MakeDirectory(path) mkdir(path, 0755)
+#endif
+
+#define MAX_STREAMED_TEXTURES 64
+#define MAX_STREAM_TARGETS 4                // materials sharing one streamed file
+#define STREAM_QUEUE_SIZE 64                // must be a power of two
+#define STREAM_QUEUE_MASK (STREAM_QUEUE_SIZE - 1)
+#define STREAM_RETRY_FRAMES 120             // wait after an upload did not fit the budget
+#define STREAM_TAIL_MAGIC 0x54545252u       // "RRTT"
+#define STREAM_TAIL_VERSION 1
+
+#define FNV64_OFFSET 14695981039346656037ULL
+#define FNV64_PRIME 1099511628211ULL
+
+typedef struct
+{
+    unsigned int magic;
+    unsigned int version;
+    int width;
+    int height;
+    int fullWidth;                  // size of the source image, so requests can be clamped early
+    int fullHeight;
+}TextureTailHeader;
+
+typedef struct
+{
+    char fileName[128];
+    unsigned long long key;
+    TextureFilter filter;
+
+    Texture2D tail;
+    Texture2D resident;             // id 0 while only the tail is up
+    size_t residentBytes;
+
+    Texture2D* targets[MAX_STREAM_TARGETS];
+    Texture2D original[MAX_STREAM_TARGETS];
+    MaterialMap* targetMaps[MAX_STREAM_TARGETS];
+    int targetCount;
+
+    float desiredPixels;            // largest request since the last update
+    unsigned int lastUsed;
+    unsigned int retryFrame;
+
+    // shared with the loader thread, guarded by streamLock
+    bool needsTail;
+    bool failed;
+    int pendingSize;
+    int fullWidth;
+    int fullHeight;
+    bool hasReady;
+    Image ready;
+    Image readyTail;
+}StreamedTexture;
+
+typedef struct
+{
+    int slot;
+    int size;                       // longest side wanted, 0 for the tail only
+}StreamRequest;
+
+static StreamedTexture textures[MAX_STREAMED_TEXTURES] = { 0 };
+static int textureCount = 0;
+static size_t budget = 0;
+static size_t residentTotal = 0;
+static unsigned int frame = 1;
+
+static StreamRequest queue[STREAM_QUEUE_SIZE];
+static unsigned int queueHead = 0;
+static unsigned int queueTail = 0;
+
+static pthread_t loaderThread;
+static pthread_mutex_t streamLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t streamCond = PTHREAD_COND_INITIALIZER;
+static bool running = false;
+
+static unsigned long long TextureKey(const char* fileName)
+{
+    unsigned long long hash = FNV64_OFFSET;
+
+    // the modification time is part of the key, so a repainted texture gets a new tail
+    long modTime = GetFileModTime(fileName);
+    unsigned int version = STREAM_TAIL_VERSION;
+    const unsigned char *bytes = (const unsigned char*)&modTime;
+    for (unsigned int i = 0; i < sizeof(modTime); i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV64_PRIME;
+    }
+    bytes = (const unsigned char*)&version;
+    for (unsigned int i = 0; i < sizeof(version); i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV64_PRIME;
+    }
+    for (const char *c = fileName; *c != '\0'; c++)
+    {
+        hash ^= (unsigned char)*c;
+        hash *= FNV64_PRIME;
+    }
+    return hash;
+}
+
+static void GetTailPath(unsigned long long key, char* path, int size)
+{
+    snprintf(path, size, "%s/%016llx.tail", TEXTURE_STREAM_DIRECTORY, key);
+}
+
+static size_t GetLevelBytes(int width, int height, int format)
+{
+    size_t size = (size_t)GetPixelDataSize(width, height, format);
+
+    // uploads always get a full mip chain
+    return size + size/3;
+}
+
+static int LongestSide(int width, int height)
+{
+    return (width > height)? width : height;
+}
+
+// halve the image until one more halving would take its longest side under size
+static void FitImage(Image* image, int size)
+{
+    int width = image->width;
+    int height = image->height;
+    while (LongestSide(width, height)/2 >= size && width > 1 && height > 1)
+    {
+        width /= 2;
+        height /= 2;
+    }
+
+    if (width != image->width || height != image->height)
+        ImageResize(image, width, height);
+}
+
+// loader thread only: build the tail of a freshly decoded image and write it to the cache
+static Image BuildTail(const StreamedTexture* texture, Image image)
+{
+    Image tail = ImageCopy(image);
+    ImageFormat(&tail, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+    int width = tail.width;
+    int height = tail.height;
+    while (LongestSide(width, height) > TEXTURE_STREAM_TAIL_SIZE && width > 1 && height > 1)
+    {
+        width /= 2;
+        height /= 2;
+    }
+    if (width != tail.width || height != tail.height)
+        ImageResize(&tail, width, height);
+
+    int pixelBytes = GetPixelDataSize(tail.width, tail.height, tail.format);
+    unsigned int size = (unsigned int)(sizeof(TextureTailHeader) + pixelBytes);
+    unsigned char *data = (unsigned char*)MemAlloc(size);
+    TextureTailHeader header = { 0 };
+    header.magic = STREAM_TAIL_MAGIC;
+    header.version = STREAM_TAIL_VERSION;
+    header.width = tail.width;
+    header.height = tail.height;
+    header.fullWidth = image.width;
+    header.fullHeight = image.height;
+    memcpy(data, &header, sizeof(header));
+    memcpy(data + sizeof(header), tail.data, pixelBytes);
+
+    char path[64];
+    GetTailPath(texture->key, path, sizeof(path));
+    MakeDirectory(TEXTURE_STREAM_DIRECTORY);
+    if (!SaveFileData(path, data, size))
+        TraceLog(LOG_WARNING, "STREAM: Could not write mip tail %s for %s", path, texture->fileName);
+    MemFree(data);
+
+    return tail;
+}
+
+static void* LoaderMain(void* arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&streamLock);
+    while (true)
+    {
+        while (running && queueHead == queueTail)
+            pthread_cond_wait(&streamCond, &streamLock);
+        if (!running)
+            break;
+
+        StreamRequest request = queue[queueHead & STREAM_QUEUE_MASK];
+        queueHead++;
+        StreamedTexture *texture = &textures[request.slot];
+        bool wantTail = texture->needsTail;
+        pthread_mutex_unlock(&streamLock);
+
+        // fileName and key never change once the slot is registered
+        Image image = LoadImage(texture->fileName);
+        Image tail = { 0 };
+        int fullWidth = image.width;
+        int fullHeight = image.height;
+        if (image.data != NULL)
+        {
+            if (wantTail)
+                tail = BuildTail(texture, image);
+
+            if (request.size > 0)
+            {
+                FitImage(&image, request.size);
+            }
+            else
+            {
+                UnloadImage(image);
+                image = (Image){ 0 };
+            }
+        }
+
+        pthread_mutex_lock(&streamLock);
+        if (fullWidth == 0)
+        {
+            texture->failed = true;
+        }
+        else
+        {
+            texture->fullWidth = fullWidth;
+            texture->fullHeight = fullHeight;
+            if (tail.data != NULL)
+                texture->needsTail = false;
+            texture->ready = image;
+            texture->readyTail = tail;
+            texture->hasReady = true;
+        }
+        texture->pendingSize = 0;
+    }
+    pthread_mutex_unlock(&streamLock);
+
+    return NULL;
+}
+
+// main thread, called with streamLock held
+static bool PushRequest(int slot, int size)
+{
+    if (queueTail - queueHead >= STREAM_QUEUE_SIZE)
+        return false;
+
+    queue[queueTail & STREAM_QUEUE_MASK] = (StreamRequest){ slot, size };
+    queueTail++;
+    textures[slot].pendingSize = (size > 0)? size : 1;
+    pthread_cond_signal(&streamCond);
+    return true;
+}
+
+static Texture2D UploadLevel(Image image, TextureFilter filter, const char* name)
+{
+    Texture2D texture = LoadTextureFromImage(image);
+    GenTextureMipmaps(&texture);
+    SetTextureFilter(texture, filter);
+    TrackTexture(texture, name);
+    return texture;
+}
+
+static void PatchTargets(StreamedTexture* texture)
+{
+    Texture2D current = (texture->resident.id != 0)? texture->resident : texture->tail;
+    for (int i = 0; i < texture->targetCount; i++)
+        *texture->targets[i] = (current.id != 0)? current : texture->original[i];
+}
+
+static void DropResident(StreamedTexture* texture)
+{
+    if (texture->resident.id == 0)
+        return;
+
+    Texture2D resident = texture->resident;
+    texture->resident = (Texture2D){ 0 };
+    PatchTargets(texture);
+    UntrackTexture(resident);
+    UnloadTexture(resident);
+    residentTotal -= texture->residentBytes;
+    texture->residentBytes = 0;
+}
+
+// least recently used texture with a level above its tail, other than keep
+static StreamedTexture* FindEvictable(const StreamedTexture* keep)
+{
+    StreamedTexture *oldest = NULL;
+    for (int i = 0; i < textureCount; i++)
+    {
+        StreamedTexture *texture = &textures[i];
+        if (texture == keep || texture->resident.id == 0)
+            continue;
+        if (oldest == NULL || texture->lastUsed < oldest->lastUsed)
+            oldest = texture;
+    }
+    return oldest;
+}
+
+// evict until bytes more fit next to everything but the level texture already holds
+static bool MakeRoom(const StreamedTexture* texture, size_t bytes)
+{
+    while (residentTotal - texture->residentBytes + bytes > budget)
+    {
+        StreamedTexture *victim = FindEvictable(texture);
+        if (victim == NULL || victim->lastUsed >= texture->lastUsed)
+            return false;
+        DropResident(victim);
+    }
+    return true;
+}
+
+static void InstallResident(StreamedTexture* texture, Image image)
+{
+    // the tail already covers anything this small
+    if (texture->tail.id != 0 && LongestSide(image.width, image.height) <= LongestSide(texture->tail.width, texture->tail.height))
+        return;
+
+    size_t bytes = GetLevelBytes(image.width, image.height, image.format);
+    if (!MakeRoom(texture, bytes))
+    {
+        texture->retryFrame = frame + STREAM_RETRY_FRAMES;
+        return;
+    }
+
+    Texture2D previous = texture->resident;
+    residentTotal -= texture->residentBytes;
+    texture->resident = UploadLevel(image, texture->filter, texture->fileName);
+    texture->residentBytes = bytes;
+    residentTotal += bytes;
+    PatchTargets(texture);
+
+    if (previous.id != 0)
+    {
+        UntrackTexture(previous);
+        UnloadTexture(previous);
+    }
+}
+
+static bool LoadTail(StreamedTexture* texture)
+{
+    char path[64];
+    GetTailPath(texture->key, path, sizeof(path));
+    if (!FileExists(path))
+        return false;
+
+    unsigned int size = 0;
+    unsigned char *data = LoadFileData(path, &size);
+    if (data == NULL)
+        return false;
+
+    TextureTailHeader header = { 0 };
+    bool valid = size >= sizeof(header);
+    if (valid)
+    {
+        memcpy(&header, data, sizeof(header));
+        valid = header.magic == STREAM_TAIL_MAGIC && header.version == STREAM_TAIL_VERSION &&
+                header.width > 0 && header.height > 0 &&
+                header.width <= TEXTURE_STREAM_TAIL_SIZE && header.height <= TEXTURE_STREAM_TAIL_SIZE &&
+                size == sizeof(header) + (unsigned int)GetPixelDataSize(header.width, header.height, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    }
+
+    if (valid)
+    {
+        Image image = { data + sizeof(header), header.width, header.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+        texture->tail = UploadLevel(image, texture->filter, texture->fileName);
+        texture->fullWidth = header.fullWidth;
+        texture->fullHeight = header.fullHeight;
+    }
+    else
+    {
+        TraceLog(LOG_WARNING, "STREAM: Ignoring damaged mip tail %s", path);
+    }
+
+    UnloadFileData(data);
+    return valid;
+}
+
+void InitTextureStreaming(size_t budgetBytes)
+{
+    budget = budgetBytes;
+    residentTotal = 0;
+    textureCount = 0;
+    queueHead = queueTail = 0;
+    frame = 1;
+
+    running = true;
+    if (pthread_create(&loaderThread, NULL, LoaderMain, NULL) != 0)
+    {
+        running = false;
+        TraceLog(LOG_WARNING, "STREAM: Could not start the loader thread, textures stay at their tails");
+    }
+}
+
+void CloseTextureStreaming(void)
+{
+    if (running)
+    {
+        pthread_mutex_lock(&streamLock);
+        running = false;
+        pthread_cond_broadcast(&streamCond);
+        pthread_mutex_unlock(&streamLock);
+        pthread_join(loaderThread, NULL);
+    }
+
+    for (int i = 0; i < textureCount; i++)
+    {
+        StreamedTexture *texture = &textures[i];
+        for (int t = 0; t < texture->targetCount; t++)
+            *texture->targets[t] = texture->original[t];
+
+        if (texture->resident.id != 0)
+        {
+            UntrackTexture(texture->resident);
+            UnloadTexture(texture->resident);
+        }
+        if (texture->tail.id != 0)
+        {
+            UntrackTexture(texture->tail);
+            UnloadTexture(texture->tail);
+        }
+        if (texture->hasReady)
+        {
+            UnloadImage(texture->ready);
+            UnloadImage(texture->readyTail);
+        }
+    }
+
+    memset(textures, 0, sizeof(textures));
+    textureCount = 0;
+    residentTotal = 0;
+}
+
+void SetTextureStreamingBudget(size_t budgetBytes)
+{
+    budget = budgetBytes;
+    StreamedTexture *victim = NULL;
+    while (residentTotal > budget && (victim = FindEvictable(NULL)) != NULL)
+        DropResident(victim);
+}
+
+bool StreamMaterialMap(Material* material, int mapIndex, const char* fileName, TextureFilter filter)
+{
+    if (material == NULL || material->maps == NULL || mapIndex < 0 || mapIndex >= MAX_MATERIAL_MAPS)
+        return false;
+
+    StreamedTexture *texture = NULL;
+    for (int i = 0; i < textureCount; i++)
+    {
+        if (strcmp(textures[i].fileName, fileName) == 0)
+            texture = &textures[i];
+    }
+
+    if (texture == NULL)
+    {
+        if (textureCount == MAX_STREAMED_TEXTURES || strlen(fileName) >= sizeof(texture->fileName))
+        {
+            TraceLog(LOG_WARNING, "STREAM: Cannot stream %s", fileName);
+            return false;
+        }
+
+        int slot = textureCount++;
+        texture = &textures[slot];
+        memset(texture, 0, sizeof(*texture));
+        strcpy(texture->fileName, fileName);
+        texture->key = TextureKey(fileName);
+        texture->filter = filter;
+
+        // without a tail on disk the loader builds one before anything else
+        if (!LoadTail(texture) && running)
+        {
+            pthread_mutex_lock(&streamLock);
+            texture->needsTail = true;
+            PushRequest(slot, 0);
+            pthread_mutex_unlock(&streamLock);
+        }
+    }
+
+    if (texture->targetCount == MAX_STREAM_TARGETS)
+    {
+        TraceLog(LOG_WARNING, "STREAM: Too many materials share %s", fileName);
+        return false;
+    }
+
+    int target = texture->targetCount++;
+    texture->targets[target] = &material->maps[mapIndex].texture;
+    texture->original[target] = material->maps[mapIndex].texture;
+    texture->targetMaps[target] = material->maps;
+    PatchTargets(texture);
+    return true;
+}
+
+void RequestMaterialTextures(const Material* material, float screenPixels)
+{
+    for (int i = 0; i < textureCount; i++)
+    {
+        StreamedTexture *texture = &textures[i];
+        for (int t = 0; t < texture->targetCount; t++)
+        {
+            if (texture->targetMaps[t] != material->maps)
+                continue;
+
+            texture->lastUsed = frame;
+            if (screenPixels > texture->desiredPixels)
+                texture->desiredPixels = screenPixels;
+        }
+    }
+}
+
+void UpdateTextureStreaming(void)
+{
+    for (int i = 0; i < textureCount; i++)
+    {
+        StreamedTexture *texture = &textures[i];
+
+        pthread_mutex_lock(&streamLock);
+        bool hasReady = texture->hasReady;
+        Image ready = texture->ready;
+        Image readyTail = texture->readyTail;
+        texture->hasReady = false;
+        bool failed = texture->failed;
+        bool pending = texture->pendingSize != 0;
+        int fullSide = LongestSide(texture->fullWidth, texture->fullHeight);
+        pthread_mutex_unlock(&streamLock);
+
+        if (hasReady)
+        {
+            if (readyTail.data != NULL && texture->tail.id == 0)
+            {
+                texture->tail = UploadLevel(readyTail, texture->filter, texture->fileName);
+                PatchTargets(texture);
+            }
+            if (ready.data != NULL)
+                InstallResident(texture, ready);
+
+            UnloadImage(readyTail);
+            UnloadImage(ready);
+        }
+
+        if (failed)
+        {
+            if (texture->desiredPixels > 0.0f && texture->retryFrame == 0)
+            {
+                TraceLog(LOG_WARNING, "STREAM: Could not decode %s", texture->fileName);
+                texture->retryFrame = (unsigned int)-1;
+            }
+        }
+        else if (running && texture->desiredPixels > 0.0f && !pending && frame >= texture->retryFrame)
+        {
+            // power of two at or above the on-screen size, never past the source
+            int size = TEXTURE_STREAM_TAIL_SIZE;
+            while (size < (int)texture->desiredPixels)
+                size *= 2;
+            if (fullSide > 0 && size > fullSide)
+                size = fullSide;
+
+            Texture2D current = (texture->resident.id != 0)? texture->resident : texture->tail;
+            if (size > LongestSide(current.width, current.height))
+            {
+                pthread_mutex_lock(&streamLock);
+                PushRequest(i, size);
+                pthread_mutex_unlock(&streamLock);
+            }
+        }
+
+        texture->desiredPixels = 0.0f;
+    }
+
+    frame++;
+}
+
+size_t GetStreamedTextureBytes(void)
+{
+    return residentTotal;
+}
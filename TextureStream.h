@@ -0,0 +1,51 @@
+/**********************************************************************************************
+*
+*   RockyRoad * TextureStream * Material textures streamed in by on-screen size
+*
+*   A streamed texture starts out as its mip tail, a copy no bigger than 32 pixels kept in
+*   cache/<key>.tail and uploaded straight away when the map is registered. Full size images
+*   are only decoded on the loader thread, once the game reports the material on screen, and
+*   only down to the power of two level that its on-screen size needs.
+*
+*   Levels above the tail count against a VRAM budget. When an upload would go over it, the
+*   least recently used textures fall back to their tails first. Textures that were used just
+*   as recently as the one waiting are never evicted for it, the upload is retried later.
+*
+*   Registered maps are patched in place whenever their texture changes, so every model that
+*   shares the material picks the new level up. Until the first run has written a tail, a map
+*   keeps whatever texture it had before it was registered.
+*
+**********************************************************************************************/
+
+#ifndef TEXTURE_STREAM_H
+#define TEXTURE_STREAM_H
+
+#include "raylib.h"
+
+#include <stddef.h>
+
+#define TEXTURE_STREAM_DIRECTORY "cache"
+#define TEXTURE_STREAM_TAIL_SIZE 32
+
+// start the loader thread, levels above the tails may use up to budgetBytes of VRAM
+void InitTextureStreaming(size_t budgetBytes);
+
+// join the loader thread, unload every streamed texture and put the original map textures back
+void CloseTextureStreaming(void);
+
+// change the budget, evicting right away if the resident levels no longer fit
+void SetTextureStreamingBudget(size_t budgetBytes);
+
+// stream a file into a material map. registering the same file again shares its texture
+bool StreamMaterialMap(Material* material, int mapIndex, const char* fileName, TextureFilter filter);
+
+// report a material as drawn this frame at about that many pixels across
+void RequestMaterialTextures(const Material* material, float screenPixels);
+
+// upload finished decodes, queue new ones and enforce the budget. once per frame, main thread
+void UpdateTextureStreaming(void);
+
+// VRAM held by levels above the tails
+size_t GetStreamedTextureBytes(void);
+
+#endif //TEXTURE_STREAM_H
@@ -0,0 +1,9 @@
+#version 330
+
+// Output fragment color, discarded by the blend state, only depth is kept
+out vec4 finalColor;
+
+void main()
+{
+    finalColor = vec4(0.0);
+}
@@ -0,0 +1,15 @@
+#version 330
+
+// must match the PBR vertex shader bit for bit so the main pass passes the depth test
+invariant gl_Position;
+
+// Input vertex attributes
+in vec3 vertexPosition;
+
+// Input uniform values
+uniform mat4 mvp;
+
+void main()
+{
+    gl_Position = mvp*vec4(vertexPosition, 1.0);
+}
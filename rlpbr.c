@@ -8,11 +8,16 @@
  * at https://mozilla.org/MPL/2.0/. */
 
 #include "rlpbr.h"
+#include "raymath.h"
+#include "rlgl.h"
 
 #ifdef BUNDLE_SHADERS
 #include "shaders.h"
 #endif
 
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -20,6 +25,37 @@
 Shader pbr_shader;
 Texture albedo, ao, metallic, normals, roughness;
 
+// materials still pointing at the shared fallback textures, they are only freed by ClosePBR
+int default_refs = 0;
+
+// NOTE: Texture slot 14 is past the 12 material maps DrawMesh binds and unbinds
+#define SHADOW_MAP_SLOT 14
+
+const char shadow_vs[] = "#version 330 core\n"
+                         "in vec3 vertexPosition;\n"
+                         "uniform mat4 mvp;\n"
+                         "void main(){\n"
+                         "gl_Position=mvp*vec4(vertexPosition,1.0);\n"
+                         "}";
+
+const char shadow_fs[] = "#version 330 core\n"
+                         "out vec4 FragColor;\n"
+                         "void main(){\n"
+                         "FragColor=vec4(1.0);\n"
+                         "}";
+
+typedef struct pbr_shadow_map {
+    void *light;
+    int resolution;
+    unsigned int fbo;
+    unsigned int depth;
+    unsigned int color;
+    unsigned long long hash;
+    Shader shader;
+} pbr_shadow_map;
+
+pbr_shadow_map shadow = {0};
+
 typedef struct pbr_internal_light {
     float pos[3];
     float color[3];
@@ -33,6 +69,18 @@ typedef struct pbr_internal_light {
 pbr_internal_light *lights = NULL;
 pbr_internal_light empty = {0};
 
+static Texture LoadDefaultTexture(Color color) {
+    Image image = GenImageColor(1, 1, color);
+    Texture texture = LoadTextureFromImage(image);
+    UnloadImage(image);
+    return texture;
+}
+
+static bool IsDefaultTexture(Texture texture) {
+    return texture.id == albedo.id || texture.id == ao.id || texture.id == metallic.id ||
+           texture.id == normals.id || texture.id == roughness.id;
+}
+
 void InitPBR() {
     #ifdef BUNDLE_SHADERS
     pbr_shader = LoadShaderFromMemory(pbr_vs, pbr_fs);
@@ -51,16 +99,32 @@ void InitPBR() {
     pbr_shader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocation(pbr_shader, "matModel");
     pbr_shader.locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(pbr_shader, "camPos");
 
-    albedo = LoadTextureFromImage(GenImageColor(1, 1, WHITE));
-    ao = LoadTextureFromImage(GenImageColor(1, 1, WHITE));
-    metallic = LoadTextureFromImage(GenImageColor(1, 1, BLACK));
-    normals = LoadTextureFromImage(GenImageColor(1, 1, (Color) {128, 128, 255, 255}));
-    roughness = LoadTextureFromImage(GenImageColor(1, 1, GRAY));
+    albedo = LoadDefaultTexture(WHITE);
+    ao = LoadDefaultTexture(WHITE);
+    metallic = LoadDefaultTexture(BLACK);
+    normals = LoadDefaultTexture((Color) {128, 128, 255, 255});
+    roughness = LoadDefaultTexture(GRAY);
+    default_refs = 0;
+
+    int shadow_slot = SHADOW_MAP_SLOT;
+    int no_shadow = -1;
+    SetShaderValue(pbr_shader, GetShaderLocation(pbr_shader, "shadowMap"), &shadow_slot, SHADER_UNIFORM_INT);
+    SetShaderValue(pbr_shader, GetShaderLocation(pbr_shader, "shadowLight"), &no_shadow, SHADER_UNIFORM_INT);
 
     EnableSpecular();
 }
 
 void ClosePBR() {
+    DisableLightShadows();
+
+    if (default_refs > 0)
+        TraceLog(LOG_WARNING, "PBR: %i material maps still use the default textures", default_refs);
+
+    UnloadTexture(albedo);
+    UnloadTexture(ao);
+    UnloadTexture(metallic);
+    UnloadTexture(normals);
+    UnloadTexture(roughness);
     UnloadShader(pbr_shader);
 }
 
@@ -100,6 +164,8 @@ Material LoadPBRMaterial(const char *albedo_path,
     GenTextureMipmaps(&mat.maps[MATERIAL_MAP_ROUGHNESS].texture);
     GenTextureMipmaps(&mat.maps[MATERIAL_MAP_OCCLUSION].texture);
 
+    default_refs += !albedo_path + !ao_path + !metallic_path + !normals_path + !roughness_path;
+
     return mat;
 }
 
@@ -201,6 +267,8 @@ void *AddLight(Light light) {
 
 void RemoveLight(void *_light) {
     pbr_internal_light *light = (pbr_internal_light*)_light;
+    if (light == shadow.light) DisableLightShadows();
+
     light->prev->next = light->next;
     light->next->prev = light->prev;
 
@@ -240,14 +308,159 @@ void DisableLight(void *_light) {
     SetOn(_light, 0);
 }
 
+static void UnloadShadowTargets() {
+    if (shadow.fbo) rlUnloadFramebuffer(shadow.fbo);
+    if (shadow.depth) rlUnloadTexture(shadow.depth);
+    if (shadow.color) rlUnloadTexture(shadow.color);
+
+    shadow.fbo = shadow.depth = shadow.color = 0;
+}
+
+void EnableLightShadows(void *light, int resolution) {
+    if (shadow.light && shadow.resolution != resolution) UnloadShadowTargets();
+
+    shadow.light = light;
+    shadow.resolution = resolution;
+    shadow.hash = 0;
+
+    if (!shadow.shader.id) shadow.shader = LoadShaderFromMemory(shadow_vs, shadow_fs);
+
+    if (!shadow.fbo) {
+        // NOTE: The color attachment is never sampled, some drivers want one for a complete fbo
+        shadow.fbo = rlLoadFramebuffer(resolution, resolution);
+        shadow.depth = rlLoadTextureDepth(resolution, resolution, false);
+        shadow.color = rlLoadTexture(NULL, resolution, resolution, PIXELFORMAT_UNCOMPRESSED_GRAYSCALE, 1);
+        rlFramebufferAttach(shadow.fbo, shadow.color, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+        rlFramebufferAttach(shadow.fbo, shadow.depth, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
+
+        if (!rlFramebufferComplete(shadow.fbo)) {
+            TraceLog(LOG_WARNING, "PBR: Shadow map framebuffer is incomplete, shadows disabled");
+            DisableLightShadows();
+            return;
+        }
+    }
+
+    float texel = 1.0f/(float)resolution;
+    SetShaderValue(pbr_shader, GetShaderLocation(pbr_shader, "shadowTexel"), &texel, SHADER_UNIFORM_FLOAT);
+
+    rlActiveTextureSlot(SHADOW_MAP_SLOT);
+    rlEnableTexture(shadow.depth);
+    rlActiveTextureSlot(0);
+}
+
+void DisableLightShadows() {
+    int no_shadow = -1;
+    SetShaderValue(pbr_shader, GetShaderLocation(pbr_shader, "shadowLight"), &no_shadow, SHADER_UNIFORM_INT);
+
+    UnloadShadowTargets();
+    if (shadow.shader.id) UnloadShader(shadow.shader);
+
+    memset(&shadow, 0, sizeof(shadow));
+}
+
+static unsigned long long HashBytes(unsigned long long hash, const void *data, size_t size) {
+    const unsigned char *bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static Matrix GetShadowView(pbr_internal_light *light) {
+    Vector3 dir;
+    if (light->type == SUN) {
+        // NOTE: Sun lights store the direction towards the light in target
+        dir = Vector3Negate((Vector3) {light->target[0], light->target[1], light->target[2]});
+    } else {
+        dir = Vector3Subtract((Vector3) {light->target[0], light->target[1], light->target[2]},
+                              (Vector3) {light->pos[0], light->pos[1], light->pos[2]});
+    }
+    dir = Vector3Normalize(dir);
+
+    // NOTE: A light looking straight up or down needs another up vector
+    Vector3 up = fabsf(dir.y) > 0.99f ? (Vector3) {0, 0, 1} : (Vector3) {0, 1, 0};
+    return MatrixLookAt(Vector3Zero(), dir, up);
+}
+
+bool UpdateShadowMap(const ShadowCaster *casters, int count) {
+    pbr_internal_light *light = (pbr_internal_light*)shadow.light;
+    if (!light || !shadow.fbo) return false;
+
+    unsigned long long hash = 14695981039346656037ULL;
+    hash = HashBytes(hash, light, offsetof(pbr_internal_light, next));
+    for (int i = 0; i < count; i++) {
+        hash = HashBytes(hash, &casters[i].mesh->vaoId, sizeof(unsigned int));
+        hash = HashBytes(hash, &casters[i].transform, sizeof(Matrix));
+    }
+    if (hash == shadow.hash) return false;
+    shadow.hash = hash;
+
+    // NOTE: Spot lights shade with a single direction as well, both get a projection fitted
+    // around the casters
+    Matrix view = GetShadowView(light);
+    Vector3 min = {FLT_MAX, FLT_MAX, FLT_MAX};
+    Vector3 max = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (int i = 0; i < count; i++) {
+        BoundingBox box = GetMeshBoundingBox(*casters[i].mesh);
+        for (int c = 0; c < 8; c++) {
+            Vector3 corner = {(c & 1) ? box.max.x : box.min.x, (c & 2) ? box.max.y : box.min.y, (c & 4) ? box.max.z : box.min.z};
+            corner = Vector3Transform(Vector3Transform(corner, casters[i].transform), view);
+            min = Vector3Min(min, corner);
+            max = Vector3Max(max, corner);
+        }
+    }
+    if (count == 0) min = max = Vector3Zero();
+
+    Matrix proj = MatrixOrtho(min.x, max.x, min.y, max.y, -max.z - 1.0f, -min.z + 1.0f);
+    Matrix light_vp = MatrixMultiply(view, proj);
+
+    rlDrawRenderBatchActive();
+    rlEnableFramebuffer(shadow.fbo);
+    rlViewport(0, 0, shadow.resolution, shadow.resolution);
+    rlClearScreenBuffers();
+    rlEnableDepthTest();
+    rlEnableShader(shadow.shader.id);
+
+    for (int i = 0; i < count; i++) {
+        if (!rlEnableVertexArray(casters[i].mesh->vaoId)) continue;
+
+        rlSetUniformMatrix(shadow.shader.locs[SHADER_LOC_MATRIX_MVP], MatrixMultiply(casters[i].transform, light_vp));
+        if (casters[i].mesh->indices) rlDrawVertexArrayElements(0, casters[i].mesh->triangleCount*3, 0);
+        else rlDrawVertexArray(0, casters[i].mesh->vertexCount);
+    }
+
+    rlDisableVertexArray();
+    rlDisableShader();
+    rlDisableFramebuffer();
+    rlViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
+
+    pbr_internal_light *cur = lights;
+    int index = 0;
+    while (cur && cur != light) {
+        cur = cur->next;
+        index++;
+    }
+    if (!cur) index = -1;
+
+    SetShaderValueMatrix(pbr_shader, GetShaderLocation(pbr_shader, "lightVP"), light_vp);
+    SetShaderValue(pbr_shader, GetShaderLocation(pbr_shader, "shadowLight"), &index, SHADER_UNIFORM_INT);
+
+    return true;
+}
+
 void UnloadPBRModel(Model pbr) {
     // NOTE: Not unloading shader, because it's shared across models
-
-    UnloadTexture(pbr.materials[0].maps[MATERIAL_MAP_ALBEDO].texture);
-    UnloadTexture(pbr.materials[0].maps[MATERIAL_MAP_OCCLUSION].texture);
-    UnloadTexture(pbr.materials[0].maps[MATERIAL_MAP_METALNESS].texture);
-    UnloadTexture(pbr.materials[0].maps[MATERIAL_MAP_NORMAL].texture);
-    UnloadTexture(pbr.materials[0].maps[MATERIAL_MAP_ROUGHNESS].texture);
+    // NOTE: Default textures are shared as well, they only lose a reference here
+    int maps[5] = {MATERIAL_MAP_ALBEDO, MATERIAL_MAP_OCCLUSION, MATERIAL_MAP_METALNESS, MATERIAL_MAP_NORMAL, MATERIAL_MAP_ROUGHNESS};
+
+    for (int i = 0; i < 5; i++) {
+        Texture texture = pbr.materials[0].maps[maps[i]].texture;
+        if (IsDefaultTexture(texture))
+            default_refs--;
+        else
+            UnloadTexture(texture);
+    }
 
     UnloadModel(pbr);
 }
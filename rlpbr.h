@@ -29,6 +29,11 @@ typedef struct Light {
     int on;
 } Light;
 
+typedef struct ShadowCaster {
+    const Mesh *mesh;
+    Matrix transform;
+} ShadowCaster;
+
 void InitPBR();
 void ClosePBR();
 
@@ -54,6 +59,14 @@ Light GetLight(void *light);
 void EnableLight(void *light);
 void DisableLight(void *light);
 
+/// Give a spot or sun light a shadow map. Only one light casts shadows at a time
+void EnableLightShadows(void *light, int resolution);
+void DisableLightShadows();
+
+/// Render the shadow map from the casters, skipped while neither they nor the light changed.
+/// Call outside of any 3D or texture mode. Returns true if the map was redrawn
+bool UpdateShadowMap(const ShadowCaster *casters, int count);
+
 void UnloadPBRModel(Model pbr);
 
 void DisableSpecular();
@@ -4,6 +4,7 @@
 #define RAYLIB_PBR_SRC_SHADERS_H_
 
 const char pbr_vs[] = "#version 330 core\n"
+                      "invariant gl_Position;\n"
                       "in vec3 vertexPosition;\n"
                       "in vec2 vertexTexCoord;\n"
                       "in vec3 vertexNormal;\n"
@@ -44,6 +45,10 @@ const char pbr_fs[] = "#version 330 core\n"
                       "};\n"
                       "uniform Light lights[100];\n"
                       "uniform vec3 camPos;\n"
+                      "uniform sampler2D shadowMap;\n"
+                      "uniform mat4 lightVP;\n"
+                      "uniform int shadowLight;\n"
+                      "uniform float shadowTexel;\n"
                       "const float PI=3.14159265359;\n"
                       "vec3 GetNormalFromMap(){\n"
                       "vec3 tangentNormal=texture(normalMap,tex_coords).xyz*2.0-1.0;\n"
@@ -84,6 +89,20 @@ const char pbr_fs[] = "#version 330 core\n"
                       "vec3 FresnelSchlick(float cosTheta,vec3 F0){\n"
                       "return F0+(1.0-F0)*max(1.0-cosTheta,0.0);\n"
                       "}\n"
+                      "float ShadowFactor(vec3 L){\n"
+                      "vec4 light_pos=lightVP*vec4(vert_pos,1.0);\n"
+                      "vec3 p=light_pos.xyz/light_pos.w*0.5+0.5;\n"
+                      "if(p.x<0.0||p.x>1.0||p.y<0.0||p.y>1.0||p.z>1.0) return 0.0;\n"
+                      "float bias=max(0.005*(1.0-dot(normalize(vert_norm),L)),0.0005);\n"
+                      "float shadow=0.0;\n"
+                      "for(int x=-1;x<=1;++x){\n"
+                      "for(int y=-1;y<=1;++y){\n"
+                      "float closest=texture(shadowMap,p.xy+vec2(x,y)*shadowTexel).r;\n"
+                      "shadow+=(p.z-bias>closest)?1.0:0.0;\n"
+                      "}\n"
+                      "}\n"
+                      "return shadow/9.0;\n"
+                      "}\n"
                       "void main(){\n"
                       "vec3 albedo=pow(texture(albedoMap,tex_coords).rgb,vec3(2.2));\n"
                       "float metallic=texture(metallicMap,tex_coords).r;\n"
@@ -111,6 +130,7 @@ const char pbr_fs[] = "#version 330 core\n"
                       "}else if(lights[i].type==LIGHT_SUN){\n"
                       "L=normalize(lights[i].target);\n"
                       "}\n"
+                      "if(i==shadowLight) radiance*=1.0-ShadowFactor(L);\n"
                       "vec3 H=normalize(V+L);\n"
                       "float NDF=DistributionGGX(N,H,roughness);\n"
                       "float G=GeometrySmith(N,V,L,roughness);\n"
@@ -0,0 +1,32 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in vec2 fragTexCoord;
+in vec4 fragColor;
+
+// Input uniform values
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+
+// one texel of the scene texture, and how strongly the upscaled edges are restored (0..1)
+uniform vec2 texelSize;
+uniform float sharpness;
+
+// Output fragment color
+out vec4 finalColor;
+
+void main()
+{
+    vec3 center = texture(texture0, fragTexCoord).rgb;
+    vec3 north = texture(texture0, fragTexCoord + vec2(0.0, texelSize.y)).rgb;
+    vec3 south = texture(texture0, fragTexCoord - vec2(0.0, texelSize.y)).rgb;
+    vec3 east = texture(texture0, fragTexCoord + vec2(texelSize.x, 0.0)).rgb;
+    vec3 west = texture(texture0, fragTexCoord - vec2(texelSize.x, 0.0)).rgb;
+
+    // unsharp mask, clamped to the neighbourhood so edges do not ring
+    vec3 sharpened = center + (4.0*center - north - south - east - west)*0.25*sharpness;
+    vec3 low = min(center, min(min(north, south), min(east, west)));
+    vec3 high = max(center, max(max(north, south), max(east, west)));
+
+    finalColor = vec4(clamp(sharpened, low, high), 1.0)*colDiffuse*fragColor;
+}
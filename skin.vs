@@ -0,0 +1,53 @@
+#version 330
+
+#define MAX_BONES 64
+
+// Input vertex attributes
+in vec3 vertexPosition;
+in vec2 vertexTexCoord;
+in vec4 vertexBoneIds;
+in vec4 vertexBoneWeights;
+in mat4 instanceTransform;
+
+// Input uniform values
+uniform mat4 mvp;
+
+// 1 while drawn instanced, mvp then leaves out the model and every copy has its transform
+uniform int instanced;
+
+// three rows of an affine matrix per bone
+uniform vec4 bones[MAX_BONES*3];
+
+// Output vertex attributes (to fragment shader)
+out vec2 fragTexCoord;
+
+void main()
+{
+    vec4 row0 = vec4(0.0);
+    vec4 row1 = vec4(0.0);
+    vec4 row2 = vec4(0.0);
+    float total = 0.0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        int bone = int(vertexBoneIds[i])*3;
+        float weight = vertexBoneWeights[i];
+
+        row0 += bones[bone]*weight;
+        row1 += bones[bone + 1]*weight;
+        row2 += bones[bone + 2]*weight;
+        total += weight;
+    }
+
+    vec4 position = vec4(vertexPosition, 1.0);
+    vec3 skinned = vertexPosition;
+
+    // vertices without weights stay in the bind pose instead of collapsing to the origin
+    if (total > 0.0001) skinned = vec3(dot(row0, position), dot(row1, position), dot(row2, position));
+
+    vec4 placed = vec4(skinned, 1.0);
+    if (instanced == 1) placed = instanceTransform*placed;
+
+    fragTexCoord = vertexTexCoord;
+    gl_Position = mvp*placed;
+}
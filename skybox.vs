@@ -27,6 +27,7 @@ void main()
     mat4 rotView = mat4(mat3(view));
     vec4 clipPos = projection*rotView*vec4(vertexPosition, 1.0);
 
-    // Calculate final vertex position
-    gl_Position = clipPos.xyzw;
+    // Calculate final vertex position, w for z puts the sky on the far plane so it is drawn
+    // last and only where the depth buffer is still clear
+    gl_Position = clipPos.xyww;
 }